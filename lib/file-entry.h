@@ -27,6 +27,11 @@ typedef struct
     char *name_sort_key;
     // Key used for comparing extensions
     char *extension_sort_key;
+    // Color of file highlighting, valid if fhl_stamp is equal to stamp of the current rules
+    int fhl_color;
+    unsigned int fhl_stamp;
+    // Identifier of entry in caches of formatted lines of panels, 0 if it isn't set yet
+    unsigned int line_stamp;
 
     // Flags
     struct
@@ -44,6 +49,19 @@ typedef struct
 
 /* --------------------------------------------------------------------------------------------- */
 /*** inline functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget cached values which depend on name and attributes of entry. Must be called if they are
+ * changed in place.
+ */
+
+static inline void
+file_entry_reset_cache (file_entry_t *fe)
+{
+    fe->fhl_stamp = 0;
+    fe->line_stamp = 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 #endif
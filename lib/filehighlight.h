@@ -3,6 +3,7 @@
 
 #include "lib/mcconfig.h"  // mc_config_t
 #include "lib/file-entry.h"
+#include "lib/search.h"  // mc_search_t
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -14,6 +15,13 @@ typedef struct mc_fhl_struct
 {
     mc_config_t *config;
     GPtrArray *filters;
+
+    // rules compiled at load time
+    GHashTable *extensions;           // extension -> index of the first filter + 1
+    GHashTable *extensions_caseless;  // the same for lowercase ASCII extensions
+    mc_search_t *regexps;             // regexp filters combined into one pattern
+    GArray *regexp_groups;            // array of mc_fhl_regexp_group_t, in order of filters
+    guint stamp;                      // identifier of rules to cache colors of entries
 } mc_fhl_t;
 
 /*** global variables defined in .c file *********************************************************/
@@ -23,7 +31,7 @@ typedef struct mc_fhl_struct
 mc_fhl_t *mc_fhl_new (gboolean need_auto_fill);
 void mc_fhl_free (mc_fhl_t **fhl);
 
-int mc_fhl_get_color (const mc_fhl_t *fhl, const file_entry_t *fe);
+int mc_fhl_get_color (const mc_fhl_t *fhl, file_entry_t *fe);
 
 gboolean mc_fhl_read_ini_file (mc_fhl_t *fhl, const gchar *filename);
 gboolean mc_fhl_parse_ini_file (mc_fhl_t *fhl);
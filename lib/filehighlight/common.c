@@ -70,6 +70,29 @@ mc_fhl_array_free (mc_fhl_t *fhl)
         g_ptr_array_free (fhl->filters, TRUE);
         fhl->filters = NULL;
     }
+
+    if (fhl->extensions != NULL)
+    {
+        g_hash_table_destroy (fhl->extensions);
+        fhl->extensions = NULL;
+    }
+
+    if (fhl->extensions_caseless != NULL)
+    {
+        g_hash_table_destroy (fhl->extensions_caseless);
+        fhl->extensions_caseless = NULL;
+    }
+
+    mc_search_free (fhl->regexps);
+    fhl->regexps = NULL;
+
+    if (fhl->regexp_groups != NULL)
+    {
+        g_array_free (fhl->regexp_groups, TRUE);
+        fhl->regexp_groups = NULL;
+    }
+
+    fhl->stamp = 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -272,17 +272,94 @@ mc_fhl_get_color_regexp (const mc_fhl_filter_t *mc_filter, const mc_fhl_t *fhl,
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/*** public functions ****************************************************************************/
+/**
+ * Find extension filter matched by name. Like in regexp filters, only the first line of name is
+ * checked. Extensions may contain dots, so every suffix after dot is looked up.
+ *
+ * @return index of the first matched filter, -1 if there is no one
+ */
+
+static int
+mc_fhl_find_ext_filter (const mc_fhl_t *fhl, const file_entry_t *fe)
+{
+    const char *eol;
+    gsize len;
+    char *name, *lower = NULL;
+    const char *dot;
+    guint found = 0;
+
+    if (fhl->extensions == NULL && fhl->extensions_caseless == NULL)
+        return -1;
+
+    eol = memchr (fe->fname->str, '\n', fe->fname->len);
+    len = eol != NULL ? (gsize) (eol - fe->fname->str) : fe->fname->len;
+    name = g_strndup (fe->fname->str, len);
+    if (fhl->extensions_caseless != NULL)
+        lower = g_ascii_strdown (name, -1);
+
+    for (dot = strchr (name, '.'); dot != NULL; dot = strchr (dot + 1, '.'))
+    {
+        guint filter;
+
+        if (fhl->extensions != NULL)
+        {
+            filter = GPOINTER_TO_UINT (g_hash_table_lookup (fhl->extensions, dot + 1));
+            if (filter != 0 && (found == 0 || filter < found))
+                found = filter;
+        }
+
+        if (lower != NULL)
+        {
+            filter = GPOINTER_TO_UINT (g_hash_table_lookup (fhl->extensions_caseless,
+                                                            lower + (dot - name) + 1));
+            if (filter != 0 && (found == 0 || filter < found))
+                found = filter;
+        }
+    }
+
+    g_free (lower);
+    g_free (name);
+
+    return (int) found - 1;
+}
+
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the first regexp filter matched by name with combined pattern.
+ *
+ * @return index of the first matched filter, -1 if there is no one
+ */
 
-int
-mc_fhl_get_color (const mc_fhl_t *fhl, const file_entry_t *fe)
+static int
+mc_fhl_find_regexp_filter (const mc_fhl_t *fhl, const file_entry_t *fe)
 {
     guint i;
-    int ret;
 
-    if (fhl == NULL)
-        return FILEHIGHLIGHT_DEFAULT_COLOR;
+    if (fhl->regexps == NULL
+        || !mc_search_run (fhl->regexps, fe->fname->str, 0, fe->fname->len, NULL))
+        return -1;
+
+    for (i = 0; i < fhl->regexp_groups->len; i++)
+    {
+        const mc_fhl_regexp_group_t *g;
+
+        g = &g_array_index (fhl->regexp_groups, mc_fhl_regexp_group_t, i);
+        if (mc_search_getstart_result_by_num (fhl->regexps, g->group) >= 0)
+            return (int) g->filter;
+    }
+
+    return -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+mc_fhl_get_color_uncached (const mc_fhl_t *fhl, const file_entry_t *fe)
+{
+    int ext_filter = -2;     // not found yet
+    int regexp_filter = -2;  // not found yet
+    guint i;
+    int ret;
 
     for (i = 0; i < fhl->filters->len; i++)
     {
@@ -297,7 +374,20 @@ mc_fhl_get_color (const mc_fhl_t *fhl, const file_entry_t *fe)
                 return ret;
             break;
         case MC_FLHGH_T_EXT:
+            if (ext_filter == -2)
+                ext_filter = mc_fhl_find_ext_filter (fhl, fe);
+            if (ext_filter == (int) i)
+                return mc_filter->color_pair_index;
+            break;
         case MC_FLHGH_T_FREGEXP:
+            if (mc_filter->is_combined)
+            {
+                if (regexp_filter == -2)
+                    regexp_filter = mc_fhl_find_regexp_filter (fhl, fe);
+                if (regexp_filter == (int) i)
+                    return mc_filter->color_pair_index;
+                break;
+            }
             ret = mc_fhl_get_color_regexp (mc_filter, fhl, fe);
             if (ret >= 0)
                 return ret;
@@ -310,3 +400,33 @@ mc_fhl_get_color (const mc_fhl_t *fhl, const file_entry_t *fe)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get color of file. The color is cached in the entry until rules or the entry are changed.
+ *
+ * @param fhl rules of file highlighting
+ * @param fe file entry
+ *
+ * @return color pair index
+ */
+
+int
+mc_fhl_get_color (const mc_fhl_t *fhl, file_entry_t *fe)
+{
+    if (fhl == NULL)
+        return FILEHIGHLIGHT_DEFAULT_COLOR;
+
+    if (fhl->stamp == 0)
+        return mc_fhl_get_color_uncached (fhl, fe);
+
+    if (fe->fhl_stamp != fhl->stamp)
+    {
+        fe->fhl_color = mc_fhl_get_color_uncached (fhl, fe);
+        fe->fhl_stamp = fhl->stamp;
+    }
+
+    return fe->fhl_color;
+}
+
+/* --------------------------------------------------------------------------------------------- */
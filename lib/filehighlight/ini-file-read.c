@@ -47,6 +47,9 @@
 
 /*** file scope variables ************************************************************************/
 
+/* the last stamp of rules */
+static guint mc_fhl_last_stamp = 0;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -104,9 +107,171 @@ mc_fhl_parse_get_file_type_id (mc_fhl_t *fhl, const gchar *group_name)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of capture groups of regexp which may be a part of combined pattern.
+ *
+ * @return number of groups, or -1 if regexp refers to groups by number, contains quoted text
+ *         or verbs which would affect the whole pattern, or cannot be compiled alone
+ */
+
+static int
+mc_fhl_regexp_get_groups (const char *regexp)
+{
+    const char *p;
+    GRegex *regex;
+    int groups;
+
+    for (p = regexp; *p != '\0'; p++)
+    {
+        if (p[0] == '\\' && p[1] != '\0')
+        {
+            p++;
+            if (g_ascii_isdigit (*p) || strchr ("gkQE", *p) != NULL)
+                return -1;
+        }
+        else if (p[0] == '(' && p[1] == '*')
+            return -1;
+        else if (p[0] == '(' && p[1] == '?' && p[2] != '\0'
+                 && (g_ascii_isdigit (p[2]) || strchr ("P&R(+-", p[2]) != NULL))
+            return -1;
+    }
+
+    regex = g_regex_new (regexp, G_REGEX_RAW, 0, NULL);
+    if (regex == NULL)
+        return -1;
+
+    groups = g_regex_get_capture_count (regex);
+    g_regex_unref (regex);
+
+    return groups;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add regexp of filter which will be added next to combined pattern
+ * "^(?:.*?(?:re1)()|.*?(?:re2)()|...)". The pattern is anchored, so alternatives are tried
+ * in order of filters, and the empty group after the first matched regexp identifies the filter.
+ *
+ * @return TRUE if regexp is added, FALSE if it must be searched alone
+ */
 
 static gboolean
-mc_fhl_parse_get_regexp (mc_fhl_t *fhl, const gchar *group_name)
+mc_fhl_combine_regexp (mc_fhl_t *fhl, GString *regexps, const char *regexp)
+{
+    mc_fhl_regexp_group_t g;
+    int groups;
+
+    groups = mc_fhl_regexp_get_groups (regexp);
+    if (groups < 0)
+        return FALSE;
+
+    g.group = groups + 1;
+    if (fhl->regexp_groups->len != 0)
+    {
+        const mc_fhl_regexp_group_t *last;
+
+        last = &g_array_index (fhl->regexp_groups, mc_fhl_regexp_group_t,
+                               fhl->regexp_groups->len - 1);
+        g.group += last->group;
+    }
+    g.filter = fhl->filters->len;
+    g_array_append_val (fhl->regexp_groups, g);
+
+    g_string_append (regexps, regexps->len == 0 ? "^(?:" : "|");
+    g_string_append (regexps, ".*?(?:");
+    g_string_append (regexps, regexp);
+    g_string_append (regexps, ")()");
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mc_fhl_compile_regexps (mc_fhl_t *fhl, GString *regexps)
+{
+    guint i;
+
+    if (regexps->len == 0)
+        return;
+
+    g_string_append_c (regexps, ')');
+
+    fhl->regexps = mc_search_new_len (regexps->str, regexps->len, NULL);
+    fhl->regexps->is_case_sensitive = TRUE;
+    fhl->regexps->search_type = MC_SEARCH_T_REGEX;
+
+    if (mc_search_prepare (fhl->regexps))
+        return;
+
+    // search every regexp alone
+    mc_search_free (fhl->regexps);
+    fhl->regexps = NULL;
+
+    for (i = 0; i < fhl->regexp_groups->len; i++)
+    {
+        const mc_fhl_regexp_group_t *g;
+        mc_fhl_filter_t *mc_filter;
+
+        g = &g_array_index (fhl->regexp_groups, mc_fhl_regexp_group_t, i);
+        mc_filter = (mc_fhl_filter_t *) g_ptr_array_index (fhl->filters, g->filter);
+        mc_filter->is_combined = FALSE;
+    }
+
+    g_array_set_size (fhl->regexp_groups, 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add extensions of filter which will be added next to hash table. Caseless extensions are
+ * compared with ASCII case folding only, so ones with other characters are left to regexp.
+ *
+ * @return TRUE if extensions are added, FALSE if they must be searched with regexp
+ */
+
+static gboolean
+mc_fhl_hash_extensions (mc_fhl_t *fhl, gchar **exts, gboolean case_sensitive)
+{
+    GHashTable **table;
+    gpointer filter;
+    gchar **e;
+
+    if (!case_sensitive)
+        for (e = exts; *e != NULL; e++)
+        {
+            const char *p;
+
+            for (p = *e; *p != '\0'; p++)
+                if ((unsigned char) *p >= 0x80)
+                    return FALSE;
+        }
+
+    table = case_sensitive ? &fhl->extensions : &fhl->extensions_caseless;
+    if (*table == NULL)
+        *table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    filter = GUINT_TO_POINTER (fhl->filters->len + 1);
+
+    for (e = exts; *e != NULL; e++)
+    {
+        char *ext;
+
+        ext = case_sensitive ? g_strdup (*e) : g_ascii_strdown (*e, -1);
+
+        // the first filter wins
+        if (g_hash_table_lookup (*table, ext) == NULL)
+            g_hash_table_insert (*table, ext, filter);
+        else
+            g_free (ext);
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+mc_fhl_parse_get_regexp (mc_fhl_t *fhl, const gchar *group_name, GString *regexps)
 {
     mc_fhl_filter_t *mc_filter;
     gchar *regexp;
@@ -123,6 +288,7 @@ mc_fhl_parse_get_regexp (mc_fhl_t *fhl, const gchar *group_name)
     mc_filter->search_condition = mc_search_new (regexp, NULL);
     mc_filter->search_condition->is_case_sensitive = TRUE;
     mc_filter->search_condition->search_type = MC_SEARCH_T_REGEX;
+    mc_filter->is_combined = mc_fhl_combine_regexp (fhl, regexps, regexp);
 
     mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
     g_ptr_array_add (fhl->filters, (gpointer) mc_filter);
@@ -138,6 +304,7 @@ mc_fhl_parse_get_extensions (mc_fhl_t *fhl, const gchar *group_name)
 {
     mc_fhl_filter_t *mc_filter;
     gchar **exts, **exts_orig;
+    gboolean case_sensitive;
     GString *buf;
 
     exts_orig = mc_config_get_string_list (fhl->config, group_name, "extensions", NULL);
@@ -147,6 +314,20 @@ mc_fhl_parse_get_extensions (mc_fhl_t *fhl, const gchar *group_name)
         return FALSE;
     }
 
+    case_sensitive = mc_config_get_bool (fhl->config, group_name, "extensions_case", FALSE);
+
+    if (mc_fhl_hash_extensions (fhl, exts_orig, case_sensitive))
+    {
+        g_strfreev (exts_orig);
+
+        mc_filter = g_new0 (mc_fhl_filter_t, 1);
+        mc_filter->type = MC_FLHGH_T_EXT;
+        mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
+        g_ptr_array_add (fhl->filters, (gpointer) mc_filter);
+
+        return TRUE;
+    }
+
     buf = g_string_sized_new (64);
 
     for (exts = exts_orig; *exts != NULL; exts++)
@@ -168,8 +349,7 @@ mc_fhl_parse_get_extensions (mc_fhl_t *fhl, const gchar *group_name)
     mc_filter = g_new0 (mc_fhl_filter_t, 1);
     mc_filter->type = MC_FLHGH_T_FREGEXP;
     mc_filter->search_condition = mc_search_new_len (buf->str, buf->len, NULL);
-    mc_filter->search_condition->is_case_sensitive =
-        mc_config_get_bool (fhl->config, group_name, "extensions_case", FALSE);
+    mc_filter->search_condition->is_case_sensitive = case_sensitive;
     mc_filter->search_condition->search_type = MC_SEARCH_T_REGEX;
 
     mc_fhl_parse_fill_color_info (mc_filter, fhl, group_name);
@@ -232,10 +412,13 @@ gboolean
 mc_fhl_parse_ini_file (mc_fhl_t *fhl)
 {
     gchar **group_names, **orig_group_names;
+    GString *regexps;
     gboolean ok;
 
     mc_fhl_array_free (fhl);
     fhl->filters = g_ptr_array_new_with_free_func (mc_fhl_filter_free);
+    fhl->regexp_groups = g_array_new (FALSE, FALSE, sizeof (mc_fhl_regexp_group_t));
+    regexps = g_string_sized_new (256);
 
     orig_group_names = mc_config_get_groups (fhl->config, NULL);
     ok = (*orig_group_names != NULL);
@@ -250,7 +433,7 @@ mc_fhl_parse_ini_file (mc_fhl_t *fhl)
         if (mc_config_has_param (fhl->config, *group_names, "regexp"))
         {
             // parse regexp filter
-            mc_fhl_parse_get_regexp (fhl, *group_names);
+            mc_fhl_parse_get_regexp (fhl, *group_names, regexps);
         }
         if (mc_config_has_param (fhl->config, *group_names, "extensions"))
         {
@@ -261,6 +444,14 @@ mc_fhl_parse_ini_file (mc_fhl_t *fhl)
 
     g_strfreev (orig_group_names);
 
+    mc_fhl_compile_regexps (fhl, regexps);
+    g_string_free (regexps, TRUE);
+
+    // zero stamp means that color of entry is not cached
+    if (++mc_fhl_last_stamp == 0)
+        mc_fhl_last_stamp++;
+    fhl->stamp = mc_fhl_last_stamp;
+
     return ok;
 }
 
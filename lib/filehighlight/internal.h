@@ -44,9 +44,17 @@ typedef struct mc_fhl_filter_struct
     mc_flhgh_filter_type type;
     mc_search_t *search_condition;
     mc_flhgh_ftype_type file_type;
+    gboolean is_combined;  // regexp is a part of mc_fhl_t::regexps
 
 } mc_fhl_filter_t;
 
+/* regexp filter in combined pattern */
+typedef struct
+{
+    int group;     // number of empty group which is matched together with regexp of filter
+    guint filter;  // index of filter
+} mc_fhl_regexp_group_t;
+
 /*** global variables defined in .c file *********************************************************/
 
 /*** declarations of public functions ************************************************************/
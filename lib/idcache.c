@@ -0,0 +1,545 @@
+/*
+   Cache of user and group names.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file idcache.c
+ *  \brief Source: cache of user and group names
+ *
+ *  Names of users and groups are resolved via NSS which may ask a network service.
+ *  Resolved names are kept for MC_IDCACHE_TTL seconds, unknown ids are remembered for
+ *  MC_IDCACHE_NEGATIVE_TTL seconds. Names are interned, so returned strings are never freed.
+ *
+ *  If the caller doesn't want to wait, the id is resolved in a worker thread and the stale name
+ *  or the number is returned meanwhile. When the name is resolved, the main loop is woken via
+ *  a pipe and the notification function is called to redraw.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <pwd.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/tty/key.h"  // add_select_channel()
+#include "lib/workpool.h"
+
+#include "lib/idcache.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined(HAVE_GETPWUID_R) && defined(HAVE_GETGRGID_R)
+#define IDCACHE_BACKGROUND 1
+#endif
+
+/* lookups wait for network mostly, so a few of them may run at once */
+#define IDCACHE_MAX_WORKERS 4
+
+/* upper limit of buffer for getpwuid_r() and getgrgid_r() */
+#define IDCACHE_MAX_BUFFER  (1024 * 1024)
+
+/*** file scope type declarations ****************************************************************/
+
+typedef enum
+{
+    IDCACHE_USER = 0,
+    IDCACHE_GROUP,
+    IDCACHE_NUM
+} idcache_kind_t;
+
+typedef struct
+{
+    const char *name;  // interned name, NULL if id is unknown
+    gint64 expires;    // monotonic time when the entry becomes stale
+    gboolean pending;  // id is being resolved
+    gboolean notify;   // stale value was returned while id was being resolved
+} idcache_entry_t;
+
+typedef struct
+{
+    idcache_kind_t kind;
+    guint id;
+} idcache_task_t;
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* statically allocated mutex and condition don't need initialization */
+static GMutex idcache_lock;     // protects entries
+static GCond idcache_resolved;  // signaled when pending entries are resolved
+static GHashTable *idcache_tables[IDCACHE_NUM] = { NULL, NULL };
+
+static mc_idcache_notify_fn idcache_notify = NULL;
+static guint idcache_stamp = 0;
+
+#ifdef IDCACHE_BACKGROUND
+static mc_workpool_t *idcache_pool = NULL;
+static int idcache_pipe[2] = { -1, -1 };
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Resolve id via NSS. Thread-safe if getpwuid_r() and getgrgid_r() are available.
+ *
+ * @param name resolved name or NULL if id is unknown
+ *
+ * @return TRUE if lookup was done, FALSE on error
+ */
+
+static gboolean
+idcache_resolve (idcache_kind_t kind, guint id, const char **name)
+{
+#ifdef IDCACHE_BACKGROUND
+    long size;
+    int ret;
+
+    size = sysconf (kind == IDCACHE_USER ? _SC_GETPW_R_SIZE_MAX : _SC_GETGR_R_SIZE_MAX);
+    if (size <= 0)
+        size = 1024;
+
+    *name = NULL;
+
+    while (TRUE)
+    {
+        char *buf;
+
+        buf = g_malloc ((gsize) size);
+
+        if (kind == IDCACHE_USER)
+        {
+            struct passwd pwd, *result = NULL;
+
+            ret = getpwuid_r ((uid_t) id, &pwd, buf, (size_t) size, &result);
+            if (ret == 0 && result != NULL)
+                *name = g_intern_string (result->pw_name);
+        }
+        else
+        {
+            struct group grp, *result = NULL;
+
+            ret = getgrgid_r ((gid_t) id, &grp, buf, (size_t) size, &result);
+            if (ret == 0 && result != NULL)
+                *name = g_intern_string (result->gr_name);
+        }
+
+        g_free (buf);
+
+        if (ret != ERANGE || size >= IDCACHE_MAX_BUFFER)
+            break;
+
+        size *= 2;
+    }
+
+    // "not found" is reported either as success with NULL result or as one of these errors
+    return (ret == 0 || ret == ENOENT || ret == ESRCH || ret == EBADF || ret == EPERM);
+#else
+    if (kind == IDCACHE_USER)
+    {
+        const struct passwd *pwd;
+
+        pwd = getpwuid ((uid_t) id);
+        *name = pwd == NULL ? NULL : g_intern_string (pwd->pw_name);
+    }
+    else
+    {
+        const struct group *grp;
+
+        grp = getgrgid ((gid_t) id);
+        *name = grp == NULL ? NULL : g_intern_string (grp->gr_name);
+    }
+
+    return TRUE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find entry of id or create a stale one. Must be called with the lock held.
+ */
+
+static idcache_entry_t *
+idcache_lookup (idcache_kind_t kind, guint id)
+{
+    idcache_entry_t *e;
+
+    if (idcache_tables[kind] == NULL)
+        idcache_tables[kind] = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
+    e = (idcache_entry_t *) g_hash_table_lookup (idcache_tables[kind], GUINT_TO_POINTER (id));
+    if (e == NULL)
+    {
+        e = g_new0 (idcache_entry_t, 1);
+        g_hash_table_insert (idcache_tables[kind], GUINT_TO_POINTER (id), e);
+    }
+
+    return e;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Store result of lookup and wake up waiters. Must be called with the lock held.
+ *
+ * @return TRUE if name is changed and the stale one was returned while entry was being resolved
+ */
+
+static gboolean
+idcache_store (idcache_entry_t *e, gboolean ok, const char *name)
+{
+    const gboolean changed = ok && e->name != name;
+    const gboolean notify = e->notify;
+
+    // on error keep the previous name, but try again soon
+    if (changed)
+        e->name = name;
+    e->expires = g_get_monotonic_time ()
+        + (ok && name != NULL ? MC_IDCACHE_TTL : MC_IDCACHE_NEGATIVE_TTL) * G_USEC_PER_SEC;
+    e->pending = FALSE;
+    e->notify = FALSE;
+
+    g_cond_broadcast (&idcache_resolved);
+
+    return notify && changed;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef IDCACHE_BACKGROUND
+static int
+idcache_pipe_callback (int fd, void *info)
+{
+    char buf[64];
+
+    (void) info;
+
+    // one redraw for all names resolved since the previous call
+    while (read (fd, buf, sizeof (buf)) > 0)
+        ;
+
+    idcache_stamp++;
+
+    if (idcache_notify != NULL)
+        idcache_notify ();
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Resolve one id. Runs in a worker thread.
+ */
+
+static void
+idcache_task (gpointer task, gpointer user_data)
+{
+    idcache_task_t *t = (idcache_task_t *) task;
+    const char *name;
+    gboolean ok;
+    gboolean notify;
+
+    (void) user_data;
+
+    ok = idcache_resolve (t->kind, t->id, &name);
+
+    g_mutex_lock (&idcache_lock);
+    notify = idcache_store (idcache_lookup (t->kind, t->id), ok, name);
+    g_mutex_unlock (&idcache_lock);
+
+    // if pipe is full, main loop is going to be woken up anyway
+    if (notify)
+    {
+        MC_UNUSED const ssize_t ret = write (idcache_pipe[1], "", 1);
+    }
+
+    g_free (t);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+idcache_init_background (void)
+{
+    if (idcache_pool != NULL)
+        return TRUE;
+
+    if (pipe (idcache_pipe) != 0)
+        return FALSE;
+
+    (void) fcntl (idcache_pipe[0], F_SETFL, O_NONBLOCK);
+    (void) fcntl (idcache_pipe[1], F_SETFL, O_NONBLOCK);
+    (void) fcntl (idcache_pipe[0], F_SETFD, FD_CLOEXEC);
+    (void) fcntl (idcache_pipe[1], F_SETFD, FD_CLOEXEC);
+
+    add_select_channel (idcache_pipe[0], idcache_pipe_callback, NULL);
+
+    idcache_pool = mc_workpool_new (idcache_task, NULL, IDCACHE_MAX_WORKERS);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+idcache_push (idcache_kind_t kind, guint id)
+{
+    idcache_task_t *t;
+
+    t = g_new (idcache_task_t, 1);
+    t->kind = kind;
+    t->id = id;
+    mc_workpool_push (idcache_pool, t);
+}
+#endif /* IDCACHE_BACKGROUND */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get name of user or group.
+ *
+ * @param wait if FALSE and name is not cached, resolve it in background and return the stale
+ *             name or the number
+ *
+ * @return name. If id is unknown, the number in a static buffer which is overwritten
+ *         by the next call
+ */
+
+static const char *
+idcache_get (idcache_kind_t kind, guint id, gboolean wait)
+{
+    static char ibuf[IDCACHE_NUM][BUF_TINY];
+    idcache_entry_t *e;
+    const char *name;
+    gboolean resolve = FALSE;
+    gboolean push = FALSE;
+
+    g_mutex_lock (&idcache_lock);
+
+    e = idcache_lookup (kind, id);
+
+    if (e->pending && wait)
+        while (e->pending)
+            g_cond_wait (&idcache_resolved, &idcache_lock);
+    else if (!e->pending && e->expires <= g_get_monotonic_time ())
+    {
+        // don't let other callers resolve the same id
+        e->pending = TRUE;
+#ifdef IDCACHE_BACKGROUND
+        push = !wait && idcache_init_background ();
+#endif
+        resolve = !push;
+    }
+
+    // stale value is returned: notify when the entry is resolved
+    if (e->pending && !resolve)
+        e->notify = TRUE;
+
+    name = e->name;
+
+    g_mutex_unlock (&idcache_lock);
+
+    if (resolve)
+    {
+        gboolean ok;
+
+        ok = idcache_resolve (kind, id, &name);
+
+        g_mutex_lock (&idcache_lock);
+        (void) idcache_store (e, ok, name);
+        name = e->name;
+        g_mutex_unlock (&idcache_lock);
+    }
+#ifdef IDCACHE_BACKGROUND
+    else if (push)
+        idcache_push (kind, id);
+#endif
+
+    if (name == NULL)
+    {
+        g_snprintf (ibuf[kind], sizeof (ibuf[kind]), "%u", id);
+        name = ibuf[kind];
+    }
+
+    return name;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get name of user.
+ *
+ * @param uid user id
+ * @param wait if FALSE, don't block on NSS: if name is not cached yet, it is resolved in
+ *             background and the number is returned meanwhile
+ *
+ * @return name of user or number if user is unknown
+ */
+
+const char *
+mc_idcache_get_owner (uid_t uid, gboolean wait)
+{
+    return idcache_get (IDCACHE_USER, (guint) uid, wait);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get name of group.
+ *
+ * @param gid group id
+ * @param wait if FALSE, don't block on NSS: if name is not cached yet, it is resolved in
+ *             background and the number is returned meanwhile
+ *
+ * @return name of group or number if group is unknown
+ */
+
+const char *
+mc_idcache_get_group (gid_t gid, gboolean wait)
+{
+    return idcache_get (IDCACHE_GROUP, (guint) gid, wait);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Resolve names of users and groups in background. Does nothing if NSS is not thread-safe.
+ *
+ * @param uids array of user ids, may contain duplicates
+ * @param gids array of group ids, may contain duplicates
+ * @param len length of arrays
+ */
+
+void
+mc_idcache_prefetch (const uid_t *uids, const gid_t *gids, size_t len)
+{
+#ifdef IDCACHE_BACKGROUND
+    GArray *tasks;
+    gint64 now;
+    size_t i;
+    guint j;
+
+    if (len == 0 || !idcache_init_background ())
+        return;
+
+    tasks = g_array_new (FALSE, FALSE, sizeof (idcache_task_t));
+    now = g_get_monotonic_time ();
+
+    g_mutex_lock (&idcache_lock);
+
+    for (i = 0; i < len; i++)
+    {
+        idcache_task_t t[2] = {
+            { IDCACHE_USER, (guint) uids[i] },
+            { IDCACHE_GROUP, (guint) gids[i] },
+        };
+
+        for (j = 0; j < G_N_ELEMENTS (t); j++)
+        {
+            idcache_entry_t *e;
+
+            e = idcache_lookup (t[j].kind, t[j].id);
+            if (!e->pending && e->expires <= now)
+            {
+                e->pending = TRUE;
+                g_array_append_val (tasks, t[j]);
+            }
+        }
+    }
+
+    g_mutex_unlock (&idcache_lock);
+
+    // push outside of lock: task may be run in this thread if worker cannot be created
+    for (j = 0; j < tasks->len; j++)
+    {
+        const idcache_task_t *t = &g_array_index (tasks, idcache_task_t, j);
+
+        idcache_push (t->kind, t->id);
+    }
+
+    g_array_free (tasks, TRUE);
+#else
+    (void) uids;
+    (void) gids;
+    (void) len;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get stamp which is changed when names requested without waiting are resolved.
+ * Texts built from such names should be rebuilt.
+ */
+
+guint
+mc_idcache_get_stamp (void)
+{
+    return idcache_stamp;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Set function which is called in the main loop when names requested without waiting are
+ * resolved.
+ */
+
+void
+mc_idcache_set_notify (mc_idcache_notify_fn notify)
+{
+    idcache_notify = notify;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for workers and free cache.
+ */
+
+void
+mc_idcache_done (void)
+{
+    int i;
+
+#ifdef IDCACHE_BACKGROUND
+    if (idcache_pool != NULL)
+    {
+        mc_workpool_free (idcache_pool);
+        idcache_pool = NULL;
+
+        delete_select_channel (idcache_pipe[0]);
+        close (idcache_pipe[0]);
+        close (idcache_pipe[1]);
+        idcache_pipe[0] = idcache_pipe[1] = -1;
+    }
+#endif
+
+    for (i = 0; i < IDCACHE_NUM; i++)
+        if (idcache_tables[i] != NULL)
+        {
+            g_hash_table_destroy (idcache_tables[i]);
+            idcache_tables[i] = NULL;
+        }
+
+    idcache_notify = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
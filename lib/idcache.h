@@ -0,0 +1,42 @@
+/** \file lib/idcache.h
+ *  \brief Header: cache of user and group names
+ */
+
+#ifndef MC__IDCACHE_H
+#define MC__IDCACHE_H
+
+#include <sys/types.h>  // uid_t, gid_t
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* time in seconds while the resolved name is valid */
+#define MC_IDCACHE_TTL          600
+
+/* time in seconds while the unknown id is not looked up again */
+#define MC_IDCACHE_NEGATIVE_TTL 60
+
+/* called in the main thread when names requested without waiting are resolved */
+typedef void (*mc_idcache_notify_fn) (void);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+const char *mc_idcache_get_owner (uid_t uid, gboolean wait);
+const char *mc_idcache_get_group (gid_t gid, gboolean wait);
+
+void mc_idcache_prefetch (const uid_t *uids, const gid_t *gids, size_t len);
+guint mc_idcache_get_stamp (void);
+
+void mc_idcache_set_notify (mc_idcache_notify_fn notify);
+void mc_idcache_done (void);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -104,6 +104,9 @@ typedef struct mc_search_struct
 
     // private data
 
+    // data of block where the last match was found by mc_search_run_block()
+    const char *block_data;
+
     struct
     {
         GPtrArray *conditions;
@@ -122,6 +125,30 @@ typedef struct mc_search_struct
     gchar *error_str;
 } mc_search_t;
 
+/* contiguous part of text for mc_search_run_block() */
+typedef struct mc_search_block_struct
+{
+    // public input data
+
+    const char *data;
+    gsize len;
+    // offset of data in the whole text
+    off_t offset;
+    // there is no text after the block
+    gboolean is_last;
+
+    // public output data
+
+    // data before this position isn't needed to continue search in the next block
+    gsize keep;
+
+    // private data
+
+    // copy of data where invalid UTF-8 sequences are replaced, if data isn't valid
+    char *safe_data;
+    gboolean checked;
+} mc_search_block_t;
+
 typedef struct mc_search_type_str_struct
 {
     const char *str;
@@ -150,6 +177,12 @@ gboolean mc_search_prepare (mc_search_t *mc_search);
 gboolean mc_search_run (mc_search_t *mc_search, const void *user_data, off_t start_search,
                         off_t end_search, gsize *found_len);
 
+void mc_search_block_init (mc_search_block_t *block, const char *data, gsize len, off_t offset,
+                           gboolean is_last);
+void mc_search_block_deinit (mc_search_block_t *block);
+gboolean mc_search_run_block (mc_search_t *lc_mc_search, mc_search_block_t *block, gsize start,
+                              gsize *found_len);
+
 gboolean mc_search_is_type_avail (mc_search_type_t search_type);
 
 const mc_search_type_str_t *mc_search_types_list_get (size_t *num);
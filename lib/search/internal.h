@@ -23,6 +23,10 @@ typedef struct mc_search_cond_struct
     GString *upper;
     GString *lower;
     GRegex *regex_handle;
+    GRegexCompileFlags regex_options;
+    GRegex *block_regex_handle;  // multiline copy of regex_handle, created on demand
+    GString *literal;            // plain string to search without regex, or NULL
+    gboolean literal_caseless;   // literal is lowercase and ASCII letters are compared caselessly
     gchar *charset;
 } mc_search_cond_t;
 
@@ -45,6 +49,8 @@ void mc_search__cond_struct_new_init_regex (const char *charset, mc_search_t *lc
                                             mc_search_cond_t *mc_search_cond);
 gboolean mc_search__run_regex (mc_search_t *lc_mc_search, const void *user_data, off_t start_search,
                                off_t end_search, gsize *found_len);
+gboolean mc_search__run_regex_block (mc_search_t *lc_mc_search, mc_search_block_t *block,
+                                     gsize start, gsize *found_len);
 GString *mc_search_regex_prepare_replace_str (mc_search_t *lc_mc_search, GString *replace_str);
 
 /* search/normal.c : */
@@ -54,6 +60,10 @@ void mc_search__cond_struct_new_init_normal (const char *charset, mc_search_t *l
 gboolean mc_search__run_normal (mc_search_t *lc_mc_search, const void *user_data,
                                 off_t start_search, off_t end_search, gsize *found_len);
 GString *mc_search_normal_prepare_replace_str (mc_search_t *lc_mc_search, GString *replace_str);
+gboolean mc_search__normal_find_literal (const mc_search_cond_t *mc_search_cond, const char *str,
+                                         gsize len, gsize *found_pos);
+gsize mc_search__normal_literal_partial (const mc_search_cond_t *mc_search_cond, const char *str,
+                                         gsize len);
 
 /* search/glob.c : */
 
@@ -26,6 +26,8 @@
 
 #include <config.h>
 
+#include <string.h>
+
 #include "lib/global.h"
 #include "lib/strutil.h"
 #include "lib/search.h"
@@ -78,6 +80,119 @@ mc_search__normal_translate_to_regex (GString *str)
         }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remember pattern as plain string if it can be searched without regex with the same result.
+ * Whole words need lookarounds, and search in lines never finds newline in the middle of
+ * pattern. Caseless search is done for ASCII only: folding of other letters depends on charset.
+ * In UTF-8 mode, regex folds 'k' and 's' with KELVIN SIGN and LATIN SMALL LETTER LONG S, so
+ * they are excluded too.
+ */
+
+static void
+mc_search__normal_init_literal (const char *charset, const mc_search_t *lc_mc_search,
+                                mc_search_cond_t *mc_search_cond)
+{
+    const GString *str = mc_search_cond->str;
+    const gboolean is_utf8 = str_isutf8 (charset) && mc_global.utf8_display;
+    gsize i;
+
+    if (lc_mc_search->whole_words || str->len == 0)
+        return;
+
+    for (i = 0; i < str->len; i++)
+    {
+        const unsigned char c = (unsigned char) str->str[i];
+
+        if (c == '\0' || c == '\n')
+            return;
+
+        if (!lc_mc_search->is_case_sensitive
+            && (c >= 0x80 || (is_utf8 && strchr ("KSks", c) != NULL)))
+            return;
+    }
+
+    // invalid pattern is handled by regex
+    if (is_utf8 && !g_utf8_validate (str->str, (gssize) str->len, NULL))
+        return;
+
+    mc_search_cond->literal = mc_g_string_dup (str);
+    mc_search_cond->literal_caseless = !lc_mc_search->is_case_sensitive;
+
+    if (mc_search_cond->literal_caseless)
+        for (i = 0; i < mc_search_cond->literal->len; i++)
+            mc_search_cond->literal->str[i] = g_ascii_tolower (mc_search_cond->literal->str[i]);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+mc_search__normal_memmem (const char *str, gsize len, const GString *literal)
+{
+#ifdef HAVE_MEMMEM
+    return (const char *) memmem (str, len, literal->str, literal->len);
+#else
+    const char *p = str;
+    const char *last = str + len - literal->len;
+
+    while (p <= last && (p = memchr (p, literal->str[0], (gsize) (last - p) + 1)) != NULL)
+    {
+        if (memcmp (p + 1, literal->str + 1, literal->len - 1) == 0)
+            return p;
+        p++;
+    }
+
+    return NULL;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find lowercase ASCII @literal ignoring case. Candidates are found with memchr() for both cases
+ * of the first byte, every byte of @str is scanned by memchr() at most twice.
+ */
+
+static const char *
+mc_search__normal_memmem_caseless (const char *str, gsize len, const GString *literal)
+{
+    const char *last = str + len - literal->len;
+    const char lower = literal->str[0];
+    const char upper = g_ascii_toupper (lower);
+    const char *found_lower, *found_upper = NULL;
+    const char *p = str;
+
+    found_lower = memchr (str, lower, (gsize) (last - str) + 1);
+    if (upper != lower)
+        found_upper = memchr (str, upper, (gsize) (last - str) + 1);
+
+    while (p <= last)
+    {
+        const char *c;
+
+        if (found_lower != NULL && found_lower < p)
+            found_lower = memchr (p, lower, (gsize) (last - p) + 1);
+        if (found_upper != NULL && found_upper < p)
+            found_upper = memchr (p, upper, (gsize) (last - p) + 1);
+
+        if (found_lower == NULL)
+            c = found_upper;
+        else if (found_upper == NULL)
+            c = found_lower;
+        else
+            c = MIN (found_lower, found_upper);
+
+        if (c == NULL)
+            break;
+
+        if (g_ascii_strncasecmp (c + 1, literal->str + 1, literal->len - 1) == 0)
+            return c;
+
+        p = c + 1;
+    }
+
+    return NULL;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -86,6 +201,7 @@ void
 mc_search__cond_struct_new_init_normal (const char *charset, mc_search_t *lc_mc_search,
                                         mc_search_cond_t *mc_search_cond)
 {
+    mc_search__normal_init_literal (charset, lc_mc_search, mc_search_cond);
     mc_search__normal_translate_to_regex (mc_search_cond->str);
     mc_search__cond_struct_new_init_regex (charset, lc_mc_search, mc_search_cond);
 }
@@ -100,6 +216,72 @@ mc_search__run_normal (mc_search_t *lc_mc_search, const void *user_data, off_t s
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Find plain string of search condition.
+ *
+ * @param mc_search_cond search condition with non-NULL literal
+ * @param str text, it may contain NULs
+ * @param len length of @str
+ * @param found_pos offset of the found string in @str
+ *
+ * @return TRUE if string is found, FALSE otherwise
+ */
+
+gboolean
+mc_search__normal_find_literal (const mc_search_cond_t *mc_search_cond, const char *str,
+                                gsize len, gsize *found_pos)
+{
+    const GString *literal = mc_search_cond->literal;
+    const char *p;
+
+    if (literal->len > len)
+        return FALSE;
+
+    if (mc_search_cond->literal_caseless)
+        p = mc_search__normal_memmem_caseless (str, len, literal);
+    else
+        p = mc_search__normal_memmem (str, len, literal);
+
+    if (p == NULL)
+        return FALSE;
+
+    *found_pos = (gsize) (p - str);
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get length of the longest end of text which is a beginning of plain string of search
+ * condition, i.e. of match which may continue after the text.
+ *
+ * @param mc_search_cond search condition with non-NULL literal
+ * @param str text, it may contain NULs
+ * @param len length of @str
+ *
+ * @return length of partial match, 0 if there is no one
+ */
+
+gsize
+mc_search__normal_literal_partial (const mc_search_cond_t *mc_search_cond, const char *str,
+                                   gsize len)
+{
+    const GString *literal = mc_search_cond->literal;
+    gsize n;
+
+    for (n = MIN (len, literal->len - 1); n > 0; n--)
+    {
+        const char *p = str + len - n;
+
+        if (mc_search_cond->literal_caseless ? g_ascii_strncasecmp (p, literal->str, n) == 0
+                                             : memcmp (p, literal->str, n) == 0)
+            break;
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 GString *
 mc_search_normal_prepare_replace_str (mc_search_t *lc_mc_search, GString *replace_str)
 {
@@ -269,27 +269,12 @@ mc_search__cond_struct_new_regex_ci_str (const char *charset, const GString *ast
 
 /* --------------------------------------------------------------------------------------------- */
 
-/* A thin wrapper above g_regex_match_full that makes sure the string passed
- * to it is valid UTF-8 (unless G_REGEX_RAW compile flag was set), as it is a
- * requirement by glib and it might crash otherwise. See: mc ticket 3449.
+/* Make a copy of string where invalid UTF-8 sequences are replaced with NULs.
  * Be careful: there might be embedded NULs in the strings. */
-static gboolean
-mc_search__g_regex_match_full_safe (const GRegex *regex, const gchar *string, gssize string_len,
-                                    gint start_position, GRegexMatchFlags match_options,
-                                    GMatchInfo **match_info, GError **error)
+static char *
+mc_search__g_regex_string_safe_dup (const gchar *string, gsize string_len)
 {
     char *string_safe, *p, *end;
-    gboolean ret;
-
-    if (string_len < 0)
-        string_len = strlen (string);
-
-    if ((g_regex_get_compile_flags (regex) & G_REGEX_RAW)
-        || g_utf8_validate (string, string_len, NULL))
-    {
-        return g_regex_match_full (regex, string, string_len, start_position, match_options,
-                                   match_info, error);
-    }
 
     // Correctly handle embedded NULs while copying
     p = string_safe = g_malloc (string_len + 1);
@@ -313,6 +298,35 @@ mc_search__g_regex_match_full_safe (const GRegex *regex, const gchar *string, gs
         }
     }
 
+    return string_safe;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* A thin wrapper above g_regex_match_full that makes sure the string passed
+ * to it is valid UTF-8 (unless G_REGEX_RAW compile flag was set), as it is a
+ * requirement by glib and it might crash otherwise. See: mc ticket 3449.
+ * Be careful: there might be embedded NULs in the strings. */
+static gboolean
+mc_search__g_regex_match_full_safe (const GRegex *regex, const gchar *string, gssize string_len,
+                                    gint start_position, GRegexMatchFlags match_options,
+                                    GMatchInfo **match_info, GError **error)
+{
+    char *string_safe;
+    gboolean ret;
+
+    if (string_len < 0)
+        string_len = strlen (string);
+
+    if ((g_regex_get_compile_flags (regex) & G_REGEX_RAW)
+        || g_utf8_validate (string, string_len, NULL))
+    {
+        return g_regex_match_full (regex, string, string_len, start_position, match_options,
+                                   match_info, error);
+    }
+
+    string_safe = mc_search__g_regex_string_safe_dup (string, (gsize) string_len);
+
     ret = g_regex_match_full (regex, string_safe, string_len, start_position, match_options,
                               match_info, error);
     g_free (string_safe);
@@ -321,6 +335,17 @@ mc_search__g_regex_match_full_safe (const GRegex *regex, const gchar *string, gs
 
 /* --------------------------------------------------------------------------------------------- */
 
+static void
+mc_search__regex_set_gerror (mc_search_t *lc_mc_search, mc_search_error_t code, GError *mcerror)
+{
+    lc_mc_search->error = code;
+    g_free (lc_mc_search->error_str);
+    lc_mc_search->error_str = str_conv_gerror_message (mcerror, _ ("Regular expression error"));
+    g_error_free (mcerror);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static mc_search__found_cond_t
 mc_search__regex_found_cond_one (mc_search_t *lc_mc_search, GRegex *regex, GString *search_str)
 {
@@ -334,11 +359,7 @@ mc_search__regex_found_cond_one (mc_search_t *lc_mc_search, GRegex *regex, GStri
         lc_mc_search->regex_match_info = NULL;
         if (mcerror != NULL)
         {
-            lc_mc_search->error = MC_SEARCH_E_REGEX;
-            g_free (lc_mc_search->error_str);
-            lc_mc_search->error_str =
-                str_conv_gerror_message (mcerror, _ ("Regular expression error"));
-            g_error_free (mcerror);
+            mc_search__regex_set_gerror (lc_mc_search, MC_SEARCH_E_REGEX, mcerror);
             return COND__FOUND_ERROR;
         }
         return COND__NOT_FOUND;
@@ -351,7 +372,8 @@ mc_search__regex_found_cond_one (mc_search_t *lc_mc_search, GRegex *regex, GStri
 /* --------------------------------------------------------------------------------------------- */
 
 static mc_search__found_cond_t
-mc_search__regex_found_cond (mc_search_t *lc_mc_search, GString *search_str)
+mc_search__regex_found_cond (mc_search_t *lc_mc_search, GString *search_str, gint *start_pos,
+                             gint *end_pos)
 {
     gsize loop1;
 
@@ -363,11 +385,27 @@ mc_search__regex_found_cond (mc_search_t *lc_mc_search, GString *search_str)
         mc_search_cond =
             (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->prepared.conditions, loop1);
 
+        if (mc_search_cond->literal != NULL)
+        {
+            gsize pos;
+
+            if (!mc_search__normal_find_literal (mc_search_cond, search_str->str, search_str->len,
+                                                 &pos))
+                continue;
+
+            lc_mc_search->num_results = 1;
+            *start_pos = (gint) pos;
+            *end_pos = (gint) (pos + mc_search_cond->literal->len);
+            return COND__FOUND_OK;
+        }
+
         if (!mc_search_cond->regex_handle)
             continue;
 
         ret = mc_search__regex_found_cond_one (lc_mc_search, mc_search_cond->regex_handle,
                                                search_str);
+        if (ret == COND__FOUND_OK)
+            g_match_info_fetch_pos (lc_mc_search->regex_match_info, 0, start_pos, end_pos);
         if (ret != COND__NOT_FOUND)
             return ret;
     }
@@ -430,6 +468,9 @@ mc_search_regex__get_token_by_num (const mc_search_t *lc_mc_search, gsize lc_ind
     if (fnd_end == fnd_start)
         return g_strdup ("");
 
+    if (lc_mc_search->block_data != NULL)
+        return g_strndup (lc_mc_search->block_data + fnd_start, fnd_end - fnd_start);
+
     return g_strndup (lc_mc_search->regex_buffer->str + fnd_start, fnd_end - fnd_start);
 }
 
@@ -766,6 +807,64 @@ mc_search_regex__process_escape_sequence (GString *dest_str, const char *from, g
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get regex to search in block of text. Unlike search in one line, '^' and '$' match at every
+ * line and '.' doesn't match newline.
+ */
+
+static GRegex *
+mc_search__regex_get_block_handle (mc_search_t *lc_mc_search, mc_search_cond_t *mc_search_cond)
+{
+    if (mc_search_cond->block_regex_handle == NULL && mc_search_cond->regex_handle != NULL)
+    {
+        GRegexCompileFlags g_regex_options;
+        GError *mcerror = NULL;
+
+        g_regex_options = (mc_search_cond->regex_options & ~G_REGEX_DOTALL) | G_REGEX_MULTILINE;
+        mc_search_cond->block_regex_handle =
+            g_regex_new (mc_search_cond->str->str, g_regex_options, 0, &mcerror);
+
+        if (mcerror != NULL)
+            mc_search__regex_set_gerror (lc_mc_search, MC_SEARCH_E_REGEX_COMPILE, mcerror);
+    }
+
+    return mc_search_cond->block_regex_handle;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get data of block which can be passed to regex. UTF-8 validity is checked once per block.
+ */
+
+static const char *
+mc_search__regex_get_block_data (mc_search_block_t *block, const GRegex *regex)
+{
+    if ((g_regex_get_compile_flags (regex) & G_REGEX_RAW) != 0)
+        return block->data;
+
+    if (!block->checked)
+    {
+        block->checked = TRUE;
+
+        if (!g_utf8_validate (block->data, (gssize) block->len, NULL))
+            block->safe_data = mc_search__g_regex_string_safe_dup (block->data, block->len);
+    }
+
+    return (block->safe_data != NULL ? block->safe_data : block->data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gsize
+mc_search__regex_block_get_bol (const mc_search_block_t *block, gsize start, gsize pos)
+{
+    while (pos > start && block->data[pos - 1] != '\n')
+        pos--;
+
+    return pos;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -806,6 +905,7 @@ mc_search__cond_struct_new_init_regex (const char *charset, mc_search_t *lc_mc_s
             }
         }
 
+        mc_search_cond->regex_options = g_regex_options;
         mc_search_cond->regex_handle =
             g_regex_new (mc_search_cond->str->str, g_regex_options, 0, &mcerror);
 
@@ -840,6 +940,8 @@ mc_search__run_regex (mc_search_t *lc_mc_search, const void *user_data, off_t st
     virtual_pos = current_pos = start_search;
     while (virtual_pos <= end_search)
     {
+        gint start_pos, end_pos;
+
         g_string_set_size (lc_mc_search->regex_buffer, 0);
         lc_mc_search->start_buffer = current_pos;
 
@@ -895,18 +997,14 @@ mc_search__run_regex (mc_search_t *lc_mc_search, const void *user_data, off_t st
             virtual_pos = current_pos;
         }
 
-        switch (mc_search__regex_found_cond (lc_mc_search, lc_mc_search->regex_buffer))
+        switch (mc_search__regex_found_cond (lc_mc_search, lc_mc_search->regex_buffer, &start_pos,
+                                             &end_pos))
         {
         case COND__FOUND_OK:
-        {
-            gint start_pos, end_pos;
-
-            g_match_info_fetch_pos (lc_mc_search->regex_match_info, 0, &start_pos, &end_pos);
             if (found_len != NULL)
                 *found_len = end_pos - start_pos;
             lc_mc_search->normal_offset = lc_mc_search->start_buffer + start_pos;
             return TRUE;
-        }
         case COND__NOT_ALL_FOUND:
             break;
         default:
@@ -932,6 +1030,150 @@ mc_search__run_regex (mc_search_t *lc_mc_search, const void *user_data, off_t st
     return FALSE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search in block of text. The whole block is passed to regex at once, so the pattern may match
+ * several lines.
+ *
+ * If there is text after the block, the end of block isn't treated as the end of line. Match
+ * which reaches the end of block or partial match at the end of block means that match may
+ * continue in the next block: in this case nothing is found and block->keep points to the line
+ * where the match starts. Plain strings of normal search are found without regex, such match
+ * is complete even if it reaches the end of block.
+ */
+
+gboolean
+mc_search__run_regex_block (mc_search_t *lc_mc_search, mc_search_block_t *block, gsize start,
+                            gsize *found_len)
+{
+    GRegexMatchFlags match_options = G_REGEX_MATCH_NEWLINE_ANY;
+    GMatchInfo *found_info = NULL;
+    gboolean found = FALSE;
+    gint found_start = 0, found_end = 0;
+    gsize partial_start;
+    gsize loop1;
+
+    if (!block->is_last)
+        match_options |= G_REGEX_MATCH_PARTIAL_SOFT | G_REGEX_MATCH_NOTEOL;
+
+    start = MIN (start, block->len);
+    partial_start = block->len;
+
+    for (loop1 = 0; loop1 < lc_mc_search->prepared.conditions->len; loop1++)
+    {
+        mc_search_cond_t *mc_search_cond;
+        GRegex *regex;
+        GMatchInfo *match_info = NULL;
+        GError *mcerror = NULL;
+
+        mc_search_cond =
+            (mc_search_cond_t *) g_ptr_array_index (lc_mc_search->prepared.conditions, loop1);
+
+        if (mc_search_cond->literal != NULL)
+        {
+            gsize pos;
+
+            if (mc_search__normal_find_literal (mc_search_cond, block->data + start,
+                                                block->len - start, &pos))
+            {
+                pos += start;
+                if (!found || (gint) pos < found_start)
+                {
+                    g_match_info_free (found_info);
+                    found_info = NULL;
+                    found = TRUE;
+                    found_start = (gint) pos;
+                    found_end = (gint) (pos + mc_search_cond->literal->len);
+                }
+            }
+            else if (!block->is_last)
+            {
+                gsize n;
+
+                n = mc_search__normal_literal_partial (mc_search_cond, block->data + start,
+                                                       block->len - start);
+                partial_start = MIN (partial_start, block->len - n);
+            }
+            continue;
+        }
+
+        regex = mc_search__regex_get_block_handle (lc_mc_search, mc_search_cond);
+        if (regex == NULL)
+        {
+            if (lc_mc_search->error != MC_SEARCH_E_OK)
+            {
+                g_match_info_free (found_info);
+                return FALSE;
+            }
+            continue;
+        }
+
+        if (g_regex_match_full (regex, mc_search__regex_get_block_data (block, regex),
+                                (gssize) block->len, (gint) start, match_options, &match_info,
+                                &mcerror))
+        {
+            gint start_pos, end_pos;
+
+            g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+
+            // in case of several charsets, the leftmost match wins
+            if (!found || start_pos < found_start)
+            {
+                g_match_info_free (found_info);
+                found_info = match_info;
+                match_info = NULL;
+                found = TRUE;
+                found_start = start_pos;
+                found_end = end_pos;
+            }
+        }
+        else if (mcerror != NULL)
+        {
+            g_match_info_free (match_info);
+            g_match_info_free (found_info);
+            mc_search__regex_set_gerror (lc_mc_search, MC_SEARCH_E_REGEX, mcerror);
+            return FALSE;
+        }
+        else if (g_match_info_is_partial_match (match_info))
+            partial_start = start;  // position of partial match is unknown
+
+        g_match_info_free (match_info);
+    }
+
+    if (found_info != NULL && !block->is_last && (gsize) found_end == block->len)
+    {
+        // match may be longer
+        g_match_info_free (found_info);
+        found_info = NULL;
+        found = FALSE;
+        block->keep = mc_search__regex_block_get_bol (block, start, (gsize) found_start);
+    }
+    else if (found)
+        block->keep = mc_search__regex_block_get_bol (block, start, (gsize) found_start);
+    else if (block->is_last)
+        block->keep = block->len;
+    else
+        block->keep = mc_search__regex_block_get_bol (block, start, partial_start);
+
+    if (!found)
+    {
+        MC_PTR_FREE (lc_mc_search->error_str);
+        lc_mc_search->error = MC_SEARCH_E_NOTFOUND;
+        return FALSE;
+    }
+
+    // plain string is found without match info
+    lc_mc_search->regex_match_info = found_info;
+    lc_mc_search->num_results = found_info != NULL ? g_match_info_get_match_count (found_info) : 1;
+    lc_mc_search->block_data = block->data;
+    lc_mc_search->start_buffer = block->offset;
+    lc_mc_search->normal_offset = block->offset + found_start;
+    if (found_len != NULL)
+        *found_len = (gsize) (found_end - found_start);
+
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 GString *
@@ -103,12 +103,18 @@ mc_search__cond_struct_free (gpointer data)
     if (mc_search_cond->lower != NULL)
         g_string_free (mc_search_cond->lower, TRUE);
 
+    if (mc_search_cond->literal != NULL)
+        g_string_free (mc_search_cond->literal, TRUE);
+
     g_string_free (mc_search_cond->str, TRUE);
     g_free (mc_search_cond->charset);
 
     if (mc_search_cond->regex_handle != NULL)
         g_regex_unref (mc_search_cond->regex_handle);
 
+    if (mc_search_cond->block_regex_handle != NULL)
+        g_regex_unref (mc_search_cond->block_regex_handle);
+
     g_free (mc_search_cond);
 }
 
@@ -264,6 +270,8 @@ mc_search_run (mc_search_t *lc_mc_search, const void *user_data, off_t start_sea
         lc_mc_search->regex_match_info = NULL;
     }
 
+    lc_mc_search->block_data = NULL;
+
     mc_search_set_error (lc_mc_search, MC_SEARCH_E_OK, NULL);
 
     if (!mc_search_prepare (lc_mc_search))
@@ -289,6 +297,91 @@ mc_search_run (mc_search_t *lc_mc_search, const void *user_data, off_t start_sea
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Init block of text for mc_search_run_block().
+ *
+ * @param block block to init
+ * @param data text. It must be kept unchanged until the block is deinitialized
+ * @param len length of @data
+ * @param offset offset of @data in the whole text
+ * @param is_last TRUE if there is no text after @data
+ */
+
+void
+mc_search_block_init (mc_search_block_t *block, const char *data, gsize len, off_t offset,
+                      gboolean is_last)
+{
+    block->data = data;
+    block->len = len;
+    block->offset = offset;
+    block->is_last = is_last;
+    block->keep = len;
+    block->safe_data = NULL;
+    block->checked = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+mc_search_block_deinit (mc_search_block_t *block)
+{
+    MC_PTR_FREE (block->safe_data);
+    block->checked = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search in a block of text at once.
+ *
+ * Unlike mc_search_run(), the text isn't split to lines: the pattern may match several lines,
+ * '^' and '$' match at the beginning and at the end of every line, '.' doesn't match newline.
+ *
+ * If text is split to several blocks, matches which may continue in the next block aren't
+ * returned. In this case, and if nothing is found, block->keep points to the data which
+ * should be searched again together with the next block.
+ *
+ * Returns TRUE if found. Offset of match in the whole text is in lc_mc_search->normal_offset.
+ *
+ * Returns FALSE if not found. In this case, lc_mc_search->error reveals the reason
+ * like for mc_search_run().
+ *
+ * @param lc_mc_search search handle
+ * @param block block of text
+ * @param start position in @block where to start search. Should be the beginning of line
+ * @param found_len length of match
+ */
+
+gboolean
+mc_search_run_block (mc_search_t *lc_mc_search, mc_search_block_t *block, gsize start,
+                     gsize *found_len)
+{
+    if (lc_mc_search == NULL || block == NULL || block->data == NULL)
+        return FALSE;
+
+    if (!mc_search_is_type_avail (lc_mc_search->search_type))
+    {
+        mc_search_set_error (lc_mc_search, MC_SEARCH_E_INPUT, "%s", _ (STR_E_UNKNOWN_TYPE));
+        return FALSE;
+    }
+
+    if (lc_mc_search->regex_match_info != NULL)
+    {
+        g_match_info_free (lc_mc_search->regex_match_info);
+        lc_mc_search->regex_match_info = NULL;
+    }
+
+    lc_mc_search->block_data = NULL;
+
+    mc_search_set_error (lc_mc_search, MC_SEARCH_E_OK, NULL);
+
+    if (!mc_search_prepare (lc_mc_search))
+        return FALSE;
+
+    // all search types are translated to regex
+    return mc_search__run_regex_block (lc_mc_search, block, start, found_len);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 gboolean
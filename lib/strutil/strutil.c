@@ -927,6 +927,14 @@ str_release_key (char *key, gboolean case_sen)
 
 /* --------------------------------------------------------------------------------------------- */
 
+gboolean
+str_key_is_bytewise (gboolean case_sen)
+{
+    return used_class.key_is_bytewise (case_sen);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 void
 str_msg_term_size (const char *text, int *lines, int *columns)
 {
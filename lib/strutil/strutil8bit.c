@@ -810,6 +810,14 @@ str_8bit_release_key (char *key, gboolean case_sen)
         g_free (key);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+str_8bit_key_is_bytewise (gboolean case_sen)
+{
+    return case_sen;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -866,6 +874,7 @@ str_8bit_init (void)
     result.create_key_for_filename = str_8bit_create_key;
     result.key_collate = str_8bit_key_collate;
     result.release_key = str_8bit_release_key;
+    result.key_is_bytewise = str_8bit_key_is_bytewise;
 
     return result;
 }
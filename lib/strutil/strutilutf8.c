@@ -1475,6 +1475,15 @@ str_utf8_release_key (char *key, gboolean case_sen)
     g_free (key);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+str_utf8_key_is_bytewise (gboolean case_sen)
+{
+    (void) case_sen;
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -1537,6 +1546,7 @@ str_utf8_init (void)
 #endif
     result.key_collate = str_utf8_key_collate;
     result.release_key = str_utf8_release_key;
+    result.key_is_bytewise = str_utf8_key_is_bytewise;
 
     return result;
 }
@@ -59,6 +59,7 @@
 
 #include "lib/global.h"
 
+#include "lib/idcache.h"  // mc_idcache_get_owner(), mc_idcache_get_group()
 #include "lib/unixcompat.h"
 #include "lib/vfs/vfs.h"  // VFS_ENCODING_PREFIX
 #include "lib/strutil.h"  // str_move(), str_tokenize()
@@ -73,17 +74,8 @@ struct sigaction startup_handler;
 
 /*** file scope macro definitions ****************************************************************/
 
-#define UID_CACHE_SIZE 200
-#define GID_CACHE_SIZE 30
-
 /*** file scope type declarations ****************************************************************/
 
-typedef struct
-{
-    int index;
-    char *string;
-} int_cache;
-
 typedef enum
 {
     FORK_ERROR = -1,
@@ -102,37 +94,10 @@ typedef struct
 
 /*** file scope variables ************************************************************************/
 
-static int_cache uid_cache[UID_CACHE_SIZE];
-static int_cache gid_cache[GID_CACHE_SIZE];
-
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
 
-static char *
-i_cache_match (int id, int_cache *cache, int size)
-{
-    int i;
-
-    for (i = 0; i < size; i++)
-        if (cache[i].index == id)
-            return cache[i].string;
-    return 0;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
-static void
-i_cache_add (int id, int_cache *cache, int size, char *text, int *last)
-{
-    g_free (cache[*last].string);
-    cache[*last].string = g_strdup (text);
-    cache[*last].index = id;
-    *last = ((*last) + 1) % size;
-}
-
-/* --------------------------------------------------------------------------------------------- */
-
 static my_fork_state_t
 my_fork_state (void)
 {
@@ -267,27 +232,7 @@ mc_pread_stream (mc_pipe_stream_t *ps, const fd_set *fds)
 const char *
 get_owner (uid_t uid)
 {
-    struct passwd *pwd;
-    char *name;
-    static uid_t uid_last;
-
-    name = i_cache_match ((int) uid, uid_cache, UID_CACHE_SIZE);
-    if (name != NULL)
-        return name;
-
-    pwd = getpwuid (uid);
-    if (pwd != NULL)
-    {
-        i_cache_add ((int) uid, uid_cache, UID_CACHE_SIZE, pwd->pw_name, (int *) &uid_last);
-        return pwd->pw_name;
-    }
-    else
-    {
-        static char ibuf[10];
-
-        g_snprintf (ibuf, sizeof (ibuf), "%d", (int) uid);
-        return ibuf;
-    }
+    return mc_idcache_get_owner (uid, TRUE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -295,27 +240,7 @@ get_owner (uid_t uid)
 const char *
 get_group (gid_t gid)
 {
-    struct group *grp;
-    char *name;
-    static gid_t gid_last;
-
-    name = i_cache_match ((int) gid, gid_cache, GID_CACHE_SIZE);
-    if (name != NULL)
-        return name;
-
-    grp = getgrgid (gid);
-    if (grp != NULL)
-    {
-        i_cache_add ((int) gid, gid_cache, GID_CACHE_SIZE, grp->gr_name, (int *) &gid_last);
-        return grp->gr_name;
-    }
-    else
-    {
-        static char gbuf[10];
-
-        g_snprintf (gbuf, sizeof (gbuf), "%d", (int) gid);
-        return gbuf;
-    }
+    return mc_idcache_get_group (gid, TRUE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
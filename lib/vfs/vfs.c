@@ -53,7 +53,11 @@
 #ifdef HAVE_SYS_IOCTL_H
 #include <sys/ioctl.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
 #endif
+#endif
+#include <unistd.h>  // copy_file_range()
 
 #include "lib/global.h"
 #include "lib/strutil.h"
@@ -760,3 +764,82 @@ vfs_clone_file (int dest_vfs_fd, int src_vfs_fd)
 }
 
 /* --------------------------------------------------------------------------------------------- */
+/**
+ * Get descriptor of local file opened via VFS.
+ *
+ * @param vfs_fd VFS file descriptor
+ *
+ * @return file descriptor or -1 if file is not local
+ */
+
+int
+vfs_get_local_fd (int vfs_fd)
+{
+    void *fd = NULL;
+    struct vfs_class *vclass;
+
+    vclass = vfs_class_find_by_handle (vfs_fd, &fd);
+    if (vclass == NULL || (vclass->flags & VFSF_LOCAL) == 0 || fd == NULL)
+        return (-1);
+
+    return *(int *) fd;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy data between local files in kernel, without userspace buffer.
+ * Data is copied from the current offset of source file to the current offset of target file,
+ * both offsets are advanced.
+ *
+ * @param dest_vfs_fd target file descriptor
+ * @param src_vfs_fd source file descriptor
+ * @param count max number of bytes to copy
+ *
+ * @return number of copied bytes, 0 at the end of source file, -1 on error.
+ *         If files cannot be copied in kernel, errno is set to ENOTSUP.
+ */
+
+ssize_t
+vfs_copy_file_chunk (int dest_vfs_fd, int src_vfs_fd, size_t count)
+{
+#if defined(HAVE_COPY_FILE_RANGE) || (defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H))
+    int dest_fd, src_fd;
+    ssize_t n;
+
+    dest_fd = vfs_get_local_fd (dest_vfs_fd);
+    src_fd = vfs_get_local_fd (src_vfs_fd);
+    if (dest_fd == -1 || src_fd == -1)
+    {
+        errno = ENOTSUP;
+        return (-1);
+    }
+
+#ifdef HAVE_COPY_FILE_RANGE
+    n = copy_file_range (src_fd, NULL, dest_fd, NULL, count, 0);
+    if (n >= 0)
+        return n;
+    // target file opened with O_APPEND, special files, old kernel...
+    if (errno != EXDEV && errno != EINVAL && errno != EBADF && errno != ENOSYS
+        && errno != EOPNOTSUPP && errno != ETXTBSY)
+        return (-1);
+#endif
+
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+    n = sendfile (dest_fd, src_fd, NULL, count);
+    if (n >= 0)
+        return n;
+    if (errno != EINVAL && errno != ENOSYS)
+        return (-1);
+#endif
+
+#else
+    (void) dest_vfs_fd;
+    (void) src_vfs_fd;
+    (void) count;
+#endif
+
+    errno = ENOTSUP;
+    return (-1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -302,7 +302,9 @@ char *vfs_get_cwd (void);
 
 int vfs_preallocate (int dest_desc, off_t src_fsize, off_t dest_fsize);
 
+int vfs_get_local_fd (int vfs_fd);
 int vfs_clone_file (int dest_vfs_fd, int src_vfs_fd);
+ssize_t vfs_copy_file_chunk (int dest_vfs_fd, int src_vfs_fd, size_t count);
 
 /**
  * Interface functions described in interface.c
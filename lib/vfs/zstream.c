@@ -0,0 +1,925 @@
+/*
+   Virtual File System: reading of compressed archives
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ * \brief Source: Virtual File System: reading of compressed archives
+ *
+ * Archives compressed with gzip, bzip2, xz or zstd are decompressed on the fly while they are
+ * read, so tarfs and cpiofs don't need a temporary copy of the whole decompressed archive.
+ * The stream is linear: seeking forward decompresses and drops data. The last decompressed block
+ * is kept, so short backward seeks made by archive parsers are cheap. The first seek before
+ * the kept block restarts decompression from the beginning of the archive, and since then
+ * the first ZSTREAM_SPILL_MAX bytes of decompressed data are copied to a temporary file, so
+ * further backward seeks into them are read from it. Seeks before the kept block beyond that
+ * restart decompression.
+ *
+ * Other compression formats, or those whose library is not available, are decompressed
+ * by external programs via sfs as before.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_BZLIB
+#include <bzlib.h>
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "lib/global.h"
+#include "lib/util.h"  // get_compression_type()
+
+#include "vfs.h"
+
+#include "zstream.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* size of buffer for compressed data */
+#define ZSTREAM_IN_SIZE  (64 * 1024)
+
+/* max size of data decompressed at once */
+#define ZSTREAM_OUT_SIZE (64 * 1024)
+
+/* size of previously read data kept for backward seeks */
+#define ZSTREAM_HISTORY  (64 * 1024)
+
+/* Configurable: max size of decompressed data copied to temporary file for backward seeks */
+#ifndef ZSTREAM_SPILL_MAX
+#define ZSTREAM_SPILL_MAX ((off_t) 64 * 1024 * 1024)
+#endif
+
+/*** file scope type declarations ****************************************************************/
+
+typedef enum
+{
+    ZSTREAM_OK = 0,  // continue decompression
+    ZSTREAM_END,     // end of compressed data
+    ZSTREAM_ERROR    // corrupted data
+} zstream_status_t;
+
+typedef struct
+{
+    gboolean (*init) (vfs_zstream_t *zs);
+    // decompress input buffer of stream to @out and advance it
+    zstream_status_t (*decode) (vfs_zstream_t *zs, guint8 **out, size_t *out_left);
+    void (*done) (vfs_zstream_t *zs);
+} zstream_codec_t;
+
+struct vfs_zstream_t
+{
+    int fd;
+    const zstream_codec_t *codec;  // NULL if data are read as is
+    void *state;                   // state of decompressor
+
+    guint8 *in;             // compressed data
+    const guint8 *in_next;  // first unused byte of compressed data
+    size_t in_left;         // number of unused bytes of compressed data
+    gboolean in_eof;        // all compressed data are read
+
+    guint8 *out;       // decompressed data
+    off_t out_pos;     // position of decompressed data in stream
+    size_t out_len;    // length of decompressed data
+    off_t pos;         // current position in stream
+    gboolean end;      // all data are decompressed
+    gboolean restart;  // decompressor is restarted to read concatenated stream
+
+    int spill_fd;     // temporary file with the first decompressed data, or -1
+    off_t spill_len;  // length of data in temporary file
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_ZLIB
+static gboolean
+zstream_gzip_init (vfs_zstream_t *zs)
+{
+    z_stream *z;
+
+    z = g_new0 (z_stream, 1);
+
+    // 32: recognize gzip header
+    if (inflateInit2 (z, 15 + 32) != Z_OK)
+    {
+        g_free (z);
+        return FALSE;
+    }
+
+    zs->state = z;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static zstream_status_t
+zstream_gzip_decode (vfs_zstream_t *zs, guint8 **out, size_t *out_left)
+{
+    z_stream *z = (z_stream *) zs->state;
+    int ret;
+
+    z->next_in = (Bytef *) zs->in_next;
+    z->avail_in = (uInt) zs->in_left;
+    z->next_out = (Bytef *) *out;
+    z->avail_out = (uInt) *out_left;
+
+    ret = inflate (z, Z_NO_FLUSH);
+
+    zs->in_next = z->next_in;
+    zs->in_left = z->avail_in;
+    *out = z->next_out;
+    *out_left = z->avail_out;
+
+    switch (ret)
+    {
+    case Z_OK:
+    case Z_BUF_ERROR:
+        return ZSTREAM_OK;
+    case Z_STREAM_END:
+        if (zs->in_left == 0 && zs->in_eof)
+            return ZSTREAM_END;
+        // gzip file may consist of several members
+        inflateReset (z);
+        zs->restart = TRUE;
+        return ZSTREAM_OK;
+    default:
+        return ZSTREAM_ERROR;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zstream_gzip_done (vfs_zstream_t *zs)
+{
+    z_stream *z = (z_stream *) zs->state;
+
+    if (z != NULL)
+    {
+        inflateEnd (z);
+        g_free (z);
+        zs->state = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const zstream_codec_t zstream_gzip = {
+    .init = zstream_gzip_init,
+    .decode = zstream_gzip_decode,
+    .done = zstream_gzip_done,
+};
+#endif /* HAVE_ZLIB */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_BZLIB
+static gboolean
+zstream_bzip2_init (vfs_zstream_t *zs)
+{
+    bz_stream *b;
+
+    b = g_new0 (bz_stream, 1);
+
+    if (BZ2_bzDecompressInit (b, 0, 0) != BZ_OK)
+    {
+        g_free (b);
+        return FALSE;
+    }
+
+    zs->state = b;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static zstream_status_t
+zstream_bzip2_decode (vfs_zstream_t *zs, guint8 **out, size_t *out_left)
+{
+    bz_stream *b = (bz_stream *) zs->state;
+    int ret;
+
+    b->next_in = (char *) zs->in_next;
+    b->avail_in = (unsigned int) zs->in_left;
+    b->next_out = (char *) *out;
+    b->avail_out = (unsigned int) *out_left;
+
+    ret = BZ2_bzDecompress (b);
+
+    zs->in_next = (const guint8 *) b->next_in;
+    zs->in_left = b->avail_in;
+    *out = (guint8 *) b->next_out;
+    *out_left = b->avail_out;
+
+    switch (ret)
+    {
+    case BZ_OK:
+        return ZSTREAM_OK;
+    case BZ_STREAM_END:
+        if (zs->in_left == 0 && zs->in_eof)
+            return ZSTREAM_END;
+        // parallel compressors produce concatenated streams
+        BZ2_bzDecompressEnd (b);
+        memset (b, 0, sizeof (*b));
+        if (BZ2_bzDecompressInit (b, 0, 0) != BZ_OK)
+        {
+            g_free (b);
+            zs->state = NULL;
+            return ZSTREAM_ERROR;
+        }
+        zs->restart = TRUE;
+        return ZSTREAM_OK;
+    default:
+        return ZSTREAM_ERROR;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zstream_bzip2_done (vfs_zstream_t *zs)
+{
+    bz_stream *b = (bz_stream *) zs->state;
+
+    if (b != NULL)
+    {
+        BZ2_bzDecompressEnd (b);
+        g_free (b);
+        zs->state = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const zstream_codec_t zstream_bzip2 = {
+    .init = zstream_bzip2_init,
+    .decode = zstream_bzip2_decode,
+    .done = zstream_bzip2_done,
+};
+#endif /* HAVE_BZLIB */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_LZMA
+static gboolean
+zstream_xz_init (vfs_zstream_t *zs)
+{
+    static const lzma_stream init = LZMA_STREAM_INIT;
+    lzma_stream *s;
+
+    s = g_new (lzma_stream, 1);
+    *s = init;
+
+    if (lzma_stream_decoder (s, UINT64_MAX, LZMA_CONCATENATED) != LZMA_OK)
+    {
+        g_free (s);
+        return FALSE;
+    }
+
+    zs->state = s;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static zstream_status_t
+zstream_xz_decode (vfs_zstream_t *zs, guint8 **out, size_t *out_left)
+{
+    lzma_stream *s = (lzma_stream *) zs->state;
+    lzma_ret ret;
+
+    s->next_in = zs->in_next;
+    s->avail_in = zs->in_left;
+    s->next_out = *out;
+    s->avail_out = *out_left;
+
+    // with LZMA_CONCATENATED the end of stream is known only at the end of input
+    ret = lzma_code (s, zs->in_eof ? LZMA_FINISH : LZMA_RUN);
+
+    zs->in_next = s->next_in;
+    zs->in_left = s->avail_in;
+    *out = s->next_out;
+    *out_left = s->avail_out;
+
+    switch (ret)
+    {
+    case LZMA_OK:
+    case LZMA_BUF_ERROR:
+        return ZSTREAM_OK;
+    case LZMA_STREAM_END:
+        return ZSTREAM_END;
+    default:
+        return ZSTREAM_ERROR;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zstream_xz_done (vfs_zstream_t *zs)
+{
+    lzma_stream *s = (lzma_stream *) zs->state;
+
+    if (s != NULL)
+    {
+        lzma_end (s);
+        g_free (s);
+        zs->state = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const zstream_codec_t zstream_xz = {
+    .init = zstream_xz_init,
+    .decode = zstream_xz_decode,
+    .done = zstream_xz_done,
+};
+#endif /* HAVE_LZMA */
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_ZSTD
+static gboolean
+zstream_zstd_init (vfs_zstream_t *zs)
+{
+    ZSTD_DStream *d;
+
+    d = ZSTD_createDStream ();
+    if (d == NULL)
+        return FALSE;
+
+    if (ZSTD_isError (ZSTD_initDStream (d)))
+    {
+        ZSTD_freeDStream (d);
+        return FALSE;
+    }
+
+    zs->state = d;
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static zstream_status_t
+zstream_zstd_decode (vfs_zstream_t *zs, guint8 **out, size_t *out_left)
+{
+    ZSTD_inBuffer in = { zs->in_next, zs->in_left, 0 };
+    ZSTD_outBuffer o = { *out, *out_left, 0 };
+    size_t ret;
+
+    // concatenated frames are decompressed one after another
+    ret = ZSTD_decompressStream ((ZSTD_DStream *) zs->state, &o, &in);
+
+    zs->in_next += in.pos;
+    zs->in_left -= in.pos;
+    *out += o.pos;
+    *out_left -= o.pos;
+
+    if (ZSTD_isError (ret))
+        return ZSTREAM_ERROR;
+
+    // frame is completely decoded and flushed
+    if (ret == 0 && zs->in_left == 0 && zs->in_eof)
+        return ZSTREAM_END;
+
+    return ZSTREAM_OK;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zstream_zstd_done (vfs_zstream_t *zs)
+{
+    if (zs->state != NULL)
+    {
+        ZSTD_freeDStream ((ZSTD_DStream *) zs->state);
+        zs->state = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const zstream_codec_t zstream_zstd = {
+    .init = zstream_zstd_init,
+    .decode = zstream_zstd_decode,
+    .done = zstream_zstd_done,
+};
+#endif /* HAVE_ZSTD */
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find built-in decompressor.
+ *
+ * @return decompressor or NULL if data should be read as is or decompressed via sfs
+ */
+
+static const zstream_codec_t *
+zstream_find_codec (int fd, enum compression_type type)
+{
+    switch (type)
+    {
+#ifdef HAVE_ZLIB
+    case COMPRESSION_GZIP:
+    {
+        guint8 magic[2];
+
+        // compress, pack and old gzip formats are reported as gzip too
+        if (mc_lseek (fd, 0, SEEK_SET) == 0 && mc_read (fd, (char *) magic, 2) == 2
+            && magic[0] == 0x1F && magic[1] == 0x8B)
+            return &zstream_gzip;
+        break;
+    }
+#endif
+#ifdef HAVE_BZLIB
+    case COMPRESSION_BZIP2:
+        return &zstream_bzip2;
+#endif
+#ifdef HAVE_LZMA
+    case COMPRESSION_XZ:
+        return &zstream_xz;
+#endif
+#ifdef HAVE_ZSTD
+    case COMPRESSION_ZSTD:
+        return &zstream_zstd;
+#endif
+    default:
+        break;
+    }
+
+    (void) fd;
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+zstream_fill (vfs_zstream_t *zs)
+{
+    ssize_t len;
+
+    if (zs->in_left != 0 || zs->in_eof)
+        return TRUE;
+
+    len = mc_read (zs->fd, (char *) zs->in, ZSTREAM_IN_SIZE);
+    if (len == -1)
+        return FALSE;
+
+    zs->in_next = zs->in;
+    zs->in_left = (size_t) len;
+    zs->in_eof = (len == 0);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create temporary file for decompressed data. The file is removed at once and exists until
+ * it is closed.
+ */
+
+static void
+zstream_spill_open (vfs_zstream_t *zs)
+{
+    vfs_path_t *vpath;
+
+    zs->spill_fd = mc_mkstemps (&vpath, "zstream", NULL);
+    if (zs->spill_fd == -1)
+        return;
+
+    mc_unlink (vpath);
+    vfs_path_free (vpath, TRUE);
+    zs->spill_len = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+zstream_spill_close (vfs_zstream_t *zs)
+{
+    if (zs->spill_fd != -1)
+    {
+        close (zs->spill_fd);
+        zs->spill_fd = -1;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Append newly decompressed data to temporary file up to its max size. Data are decompressed
+ * sequentially, so they continue the file.
+ *
+ * @return FALSE on error
+ */
+
+static gboolean
+zstream_spill_write (vfs_zstream_t *zs)
+{
+    const off_t out_end = MIN (zs->out_pos + (off_t) zs->out_len, ZSTREAM_SPILL_MAX);
+    const guint8 *p;
+    size_t left;
+
+    // data are already in file after restart of decompression, or file is full
+    if (out_end <= zs->spill_len)
+        return TRUE;
+
+    if (zs->spill_len < zs->out_pos || lseek (zs->spill_fd, zs->spill_len, SEEK_SET) == -1)
+        return FALSE;
+
+    p = zs->out + (zs->spill_len - zs->out_pos);
+    left = (size_t) (out_end - zs->spill_len);
+
+    while (left != 0)
+    {
+        ssize_t n;
+
+        n = write (zs->spill_fd, p, left);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+
+        p += n;
+        left -= (size_t) n;
+        zs->spill_len += (off_t) n;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read data before the kept block from temporary file.
+ *
+ * @return number of read bytes or -1 on error
+ */
+
+static ssize_t
+zstream_spill_read (vfs_zstream_t *zs, void *buf, size_t count)
+{
+    ssize_t n;
+
+    count = (size_t) MIN ((off_t) count, MIN (zs->out_pos, zs->spill_len) - zs->pos);
+
+    if (lseek (zs->spill_fd, zs->pos, SEEK_SET) == -1)
+        return -1;
+
+    while ((n = read (zs->spill_fd, buf, count)) == -1 && errno == EINTR)
+        ;
+
+    if (n == 0)
+    {
+        // file is shorter than written data
+        errno = EIO;
+        return -1;
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Decompress next block of data.
+ *
+ * @return FALSE on error
+ */
+
+static gboolean
+zstream_decode (vfs_zstream_t *zs)
+{
+    const off_t out_end = zs->out_pos + (off_t) zs->out_len;
+    size_t keep;
+    guint8 *out;
+    size_t out_left = ZSTREAM_OUT_SIZE;
+
+    // keep the tail of previous data, unless the current position is beyond it
+    keep = zs->pos > out_end ? 0 : MIN (zs->out_len, ZSTREAM_HISTORY);
+    if (keep < zs->out_len)
+        memmove (zs->out, zs->out + zs->out_len - keep, keep);
+    zs->out_pos = out_end - (off_t) keep;
+    zs->out_len = keep;
+
+    out = zs->out + keep;
+
+    while (out_left == ZSTREAM_OUT_SIZE && !zs->end)
+    {
+        const gboolean restart = zs->restart;
+        const size_t left = out_left;
+        zstream_status_t status;
+
+        if (!zstream_fill (zs))
+            return FALSE;
+
+        /* decompressor sets the flag at the end of member. The flag is kept until data of
+           the next member are decompressed */
+        zs->restart = FALSE;
+        status = zs->codec->decode (zs, &out, &out_left);
+        if (restart && out_left == left)
+            zs->restart = TRUE;
+
+        if (status == ZSTREAM_ERROR)
+        {
+            // ignore trailing garbage after the complete stream like gzip does
+            if (!zs->restart)
+            {
+                errno = EIO;
+                return FALSE;
+            }
+
+            status = ZSTREAM_END;
+        }
+
+        // truncated archive is read until the end of available data
+        if (status == ZSTREAM_END
+            || (zs->in_left == 0 && zs->in_eof && out_left == ZSTREAM_OUT_SIZE))
+            zs->end = TRUE;
+    }
+
+    zs->out_len += ZSTREAM_OUT_SIZE - out_left;
+
+    // on error, backward seeks restart decompression as without file
+    if (zs->spill_fd != -1 && !zstream_spill_write (zs))
+        zstream_spill_close (zs);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Restart decompression from the beginning of archive.
+ */
+
+static gboolean
+zstream_rewind (vfs_zstream_t *zs)
+{
+    zs->codec->done (zs);
+
+    zs->in_left = 0;
+    zs->in_eof = FALSE;
+    zs->out_pos = 0;
+    zs->out_len = 0;
+    zs->pos = 0;
+    zs->end = FALSE;
+    zs->restart = FALSE;
+
+    return (mc_lseek (zs->fd, 0, SEEK_SET) == 0 && zs->codec->init (zs));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Prepare reading of data before the kept block. Data are read from temporary file if they are
+ * there. Otherwise decompression is restarted from the beginning, and temporary file is created
+ * at the first time.
+ *
+ * @param offset new position in stream, less than position of the kept block
+ *
+ * @return FALSE on error
+ */
+
+static gboolean
+zstream_seek_back (vfs_zstream_t *zs, off_t offset)
+{
+    if (zs->spill_fd == -1 || offset >= zs->spill_len)
+    {
+        if (zs->spill_fd == -1)
+            zstream_spill_open (zs);
+
+        if (!zstream_rewind (zs))
+        {
+            errno = EIO;
+            return FALSE;
+        }
+    }
+
+    zs->pos = offset;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Open archive for reading. Compressed archive is decompressed on the fly if possible or
+ * via sfs otherwise.
+ *
+ * @param vpath archive
+ *
+ * @return newly allocated stream or NULL on error
+ */
+
+vfs_zstream_t *
+vfs_zstream_open (const vfs_path_t *vpath)
+{
+    vfs_zstream_t *zs;
+    const zstream_codec_t *codec;
+    enum compression_type type;
+    int fd;
+
+    fd = mc_open (vpath, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    type = get_compression_type (fd, vfs_path_as_str (vpath));
+    codec = zstream_find_codec (fd, type);
+
+    if (type != COMPRESSION_NONE && codec == NULL)
+    {
+        char *s;
+        vfs_path_t *tmp_vpath;
+
+        mc_close (fd);
+        s = g_strconcat (vfs_path_as_str (vpath), decompress_extension (type), (char *) NULL);
+        tmp_vpath = vfs_path_from_str_flags (s, VPF_NO_CANON);
+        g_free (s);
+        fd = mc_open (tmp_vpath, O_RDONLY);
+        vfs_path_free (tmp_vpath, TRUE);
+        if (fd == -1)
+            return NULL;
+    }
+    else if (mc_lseek (fd, 0, SEEK_SET) != 0)
+    {
+        mc_close (fd);
+        return NULL;
+    }
+
+    zs = g_new0 (vfs_zstream_t, 1);
+    zs->fd = fd;
+    zs->spill_fd = -1;
+
+    if (codec != NULL)
+    {
+        zs->codec = codec;
+        zs->in = g_malloc (ZSTREAM_IN_SIZE);
+        zs->out = g_malloc (ZSTREAM_HISTORY + ZSTREAM_OUT_SIZE);
+
+        if (!codec->init (zs))
+        {
+            vfs_zstream_close (zs);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+
+    return zs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read data from archive. Unlike read(), the buffer is filled completely unless the end of
+ * archive is reached.
+ *
+ * @return number of read bytes or -1 on error
+ */
+
+ssize_t
+vfs_zstream_read (vfs_zstream_t *zs, void *buf, size_t count)
+{
+    size_t done = 0;
+
+    if (zs->codec == NULL)
+        return mc_read (zs->fd, (char *) buf, count);
+
+    while (done < count)
+    {
+        const off_t avail = zs->out_pos + (off_t) zs->out_len - zs->pos;
+        size_t len;
+
+        if (zs->pos < zs->out_pos)
+        {
+            ssize_t n;
+
+            // the end of temporary file is reached
+            if (zs->spill_fd == -1 || zs->pos >= zs->spill_len)
+            {
+                if (!zstream_seek_back (zs, zs->pos))
+                    return done != 0 ? (ssize_t) done : -1;
+                continue;
+            }
+
+            n = zstream_spill_read (zs, (char *) buf + done, count - done);
+            if (n == -1)
+                return done != 0 ? (ssize_t) done : -1;
+            zs->pos += (off_t) n;
+            done += (size_t) n;
+            continue;
+        }
+
+        if (avail <= 0)
+        {
+            if (zs->end)
+                break;
+            if (!zstream_decode (zs))
+                return done != 0 ? (ssize_t) done : -1;
+            continue;
+        }
+
+        len = (size_t) MIN ((off_t) (count - done), avail);
+        memcpy ((char *) buf + done, zs->out + (zs->pos - zs->out_pos), len);
+        zs->pos += (off_t) len;
+        done += len;
+    }
+
+    return (ssize_t) done;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Change position in archive. Seeking from the end is not supported for compressed archives.
+ *
+ * @return new position or -1 on error
+ */
+
+off_t
+vfs_zstream_seek (vfs_zstream_t *zs, off_t offset, int whence)
+{
+    if (zs->codec == NULL)
+        return mc_lseek (zs->fd, offset, whence);
+
+    switch (whence)
+    {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += zs->pos;
+        break;
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (offset < 0)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (offset < zs->out_pos && !zstream_seek_back (zs, offset))
+        return -1;
+
+    // data up to the new position is decompressed on the next read
+    zs->pos = offset;
+
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+vfs_zstream_close (vfs_zstream_t *zs)
+{
+    if (zs == NULL)
+        return;
+
+    if (zs->codec != NULL)
+        zs->codec->done (zs);
+
+    zstream_spill_close (zs);
+    mc_close (zs->fd);
+    g_free (zs->in);
+    g_free (zs->out);
+    g_free (zs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,29 @@
+/**
+ * \file
+ * \brief Header: Virtual File System: reading of compressed archives
+ */
+
+#ifndef MC__VFS_ZSTREAM_H
+#define MC__VFS_ZSTREAM_H
+
+#include "vfs.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct vfs_zstream_t vfs_zstream_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+vfs_zstream_t *vfs_zstream_open (const vfs_path_t *vpath);
+ssize_t vfs_zstream_read (vfs_zstream_t *zs, void *buf, size_t count);
+off_t vfs_zstream_seek (vfs_zstream_t *zs, off_t offset, int whence);
+void vfs_zstream_close (vfs_zstream_t *zs);
+
+/*** inline functions ****************************************************************************/
+#endif
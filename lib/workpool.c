@@ -0,0 +1,241 @@
+/*
+   Pool of worker threads for batch jobs.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file lib/workpool.c
+ *  \brief Source: pool of worker threads for batch jobs
+ *
+ *  The pool is a thin wrapper around GThreadPool that allows the caller to wait
+ *  until all pushed tasks are done. A pool lives only during one operation:
+ *  idle threads are not kept, so the process can be forked safely afterwards
+ *  (background jobs, subshell, external programs).
+ *
+ *  If threads cannot be created or only one worker is requested, tasks are run
+ *  synchronously in the calling thread.
+ */
+
+#include <config.h>
+
+#include <unistd.h>  // sysconf()
+
+#include "lib/global.h"
+
+#include "lib/workpool.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/*** file scope type declarations ****************************************************************/
+
+struct mc_workpool_t
+{
+    GThreadPool *pool;  // NULL if tasks are run in the calling thread
+    mc_workpool_fn func;
+    gpointer user_data;
+
+    GMutex lock;
+    GCond done;
+    guint pending;  // number of pushed but not finished tasks
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+mc_workpool_run (gpointer task, gpointer data)
+{
+    mc_workpool_t *wp = (mc_workpool_t *) data;
+
+    wp->func (task, wp->user_data);
+
+    g_mutex_lock (&wp->lock);
+    wp->pending--;
+    if (wp->pending == 0)
+        g_cond_broadcast (&wp->done);
+    g_mutex_unlock (&wp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get default number of worker threads.
+ *
+ * @return number of online CPUs limited by MC_WORKPOOL_MAX_WORKERS
+ */
+
+int
+mc_workpool_get_num_workers (void)
+{
+    static int num_workers = 0;
+
+    if (num_workers == 0)
+    {
+        long n;
+
+        n = sysconf (_SC_NPROCESSORS_ONLN);
+        num_workers = (int) CLAMP (n, 1, MC_WORKPOOL_MAX_WORKERS);
+    }
+
+    return num_workers;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create new pool.
+ *
+ * @param func task handler
+ * @param user_data data passed to every call of @func
+ * @param max_workers maximum number of threads. If 0 or less, default value is used.
+ *
+ * @return newly allocated pool
+ */
+
+mc_workpool_t *
+mc_workpool_new (mc_workpool_fn func, gpointer user_data, int max_workers)
+{
+    static gboolean initialized = FALSE;
+    mc_workpool_t *wp;
+
+    if (!initialized)
+    {
+        // don't keep idle threads: they are lost in the child process after fork()
+        g_thread_pool_set_max_unused_threads (0);
+        initialized = TRUE;
+    }
+
+    wp = g_new0 (mc_workpool_t, 1);
+    wp->func = func;
+    wp->user_data = user_data;
+    g_mutex_init (&wp->lock);
+    g_cond_init (&wp->done);
+
+    if (max_workers <= 0)
+        max_workers = mc_workpool_get_num_workers ();
+
+    if (max_workers > 1)
+        wp->pool = g_thread_pool_new (mc_workpool_run, wp, max_workers, FALSE, NULL);
+
+    return wp;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push task to the pool. If there are no threads, the task is done immediately.
+ *
+ * @param wp pool
+ * @param task task data
+ */
+
+void
+mc_workpool_push (mc_workpool_t *wp, gpointer task)
+{
+    if (wp->pool != NULL)
+    {
+        g_mutex_lock (&wp->lock);
+        wp->pending++;
+        g_mutex_unlock (&wp->lock);
+
+        if (g_thread_pool_push (wp->pool, task, NULL))
+            return;
+
+        g_mutex_lock (&wp->lock);
+        wp->pending--;
+        g_mutex_unlock (&wp->lock);
+    }
+
+    wp->func (task, wp->user_data);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until all pushed tasks are done.
+ *
+ * @param wp pool
+ */
+
+void
+mc_workpool_wait (mc_workpool_t *wp)
+{
+    g_mutex_lock (&wp->lock);
+    while (wp->pending != 0)
+        g_cond_wait (&wp->done, &wp->lock);
+    g_mutex_unlock (&wp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until all pushed tasks are done, but not longer than @timeout.
+ * Useful to keep UI alive while tasks are running.
+ *
+ * @param wp pool
+ * @param timeout max time to wait in microseconds
+ *
+ * @return TRUE if all tasks are done, FALSE if timeout is expired
+ */
+
+gboolean
+mc_workpool_wait_timeout (mc_workpool_t *wp, gint64 timeout)
+{
+    gint64 end_time;
+    gboolean done;
+
+    end_time = g_get_monotonic_time () + timeout;
+
+    g_mutex_lock (&wp->lock);
+    while (wp->pending != 0 && g_cond_wait_until (&wp->done, &wp->lock, end_time))
+        ;
+    done = (wp->pending == 0);
+    g_mutex_unlock (&wp->lock);
+
+    return done;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for all pushed tasks and destroy the pool.
+ *
+ * @param wp pool
+ */
+
+void
+mc_workpool_free (mc_workpool_t *wp)
+{
+    if (wp == NULL)
+        return;
+
+    mc_workpool_wait (wp);
+
+    if (wp->pool != NULL)
+        g_thread_pool_free (wp->pool, FALSE, TRUE);
+
+    g_cond_clear (&wp->done);
+    g_mutex_clear (&wp->lock);
+    g_free (wp);
+}
+
+/* --------------------------------------------------------------------------------------------- */
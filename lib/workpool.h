@@ -0,0 +1,38 @@
+/** \file lib/workpool.h
+ *  \brief Header: pool of worker threads for batch jobs
+ */
+
+#ifndef MC__WORKPOOL_H
+#define MC__WORKPOOL_H
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* upper limit of worker threads in one pool */
+#define MC_WORKPOOL_MAX_WORKERS 16
+
+typedef struct mc_workpool_t mc_workpool_t;
+
+/* task handler. It is called in a worker thread and must not touch VFS or UI */
+typedef void (*mc_workpool_fn) (gpointer task, gpointer user_data);
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+int mc_workpool_get_num_workers (void);
+
+mc_workpool_t *mc_workpool_new (mc_workpool_fn func, gpointer user_data, int max_workers);
+void mc_workpool_push (mc_workpool_t *pool, gpointer task);
+void mc_workpool_wait (mc_workpool_t *pool);
+gboolean mc_workpool_wait_timeout (mc_workpool_t *pool, gint64 timeout);
+void mc_workpool_free (mc_workpool_t *pool);
+
+/*** inline functions ****************************************************************************/
+
+#endif
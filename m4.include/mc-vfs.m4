@@ -15,6 +15,7 @@ m4_include([m4.include/vfs/mc-vfs-sftp.m4])
 m4_include([m4.include/vfs/mc-vfs-shell.m4])
 m4_include([m4.include/vfs/mc-vfs-tarfs.m4])
 m4_include([m4.include/vfs/mc-vfs-cpiofs.m4])
+m4_include([m4.include/vfs/mc-vfs-decompress.m4])
 
 dnl mc_VFS_CHECKS
 dnl   Check for various functions needed by libvfs.
@@ -72,6 +73,7 @@ AC_DEFUN([mc_VFS_CHECKS],
     mc_VFS_SFS
     mc_VFS_SFTP
     mc_VFS_TARFS
+    mc_VFS_DECOMPRESS
 
     AM_CONDITIONAL(ENABLE_VFS, [test x"$enable_vfs" = x"yes"])
 
@@ -0,0 +1,56 @@
+dnl In-process decompression of tar and cpio archives
+AC_DEFUN([mc_VFS_DECOMPRESS],
+[
+    AC_ARG_ENABLE([vfs-decompress],
+		    AS_HELP_STRING([--enable-vfs-decompress], [Decompress tar and cpio archives with zlib, bzip2, liblzma and libzstd instead of external programs @<:@auto@:>@]))
+
+    decompress_msg="external programs"
+
+    if test x"$enable_vfs_tar" = x"yes" -o x"$enable_vfs_cpio" = x"yes"; then
+	if test x"$enable_vfs_decompress" != x"no"; then
+	    mc_decompress=""
+
+	    PKG_CHECK_MODULES(ZLIB, [zlib], [found_zlib=yes], [:])
+	    if test x"$found_zlib" = x"yes"; then
+		AC_DEFINE([HAVE_ZLIB], [1], [Define to use zlib to decompress archives])
+		MCLIBS="$MCLIBS $ZLIB_LIBS"
+		mc_decompress="$mc_decompress gzip"
+	    fi
+
+	    PKG_CHECK_MODULES(BZIP2, [bzip2], [found_bzip2=yes],
+		[
+		    AC_CHECK_HEADER([bzlib.h],
+			[AC_CHECK_LIB([bz2], [BZ2_bzDecompressInit],
+			    [found_bzip2=yes; BZIP2_CFLAGS=""; BZIP2_LIBS="-lbz2"])])
+		])
+	    if test x"$found_bzip2" = x"yes"; then
+		AC_DEFINE([HAVE_BZLIB], [1], [Define to use libbz2 to decompress archives])
+		MCLIBS="$MCLIBS $BZIP2_LIBS"
+		mc_decompress="$mc_decompress bzip2"
+	    fi
+	    AC_SUBST(BZIP2_CFLAGS)
+	    AC_SUBST(BZIP2_LIBS)
+
+	    PKG_CHECK_MODULES(LZMA, [liblzma >= 5.0.0], [found_lzma=yes], [:])
+	    if test x"$found_lzma" = x"yes"; then
+		AC_DEFINE([HAVE_LZMA], [1], [Define to use liblzma to decompress archives])
+		MCLIBS="$MCLIBS $LZMA_LIBS"
+		mc_decompress="$mc_decompress xz"
+	    fi
+
+	    PKG_CHECK_MODULES(ZSTD, [libzstd >= 1.0.0], [found_zstd=yes], [:])
+	    if test x"$found_zstd" = x"yes"; then
+		AC_DEFINE([HAVE_ZSTD], [1], [Define to use libzstd to decompress archives])
+		MCLIBS="$MCLIBS $ZSTD_LIBS"
+		mc_decompress="$mc_decompress zstd"
+	    fi
+
+	    if test x"$mc_decompress" != x; then
+		decompress_msg="built-in:$mc_decompress"
+	    elif test x"$enable_vfs_decompress" = x"yes"; then
+		dnl user explicitly requested feature
+		AC_MSG_ERROR([none of zlib, bzip2, liblzma and libzstd libraries is found])
+	    fi
+	fi
+    fi
+])
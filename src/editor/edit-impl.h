@@ -145,13 +145,17 @@ void edit_delete_line (WEdit *edit);
 
 int edit_delete (WEdit *edit, gboolean byte_delete);
 int edit_backspace (WEdit *edit, gboolean byte_delete);
+void edit_delete_block (WEdit *edit, off_t len);
 void edit_insert (WEdit *edit, int c);
 void edit_insert_over (WEdit *edit);
 void edit_cursor_move (WEdit *edit, off_t increment);
+void edit_wait_lines (WEdit *edit);
 void edit_push_undo_action (WEdit *edit, long c);
+void edit_push_undo_action_repeat (WEdit *edit, long c, off_t n);
 void edit_push_redo_action (WEdit *edit, long c);
 void edit_push_key_press (WEdit *edit);
 void edit_insert_ahead (WEdit *edit, int c);
+void edit_insert_block_ahead (WEdit *edit, const char *s, off_t len);
 off_t edit_write_stream (WEdit *edit, FILE *f);
 char *edit_get_write_filter (const vfs_path_t *write_name_vpath, const vfs_path_t *filename_vpath);
 gboolean edit_save_confirm_cmd (WEdit *edit);
@@ -213,6 +217,8 @@ void edit_set_filename (WEdit *edit, const vfs_path_t *name_vpath);
 MC_MOCKABLE void edit_load_syntax (WEdit *edit, GPtrArray *pnames, const char *type);
 void edit_free_syntax_rules (WEdit *edit);
 MC_MOCKABLE int edit_get_syntax_color (WEdit *edit, off_t byte_index);
+void edit_syntax_invalidate (WEdit *edit, off_t offset, int delta);
+gboolean edit_syntax_idle (WEdit *edit);
 void edit_syntax_dialog (WEdit *edit);
 
 void book_mark_insert (WEdit *edit, long line, int c);
@@ -180,6 +180,30 @@ edit_load_status_update_cb (status_msg_t *sm)
     return status_msg_common_update (sm);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Show lines of large file counted in background.
+ */
+
+static void
+edit_lines_counted_cb (edit_buffer_t *buf, void *data)
+{
+    WEdit *edit = (WEdit *) data;
+    Widget *w = WIDGET (edit);
+
+    (void) buf;
+
+    edit->force |= REDRAW_PAGE;
+
+    // another window or dialog is drawn over the inactive window
+    if (widget_get_state (w, WST_FOCUSED) && top_dlg != NULL
+        && DIALOG (top_dlg->data) == DIALOG (w->owner))
+    {
+        widget_draw (w);
+        mc_refresh ();
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Load file OR text into buffers.  Set cursor to the beginning of file.
@@ -188,8 +212,9 @@ edit_load_status_update_cb (status_msg_t *sm)
  */
 
 static gboolean
-edit_load_file_fast (edit_buffer_t *buf, const vfs_path_t *filename_vpath)
+edit_load_file_fast (WEdit *edit, const vfs_path_t *filename_vpath)
 {
+    edit_buffer_t *buf = &edit->buffer;
     int file;
     gboolean ret;
     edit_buffer_read_file_status_msg_t rsm;
@@ -202,6 +227,13 @@ edit_load_file_fast (edit_buffer_t *buf, const vfs_path_t *filename_vpath)
         return FALSE;
     }
 
+    // large file is not loaded, its pages are read on demand
+    if (edit_buffer_map_file (buf, file, edit_lines_counted_cb, edit))
+    {
+        mc_close (file);
+        return TRUE;
+    }
+
     rsm.first = TRUE;
     rsm.buf = buf;
     rsm.loaded = 0;
@@ -426,7 +458,7 @@ edit_load_file (WEdit *edit)
     {
         edit_buffer_init (&edit->buffer, edit->stat1.st_size);
 
-        if (!edit_load_file_fast (&edit->buffer, edit->filename_vpath))
+        if (!edit_load_file_fast (edit, edit->filename_vpath))
         {
             edit_clean (edit);
             return FALSE;
@@ -625,8 +657,6 @@ get_prev_undo_action (WEdit *edit)
 static void
 edit_modification (WEdit *edit)
 {
-    edit->caches_valid = FALSE;
-
     // raise lock when file modified
     if (edit->modified == 0 && edit->delete_file == 0)
         edit->locked = lock_file (edit->filename_vpath);
@@ -688,51 +718,10 @@ is_blank (const edit_buffer_t *buf, off_t offset)
 static off_t
 edit_find_line (WEdit *edit, long line)
 {
-    long i;
-    long j = 0;
-    long m = 2000000000;  // what is the magic number?
+    // the last line must be known
+    edit_wait_lines (edit);
 
-    if (!edit->caches_valid)
-    {
-        memset (edit->line_numbers, 0, sizeof (edit->line_numbers));
-        memset (edit->line_offsets, 0, sizeof (edit->line_offsets));
-        // three offsets that we *know* are line 0 at 0 and these two:
-        edit->line_numbers[1] = edit->buffer.curs_line;
-        edit->line_offsets[1] = edit_buffer_get_current_bol (&edit->buffer);
-        edit->line_numbers[2] = edit->buffer.lines;
-        edit->line_offsets[2] = edit_buffer_get_bol (&edit->buffer, edit->buffer.size);
-        edit->caches_valid = TRUE;
-    }
-    if (line >= edit->buffer.lines)
-        return edit->line_offsets[2];
-    if (line <= 0)
-        return 0;
-    // find the closest known point
-    for (i = 0; i < N_LINE_CACHES; i++)
-    {
-        long n;
-
-        n = labs (edit->line_numbers[i] - line);
-        if (n < m)
-        {
-            m = n;
-            j = i;
-        }
-    }
-    if (m == 0)
-        return edit->line_offsets[j];  // know the offset exactly
-    if (m == 1 && j >= 3)
-        i = j;  // one line different - caller might be looping, so stay in this cache
-    else
-        i = 3 + (rand () % (N_LINE_CACHES - 3));
-    if (line > edit->line_numbers[j])
-        edit->line_offsets[i] = edit_buffer_get_forward_offset (
-            &edit->buffer, edit->line_offsets[j], line - edit->line_numbers[j], 0);
-    else
-        edit->line_offsets[i] = edit_buffer_get_backward_offset (
-            &edit->buffer, edit->line_offsets[j], edit->line_numbers[j] - line);
-    edit->line_numbers[i] = line;
-    return edit->line_offsets[i];
+    return edit_buffer_get_line_offset (&edit->buffer, line);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -848,6 +837,8 @@ edit_move_to_top (WEdit *edit)
 static void
 edit_move_to_bottom (WEdit *edit)
 {
+    edit_wait_lines (edit);
+
     if (edit->buffer.curs_line < edit->buffer.lines)
     {
         edit_move_down (edit, edit->buffer.lines - edit->curs_row, FALSE);
@@ -1069,6 +1060,13 @@ edit_move_updown (WEdit *edit, long lines, gboolean do_scroll, gboolean directio
     long p;
     long l = direction ? edit->buffer.curs_line : edit->buffer.lines - edit->buffer.curs_line;
 
+    if (lines > l && !direction)
+    {
+        // lines of large file may be still counted
+        edit_wait_lines (edit);
+        l = edit->buffer.lines - edit->buffer.curs_line;
+    }
+
     if (lines > l)
         lines = l;
 
@@ -2439,6 +2437,46 @@ check_bottom:
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Push the same undo action several times.
+ *
+ * @param edit editor object
+ * @param c action
+ * @param n number of actions
+ */
+
+void
+edit_push_undo_action_repeat (WEdit *edit, long c, off_t n)
+{
+    for (; n > 0; n--)
+    {
+        unsigned long sp;
+
+        edit_push_undo_action (edit, c);
+
+        if (edit->undo_stack_disable)
+            continue;
+
+        // repeated action is kept as the action followed by negative counter: enlarge counter
+        sp = edit->undo_stack_pointer;
+        if (edit->undo_stack[(sp - 1) & edit->undo_stack_size_mask] < 0
+            && edit->undo_stack[(sp - 2) & edit->undo_stack_size_mask] == c)
+        {
+            long *counter = &edit->undo_stack[(sp - 1) & edit->undo_stack_size_mask];
+            off_t room;
+
+            // see limit in edit_push_undo_action()
+            room = MIN (*counter + 1000000000 - 1, n - 1);
+            if (room > 0)
+            {
+                *counter -= (long) room;
+                n -= room;
+            }
+        }
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -2560,7 +2598,7 @@ edit_insert (WEdit *edit, int c)
     // update markers
     edit->mark1 += (edit->mark1 > edit->buffer.curs1) ? 1 : 0;
     edit->mark2 += (edit->mark2 > edit->buffer.curs1) ? 1 : 0;
-    edit->last_get_rule += (edit->last_get_rule > edit->buffer.curs1) ? 1 : 0;
+    edit_syntax_invalidate (edit, edit->buffer.curs1, 1);
 
     edit_buffer_insert (&edit->buffer, c);
 }
@@ -2592,11 +2630,57 @@ edit_insert_ahead (WEdit *edit, int c)
 
     edit->mark1 += (edit->mark1 >= edit->buffer.curs1) ? 1 : 0;
     edit->mark2 += (edit->mark2 >= edit->buffer.curs1) ? 1 : 0;
-    edit->last_get_rule += (edit->last_get_rule >= edit->buffer.curs1) ? 1 : 0;
+    edit_syntax_invalidate (edit, edit->buffer.curs1, 1);
 
     edit_buffer_insert_ahead (&edit->buffer, c);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert block of bytes at the cursor without moving the cursor.  Same as edit_insert_ahead()
+ * called for each byte from the end of block, but the buffer is changed by pages.
+ *
+ * @param edit editor object
+ * @param s block of bytes
+ * @param len length of block
+ */
+
+void
+edit_insert_block_ahead (WEdit *edit, const char *s, off_t len)
+{
+    off_t i;
+    long lines;
+
+    if (len <= 0)
+        return;
+
+    edit_modification (edit);
+
+    // the undo stack keeps one action per byte
+    for (i = len; i != 0; i--)
+        edit_push_undo_action (edit, (unsigned char) s[i - 1] > 32 ? DELCHAR : DELCHAR_BR);
+
+    edit->mark1 += (edit->mark1 >= edit->buffer.curs1) ? len : 0;
+    edit->mark2 += (edit->mark2 >= edit->buffer.curs1) ? len : 0;
+    for (i = 0; i < len; i++)
+        edit_syntax_invalidate (edit, edit->buffer.curs1, 1);
+
+    lines = edit_buffer_insert_block_ahead (&edit->buffer, s, len);
+
+    if (edit->buffer.curs1 < edit->start_display)
+    {
+        edit->start_display += len;
+        edit->start_line += lines;
+    }
+    if (lines != 0)
+    {
+        for (i = 0; i < lines; i++)
+            book_mark_inc (edit, edit->buffer.curs_line);
+        edit->buffer.lines += lines;
+        edit->force |= REDRAW_AFTER_CURSOR;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -2642,8 +2726,7 @@ edit_delete (WEdit *edit, gboolean byte_delete)
         }
         if (edit->mark2 > edit->buffer.curs1)
             edit->mark2--;
-        if (edit->last_get_rule > edit->buffer.curs1)
-            edit->last_get_rule--;
+        edit_syntax_invalidate (edit, edit->buffer.curs1, -1);
 
         p = edit_buffer_delete (&edit->buffer);
 
@@ -2667,6 +2750,75 @@ edit_delete (WEdit *edit, gboolean byte_delete)
     return p;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Delete block of bytes at the cursor.  Same as edit_delete() called with byte_delete for each
+ * byte, but the buffer is changed by pages.
+ *
+ * @param edit editor object
+ * @param len length of block
+ */
+
+void
+edit_delete_block (WEdit *edit, off_t len)
+{
+    const off_t curs = edit->buffer.curs1;
+    off_t i;
+    long lines;
+
+    len = MIN (len, edit->buffer.curs2);
+    if (len <= 0)
+        return;
+
+    if (edit->mark2 != edit->mark1)
+        edit_push_markers (edit);
+
+    if (edit->mark1 > curs)
+    {
+        const off_t n = MIN (len, edit->mark1 - curs);
+
+        edit->mark1 -= n;
+        edit->end_mark_curs -= n;
+    }
+    if (edit->mark2 > curs)
+        edit->mark2 -= MIN (len, edit->mark2 - curs);
+
+    // the undo stack keeps one action per byte
+    for (i = 0; i < len;)
+    {
+        const char *s;
+        off_t n, k;
+
+        s = edit_buffer_get_chunk (&edit->buffer, curs + i, &n);
+        n = MIN (n, len - i);
+        for (k = 0; k < n; k++)
+            edit_push_undo_action (edit, (unsigned char) s[k] + 256);
+        i += n;
+    }
+
+    for (i = 0; i < len; i++)
+        edit_syntax_invalidate (edit, curs, -1);
+
+    if (curs < edit->start_display)
+    {
+        const off_t n = MIN (len, edit->start_display - curs);
+
+        edit->start_line -= edit_buffer_count_lines (&edit->buffer, curs, curs + n);
+        edit->start_display -= n;
+    }
+
+    lines = edit_buffer_delete_block (&edit->buffer, len);
+
+    edit_modification (edit);
+    if (lines != 0)
+    {
+        for (i = 0; i < lines; i++)
+            book_mark_dec (edit, edit->buffer.curs_line);
+        edit->buffer.lines -= lines;
+        edit->force |= REDRAW_AFTER_CURSOR;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 int
@@ -2698,8 +2850,7 @@ edit_backspace (WEdit *edit, gboolean byte_delete)
         }
         if (edit->mark2 >= edit->buffer.curs1)
             edit->mark2--;
-        if (edit->last_get_rule >= edit->buffer.curs1)
-            edit->last_get_rule--;
+        edit_syntax_invalidate (edit, edit->buffer.curs1 - 1, -1);
 
         p = edit_buffer_backspace (&edit->buffer);
 
@@ -2730,44 +2881,47 @@ edit_backspace (WEdit *edit, gboolean byte_delete)
 void
 edit_cursor_move (WEdit *edit, off_t increment)
 {
+    long lines;
+
     if (increment < 0)
     {
-        for (; increment < 0 && edit->buffer.curs1 != 0; increment++)
-        {
-            int c;
-
-            edit_push_undo_action (edit, CURS_RIGHT);
+        increment = MAX (increment, -edit->buffer.curs1);
+        edit_push_undo_action_repeat (edit, CURS_RIGHT, -increment);
 
-            c = edit_buffer_get_previous_byte (&edit->buffer);
-            edit_buffer_insert_ahead (&edit->buffer, c);
-            c = edit_buffer_backspace (&edit->buffer);
-            if (c == '\n')
-            {
-                edit->buffer.curs_line--;
-                edit->force |= REDRAW_LINE_BELOW;
-            }
+        lines = edit_buffer_move_cursor (&edit->buffer, increment);
+        if (lines != 0)
+        {
+            edit->buffer.curs_line -= lines;
+            edit->force |= REDRAW_LINE_BELOW;
         }
     }
-    else
+    else if (increment > 0)
     {
-        for (; increment > 0 && edit->buffer.curs2 != 0; increment--)
-        {
-            int c;
-
-            edit_push_undo_action (edit, CURS_LEFT);
+        increment = MIN (increment, edit->buffer.curs2);
+        edit_push_undo_action_repeat (edit, CURS_LEFT, increment);
 
-            c = edit_buffer_get_current_byte (&edit->buffer);
-            edit_buffer_insert (&edit->buffer, c);
-            c = edit_buffer_delete (&edit->buffer);
-            if (c == '\n')
-            {
-                edit->buffer.curs_line++;
-                edit->force |= REDRAW_LINE_ABOVE;
-            }
+        lines = edit_buffer_move_cursor (&edit->buffer, increment);
+        if (lines != 0)
+        {
+            edit->buffer.curs_line += lines;
+            edit->force |= REDRAW_LINE_ABOVE;
         }
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for lines of large file counted in background.
+ *
+ * @param edit editor object
+ */
+
+void
+edit_wait_lines (WEdit *edit)
+{
+    (void) edit_buffer_finish_lines (&edit->buffer);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /* If cols is zero this returns the count of columns from current to upto. */
 /* If upto is zero returns index of cols across from current. */
@@ -2912,6 +3066,12 @@ edit_scroll_downward (WEdit *edit, long i)
     long lines_below;
 
     lines_below = edit->buffer.lines - edit->start_line - (WIDGET (edit)->rect.lines - 1);
+    if (i > lines_below)
+    {
+        // lines of large file may be still counted
+        edit_wait_lines (edit);
+        lines_below = edit->buffer.lines - edit->start_line - (WIDGET (edit)->rect.lines - 1);
+    }
     if (lines_below > 0)
     {
         if (i > lines_below)
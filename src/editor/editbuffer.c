@@ -32,12 +32,20 @@
 #include <config.h>
 
 #include <ctype.h>  // isdigit()
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#include <unistd.h>  // pipe(), pread()
 
 #include "lib/global.h"
 
+#include "lib/tty/key.h"  // add_select_channel()
 #include "lib/vfs/vfs.h"
 
 #include "edit-impl.h"
@@ -74,6 +82,27 @@
  * See also:
  * https://en.wikipedia.org/wiki/Gap_buffer
  * https://stackoverflow.com/questions/4199694/data-structure-for-text-editor
+ *
+ * Large local files are not read into memory at once.  Then unread pages of b1 and b2 are
+ * pointers into a reserved range of address space which is never accessed: the offset of such
+ * pointer in the range is the offset of page in the file.  Such pages are always full.  A page
+ * is read with pread() into memory at the first access and is not changed by others since then.
+ * Unread pages, the background line counter and the lines of unread pages are still taken from
+ * the file: if it is truncated or rewritten by others, the buffer gets a mix of old and new text,
+ * where missing data are read as zeros, and the numbers of lines may be wrong.  The editor doesn't
+ * crash in this case, and saving of the changed file is prompted as usual.  Since an unread page
+ * can start at any offset of the file, whole pages are moved between b2 and b1 when the cursor
+ * goes far away, without reading of data.
+ *
+ * Numbers of lines in pages are kept in two arrays of cumulative sums, l1 for pages of b1 and l2
+ * for pages of b2 (from the end of file).  Since text is changed only at the cursor, only the top
+ * elements of these arrays are changed on insertion and deletion.  So the offset of any line and
+ * the line of any offset are found by binary search and scan of one page.  The line index of
+ * large file is built when the background line counter has finished.
+ *
+ * Bytes of one page are contiguous in memory.  Code which scans or copies ranges of text should
+ * get them by chunks with edit_buffer_get_chunk() and edit_buffer_get_prev_chunk() instead of
+ * calling edit_buffer_get_byte() for each byte.
  */
 
 /*** global variables ****************************************************************************/
@@ -96,14 +125,460 @@
 /* Buffer mask (used to find cursor position relative to the buffer) */
 #define M_EDIT_BUF_SIZE (EDIT_BUF_SIZE - 1)
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define EDIT_BUFFER_MMAP 1
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+/* Smaller files are read into memory */
+#define EDIT_MAP_MIN_SIZE (16 * EDIT_BUF_SIZE)
+
+/* Lines of large file are counted by chunks of this size */
+#define EDIT_MAP_COUNT_CHUNK ((size_t) (64 * EDIT_BUF_SIZE))
+
+/* Minimal interval between redraws caused by line counter, in microseconds */
+#define EDIT_MAP_NOTIFY_INTERVAL (G_USEC_PER_SEC / 10)
+
+/* Lines are found without line index if they are closer */
+#define EDIT_INDEX_MIN_LINES 64
+
+/* Number of lines up to the end of page */
+#define edit_buffer_index(l, i) g_array_index ((l), long, (i))
+
 /*** file scope type declarations ****************************************************************/
 
+struct edit_buffer_map_struct
+{
+    char *data;  // reserved address range, pointers into it are unread pages
+    size_t size;
+    int fd;      // file is read with pread(), so descriptor is shared with counter thread
+    char *page;  // page read without keeping it, used in main thread only
+    dev_t dev;   // identity of file
+    ino_t ino;
+
+    // background line counter
+    GThread *counter;
+    size_t scanned;      // bytes scanned by counter, used by counter thread only
+    long *page_lines;    // lines of full pages of file, in order of b2 after opening
+    GMutex lock;         // protects lines and done
+    long lines;          // newlines found by counter
+    gboolean done;       // whole file is scanned
+    long lines_applied;  // part of lines already added to buffer
+    gint cancel;
+    int pipe[2];
+    edit_buffer_lines_fn notify;
+    void *notify_data;
+};
+
 /*** forward declarations (file scope functions) *************************************************/
 
 /*** file scope variables ************************************************************************/
 
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static inline gboolean
+edit_buffer_page_is_unread (const edit_buffer_t *buf, const void *b)
+{
+    return (buf->map != NULL && (const char *) b >= buf->map->data
+            && (const char *) b < buf->map->data + buf->map->size);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read part of large file.  The file can be truncated or changed by others after it was opened:
+ * missing data are replaced by zeros.
+ *
+ * @param map large file
+ * @param offset offset in file
+ * @param dest buffer for data
+ * @param len length of data
+ */
+
+static void
+edit_buffer_map_read (const edit_buffer_map_t *map, size_t offset, char *dest, size_t len)
+{
+    size_t done = 0;
+
+    while (done < len)
+    {
+        ssize_t n;
+
+        n = pread (map->fd, dest + done, len - done, (off_t) (offset + done));
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += (size_t) n;
+    }
+
+    memset (dest + done, 0, len - done);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get data of page without keeping of unread page in memory.  Data of unread page are valid
+ * until the next call.
+ *
+ * @param buf pointer to editor buffer
+ * @param b page
+ *
+ * @return pointer to data of page
+ */
+
+static const char *
+edit_buffer_peek_page (const edit_buffer_t *buf, const char *b)
+{
+    if (!edit_buffer_page_is_unread (buf, b))
+        return b;
+
+    edit_buffer_map_read (buf->map, (size_t) (b - buf->map->data), buf->map->page, EDIT_BUF_SIZE);
+
+    return buf->map->page;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get page of b1 or b2 to access or modify its data.  Unread page is read into memory.
+ *
+ * @param buf pointer to editor buffer
+ * @param pages b1 or b2
+ * @param k index of page
+ *
+ * @return pointer to page
+ */
+
+static char *
+edit_buffer_get_page (const edit_buffer_t *buf, GPtrArray *pages, guint k)
+{
+    char *b;
+
+    b = g_ptr_array_index (pages, k);
+    if (edit_buffer_page_is_unread (buf, b))
+    {
+        char *page;
+
+        page = g_malloc (EDIT_BUF_SIZE);
+        edit_buffer_map_read (buf->map, (size_t) (b - buf->map->data), page, EDIT_BUF_SIZE);
+        g_ptr_array_index (pages, k) = page;
+        b = page;
+    }
+
+    return b;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_buffer_free_page (const edit_buffer_t *buf, void *b)
+{
+    if (!edit_buffer_page_is_unread (buf, b))
+        g_free (b);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_buffer_free_pages (const edit_buffer_t *buf, GPtrArray *pages)
+{
+    guint i;
+
+    for (i = 0; i < pages->len; i++)
+        edit_buffer_free_page (buf, g_ptr_array_index (pages, i));
+
+    g_ptr_array_free (pages, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static long
+edit_buffer_count_newlines (const char *s, size_t len)
+{
+    const char *end = s + len;
+    long lines = 0;
+
+    while ((s = memchr (s, '\n', (size_t) (end - s))) != NULL)
+    {
+        lines++;
+        s++;
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find n-th newline.  String should contain at least n newlines, but unread page of large file
+ * may be changed after its lines were counted.
+ *
+ * @return pointer to newline, pointer to the last byte if there are less newlines
+ */
+
+static const char *
+edit_buffer_find_newline (const char *s, size_t len, long n)
+{
+    const char *end = s + len;
+
+    for (s--; n > 0; n--)
+    {
+        const char *p;
+
+        p = memchr (s + 1, '\n', (size_t) (end - s - 1));
+        if (p == NULL)
+            return end - 1;
+        s = p;
+    }
+
+    return s;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count lines in page.  Lines of unread full pages of large file are already counted.
+ *
+ * @param buf pointer to editor buffer
+ * @param b page
+ * @param start offset of data in page
+ * @param len length of data
+ *
+ * @return number of lines
+ */
+
+static long
+edit_buffer_count_page_lines (const edit_buffer_t *buf, const char *b, off_t start, off_t len)
+{
+    const edit_buffer_map_t *map = buf->map;
+
+    if (len == EDIT_BUF_SIZE && edit_buffer_page_is_unread (buf, b) && map->counter == NULL
+        && map->scanned == map->size)
+    {
+        size_t rest;
+
+        rest = (size_t) (map->data + map->size - b);
+        if ((rest & M_EDIT_BUF_SIZE) == 0)
+            return map->page_lines[rest / EDIT_BUF_SIZE - 1];
+    }
+
+    return edit_buffer_count_newlines (edit_buffer_peek_page (buf, b) + start, (size_t) len);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline long
+edit_buffer_index_total (const GArray *l)
+{
+    return (l->len == 0 ? 0 : edit_buffer_index (l, l->len - 1));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add new page to line index.
+ *
+ * @param l line index of b1 or b2
+ * @param lines number of lines in new page
+ */
+
+static void
+edit_buffer_index_push (GArray *l, long lines)
+{
+    lines += edit_buffer_index_total (l);
+    g_array_append_val (l, lines);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove top page from line index.
+ *
+ * @param l line index of b1 or b2
+ * @param lines number of lines remaining in b1 or b2
+ */
+
+static void
+edit_buffer_index_pop (GArray *l, long lines)
+{
+    g_array_set_size (l, l->len - 1);
+
+    if (l->len != 0)
+        edit_buffer_index (l, l->len - 1) = lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Build line index of editor buffer.
+ *
+ * @param buf pointer to editor buffer
+ */
+
+static void
+edit_buffer_index_lines (edit_buffer_t *buf)
+{
+    guint i;
+
+    buf->l1 = g_array_sized_new (FALSE, FALSE, sizeof (long), buf->b1->len);
+    buf->l2 = g_array_sized_new (FALSE, FALSE, sizeof (long), buf->b2->len);
+
+    for (i = 0; i < buf->b1->len; i++)
+    {
+        off_t len;
+
+        len = i + 1 < buf->b1->len ? EDIT_BUF_SIZE : ((buf->curs1 - 1) & M_EDIT_BUF_SIZE) + 1;
+        edit_buffer_index_push (
+            buf->l1, edit_buffer_count_page_lines (buf, g_ptr_array_index (buf->b1, i), 0, len));
+    }
+
+    for (i = 0; i < buf->b2->len; i++)
+    {
+        off_t len;
+
+        len = i + 1 < buf->b2->len ? EDIT_BUF_SIZE : ((buf->curs2 - 1) & M_EDIT_BUF_SIZE) + 1;
+        edit_buffer_index_push (buf->l2,
+                                edit_buffer_count_page_lines (buf, g_ptr_array_index (buf->b2, i),
+                                                              EDIT_BUF_SIZE - len, len));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_buffer_index_free (edit_buffer_t *buf)
+{
+    if (buf->l1 != NULL)
+    {
+        g_array_free (buf->l1, TRUE);
+        buf->l1 = NULL;
+    }
+
+    if (buf->l2 != NULL)
+    {
+        g_array_free (buf->l2, TRUE);
+        buf->l2 = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find page containing n-th line of b1 or b2.
+ *
+ * @param l line index of b1 or b2
+ * @param line number of line, must not be greater than number of lines in index
+ *
+ * @return index of page
+ */
+
+static guint
+edit_buffer_index_find (const GArray *l, long line)
+{
+    guint lo = 0, hi = l->len - 1;
+
+    while (lo < hi)
+    {
+        guint mid;
+
+        mid = lo + (hi - lo) / 2;
+        if (edit_buffer_index (l, mid) >= line)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return lo;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of lines before specified byte offset using line index.
+ *
+ * @param buf pointer to editor buffer
+ * @param offset byte offset
+ *
+ * @return line number
+ */
+
+static long
+edit_buffer_index_get_line (const edit_buffer_t *buf, off_t offset)
+{
+    off_t k, n;
+    long lines;
+
+    offset = CLAMP (offset, 0, buf->curs1 + buf->curs2);
+
+    if (offset <= buf->curs1)
+    {
+        k = offset >> S_EDIT_BUF_SIZE;
+        n = offset & M_EDIT_BUF_SIZE;
+        lines = k == 0 ? 0 : edit_buffer_index (buf->l1, k - 1);
+        if (n != 0)
+            lines += edit_buffer_count_newlines (edit_buffer_get_page (buf, buf->b1, (guint) k),
+                                                 (size_t) n);
+
+        return lines;
+    }
+
+    // count lines after offset in b2
+    offset = buf->curs1 + buf->curs2 - offset;
+    k = offset >> S_EDIT_BUF_SIZE;
+    n = offset & M_EDIT_BUF_SIZE;
+    lines = k == 0 ? 0 : edit_buffer_index (buf->l2, k - 1);
+    if (n != 0)
+        lines += edit_buffer_count_newlines (
+            edit_buffer_get_page (buf, buf->b2, (guint) k) + EDIT_BUF_SIZE - n, (size_t) n);
+
+    return edit_buffer_index_total (buf->l1) + edit_buffer_index_total (buf->l2) - lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset of line beginning using line index.
+ *
+ * @param buf pointer to editor buffer
+ * @param line line number
+ *
+ * @return offset of first char of line
+ */
+
+static off_t
+edit_buffer_index_get_offset (const edit_buffer_t *buf, long line)
+{
+    long lines1, lines2;
+    guint k;
+    long prev, n;
+    off_t len;
+    const char *b, *s;
+
+    lines1 = edit_buffer_index_total (buf->l1);
+    lines2 = edit_buffer_index_total (buf->l2);
+    line = MIN (line, lines1 + lines2);
+
+    if (line <= 0)
+        return 0;
+
+    if (line <= lines1)
+    {
+        k = edit_buffer_index_find (buf->l1, line);
+        prev = k == 0 ? 0 : edit_buffer_index (buf->l1, k - 1);
+        len = k + 1 < buf->b1->len ? EDIT_BUF_SIZE : ((buf->curs1 - 1) & M_EDIT_BUF_SIZE) + 1;
+        b = edit_buffer_get_page (buf, buf->b1, k);
+        s = edit_buffer_find_newline (b, (size_t) len, line - prev);
+
+        return ((off_t) k << S_EDIT_BUF_SIZE) + (s - b) + 1;
+    }
+
+    // the same newline counted from the end of file
+    line = lines2 - (line - lines1) + 1;
+    k = edit_buffer_index_find (buf->l2, line);
+    prev = k == 0 ? 0 : edit_buffer_index (buf->l2, k - 1);
+    n = edit_buffer_index (buf->l2, k) - prev;
+    len = k + 1 < buf->b2->len ? EDIT_BUF_SIZE : ((buf->curs2 - 1) & M_EDIT_BUF_SIZE) + 1;
+    b = edit_buffer_get_page (buf, buf->b2, k);
+    s = edit_buffer_find_newline (b + EDIT_BUF_SIZE - len, (size_t) len, n - (line - prev) + 1);
+
+    // see edit_buffer_get_byte_ptr()
+    return buf->curs1 + buf->curs2 - ((off_t) k << S_EDIT_BUF_SIZE) - EDIT_BUF_SIZE + (s - b) + 1;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Get pointer to byte at specified index
@@ -126,14 +601,430 @@ edit_buffer_get_byte_ptr (const edit_buffer_t *buf, off_t byte_index)
         off_t p;
 
         p = buf->curs1 + buf->curs2 - byte_index - 1;
-        b = g_ptr_array_index (buf->b2, p >> S_EDIT_BUF_SIZE);
+        b = edit_buffer_get_page (buf, buf->b2, (guint) (p >> S_EDIT_BUF_SIZE));
         return (char *) b + EDIT_BUF_SIZE - 1 - (p & M_EDIT_BUF_SIZE);
     }
 
-    b = g_ptr_array_index (buf->b1, byte_index >> S_EDIT_BUF_SIZE);
+    b = edit_buffer_get_page (buf, buf->b1, (guint) (byte_index >> S_EDIT_BUF_SIZE));
     return (char *) b + (byte_index & M_EDIT_BUF_SIZE);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get number of bytes which can be read starting from pointer to byte at specified index.
+ * Pages are not terminated by zeros, so don't read beyond the page.
+ */
+
+static off_t
+edit_buffer_get_byte_run (const edit_buffer_t *buf, off_t byte_index)
+{
+    if (byte_index >= buf->curs1)
+        return ((buf->curs1 + buf->curs2 - byte_index - 1) & M_EDIT_BUF_SIZE) + 1;
+
+    return MIN (EDIT_BUF_SIZE - (byte_index & M_EDIT_BUF_SIZE), buf->curs1 - byte_index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move one page from b2 to b1 without copying of data.  The cursor must be at the page boundary
+ * of b1.  That is possible if b2 page is full or if data is contiguous in unread pages.
+ *
+ * @param buf pointer to editor buffer
+ * @param lines number of passed lines is added to it
+ *
+ * @return TRUE if page was moved, FALSE otherwise
+ */
+
+static gboolean
+edit_buffer_move_page_forward (edit_buffer_t *buf, long *lines)
+{
+    guint top;
+    off_t fill;
+    char *b;
+    long n;
+
+    top = buf->b2->len - 1;
+    fill = buf->curs2 & M_EDIT_BUF_SIZE;
+    b = g_ptr_array_index (buf->b2, top);
+
+    if (fill != 0)
+    {
+        const char *next;
+
+        next = g_ptr_array_index (buf->b2, top - 1);
+        if (!edit_buffer_page_is_unread (buf, b) || !edit_buffer_page_is_unread (buf, next)
+            || next != b + EDIT_BUF_SIZE)
+            return FALSE;
+
+        b += EDIT_BUF_SIZE - fill;
+    }
+
+    n = edit_buffer_count_page_lines (buf, b, 0, EDIT_BUF_SIZE);
+    *lines += n;
+
+    if (buf->l1 != NULL)
+    {
+        edit_buffer_index_pop (buf->l2, edit_buffer_index_total (buf->l2) - n);
+        edit_buffer_index_push (buf->l1, n);
+    }
+
+    g_ptr_array_remove_index (buf->b2, top);
+    g_ptr_array_add (buf->b1, b);
+    buf->curs1 += EDIT_BUF_SIZE;
+    buf->curs2 -= EDIT_BUF_SIZE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move one page from b1 to b2 without copying of data.  The cursor must be at the page boundary
+ * of b2.  That is possible if b1 page is full or if data is contiguous in unread pages.
+ *
+ * @param buf pointer to editor buffer
+ * @param lines number of passed lines is added to it
+ *
+ * @return TRUE if page was moved, FALSE otherwise
+ */
+
+static gboolean
+edit_buffer_move_page_backward (edit_buffer_t *buf, long *lines)
+{
+    guint top;
+    off_t fill;
+    char *b;
+    long n;
+
+    top = buf->b1->len - 1;
+    fill = buf->curs1 & M_EDIT_BUF_SIZE;
+    b = g_ptr_array_index (buf->b1, top);
+
+    if (fill != 0)
+    {
+        char *prev;
+
+        prev = g_ptr_array_index (buf->b1, top - 1);
+        if (!edit_buffer_page_is_unread (buf, b) || !edit_buffer_page_is_unread (buf, prev)
+            || b != prev + EDIT_BUF_SIZE)
+            return FALSE;
+
+        b = prev + fill;
+    }
+
+    n = edit_buffer_count_page_lines (buf, b, 0, EDIT_BUF_SIZE);
+    *lines += n;
+
+    if (buf->l1 != NULL)
+    {
+        edit_buffer_index_pop (buf->l1, edit_buffer_index_total (buf->l1) - n);
+        edit_buffer_index_push (buf->l2, n);
+    }
+
+    g_ptr_array_remove_index (buf->b1, top);
+    g_ptr_array_add (buf->b2, b);
+    buf->curs1 -= EDIT_BUF_SIZE;
+    buf->curs2 += EDIT_BUF_SIZE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move bytes from the top page of b2 to the top page of b1.
+ *
+ * @param buf pointer to editor buffer
+ * @param len max number of bytes to move
+ * @param lines number of passed lines is added to it
+ *
+ * @return number of moved bytes
+ */
+
+static off_t
+edit_buffer_move_chunk_forward (edit_buffer_t *buf, off_t len, long *lines)
+{
+    const char *s;
+    char *b;
+    off_t run, i;
+    long n;
+
+    s = edit_buffer_get_chunk (buf, buf->curs1, &run);
+    i = buf->curs1 & M_EDIT_BUF_SIZE;
+    len = MIN (len, run);
+    len = MIN (len, EDIT_BUF_SIZE - i);
+
+    if (i == 0)
+    {
+        g_ptr_array_add (buf->b1, g_malloc0 (EDIT_BUF_SIZE));
+        if (buf->l1 != NULL)
+            edit_buffer_index_push (buf->l1, 0);
+    }
+
+    b = edit_buffer_get_page (buf, buf->b1, (guint) (buf->curs1 >> S_EDIT_BUF_SIZE));
+    memcpy (b + i, s, (size_t) len);
+    n = edit_buffer_count_newlines (s, (size_t) len);
+    *lines += n;
+
+    buf->curs1 += len;
+    buf->curs2 -= len;
+
+    if (buf->l1 != NULL)
+    {
+        edit_buffer_index (buf->l1, buf->l1->len - 1) += n;
+        edit_buffer_index (buf->l2, buf->l2->len - 1) -= n;
+    }
+
+    // top page of b2 is empty now
+    if (len == run)
+    {
+        guint top;
+
+        top = buf->b2->len - 1;
+        b = g_ptr_array_index (buf->b2, top);
+        g_ptr_array_remove_index (buf->b2, top);
+        edit_buffer_free_page (buf, b);
+        if (buf->l1 != NULL)
+            g_array_set_size (buf->l2, top);
+    }
+
+    return len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move bytes from the top page of b1 to the top page of b2.
+ *
+ * @param buf pointer to editor buffer
+ * @param len max number of bytes to move
+ * @param lines number of passed lines is added to it
+ *
+ * @return number of moved bytes
+ */
+
+static off_t
+edit_buffer_move_chunk_backward (edit_buffer_t *buf, off_t len, long *lines)
+{
+    const char *s;
+    char *b;
+    off_t run, i;
+    long n;
+
+    s = edit_buffer_get_prev_chunk (buf, buf->curs1, &run);
+    i = buf->curs2 & M_EDIT_BUF_SIZE;
+    len = MIN (len, run);
+    len = MIN (len, EDIT_BUF_SIZE - i);
+    // the last bytes of chunk are moved
+    s += run - len;
+
+    if (i == 0)
+    {
+        g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+        if (buf->l1 != NULL)
+            edit_buffer_index_push (buf->l2, 0);
+    }
+
+    b = edit_buffer_get_page (buf, buf->b2, (guint) (buf->curs2 >> S_EDIT_BUF_SIZE));
+    memcpy (b + EDIT_BUF_SIZE - i - len, s, (size_t) len);
+    n = edit_buffer_count_newlines (s, (size_t) len);
+    *lines += n;
+
+    buf->curs1 -= len;
+    buf->curs2 += len;
+
+    if (buf->l1 != NULL)
+    {
+        edit_buffer_index (buf->l1, buf->l1->len - 1) -= n;
+        edit_buffer_index (buf->l2, buf->l2->len - 1) += n;
+    }
+
+    // top page of b1 is empty now
+    if (len == run)
+    {
+        guint top;
+
+        top = buf->b1->len - 1;
+        b = g_ptr_array_index (buf->b1, top);
+        g_ptr_array_remove_index (buf->b1, top);
+        edit_buffer_free_page (buf, b);
+        if (buf->l1 != NULL)
+            g_array_set_size (buf->l1, top);
+    }
+
+    return len;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count lines of the next part of large file by pages.  Lines of full pages are kept to build
+ * line index later.
+ *
+ * @param map large file
+ * @param len number of bytes to scan, rounded up to the page boundary
+ * @param page buffer of page size to read file
+ *
+ * @return number of lines
+ */
+
+static long
+edit_buffer_map_count_lines (edit_buffer_map_t *map, size_t len, char *page)
+{
+    const size_t head = map->size & M_EDIT_BUF_SIZE;
+    const size_t end = MIN (map->scanned + len, map->size);
+    long lines = 0;
+
+    while (map->scanned < end)
+    {
+        size_t n;
+        long l;
+
+        // partial page at the beginning of file is read into memory, see edit_buffer_map_file()
+        n = map->scanned < head ? head - map->scanned : EDIT_BUF_SIZE;
+        edit_buffer_map_read (map, map->scanned, page, n);
+        l = edit_buffer_count_newlines (page, n);
+        if (map->scanned >= head)
+            map->page_lines[(map->size - map->scanned) / EDIT_BUF_SIZE - 1] = l;
+
+        lines += l;
+        map->scanned += n;
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop line counter of large file.  Counter thread must be finished or cancelled.
+ */
+
+static void
+edit_buffer_stop_counter (edit_buffer_map_t *map)
+{
+    if (map->counter != NULL)
+    {
+        g_thread_join (map->counter);
+        map->counter = NULL;
+    }
+
+    if (map->pipe[0] != -1)
+    {
+        delete_select_channel (map->pipe[0]);
+        close (map->pipe[0]);
+        close (map->pipe[1]);
+        map->pipe[0] = map->pipe[1] = -1;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add lines found by counter since the previous call to the buffer.
+ *
+ * @return TRUE if number of lines is changed, FALSE otherwise
+ */
+
+static gboolean
+edit_buffer_apply_lines (edit_buffer_t *buf)
+{
+    edit_buffer_map_t *map = buf->map;
+    long lines;
+    gboolean done;
+
+    g_mutex_lock (&map->lock);
+    lines = map->lines;
+    done = map->done;
+    g_mutex_unlock (&map->lock);
+
+    if (done)
+    {
+        edit_buffer_stop_counter (map);
+
+        if (buf->l1 == NULL)
+            edit_buffer_index_lines (buf);
+    }
+
+    if (lines == map->lines_applied)
+        return FALSE;
+
+    buf->lines += lines - map->lines_applied;
+    map->lines_applied = lines;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+edit_buffer_lines_callback (int fd, void *info)
+{
+    edit_buffer_t *buf = (edit_buffer_t *) info;
+    char b[64];
+
+    // one redraw for all chunks counted since the previous call
+    while (read (fd, b, sizeof (b)) > 0)
+        ;
+
+    if (edit_buffer_apply_lines (buf) && buf->map->notify != NULL)
+        buf->map->notify (buf, buf->map->notify_data);
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count lines of large file.  Runs in separate thread.
+ */
+
+static gpointer
+edit_buffer_count_lines_thread (gpointer data)
+{
+    edit_buffer_map_t *map = (edit_buffer_map_t *) data;
+    gint64 notified = 0;
+    char *page;
+
+    page = g_malloc (EDIT_BUF_SIZE);
+
+    while (map->scanned < map->size && g_atomic_int_get (&map->cancel) == 0)
+    {
+        long lines;
+        gint64 now;
+
+        lines = edit_buffer_map_count_lines (map, EDIT_MAP_COUNT_CHUNK, page);
+
+        g_mutex_lock (&map->lock);
+        map->lines += lines;
+        map->done = map->scanned == map->size;
+        g_mutex_unlock (&map->lock);
+
+        now = g_get_monotonic_time ();
+        if (map->scanned == map->size || now - notified >= EDIT_MAP_NOTIFY_INTERVAL)
+        {
+            // if pipe is full, main loop is going to be woken up anyway
+            MC_UNUSED const ssize_t ret = write (map->pipe[1], "", 1);
+
+            notified = now;
+        }
+    }
+
+    g_free (page);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_buffer_map_free (edit_buffer_map_t *map)
+{
+    g_atomic_int_set (&map->cancel, 1);
+    edit_buffer_stop_counter (map);
+    g_mutex_clear (&map->lock);
+#ifdef EDIT_BUFFER_MMAP
+    munmap (map->data, map->size);
+#endif
+    close (map->fd);
+    g_free (map->page);
+    g_free (map->page_lines);
+    g_free (map);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -143,54 +1034,133 @@ edit_buffer_get_byte_ptr (const edit_buffer_t *buf, off_t byte_index)
  * @param buf pointer to editor buffer
  */
 
-void
-edit_buffer_init (edit_buffer_t *buf, off_t size)
+void
+edit_buffer_init (edit_buffer_t *buf, off_t size)
+{
+    // pages are freed by edit_buffer_free_page() because unread pages must not be freed
+    buf->b1 = g_ptr_array_sized_new (32);
+    buf->b2 = g_ptr_array_sized_new (32);
+
+    buf->curs1 = 0;
+    buf->curs2 = 0;
+
+    buf->size = size;
+    buf->lines = 0;
+
+    buf->l1 = g_array_new (FALSE, FALSE, sizeof (long));
+    buf->l2 = g_array_new (FALSE, FALSE, sizeof (long));
+
+    buf->map = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Clean editor buffers.
+ *
+ * @param buf pointer to editor buffer
+ */
+
+void
+edit_buffer_clean (edit_buffer_t *buf)
+{
+    if (buf->b1 != NULL)
+    {
+        edit_buffer_free_pages (buf, buf->b1);
+        buf->b1 = NULL;
+    }
+
+    if (buf->b2 != NULL)
+    {
+        edit_buffer_free_pages (buf, buf->b2);
+        buf->b2 = NULL;
+    }
+
+    edit_buffer_index_free (buf);
+
+    if (buf->map != NULL)
+    {
+        edit_buffer_map_free (buf->map);
+        buf->map = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get byte at specified index
+ *
+ * @param buf pointer to editor buffer
+ * @param byte_index byte index
+ *
+ * @return '\n' if byte_index is negative or larger than file size; byte at byte_index otherwise.
+ */
+
+int
+edit_buffer_get_byte (const edit_buffer_t *buf, off_t byte_index)
 {
-    buf->b1 = g_ptr_array_new_full (32, g_free);
-    buf->b2 = g_ptr_array_new_full (32, g_free);
+    char *p;
 
-    buf->curs1 = 0;
-    buf->curs2 = 0;
+    p = edit_buffer_get_byte_ptr (buf, byte_index);
 
-    buf->size = size;
-    buf->lines = 0;
+    return (p != NULL) ? *(unsigned char *) p : '\n';
 }
 
 /* --------------------------------------------------------------------------------------------- */
 /**
- * Clean editor buffers.
+ * Get contiguous bytes starting at specified index
  *
  * @param buf pointer to editor buffer
+ * @param byte_index byte index
+ * @param len number of bytes available at returned pointer
+ *
+ * @return NULL if byte_index is negative or not less than file size; pointer to byte otherwise.
  */
 
-void
-edit_buffer_clean (edit_buffer_t *buf)
+const char *
+edit_buffer_get_chunk (const edit_buffer_t *buf, off_t byte_index, off_t *len)
 {
-    if (buf->b1 != NULL)
-        g_ptr_array_free (buf->b1, TRUE);
+    const char *p;
 
-    if (buf->b2 != NULL)
-        g_ptr_array_free (buf->b2, TRUE);
+    p = edit_buffer_get_byte_ptr (buf, byte_index);
+    *len = p == NULL ? 0 : edit_buffer_get_byte_run (buf, byte_index);
+
+    return p;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 /**
- * Get byte at specified index
+ * Get contiguous bytes ending before specified index
  *
  * @param buf pointer to editor buffer
  * @param byte_index byte index
+ * @param len number of bytes available at returned pointer
  *
- * @return '\n' if byte_index is negative or larger than file size; byte at byte_index otherwise.
+ * @return NULL if byte_index is not positive or larger than file size;
+ *         pointer to the first byte of chunk otherwise.
  */
 
-int
-edit_buffer_get_byte (const edit_buffer_t *buf, off_t byte_index)
+const char *
+edit_buffer_get_prev_chunk (const edit_buffer_t *buf, off_t byte_index, off_t *len)
 {
-    char *p;
+    const char *p;
 
-    p = edit_buffer_get_byte_ptr (buf, byte_index);
+    p = edit_buffer_get_byte_ptr (buf, byte_index - 1);
+    if (p == NULL)
+    {
+        *len = 0;
+        return NULL;
+    }
 
-    return (p != NULL) ? *(unsigned char *) p : '\n';
+    if (byte_index > buf->curs1)
+    {
+        off_t i;
+
+        i = buf->curs1 + buf->curs2 - byte_index;
+        *len = MIN (EDIT_BUF_SIZE - (i & M_EDIT_BUF_SIZE), byte_index - buf->curs1);
+    }
+    else
+        *len = ((byte_index - 1) & M_EDIT_BUF_SIZE) + 1;
+
+    return p - *len + 1;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -228,7 +1198,7 @@ edit_buffer_get_utf (const edit_buffer_t *buf, off_t byte_index, int *char_lengt
         return 0;
     }
 
-    res = g_utf8_get_char_validated (str, -1);
+    res = g_utf8_get_char_validated (str, (gssize) edit_buffer_get_byte_run (buf, byte_index));
     if (res == (gunichar) (-2) || res == (gunichar) (-1))
     {
         // Retry with explicit bytes to make sure it's not a buffer boundary
@@ -328,9 +1298,19 @@ edit_buffer_count_lines (const edit_buffer_t *buf, off_t first, off_t last)
     first = MAX (first, 0);
     last = MIN (last, buf->size);
 
+    if (buf->l1 != NULL && last - first > 2 * EDIT_BUF_SIZE)
+        return edit_buffer_index_get_line (buf, last) - edit_buffer_index_get_line (buf, first);
+
     while (first < last)
-        if (edit_buffer_get_byte (buf, first++) == '\n')
-            lines++;
+    {
+        const char *s;
+        off_t len;
+
+        s = edit_buffer_get_chunk (buf, first, &len);
+        len = MIN (len, last - first);
+        lines += edit_buffer_count_newlines (s, (size_t) len);
+        first += len;
+    }
 
     return lines;
 }
@@ -351,8 +1331,21 @@ edit_buffer_get_bol (const edit_buffer_t *buf, off_t current)
     if (current <= 0)
         return 0;
 
-    for (; edit_buffer_get_byte (buf, current - 1) != '\n'; current--)
-        ;
+    if (current > buf->size)
+        return current;
+
+    while (current > 0)
+    {
+        const char *s;
+        off_t len;
+
+        s = edit_buffer_get_prev_chunk (buf, current, &len);
+        for (s += len; len > 0 && s[-1] != '\n'; s--, len--)
+            current--;
+
+        if (len > 0)
+            break;
+    }
 
     return current;
 }
@@ -373,8 +1366,21 @@ edit_buffer_get_eol (const edit_buffer_t *buf, off_t current)
     if (current >= buf->size)
         return buf->size;
 
-    for (; edit_buffer_get_byte (buf, current) != '\n'; current++)
-        ;
+    if (current < 0)
+        return current;
+
+    while (current < buf->size)
+    {
+        const char *s, *nl;
+        off_t len;
+
+        s = edit_buffer_get_chunk (buf, current, &len);
+        nl = memchr (s, '\n', (size_t) len);
+        if (nl != NULL)
+            return current + (nl - s);
+
+        current += len;
+    }
 
     return current;
 }
@@ -495,12 +1501,19 @@ edit_buffer_insert (edit_buffer_t *buf, int c)
 
     // add a new buffer if we've reached the end of the last one
     if (i == 0)
+    {
         g_ptr_array_add (buf->b1, g_malloc0 (EDIT_BUF_SIZE));
+        if (buf->l1 != NULL)
+            edit_buffer_index_push (buf->l1, 0);
+    }
 
     // perform the insertion
-    b = g_ptr_array_index (buf->b1, buf->curs1 >> S_EDIT_BUF_SIZE);
+    b = edit_buffer_get_page (buf, buf->b1, (guint) (buf->curs1 >> S_EDIT_BUF_SIZE));
     *((unsigned char *) b + i) = (unsigned char) c;
 
+    if (c == '\n' && buf->l1 != NULL)
+        edit_buffer_index (buf->l1, buf->l1->len - 1)++;
+
     // update cursor position
     buf->curs1++;
 
@@ -527,12 +1540,19 @@ edit_buffer_insert_ahead (edit_buffer_t *buf, int c)
 
     // add a new buffer if we've reached the end of the last one
     if (i == 0)
+    {
         g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+        if (buf->l1 != NULL)
+            edit_buffer_index_push (buf->l2, 0);
+    }
 
     // perform the insertion
-    b = g_ptr_array_index (buf->b2, buf->curs2 >> S_EDIT_BUF_SIZE);
+    b = edit_buffer_get_page (buf, buf->b2, (guint) (buf->curs2 >> S_EDIT_BUF_SIZE));
     *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i) = (unsigned char) c;
 
+    if (c == '\n' && buf->l1 != NULL)
+        edit_buffer_index (buf->l2, buf->l2->len - 1)++;
+
     // update cursor position
     buf->curs2++;
 
@@ -559,10 +1579,13 @@ edit_buffer_delete (edit_buffer_t *buf)
 
     prev = buf->curs2 - 1;
 
-    b = g_ptr_array_index (buf->b2, prev >> S_EDIT_BUF_SIZE);
+    b = edit_buffer_get_page (buf, buf->b2, (guint) (prev >> S_EDIT_BUF_SIZE));
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + EDIT_BUF_SIZE - 1 - i);
 
+    if (c == '\n' && buf->l1 != NULL)
+        edit_buffer_index (buf->l2, buf->l2->len - 1)--;
+
     if (i == 0)
     {
         guint j;
@@ -570,6 +1593,9 @@ edit_buffer_delete (edit_buffer_t *buf)
         j = buf->b2->len - 1;
         b = g_ptr_array_index (buf->b2, j);
         g_ptr_array_remove_index (buf->b2, j);
+        edit_buffer_free_page (buf, b);
+        if (buf->l1 != NULL)
+            g_array_set_size (buf->l2, j);
     }
 
     buf->curs2 = prev;
@@ -599,10 +1625,13 @@ edit_buffer_backspace (edit_buffer_t *buf)
 
     prev = buf->curs1 - 1;
 
-    b = g_ptr_array_index (buf->b1, prev >> S_EDIT_BUF_SIZE);
+    b = edit_buffer_get_page (buf, buf->b1, (guint) (prev >> S_EDIT_BUF_SIZE));
     i = prev & M_EDIT_BUF_SIZE;
     c = *((unsigned char *) b + i);
 
+    if (c == '\n' && buf->l1 != NULL)
+        edit_buffer_index (buf->l1, buf->l1->len - 1)--;
+
     if (i == 0)
     {
         guint j;
@@ -610,6 +1639,9 @@ edit_buffer_backspace (edit_buffer_t *buf)
         j = buf->b1->len - 1;
         b = g_ptr_array_index (buf->b1, j);
         g_ptr_array_remove_index (buf->b1, j);
+        edit_buffer_free_page (buf, b);
+        if (buf->l1 != NULL)
+            g_array_set_size (buf->l1, j);
     }
 
     buf->curs1 = prev;
@@ -620,6 +1652,169 @@ edit_buffer_backspace (edit_buffer_t *buf)
     return c;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Insert block of bytes at the cursor position without moving the cursor.  The result is the same
+ * as of edit_buffer_insert_ahead() called for each byte from the end of block, but data is copied
+ * by chunks.
+ *
+ * @param buf pointer to editor buffer
+ * @param s block of bytes
+ * @param len length of block
+ *
+ * @return number of newlines in block
+ */
+
+long
+edit_buffer_insert_block_ahead (edit_buffer_t *buf, const char *s, off_t len)
+{
+    long lines = 0;
+
+    while (len > 0)
+    {
+        char *b;
+        off_t i, n;
+        long k;
+
+        i = buf->curs2 & M_EDIT_BUF_SIZE;
+
+        // add a new buffer if we've reached the end of the last one
+        if (i == 0)
+        {
+            g_ptr_array_add (buf->b2, g_malloc0 (EDIT_BUF_SIZE));
+            if (buf->l1 != NULL)
+                edit_buffer_index_push (buf->l2, 0);
+        }
+
+        n = MIN (len, EDIT_BUF_SIZE - i);
+        len -= n;
+
+        b = edit_buffer_get_page (buf, buf->b2, (guint) (buf->curs2 >> S_EDIT_BUF_SIZE));
+        memcpy (b + EDIT_BUF_SIZE - i - n, s + len, (size_t) n);
+
+        k = edit_buffer_count_newlines (s + len, (size_t) n);
+        if (buf->l1 != NULL)
+            edit_buffer_index (buf->l2, buf->l2->len - 1) += k;
+        lines += k;
+
+        buf->curs2 += n;
+        buf->size += n;
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Delete block of bytes at the cursor position.  The result is the same as of
+ * edit_buffer_delete() called for each byte, but whole pages are removed at once and unread pages
+ * of large file are not read into memory.
+ *
+ * @param buf pointer to editor buffer
+ * @param len length of block
+ *
+ * @return number of deleted newlines
+ */
+
+long
+edit_buffer_delete_block (edit_buffer_t *buf, off_t len)
+{
+    long lines = 0;
+
+    len = MIN (len, buf->curs2);
+
+    while (len > 0)
+    {
+        void *b;
+        guint j;
+        off_t n;
+
+        j = (guint) ((buf->curs2 - 1) >> S_EDIT_BUF_SIZE);
+        b = g_ptr_array_index (buf->b2, j);
+        n = ((buf->curs2 - 1) & M_EDIT_BUF_SIZE) + 1;
+
+        if (len < n)
+        {
+            long k;
+
+            // deleted bytes are just left before the data of page
+            k = edit_buffer_count_newlines (edit_buffer_peek_page (buf, b) + EDIT_BUF_SIZE - n,
+                                            (size_t) len);
+            if (buf->l1 != NULL)
+                edit_buffer_index (buf->l2, j) -= k;
+            lines += k;
+            n = len;
+        }
+        else
+        {
+            if (buf->l1 != NULL)
+                lines += edit_buffer_index (buf->l2, j)
+                    - (j == 0 ? 0 : edit_buffer_index (buf->l2, j - 1));
+            else
+                lines += edit_buffer_count_page_lines (buf, b, EDIT_BUF_SIZE - n, n);
+
+            g_ptr_array_remove_index (buf->b2, j);
+            edit_buffer_free_page (buf, b);
+            if (buf->l1 != NULL)
+                g_array_set_size (buf->l2, j);
+        }
+
+        len -= n;
+        buf->curs2 -= n;
+
+        // update file length
+        buf->size -= n;
+    }
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move cursor right or left.  Full pages and unread pages of large file are moved as a whole,
+ * other data is copied by chunks.
+ *
+ * @param buf pointer to editor buffer
+ * @param increment number of bytes to move cursor right (if positive) or left (if negative)
+ *
+ * @return number of lines the cursor has passed
+ */
+
+long
+edit_buffer_move_cursor (edit_buffer_t *buf, off_t increment)
+{
+    long lines = 0;
+
+    if (increment > 0)
+    {
+        increment = MIN (increment, buf->curs2);
+
+        while (increment > 0)
+        {
+            if ((buf->curs1 & M_EDIT_BUF_SIZE) == 0 && increment >= EDIT_BUF_SIZE
+                && edit_buffer_move_page_forward (buf, &lines))
+                increment -= EDIT_BUF_SIZE;
+            else
+                increment -= edit_buffer_move_chunk_forward (buf, increment, &lines);
+        }
+    }
+    else
+    {
+        increment = MIN (-increment, buf->curs1);
+
+        while (increment > 0)
+        {
+            if ((buf->curs2 & M_EDIT_BUF_SIZE) == 0 && increment >= EDIT_BUF_SIZE
+                && edit_buffer_move_page_backward (buf, &lines))
+                increment -= EDIT_BUF_SIZE;
+            else
+                increment -= edit_buffer_move_chunk_backward (buf, increment, &lines);
+        }
+    }
+
+    return lines;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Calculate forward offset with specified number of lines.
@@ -642,6 +1837,20 @@ edit_buffer_get_forward_offset (const edit_buffer_t *buf, off_t current, long li
 
     lines = MAX (lines, 0);
 
+    if (buf->l1 != NULL && lines > EDIT_INDEX_MIN_LINES)
+    {
+        long line, total;
+
+        line = edit_buffer_index_get_line (buf, current);
+        total = edit_buffer_index_total (buf->l1) + edit_buffer_index_total (buf->l2);
+
+        // there is no next line
+        if (line >= total)
+            return current;
+
+        return edit_buffer_index_get_offset (buf, line + lines);
+    }
+
     while (lines-- != 0)
     {
         long next;
@@ -670,6 +1879,15 @@ off_t
 edit_buffer_get_backward_offset (const edit_buffer_t *buf, off_t current, long lines)
 {
     lines = MAX (lines, 0);
+
+    if (buf->l1 != NULL && lines > EDIT_INDEX_MIN_LINES)
+    {
+        long line;
+
+        line = edit_buffer_index_get_line (buf, current);
+        return edit_buffer_index_get_offset (buf, line - lines);
+    }
+
     current = edit_buffer_get_bol (buf, current);
 
     while (lines-- != 0 && current != 0)
@@ -678,6 +1896,29 @@ edit_buffer_get_backward_offset (const edit_buffer_t *buf, off_t current, long l
     return current;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get offset of line beginning.
+ *
+ * @param buf editor buffer
+ * @param line line number
+ *
+ * @return offset of first char of line, offset of the last line if there are less lines
+ */
+
+off_t
+edit_buffer_get_line_offset (const edit_buffer_t *buf, long line)
+{
+    if (line <= 0)
+        return 0;
+
+    // lines of large file aren't counted yet
+    if (buf->l1 == NULL)
+        return edit_buffer_get_forward_offset (buf, 0, line, 0);
+
+    return edit_buffer_index_get_offset (buf, line);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Load file into editor buffer
@@ -694,9 +1935,10 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
                        edit_buffer_read_file_status_msg_t *sm, gboolean *aborted)
 {
     off_t ret = 0;
-    off_t i, j;
+    off_t i;
     off_t data_size;
     void *b;
+    long lines;
     status_msg_t *s = STATUS_MSG (sm);
     unsigned short update_cnt = 0;
 
@@ -704,6 +1946,8 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
 
     buf->lines = 0;
     buf->curs2 = size;
+    // lines of pages are kept in order of reading and summed up later
+    g_array_set_size (buf->l2, 0);
     i = buf->curs2 >> S_EDIT_BUF_SIZE;
 
     // fill last part of b2
@@ -716,9 +1960,9 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
         ret = mc_read (fd, b, data_size);
 
         // count lines
-        for (j = 0; j < ret; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
+        lines = ret > 0 ? edit_buffer_count_newlines (b, (size_t) ret) : 0;
+        g_array_append_val (buf->l2, lines);
+        buf->lines += lines;
 
         if (ret < 0 || ret != data_size)
             return ret;
@@ -737,9 +1981,9 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
             ret += sz;
 
         // count lines
-        for (j = 0; j < sz; j++)
-            if (*((char *) b + j) == '\n')
-                buf->lines++;
+        lines = sz > 0 ? edit_buffer_count_newlines (b, (size_t) sz) : 0;
+        g_array_append_val (buf->l2, lines);
+        buf->lines += lines;
 
         if (s != NULL && s->update != NULL)
         {
@@ -775,6 +2019,10 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
         *b1 = *b2;
         *b2 = b;
 
+        lines = edit_buffer_index (buf->l2, i);
+        edit_buffer_index (buf->l2, i) = edit_buffer_index (buf->l2, buf->b2->len - 1 - i);
+        edit_buffer_index (buf->l2, buf->b2->len - 1 - i) = lines;
+
         if (s != NULL && s->update != NULL)
         {
             update_cnt = (update_cnt + 1) & 0xf;
@@ -790,9 +2038,199 @@ edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
         }
     }
 
+    // sum up lines of pages from the end of file
+    for (i = 1; i < (off_t) buf->l2->len; i++)
+        edit_buffer_index (buf->l2, i) += edit_buffer_index (buf->l2, i - 1);
+
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Attach large local file to editor buffer instead of loading it.  Its pages are read when they
+ * are accessed.  The first lines are counted immediately, others are counted in background thread.
+ *
+ * @param buf pointer to editor buffer initialized with file size
+ * @param fd file descriptor
+ * @param notify function to call in main thread when more lines are counted
+ * @param data user data for notify function
+ *
+ * @return TRUE if file is attached, FALSE if it should be loaded with edit_buffer_read_file()
+ */
+
+gboolean
+edit_buffer_map_file (edit_buffer_t *buf, int fd, edit_buffer_lines_fn notify, void *data)
+{
+#ifdef EDIT_BUFFER_MMAP
+    edit_buffer_map_t *map;
+    struct stat st;
+    int local_fd, map_fd;
+    void *p;
+    off_t i, n;
+
+    if (buf->size < EDIT_MAP_MIN_SIZE || (uintmax_t) buf->size > (uintmax_t) SIZE_MAX)
+        return FALSE;
+
+    // file size reported by stat() must be real
+    local_fd = vfs_get_local_fd (fd);
+    if (local_fd == -1 || fstat (local_fd, &st) != 0 || !S_ISREG (st.st_mode)
+        || st.st_size != buf->size)
+        return FALSE;
+
+    // the file descriptor of VFS is closed after loading
+    map_fd = dup (local_fd);
+    if (map_fd == -1)
+        return FALSE;
+
+    // address range identifies unread pages only, it is never accessed
+    p = mmap (NULL, (size_t) buf->size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        close (map_fd);
+        return FALSE;
+    }
+
+    (void) fcntl (map_fd, F_SETFD, FD_CLOEXEC);
+
+    map = g_new0 (edit_buffer_map_t, 1);
+    map->data = (char *) p;
+    map->size = (size_t) buf->size;
+    map->fd = map_fd;
+    map->page = g_malloc (EDIT_BUF_SIZE);
+    map->dev = st.st_dev;
+    map->ino = st.st_ino;
+    g_mutex_init (&map->lock);
+    map->pipe[0] = map->pipe[1] = -1;
+    map->notify = notify;
+    map->notify_data = data;
+    map->page_lines = g_new (long, buf->size >> S_EDIT_BUF_SIZE);
+    buf->map = map;
+
+    buf->curs2 = buf->size;
+
+    // line index is built when all lines are counted
+    edit_buffer_index_free (buf);
+
+    // full pages of b2 from end to begin are unread
+    n = buf->size >> S_EDIT_BUF_SIZE;
+    for (i = 1; i <= n; i++)
+        g_ptr_array_add (buf->b2, map->data + buf->size - i * EDIT_BUF_SIZE);
+
+    // partial page at the beginning of file is read to keep all unread pages full
+    i = buf->size & M_EDIT_BUF_SIZE;
+    if (i != 0)
+    {
+        char *b;
+
+        b = g_malloc0 (EDIT_BUF_SIZE);
+        edit_buffer_map_read (map, 0, b + EDIT_BUF_SIZE - i, (size_t) i);
+        g_ptr_array_add (buf->b2, b);
+    }
+
+    // count lines of the first screens now to show them properly
+    map->lines = edit_buffer_map_count_lines (map, EDIT_MAP_COUNT_CHUNK, map->page);
+
+    if (map->scanned < map->size && pipe (map->pipe) == 0)
+    {
+        (void) fcntl (map->pipe[0], F_SETFL, O_NONBLOCK);
+        (void) fcntl (map->pipe[1], F_SETFL, O_NONBLOCK);
+        (void) fcntl (map->pipe[0], F_SETFD, FD_CLOEXEC);
+        (void) fcntl (map->pipe[1], F_SETFD, FD_CLOEXEC);
+
+        add_select_channel (map->pipe[0], edit_buffer_lines_callback, buf);
+        map->counter = g_thread_new ("mcedit-lines", edit_buffer_count_lines_thread, map);
+    }
+    else
+    {
+        // nothing to count or no way to report progress
+        map->lines += edit_buffer_map_count_lines (map, map->size, map->page);
+        map->done = TRUE;
+    }
+
+    buf->lines = map->lines;
+    map->lines_applied = map->lines;
+
+    if (map->done)
+        edit_buffer_index_lines (buf);
+
+    return TRUE;
+#else
+    (void) buf;
+    (void) fd;
+    (void) notify;
+    (void) data;
+
+    return FALSE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for background line counter of large file.
+ *
+ * @param buf pointer to editor buffer
+ *
+ * @return TRUE if number of lines is changed, FALSE otherwise
+ */
+
+gboolean
+edit_buffer_finish_lines (edit_buffer_t *buf)
+{
+    if (buf->map == NULL || buf->map->counter == NULL)
+        return FALSE;
+
+    edit_buffer_stop_counter (buf->map);
+
+    return edit_buffer_apply_lines (buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether unread pages of editor buffer are read from specified file.
+ *
+ * @param buf pointer to editor buffer
+ * @param st stat of file
+ *
+ * @return TRUE if file is attached, FALSE otherwise
+ */
+
+gboolean
+edit_buffer_is_mapped (const edit_buffer_t *buf, const struct stat *st)
+{
+    return (buf->map != NULL && buf->map->dev == st->st_dev && buf->map->ino == st->st_ino);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read all unread pages into memory and detach file.  Must be called before file is overwritten
+ * in place.
+ *
+ * @param buf pointer to editor buffer
+ */
+
+void
+edit_buffer_unmap (edit_buffer_t *buf)
+{
+    GPtrArray *pages[2] = { buf->b1, buf->b2 };
+    size_t i;
+
+    if (buf->map == NULL)
+        return;
+
+    (void) edit_buffer_finish_lines (buf);
+
+    for (i = 0; i < G_N_ELEMENTS (pages); i++)
+    {
+        guint j;
+
+        for (j = 0; j < pages[i]->len; j++)
+            (void) edit_buffer_get_page (buf, pages[i], j);
+    }
+
+    edit_buffer_map_free (buf->map);
+    buf->map = NULL;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Write editor buffer content to file
@@ -818,7 +2256,7 @@ edit_buffer_write_file (edit_buffer_t *buf, int fd)
         for (i = 0; i < (off_t) buf->b1->len - 1; i++)
         {
             b = g_ptr_array_index (buf->b1, i);
-            sz = mc_write (fd, b, data_size);
+            sz = mc_write (fd, edit_buffer_peek_page (buf, b), data_size);
             if (sz >= 0)
                 ret += sz;
             else if (i == 0)
@@ -830,7 +2268,7 @@ edit_buffer_write_file (edit_buffer_t *buf, int fd)
         // write last partially filled part of b1
         data_size = ((buf->curs1 - 1) & M_EDIT_BUF_SIZE) + 1;
         b = g_ptr_array_index (buf->b1, i);
-        sz = mc_write (fd, b, data_size);
+        sz = mc_write (fd, edit_buffer_peek_page (buf, b), data_size);
         if (sz >= 0)
             ret += sz;
         if (sz != data_size)
@@ -844,7 +2282,7 @@ edit_buffer_write_file (edit_buffer_t *buf, int fd)
         i = buf->b2->len - 1;
         b = g_ptr_array_index (buf->b2, i);
         data_size = ((buf->curs2 - 1) & M_EDIT_BUF_SIZE) + 1;
-        sz = mc_write (fd, (char *) b + EDIT_BUF_SIZE - data_size, data_size);
+        sz = mc_write (fd, edit_buffer_peek_page (buf, b) + EDIT_BUF_SIZE - data_size, data_size);
         if (sz >= 0)
             ret += sz;
 
@@ -855,7 +2293,7 @@ edit_buffer_write_file (edit_buffer_t *buf, int fd)
             while (--i >= 0)
             {
                 b = g_ptr_array_index (buf->b2, i);
-                sz = mc_write (fd, b, data_size);
+                sz = mc_write (fd, edit_buffer_peek_page (buf, b), data_size);
                 if (sz >= 0)
                     ret += sz;
                 if (sz != data_size)
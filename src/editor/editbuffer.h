@@ -11,17 +11,25 @@
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+typedef struct edit_buffer_map_struct edit_buffer_map_t;
+
 typedef struct edit_buffer_struct
 {
-    off_t curs1;     // position of the cursor from the beginning of the file.
-    off_t curs2;     // position from the end of the file
-    GPtrArray *b1;   // all data up to curs1
-    GPtrArray *b2;   // all data from end of file down to curs2
-    off_t size;      // file size
-    long lines;      // total lines in the file
-    long curs_line;  // line number of the cursor.
+    off_t curs1;             // position of the cursor from the beginning of the file.
+    off_t curs2;             // position from the end of the file
+    GPtrArray *b1;           // all data up to curs1
+    GPtrArray *b2;           // all data from end of file down to curs2
+    off_t size;              // file size
+    long lines;              // total lines in the file
+    long curs_line;          // line number of the cursor.
+    GArray *l1;              // lines up to the end of each page of b1, NULL if not counted yet
+    GArray *l2;              // lines up to the end of each page of b2 from the end of file
+    edit_buffer_map_t *map;  // large file with unread pages, NULL if file is loaded
 } edit_buffer_t;
 
+/* called when background line counter has found more lines */
+typedef void (*edit_buffer_lines_fn) (edit_buffer_t *buf, void *data);
+
 typedef struct edit_buffer_read_file_status_msg_struct
 {
     simple_status_msg_t status_msg;  // base class
@@ -39,6 +47,8 @@ void edit_buffer_init (edit_buffer_t *buf, off_t size);
 void edit_buffer_clean (edit_buffer_t *buf);
 
 int edit_buffer_get_byte (const edit_buffer_t *buf, off_t byte_index);
+const char *edit_buffer_get_chunk (const edit_buffer_t *buf, off_t byte_index, off_t *len);
+const char *edit_buffer_get_prev_chunk (const edit_buffer_t *buf, off_t byte_index, off_t *len);
 int edit_buffer_get_utf (const edit_buffer_t *buf, off_t byte_index, int *char_length);
 int edit_buffer_get_prev_utf (const edit_buffer_t *buf, off_t byte_index, int *char_length);
 long edit_buffer_count_lines (const edit_buffer_t *buf, off_t first, off_t last);
@@ -52,13 +62,23 @@ void edit_buffer_insert (edit_buffer_t *buf, int c);
 void edit_buffer_insert_ahead (edit_buffer_t *buf, int c);
 int edit_buffer_delete (edit_buffer_t *buf);
 int edit_buffer_backspace (edit_buffer_t *buf);
+long edit_buffer_insert_block_ahead (edit_buffer_t *buf, const char *s, off_t len);
+long edit_buffer_delete_block (edit_buffer_t *buf, off_t len);
 
 off_t edit_buffer_get_forward_offset (const edit_buffer_t *buf, off_t current, long lines,
                                       off_t upto);
 off_t edit_buffer_get_backward_offset (const edit_buffer_t *buf, off_t current, long lines);
+off_t edit_buffer_get_line_offset (const edit_buffer_t *buf, long line);
+
+long edit_buffer_move_cursor (edit_buffer_t *buf, off_t increment);
 
 off_t edit_buffer_read_file (edit_buffer_t *buf, int fd, off_t size,
                              edit_buffer_read_file_status_msg_t *sm, gboolean *aborted);
+gboolean edit_buffer_map_file (edit_buffer_t *buf, int fd, edit_buffer_lines_fn notify,
+                               void *data);
+gboolean edit_buffer_finish_lines (edit_buffer_t *buf);
+gboolean edit_buffer_is_mapped (const edit_buffer_t *buf, const struct stat *st);
+void edit_buffer_unmap (edit_buffer_t *buf);
 off_t edit_buffer_write_file (edit_buffer_t *buf, int fd);
 
 int edit_buffer_calc_percent (const edit_buffer_t *buf, off_t offset);
@@ -74,8 +74,6 @@ int search_create_bookmark = FALSE;
 
 /*** file scope macro definitions ****************************************************************/
 
-#define TEMP_BUF_LEN 1024
-
 /*** file scope type declarations ****************************************************************/
 
 /*** forward declarations (file scope functions) *************************************************/
@@ -205,6 +203,19 @@ edit_save_file (WEdit *edit, const vfs_path_t *filename_vpath)
                 return -1;
             }
         }
+
+        // Unmodified parts of large file are read from the file itself: don't overwrite it.
+        if (this_save_mode == EDIT_QUICK_SAVE && edit_buffer_is_mapped (&edit->buffer, &sb))
+        {
+            if (sb.st_nlink == 1)
+                this_save_mode = EDIT_SAFE_SAVE;
+            else
+            {
+                // keep hard links
+                edit_wait_lines (edit);
+                edit_buffer_unmap (&edit->buffer);
+            }
+        }
     }
 
     if (this_save_mode == EDIT_QUICK_SAVE)
@@ -549,12 +560,7 @@ edit_block_delete (WEdit *edit, off_t start_mark, off_t end_mark)
                 edit->over_col = curs_pos - line_width;
         }
         else
-        {
-            off_t count;
-
-            for (count = start_mark; count < end_mark; count++)
-                edit_delete (edit, TRUE);
-        }
+            edit_delete_block (edit, end_mark - start_mark);
     }
 
     edit_set_markers (edit, 0, 0, 0, 0);
@@ -591,11 +597,18 @@ edit_get_block (WEdit *edit, const off_t start, const off_t finish)
         }
     }
     else
-        for (off_t i = start; i < finish; i++)
+        for (off_t i = start; i < finish;)
         {
-            const int c = edit_buffer_get_byte (&edit->buffer, i);
+            const char *s;
+            off_t len;
+
+            s = edit_buffer_get_chunk (&edit->buffer, i, &len);
+            if (s == NULL)
+                break;
 
-            g_string_append_c (r, (gchar) c);
+            len = MIN (len, finish - i);
+            g_string_append_len (r, s, len);
+            i += len;
         }
 
     return r;
@@ -1358,8 +1371,7 @@ edit_block_copy_cmd (WEdit *edit)
     }
     else
     {
-        for (gsize i = copy_buf->len; i != 0; i--)
-            edit_insert_ahead (edit, copy_buf->str[i - 1]);
+        edit_insert_block_ahead (edit, copy_buf->str, (off_t) copy_buf->len);
 
         // Place cursor at the end of text selection
         if (edit_options.cursor_after_inserted_block)
@@ -1449,33 +1461,29 @@ edit_block_move_cmd (WEdit *edit)
     }
     else
     {
-        unsigned char *copy_buf;
-        off_t count, count_orig;
+        GString *copy_buf;
         off_t x;
 
         current = edit->buffer.curs1;
-        copy_buf = g_malloc0 (end_mark - start_mark);
+        copy_buf = edit_get_block (edit, start_mark, end_mark);
         edit_cursor_move (edit, start_mark - edit->buffer.curs1);
         edit_scroll_screen_over_cursor (edit);
 
-        for (count = start_mark; count < end_mark; count++)
-            copy_buf[end_mark - count - 1] = edit_delete (edit, TRUE);
+        edit_delete_block (edit, end_mark - start_mark);
 
         edit_scroll_screen_over_cursor (edit);
         x = current > edit->buffer.curs1 ? end_mark - start_mark : 0;
         edit_cursor_move (edit, current - edit->buffer.curs1 - x);
         edit_scroll_screen_over_cursor (edit);
-        count_orig = count;
-        while (count-- > start_mark)
-            edit_insert_ahead (edit, copy_buf[end_mark - count - 1]);
-        g_free (copy_buf);
+        edit_insert_block_ahead (edit, copy_buf->str, (off_t) copy_buf->len);
+        g_string_free (copy_buf, TRUE);
 
         edit_set_markers (edit, edit->buffer.curs1, edit->buffer.curs1 + end_mark - start_mark, 0,
                           0);
 
         // Place cursor at the end of text selection
         if (edit_options.cursor_after_inserted_block)
-            edit_cursor_move (edit, count_orig - start_mark);
+            edit_cursor_move (edit, end_mark - start_mark);
     }
 
     edit_scroll_screen_over_cursor (edit);
@@ -1570,8 +1578,17 @@ edit_save_block (WEdit *edit, const char *filename, off_t start, off_t finish)
     int file;
     vfs_path_t *vpath;
     off_t len = 1;
+    struct stat sb;
 
     vpath = vfs_path_from_str (filename);
+
+    // unread parts of large file are read from the file itself: read them before truncation
+    if (mc_stat (vpath, &sb) == 0 && edit_buffer_is_mapped (&edit->buffer, &sb))
+    {
+        edit_wait_lines (edit);
+        edit_buffer_unmap (&edit->buffer);
+    }
+
     file = mc_open (vpath, O_CREAT | O_WRONLY | O_TRUNC,
                     S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH | O_BINARY);
     vfs_path_free (vpath, TRUE);
@@ -1606,22 +1623,25 @@ edit_save_block (WEdit *edit, const char *filename, off_t start, off_t finish)
     }
     else
     {
-        unsigned char *buf;
-        off_t i = start;
-
         len = finish - start;
-        buf = g_malloc0 (TEMP_BUF_LEN);
-        while (start != finish)
+        while (start < finish)
         {
-            off_t end;
+            const char *s;
+            off_t n;
+            ssize_t r;
+
+            s = edit_buffer_get_chunk (&edit->buffer, start, &n);
+            if (s == NULL)
+                break;
 
-            end = MIN (finish, start + TEMP_BUF_LEN);
-            for (; i < end; i++)
-                buf[i - start] = edit_buffer_get_byte (&edit->buffer, i);
-            len -= mc_write (file, (char *) buf, end - start);
-            start = end;
+            n = MIN (n, finish - start);
+            r = mc_write (file, s, n);
+            if (r <= 0)
+                break;
+
+            len -= r;
+            start += r;
         }
-        g_free (buf);
     }
     mc_close (file);
 
@@ -1734,7 +1754,10 @@ edit_goto_cmd (WEdit *edit)
     }
 
     if (l < 0)
+    {
+        edit_wait_lines (edit);
         l = edit->buffer.lines + l + 2;
+    }
 
     edit_move_display (edit, l - WIDGET (edit)->rect.lines / 2 - 1);
     edit_move_to_line (edit, l - 1);
@@ -989,6 +989,13 @@ edit_callback (Widget *w, Widget *sender, widget_msg_t msg, int parm, void *data
     }
 
     case MSG_IDLE:
+        // highlight the text skipped while drawing the screen
+        if (edit_syntax_idle (e))
+        {
+            widget_idle (WIDGET (w->owner), TRUE);
+            if (e->force == 0)
+                return MSG_HANDLED;
+        }
         edit_update_screen (e);
         return MSG_HANDLED;
 
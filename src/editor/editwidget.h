@@ -15,8 +15,6 @@
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
-#define N_LINE_CACHES 32
-
 /*** enums ***************************************************************************************/
 
 /*** structures declarations (and typedefs of structures)*****************************************/
@@ -113,11 +111,6 @@ struct WEdit
     off_t bracket;        // position of a matching bracket
     off_t last_bracket;   // previous position of a matching bracket
 
-    // cache speedup for line lookups
-    gboolean caches_valid;
-    long line_numbers[N_LINE_CACHES];
-    off_t line_offsets[N_LINE_CACHES];
-
     edit_book_mark_t *book_mark;
     GArray *serialized_bookmarks;
 
@@ -143,10 +136,18 @@ struct WEdit
     unsigned int skip_detach_prompt : 1;  // Do not prompt whether to detach a file anymore
 
     // syntax highlighting
-    GSList *syntax_marker;
+    GArray *syntax_markers;        // highlighting states sorted by offset
+    guint syntax_shift_index;      // markers starting from this one...
+    off_t syntax_shift;            // ...are stored with offsets less by this value
+    gboolean syntax_dirty;         // text was changed since the markers were recorded
+    off_t syntax_valid;            // if dirty, markers before this offset are valid
+    off_t syntax_dirty_end;        // if dirty, markers after this offset predate the change
+    off_t syntax_idle_target;      // highlight up to this offset in idle time
     GPtrArray *rules;
     off_t last_get_rule;
     edit_syntax_rule_t rule;
+    unsigned int rule_exact : 1;   // rule is the highlighting state at last_get_rule
+    unsigned int rule_approx : 1;  // rule is a guess of the highlighting state
     char *syntax_type;             // description of syntax highlighting type being used
     GTree *defines;                // List of defines
     gboolean is_case_insensitive;  // selects language case sensitivity
@@ -75,6 +75,10 @@ gboolean auto_syntax = TRUE;
 
 /* bytes */
 #define SYNTAX_MARKER_DENSITY 512
+/* bytes highlighted at once, the rest is estimated and highlighted in idle time */
+#define SYNTAX_SYNC_LIMIT     (256 * 1024)
+/* bytes highlighted in one idle call */
+#define SYNTAX_IDLE_CHUNK     (64 * 1024)
 
 #define RULE_ON_LEFT_BORDER   1
 #define RULE_ON_RIGHT_BORDER  2
@@ -124,8 +128,18 @@ typedef struct
     char *whole_word_chars_right;
     gboolean line_start;
     int color;
+    guint next;  // next keyword with the same literal prefix
 } syntax_keyword_t;
 
+/* node of the trie of keyword literal prefixes (up to the first wildcard) */
+typedef struct
+{
+    unsigned char c;
+    guint child;    // first child node
+    guint sibling;  // next node with the same parent
+    guint keyword;  // first keyword whose literal prefix ends in this node
+} syntax_trie_node_t;
+
 typedef struct
 {
     GString *left;
@@ -137,10 +151,12 @@ typedef struct
     gboolean between_delimiters;
     char *whole_word_chars_left;
     char *whole_word_chars_right;
-    char *keyword_first_chars;
     gboolean spelling;
     // first word is word[1]
     GPtrArray *keyword;
+    // keywords compiled into a trie, node 0 is the root
+    GArray *keyword_trie;
+    guint keyword_first[256];  // children of the root indexed by the first byte
 } context_rule_t;
 
 typedef struct
@@ -181,11 +197,13 @@ context_rule_free (gpointer rule)
     g_string_free (r->right, TRUE);
     g_free (r->whole_word_chars_left);
     g_free (r->whole_word_chars_right);
-    g_free (r->keyword_first_chars);
 
     if (r->keyword != NULL)
         g_ptr_array_free (r->keyword, TRUE);
 
+    if (r->keyword_trie != NULL)
+        g_array_free (r->keyword_trie, TRUE);
+
     g_free (r);
 }
 
@@ -381,13 +399,76 @@ compare_word_to_right (const WEdit *edit, off_t i, const GString *text, const ch
 
 /* --------------------------------------------------------------------------------------------- */
 
-static const char *
-xx_strchr (const WEdit *edit, const unsigned char *s, int char_byte)
+/**
+ * Find the first keyword of the context which matches the text at the specified offset.
+ *
+ * Only keywords whose literal prefix is found in the trie along the text are compared.
+ *
+ * @param edit editor object
+ * @param r    context rule
+ * @param i    offset in the text
+ * @param c    byte at i, in lower case if the syntax is case insensitive
+ * @param end  the end of the matched keyword
+ *
+ * @return index of the keyword, or 0 if no keyword matches
+ */
+
+static guint
+match_keyword_to_right (const WEdit *edit, const context_rule_t *r, off_t i, int c, off_t *end)
 {
-    while (*s >= '\005' && xx_tolower (edit, *s) != char_byte)
-        s++;
+    guint best = 0;
+    guint node = 0;
+    off_t j = i;
+
+    if (r->keyword_trie == NULL)
+        return 0;
+
+    while (TRUE)
+    {
+        const syntax_trie_node_t *n;
+        guint k;
+
+        n = &g_array_index (r->keyword_trie, syntax_trie_node_t, node);
+
+        // keywords are linked in order of declaration, the first matching one wins
+        for (k = n->keyword; k != 0 && (best == 0 || k < best);)
+        {
+            const syntax_keyword_t *kw = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, k));
+            off_t e;
 
-    return (const char *) s;
+            e = compare_word_to_right (edit, i, kw->keyword, kw->whole_word_chars_left,
+                                       kw->whole_word_chars_right, kw->line_start);
+            if (e > 0)
+            {
+                best = k;
+                *end = e;
+                break;
+            }
+
+            k = kw->next;
+        }
+
+        if (node == 0)
+            node = r->keyword_first[c & 0xff];
+        else
+        {
+            int d;
+
+            d = edit_buffer_get_byte (&edit->buffer, ++j);
+            d = xx_tolower (edit, d);
+
+            for (node = n->child; node != 0;)
+            {
+                n = &g_array_index (r->keyword_trie, syntax_trie_node_t, node);
+                if (n->c == d)
+                    break;
+                node = n->sibling;
+            }
+        }
+
+        if (node == 0)
+            return best;
+    }
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -460,43 +541,32 @@ apply_rules_going_right (WEdit *edit, off_t i)
     // check to turn on a keyword
     if (_rule.keyword == 0)
     {
-        const char *p;
+        guint count;
+        off_t e = -1;
 
         r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule.context));
-        p = r->keyword_first_chars;
+        count = match_keyword_to_right (edit, r, i, c, &e);
+        if (count != 0)
+        {
+            syntax_keyword_t *k;
 
-        if (p != NULL)
-            while (*(p = xx_strchr (edit, (const unsigned char *) p + 1, c)) != '\0')
-            {
-                syntax_keyword_t *k;
-                int count;
-                off_t e = -1;
-
-                count = p - r->keyword_first_chars;
-                k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, count));
-                if (k->keyword != 0)
-                    e = compare_word_to_right (edit, i, k->keyword, k->whole_word_chars_left,
-                                               k->whole_word_chars_right, k->line_start);
-                if (e > 0)
-                {
-                    /* when both context and keyword terminate with a newline,
-                       the context overflows to the next line and colorizes it incorrectly */
-                    if (e > i + 1 && _rule._context != 0
-                        && k->keyword->str[k->keyword->len - 1] == '\n')
-                    {
-                        r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule._context));
-                        if (r->right != NULL && r->right->len != 0
-                            && r->right->str[r->right->len - 1] == '\n')
-                            e--;
-                    }
+            k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, count));
 
-                    end = e;
-                    _rule.end = e;
-                    _rule.keyword = count;
-                    keyword_foundright = TRUE;
-                    break;
-                }
+            /* when both context and keyword terminate with a newline,
+               the context overflows to the next line and colorizes it incorrectly */
+            if (e > i + 1 && _rule._context != 0 && k->keyword->str[k->keyword->len - 1] == '\n')
+            {
+                r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule._context));
+                if (r->right != NULL && r->right->len != 0
+                    && r->right->str[r->right->len - 1] == '\n')
+                    e--;
             }
+
+            end = e;
+            _rule.end = e;
+            _rule.keyword = count;
+            keyword_foundright = TRUE;
+        }
     }
 
     // check to turn on a context
@@ -575,93 +645,333 @@ apply_rules_going_right (WEdit *edit, off_t i)
     // check again to turn on a keyword if the context switched
     if (contextchanged && _rule.keyword == 0)
     {
-        const char *p;
+        guint count;
+        off_t e = -1;
 
         r = CONTEXT_RULE (g_ptr_array_index (edit->rules, _rule.context));
-        p = r->keyword_first_chars;
-
-        while (*(p = xx_strchr (edit, (const unsigned char *) p + 1, c)) != '\0')
+        count = match_keyword_to_right (edit, r, i, c, &e);
+        if (count != 0)
         {
-            syntax_keyword_t *k;
-            int count;
-            off_t e = -1;
-
-            count = p - r->keyword_first_chars;
-            k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, count));
-
-            if (k->keyword->len != 0)
-                e = compare_word_to_right (edit, i, k->keyword, k->whole_word_chars_left,
-                                           k->whole_word_chars_right, k->line_start);
-            if (e > 0)
-            {
-                _rule.end = e;
-                _rule.keyword = count;
-                break;
-            }
+            _rule.end = e;
+            _rule.keyword = count;
         }
     }
 
     edit->rule = _rule;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether two highlighting states at the specified offset are the same.
+ * End of a rule which has been passed already doesn't affect highlighting after the offset.
+ */
+
+static gboolean
+syntax_rule_equal (const edit_syntax_rule_t *a, const edit_syntax_rule_t *b, off_t offset)
+{
+    return a->keyword == b->keyword && a->context == b->context && a->_context == b->_context
+        && a->border == b->border && (a->end == b->end || (a->end <= offset && b->end <= offset));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get real offset of the marker.
+ *
+ * Markers starting from edit->syntax_shift_index are not updated after every insertion and
+ * deletion: their stored offsets lag behind by edit->syntax_shift.
+ */
+
+static off_t
+syntax_marker_offset (const WEdit *edit, guint i)
+{
+    const syntax_marker_t *s = &g_array_index (edit->syntax_markers, syntax_marker_t, i);
+
+    return i >= edit->syntax_shift_index ? s->offset + edit->syntax_shift : s->offset;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
-edit_get_rule (WEdit *edit, off_t byte_index)
+syntax_marker_get (const WEdit *edit, guint i, syntax_marker_t *marker)
+{
+    *marker = g_array_index (edit->syntax_markers, syntax_marker_t, i);
+
+    if (i >= edit->syntax_shift_index)
+    {
+        marker->offset += edit->syntax_shift;
+        marker->rule.end += edit->syntax_shift;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+syntax_marker_set (WEdit *edit, guint i, off_t offset, const edit_syntax_rule_t *rule)
+{
+    syntax_marker_t *s = &g_array_index (edit->syntax_markers, syntax_marker_t, i);
+
+    s->offset = offset;
+    s->rule = *rule;
+
+    if (i >= edit->syntax_shift_index)
+    {
+        s->offset -= edit->syntax_shift;
+        s->rule.end -= edit->syntax_shift;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+syntax_marker_insert (WEdit *edit, guint i, off_t offset, const edit_syntax_rule_t *rule)
+{
+    syntax_marker_t s;
+
+    g_array_insert_vals (edit->syntax_markers, i, &s, 1);
+    if (i < edit->syntax_shift_index)
+        edit->syntax_shift_index++;
+    syntax_marker_set (edit, i, offset, rule);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+syntax_marker_remove (WEdit *edit, guint i)
+{
+    g_array_remove_index (edit->syntax_markers, i);
+    if (i < edit->syntax_shift_index)
+        edit->syntax_shift_index--;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the first marker located after the specified offset.
+ *
+ * @return index of the marker or the number of markers if there is no such marker
+ */
+
+static guint
+syntax_marker_upper_bound (const WEdit *edit, off_t offset)
+{
+    guint lo = 0, hi;
+
+    if (edit->syntax_markers == NULL)
+        return 0;
+
+    hi = edit->syntax_markers->len;
+
+    while (lo < hi)
+    {
+        const guint mid = lo + (hi - lo) / 2;
+
+        if (syntax_marker_offset (edit, mid) <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Shift markers starting from the specified one by delta bytes.
+ *
+ * Only markers between the specified one and the previous shift boundary are touched, so
+ * a sequence of edits at nearby offsets costs O(1) per edit.
+ */
+
+static void
+syntax_markers_shift (WEdit *edit, guint i, off_t delta)
+{
+    guint j;
+
+    for (j = edit->syntax_shift_index; j < i; j++)
+    {
+        syntax_marker_t *s = &g_array_index (edit->syntax_markers, syntax_marker_t, j);
+
+        s->offset += edit->syntax_shift;
+        s->rule.end += edit->syntax_shift;
+    }
+
+    for (j = i; j < edit->syntax_shift_index; j++)
+    {
+        syntax_marker_t *s = &g_array_index (edit->syntax_markers, syntax_marker_t, j);
+
+        s->offset -= edit->syntax_shift;
+        s->rule.end -= edit->syntax_shift;
+    }
+
+    edit->syntax_shift_index = i;
+    edit->syntax_shift = i < edit->syntax_markers->len ? edit->syntax_shift + delta : 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Find the nearest marker which highlighting can be continued from.
+ *
+ * @return index of the marker plus one, or 0 if highlighting should start from the beginning
+ */
+
+static guint
+syntax_marker_find_start (const WEdit *edit, off_t byte_index)
+{
+    // markers after an edit are not trusted until the highlighting state converges
+    if (edit->syntax_dirty && byte_index >= edit->syntax_valid)
+        byte_index = edit->syntax_valid - 1;
+
+    return syntax_marker_upper_bound (edit, byte_index);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static off_t
+syntax_marker_start_offset (const WEdit *edit, guint n)
+{
+    return n == 0 ? -2 : syntax_marker_offset (edit, n - 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+syntax_restart (WEdit *edit, guint n)
+{
+    if (n == 0)
+    {
+        memset (&edit->rule, 0, sizeof (edit->rule));
+        edit->last_get_rule = -2;
+    }
+    else
+    {
+        syntax_marker_t s;
+
+        syntax_marker_get (edit, n - 1, &s);
+        edit->rule = s.rule;
+        edit->last_get_rule = s.offset;
+    }
+
+    edit->rule_exact = 1;
+    edit->rule_approx = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Advance the highlighting state up to byte_index.
+ *
+ * If the state is exact, markers are recorded on the way. Markers left after an edit are
+ * compared with the new state: the first match beyond the edited text means the rest of
+ * the markers are still correct. Markers recorded with the exact state after an edit are valid,
+ * so the next pass doesn't lex the same text again even if the state doesn't converge.
+ */
+
+static void
+syntax_lex_forward (WEdit *edit, off_t byte_index)
 {
     off_t i;
+    guint n = 0;
+    off_t prev = 0, next = 0;
 
-    if (byte_index > edit->last_get_rule)
+    if (edit->rule_exact)
     {
-        for (i = edit->last_get_rule + 1; i <= byte_index; i++)
-        {
-            off_t d = SYNTAX_MARKER_DENSITY;
+        if (edit->syntax_markers == NULL)
+            edit->syntax_markers = g_array_new (FALSE, FALSE, sizeof (syntax_marker_t));
+
+        n = syntax_marker_upper_bound (edit, edit->last_get_rule);
+        if (n != 0)
+            prev = syntax_marker_offset (edit, n - 1);
+        if (n < edit->syntax_markers->len)
+            next = syntax_marker_offset (edit, n);
+    }
 
-            apply_rules_going_right (edit, i);
+    for (i = edit->last_get_rule + 1; i <= byte_index; i++)
+    {
+        apply_rules_going_right (edit, i);
 
-            if (edit->syntax_marker != NULL)
-                d += ((syntax_marker_t *) edit->syntax_marker->data)->offset;
+        if (!edit->rule_exact)
+            continue;
 
-            if (i > d)
+        if (n < edit->syntax_markers->len && i == next)
+        {
+            if (edit->syntax_dirty && i >= edit->syntax_valid)
             {
-                syntax_marker_t *s;
+                syntax_marker_t s;
 
-                s = g_new (syntax_marker_t, 1);
-                s->offset = i;
-                s->rule = edit->rule;
-                edit->syntax_marker = g_slist_prepend (edit->syntax_marker, s);
+                syntax_marker_get (edit, n, &s);
+                if (i > edit->syntax_dirty_end && syntax_rule_equal (&s.rule, &edit->rule, i))
+                    edit->syntax_dirty = FALSE;
+                else
+                {
+                    syntax_marker_set (edit, n, i, &edit->rule);
+                    // don't mix new markers with ones left from before the change
+                    edit->syntax_dirty_end = MAX (edit->syntax_dirty_end, i);
+                    // the state is exact, so the next pass can continue from the new marker
+                    edit->syntax_valid = i + 1;
+                }
             }
+
+            prev = i;
+            n++;
+            if (n < edit->syntax_markers->len)
+                next = syntax_marker_offset (edit, n);
         }
-    }
-    else if (byte_index < edit->last_get_rule)
-    {
-        while (TRUE)
+        else if (i > prev + SYNTAX_MARKER_DENSITY)
         {
-            syntax_marker_t *s;
-
-            if (edit->syntax_marker == NULL)
+            syntax_marker_insert (edit, n, i, &edit->rule);
+            if (edit->syntax_dirty && i >= edit->syntax_valid)
             {
-                memset (&edit->rule, 0, sizeof (edit->rule));
-                for (i = -1; i <= byte_index; i++)
-                    apply_rules_going_right (edit, i);
-                break;
+                edit->syntax_dirty_end = MAX (edit->syntax_dirty_end, i);
+                edit->syntax_valid = i + 1;
             }
+            prev = i;
+            n++;
+        }
 
-            s = (syntax_marker_t *) edit->syntax_marker->data;
+        if (edit->syntax_dirty && i >= edit->syntax_valid
+            && edit_buffer_get_byte (&edit->buffer, i) == '\n')
+            edit->syntax_valid = i + 1;
+    }
 
-            if (byte_index >= s->offset)
-            {
-                edit->rule = s->rule;
-                for (i = s->offset + 1; i <= byte_index; i++)
-                    apply_rules_going_right (edit, i);
-                break;
-            }
+    edit->last_get_rule = byte_index;
+}
 
-            g_free (s);
-            edit->syntax_marker = g_slist_delete_link (edit->syntax_marker, edit->syntax_marker);
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+edit_get_rule (WEdit *edit, off_t byte_index)
+{
+    gboolean usable;
+    guint n;
+    off_t start;
+
+    usable = (edit->rule_exact || edit->rule_approx) && edit->last_get_rule <= byte_index;
+    if (usable && edit->last_get_rule == byte_index)
+        return;
+
+    n = syntax_marker_find_start (edit, byte_index);
+    start = syntax_marker_start_offset (edit, n);
+
+    if (!usable || edit->last_get_rule < start
+        || byte_index - edit->last_get_rule > SYNTAX_SYNC_LIMIT
+        || (edit->rule_approx && byte_index - start <= SYNTAX_SYNC_LIMIT))
+    {
+        if (byte_index - start <= SYNTAX_SYNC_LIMIT)
+            syntax_restart (edit, n);
+        else
+        {
+            /* Too far from any known state: guess the state to draw the screen now
+               and leave highlighting of the text before it to idle time */
+            memset (&edit->rule, 0, sizeof (edit->rule));
+            edit->last_get_rule = byte_index - 1;
+            edit->rule_exact = 0;
+            edit->rule_approx = 1;
+
+            edit->syntax_idle_target = MAX (edit->syntax_idle_target, byte_index);
+            if (WIDGET (edit)->owner != NULL)
+                widget_idle (WIDGET (WIDGET (edit)->owner), TRUE);
         }
     }
-    edit->last_get_rule = byte_index;
+
+    syntax_lex_forward (edit, byte_index);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -949,6 +1259,90 @@ xx_lowerize_line (WEdit *edit, char *line, size_t len)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/** Find or add the child of the trie node */
+
+static guint
+keyword_trie_child (context_rule_t *r, guint node, unsigned char c)
+{
+    syntax_trie_node_t *n, child;
+    guint i;
+
+    if (node == 0)
+        i = r->keyword_first[c];
+    else
+        i = g_array_index (r->keyword_trie, syntax_trie_node_t, node).child;
+
+    for (; i != 0; i = n->sibling)
+    {
+        n = &g_array_index (r->keyword_trie, syntax_trie_node_t, i);
+        if (n->c == c)
+            return i;
+    }
+
+    i = r->keyword_trie->len;
+    child.c = c;
+    child.child = 0;
+    child.keyword = 0;
+
+    if (node == 0)
+    {
+        child.sibling = 0;
+        r->keyword_first[c] = i;
+    }
+    else
+    {
+        n = &g_array_index (r->keyword_trie, syntax_trie_node_t, node);
+        child.sibling = n->child;
+        n->child = i;
+    }
+
+    g_array_append_val (r->keyword_trie, child);
+
+    return i;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compile keywords of the context into a trie of their literal prefixes.
+ *
+ * Keywords starting with a wildcard are attached to the root and compared at every byte.
+ * Keywords with the same literal prefix are linked in order of declaration.
+ */
+
+static void
+context_rule_compile_keywords (context_rule_t *r)
+{
+    syntax_trie_node_t root = { 0, 0, 0, 0 };
+    guint i;
+
+    r->keyword_trie = g_array_new (FALSE, FALSE, sizeof (syntax_trie_node_t));
+    g_array_append_val (r->keyword_trie, root);
+
+    for (i = 1; i < r->keyword->len; i++)
+    {
+        syntax_keyword_t *k;
+        const unsigned char *p;
+        guint node = 0;
+        guint *last;
+
+        k = SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, i));
+        p = (const unsigned char *) k->keyword->str;
+
+        // an empty keyword has always stopped the search
+        if (*p == '\0')
+            break;
+
+        for (; *p > SYNTAX_TOKEN_BRACE; p++)
+            node = keyword_trie_child (r, node, *p);
+
+        last = &g_array_index (r->keyword_trie, syntax_trie_node_t, node).keyword;
+        while (*last != 0)
+            last = &SYNTAX_KEYWORD (g_ptr_array_index (r->keyword, *last))->next;
+        *last = i;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /** returns line number on error */
 
@@ -1251,34 +1645,12 @@ edit_read_syntax_rules (WEdit *edit, FILE *f, char **args, int args_size)
     if (result == 0)
     {
         size_t i;
-        GString *first_chars;
 
         if (edit->rules == NULL)
             return line;
 
-        first_chars = g_string_sized_new (32);
-
-        // collect first character of keywords
         for (i = 0; i < edit->rules->len; i++)
-        {
-            size_t j;
-
-            g_string_set_size (first_chars, 0);
-            c = CONTEXT_RULE (g_ptr_array_index (edit->rules, i));
-
-            g_string_append_c (first_chars, (char) 1);
-            for (j = 1; j < c->keyword->len; j++)
-            {
-                syntax_keyword_t *k;
-
-                k = SYNTAX_KEYWORD (g_ptr_array_index (c->keyword, j));
-                g_string_append_c (first_chars, k->keyword->str[0]);
-            }
-
-            c->keyword_first_chars = g_strndup (first_chars->str, first_chars->len);
-        }
-
-        g_string_free (first_chars, TRUE);
+            context_rule_compile_keywords (CONTEXT_RULE (g_ptr_array_index (edit->rules, i)));
     }
 
     return result;
@@ -1496,6 +1868,125 @@ edit_get_syntax_color (WEdit *edit, off_t byte_index)
     return EDITOR_NORMAL_COLOR;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update highlighting markers before a byte is inserted or deleted.
+ *
+ * Markers before the line preceding the change stay valid. Markers after it are kept and
+ * verified against the new highlighting state when the text is highlighted again.
+ *
+ * @param edit   editor object
+ * @param offset offset of the inserted or deleted byte
+ * @param delta  1 if a byte is inserted at offset, -1 if the byte at offset is deleted
+ */
+
+void
+edit_syntax_invalidate (WEdit *edit, off_t offset, int delta)
+{
+    guint n;
+
+    if (edit->rules == NULL)
+        return;
+
+    /* Keywords can span up to the first byte of the next line,
+       so the highlighting of the previous line can depend on the changed byte */
+    if (!edit->syntax_dirty || offset <= edit->syntax_valid)
+    {
+        off_t bol;
+
+        bol = offset == 0 ? 0 : edit_buffer_get_bol (&edit->buffer, offset - 1);
+
+        if (!edit->syntax_dirty)
+        {
+            edit->syntax_dirty = TRUE;
+            edit->syntax_valid = bol;
+            edit->syntax_dirty_end = offset;
+        }
+        else
+            edit->syntax_valid = MIN (edit->syntax_valid, bol);
+    }
+
+    // the text after syntax_dirty_end is the same as it was when the markers were recorded
+    if (delta > 0)
+    {
+        if (edit->syntax_dirty_end >= offset)
+            edit->syntax_dirty_end++;
+        edit->syntax_dirty_end = MAX (edit->syntax_dirty_end, offset + 1);
+    }
+    else
+    {
+        if (edit->syntax_dirty_end > offset)
+            edit->syntax_dirty_end--;
+        edit->syntax_dirty_end = MAX (edit->syntax_dirty_end, offset);
+    }
+
+    if (edit->last_get_rule >= edit->syntax_valid)
+    {
+        edit->rule_exact = 0;
+        edit->rule_approx = 0;
+    }
+
+    if (edit->syntax_markers == NULL)
+        return;
+
+    n = syntax_marker_upper_bound (edit, offset - 1);
+    if (delta < 0 && n < edit->syntax_markers->len && syntax_marker_offset (edit, n) == offset)
+        syntax_marker_remove (edit, n);
+    syntax_markers_shift (edit, n, delta);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Highlight the text which was skipped by edit_get_syntax_color() because it was too far away
+ * from any known highlighting state. Called in idle time.
+ *
+ * @param edit editor object
+ *
+ * @return TRUE if there is more text to highlight, FALSE otherwise
+ */
+
+gboolean
+edit_syntax_idle (WEdit *edit)
+{
+    off_t target, start;
+    guint n;
+    edit_syntax_rule_t rule;
+    off_t last_get_rule;
+    gboolean exact, approx;
+
+    if (edit->syntax_idle_target <= 0)
+        return FALSE;
+
+    target = MIN (edit->syntax_idle_target, edit->buffer.size - 1);
+    n = syntax_marker_find_start (edit, target);
+    start = syntax_marker_start_offset (edit, n);
+
+    if (!edit_options.syntax_highlighting || edit->rules == NULL
+        || target - start <= SYNTAX_SYNC_LIMIT)
+    {
+        // the screen can be highlighted exactly now
+        edit->syntax_idle_target = 0;
+        edit->force |= REDRAW_PAGE;
+        return FALSE;
+    }
+
+    // keep the state used to draw the screen
+    rule = edit->rule;
+    last_get_rule = edit->last_get_rule;
+    exact = edit->rule_exact != 0;
+    approx = edit->rule_approx != 0;
+
+    syntax_restart (edit, n);
+    syntax_lex_forward (edit, MIN (start + SYNTAX_IDLE_CHUNK, target));
+
+    edit->rule = rule;
+    edit->last_get_rule = last_get_rule;
+    edit->rule_exact = exact ? 1 : 0;
+    edit->rule_approx = approx ? 1 : 0;
+
+    return TRUE;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -1510,12 +2001,23 @@ edit_free_syntax_rules (WEdit *edit)
     if (edit->rules == NULL)
         return;
 
-    edit_get_rule (edit, -1);
     MC_PTR_FREE (edit->syntax_type);
 
     g_ptr_array_free (edit->rules, TRUE);
     edit->rules = NULL;
-    g_clear_slist (&edit->syntax_marker, g_free);
+
+    if (edit->syntax_markers != NULL)
+    {
+        g_array_free (edit->syntax_markers, TRUE);
+        edit->syntax_markers = NULL;
+    }
+    edit->syntax_shift_index = 0;
+    edit->syntax_shift = 0;
+    edit->syntax_dirty = FALSE;
+    edit->syntax_idle_target = 0;
+    edit->last_get_rule = -1;
+    edit->rule_exact = 0;
+    edit->rule_approx = 0;
     tty_color_free_temp ();
 }
 
@@ -86,7 +86,7 @@
 #include "boxes.h"        // cd_box()
 #include "dir.h"
 #include "cd.h"
-#include "ioblksize.h"  // IO_BUFSIZE
+#include "filecmp.h"
 
 #include "cmd.h"  // Our definitions
 
@@ -165,52 +165,57 @@ do_edit (const vfs_path_t *what_vpath)
 
 /* --------------------------------------------------------------------------------------------- */
 
-static int
-compare_files (const vfs_path_t *vpath1, const vfs_path_t *vpath2, off_t size)
+/**
+ * Create index of panel entries by name. Basenames are used if panel is panelized.
+ * If several entries have the same name, the first one is indexed.
+ *
+ * @param panel file panel
+ *
+ * @return hash table of file_entry_t pointers
+ */
+
+static GHashTable *
+compare_dir_index (const WPanel *panel)
 {
-    int file1;
-    int result = -1;  // Different by default
+    GHashTable *index;
+    int i;
 
-    if (size == 0)
-        return 0;
+    index = g_hash_table_new (g_str_hash, g_str_equal);
 
-    file1 = open (vfs_path_as_str (vpath1), O_RDONLY);
-    if (file1 >= 0)
+    // go backwards: value of the first entry is set last
+    for (i = panel->dir.len - 1; i >= 0; i--)
     {
-        int file2;
-
-        file2 = open (vfs_path_as_str (vpath2), O_RDONLY);
-        if (file2 >= 0)
-        {
-            char buf1[IO_BUFSIZE], buf2[IO_BUFSIZE];
-            ssize_t n1, n2;
+        file_entry_t *fe = &panel->dir.list[i];
+        const char *fname;
 
-            rotate_dash (TRUE);
-            do
-            {
-                while ((n1 = read (file1, buf1, sizeof (buf1))) == -1 && errno == EINTR)
-                    ;
-                while ((n2 = read (file2, buf2, sizeof (buf2))) == -1 && errno == EINTR)
-                    ;
-            }
-            while (n1 == n2 && n1 == sizeof (buf1) && memcmp (buf1, buf2, sizeof (buf1)) == 0);
-            result = (n1 != n2) || (memcmp (buf1, buf2, MIN ((size_t) n1, sizeof (buf1))) != 0);
-            rotate_dash (FALSE);
+        fname = fe->fname->str;
+        if (panel->is_panelized)
+            fname = x_basename (fname);
 
-            close (file2);
-        }
-        close (file1);
+        g_hash_table_insert (index, (gpointer) fname, fe);
     }
 
-    return result;
+    return index;
 }
 
 /* --------------------------------------------------------------------------------------------- */
 
-static void
+/**
+ * Mark files of panel that are absent in other panel or differ from them.
+ *
+ * @return FALSE if compare was interrupted by user, TRUE otherwise
+ */
+
+static gboolean
 compare_dir (WPanel *panel, const WPanel *other, enum CompareMode mode)
 {
-    int i, j;
+    GHashTable *other_index;
+    GPtrArray *pairs;
+    gboolean ret = TRUE;
+    int i;
+
+    other_index = compare_dir_index (other);
+    pairs = g_ptr_array_new_with_free_func (file_cmp_pair_free);
 
     // No marks by default
     panel->marked = 0;
@@ -221,6 +226,7 @@ compare_dir (WPanel *panel, const WPanel *other, enum CompareMode mode)
     for (i = 0; i < panel->dir.len; i++)
     {
         file_entry_t *source = &panel->dir.list[i];
+        file_entry_t *target;
         const char *source_fname;
 
         // Default: unmarked
@@ -235,26 +241,14 @@ compare_dir (WPanel *panel, const WPanel *other, enum CompareMode mode)
             source_fname = x_basename (source_fname);
 
         // Search the corresponding entry from the other panel
-        for (j = 0; j < other->dir.len; j++)
-        {
-            const char *other_fname;
-
-            other_fname = other->dir.list[j].fname->str;
-            if (other->is_panelized)
-                other_fname = x_basename (other_fname);
-
-            if (strcmp (source_fname, other_fname) == 0)
-                break;
-        }
+        target = (file_entry_t *) g_hash_table_lookup (other_index, source_fname);
 
-        if (j >= other->dir.len)
+        if (target == NULL)
             // Not found -> mark
             do_file_mark (panel, i, 1);
         else
         {
             // Found
-            file_entry_t *target = &other->dir.list[j];
-
             if (mode != compare_size_only)
                 // Older version is not marked
                 if (source->st.st_mtime < target->st.st_mtime)
@@ -280,7 +274,8 @@ compare_dir (WPanel *panel, const WPanel *other, enum CompareMode mode)
                 continue;
             }
 
-            // Thorough compare on, do byte-by-byte comparison
+            // Thorough compare on, do byte-by-byte comparison later
+            if (source->st.st_size != 0)
             {
                 vfs_path_t *src_name, *dst_name;
 
@@ -288,13 +283,32 @@ compare_dir (WPanel *panel, const WPanel *other, enum CompareMode mode)
                     vfs_path_append_new (panel->cwd_vpath, source->fname->str, (char *) NULL);
                 dst_name =
                     vfs_path_append_new (other->cwd_vpath, target->fname->str, (char *) NULL);
-                if (compare_files (src_name, dst_name, source->st.st_size))
-                    do_file_mark (panel, i, 1);
-                vfs_path_free (src_name, TRUE);
-                vfs_path_free (dst_name, TRUE);
+                g_ptr_array_add (pairs,
+                                 file_cmp_pair_new (src_name, dst_name, source->st.st_size, i));
             }
         }
     }  // for (i ...)
+
+    g_hash_table_destroy (other_index);
+
+    if (pairs->len != 0)
+    {
+        guint j;
+
+        ret = file_cmp_run (pairs);
+
+        for (j = 0; j < pairs->len; j++)
+        {
+            const file_cmp_pair_t *pair = (const file_cmp_pair_t *) g_ptr_array_index (pairs, j);
+
+            if (pair->differ)
+                do_file_mark (panel, pair->index, 1);
+        }
+    }
+
+    g_ptr_array_free (pairs, TRUE);
+
+    return ret;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -1013,8 +1027,8 @@ compare_dirs_cmd (void)
 
     if (get_current_type () == view_listing && get_other_type () == view_listing)
     {
-        compare_dir (current_panel, other_panel, thorough_flag);
-        compare_dir (other_panel, current_panel, thorough_flag);
+        if (compare_dir (current_panel, other_panel, thorough_flag))
+            compare_dir (other_panel, current_panel, thorough_flag);
     }
     else
         message (D_ERROR, MSG_ERROR,
@@ -1243,6 +1257,7 @@ single_dirsize_cmd (WPanel *panel)
         {
             entry->st.st_size = (off_t) total;
             entry->f.dir_size_computed = 1;
+            file_entry_reset_cache (entry);
         }
 
         vfs_path_free (p, TRUE);
@@ -1293,6 +1308,7 @@ dirsizes_cmd (WPanel *panel)
 
             panel->dir.list[i].st.st_size = (off_t) total;
             panel->dir.list[i].f.dir_size_computed = 1;
+            file_entry_reset_cache (&panel->dir.list[i]);
         }
 
     status_msg_deinit (STATUS_MSG (&dsm));
@@ -0,0 +1,497 @@
+/*
+   Pipelined copy of file data.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file copypipe.c
+ *  \brief Source: pipelined copy of file data
+ *
+ *  If source and target files are on different devices, reading and writing are overlapped:
+ *  one side of copy is done in a separate thread, the other one in the caller's thread.
+ *  Both sides exchange data via ring of buffers.
+ *
+ *  VFS is not thread-safe, so only the local file is accessed from the thread, using its
+ *  system descriptor. Errors of the thread are returned to the caller, which decides whether
+ *  to retry the failed operation.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"  // vfs_get_local_fd()
+
+#include "copypipe.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+/* preferred size of all buffers of ring */
+#define COPY_PIPE_RING_SIZE (4 * 1024 * 1024)
+
+#define COPY_PIPE_MIN_BUFS  2
+#define COPY_PIPE_MAX_BUFS  16
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    char *data;
+    size_t len;   // size of data
+    size_t done;  // size of already written data
+} copy_pipe_buf_t;
+
+struct copy_pipe_t
+{
+    copy_pipe_side_t side;
+    int fd;  // local file accessed by the thread
+    GThread *thread;
+
+    GMutex lock;
+    GCond cond;
+
+    copy_pipe_buf_t *bufs;
+    guint nbufs;
+    size_t bufsize;
+    guint head;   // first filled buffer
+    guint count;  // number of filled buffers
+
+    gboolean eof;     // reader: end of file is reached
+    gboolean failed;  // thread is stopped due to error and waits for retry
+    int error;        // errno of failed operation
+    gboolean stop;    // thread should exit
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static ssize_t
+copy_pipe_sys_read (int fd, char *buf, size_t count)
+{
+    ssize_t n;
+
+    while ((n = read (fd, buf, count)) == -1 && errno == EINTR)
+        ;
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+copy_pipe_reader (gpointer data)
+{
+    copy_pipe_t *cp = (copy_pipe_t *) data;
+
+    g_mutex_lock (&cp->lock);
+
+    while (!cp->stop)
+    {
+        copy_pipe_buf_t *buf;
+        ssize_t n;
+        int error;
+
+        if (cp->failed || cp->eof || cp->count == cp->nbufs)
+        {
+            g_cond_wait (&cp->cond, &cp->lock);
+            continue;
+        }
+
+        buf = &cp->bufs[(cp->head + cp->count) % cp->nbufs];
+
+        g_mutex_unlock (&cp->lock);
+        n = copy_pipe_sys_read (cp->fd, buf->data, cp->bufsize);
+        error = errno;
+        g_mutex_lock (&cp->lock);
+
+        if (n < 0)
+        {
+            cp->failed = TRUE;
+            cp->error = error;
+        }
+        else
+        {
+            buf->len = (size_t) n;
+            cp->count++;
+            cp->eof = (n == 0);
+        }
+
+        g_cond_broadcast (&cp->cond);
+    }
+
+    g_mutex_unlock (&cp->lock);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+copy_pipe_writer (gpointer data)
+{
+    copy_pipe_t *cp = (copy_pipe_t *) data;
+
+    g_mutex_lock (&cp->lock);
+
+    while (!cp->stop)
+    {
+        copy_pipe_buf_t *buf;
+        ssize_t n;
+        int error;
+
+        if (cp->failed || cp->count == 0)
+        {
+            g_cond_wait (&cp->cond, &cp->lock);
+            continue;
+        }
+
+        buf = &cp->bufs[cp->head];
+
+        g_mutex_unlock (&cp->lock);
+        while ((n = write (cp->fd, buf->data + buf->done, buf->len - buf->done)) == -1
+               && errno == EINTR)
+            ;
+        error = errno;
+        g_mutex_lock (&cp->lock);
+
+        if (n < 0 || (n == 0 && buf->done < buf->len))
+        {
+            cp->failed = TRUE;
+            cp->error = n < 0 ? error : ENOSPC;
+        }
+        else
+        {
+            buf->done += (size_t) n;
+            if (buf->done == buf->len)
+            {
+                cp->head = (cp->head + 1) % cp->nbufs;
+                cp->count--;
+            }
+        }
+
+        g_cond_broadcast (&cp->cond);
+    }
+
+    g_mutex_unlock (&cp->lock);
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create pipe to copy data between files.
+ *
+ * The side of copy is chosen automatically: if source file is local, it is read in the thread,
+ * otherwise the target file is written in the thread.
+ *
+ * @param src_vfs_fd source file opened via VFS
+ * @param dest_vfs_fd target file opened via VFS
+ * @param bufsize preferred size of I/O operation
+ *
+ * @return newly allocated pipe or NULL if files are not suitable for pipelined copy or
+ *         thread cannot be created
+ */
+
+copy_pipe_t *
+copy_pipe_new (int src_vfs_fd, int dest_vfs_fd, size_t bufsize)
+{
+    copy_pipe_t *cp;
+    int src_fd, dest_fd;
+    GThreadFunc func;
+    guint i;
+
+    src_fd = vfs_get_local_fd (src_vfs_fd);
+    dest_fd = vfs_get_local_fd (dest_vfs_fd);
+
+    if (src_fd == -1 && dest_fd == -1)
+        return NULL;
+
+    if (src_fd != -1 && dest_fd != -1)
+    {
+        struct stat src_st, dest_st;
+
+        // page cache already overlaps reading and writing on the same device
+        if (fstat (src_fd, &src_st) != 0 || fstat (dest_fd, &dest_st) != 0
+            || src_st.st_dev == dest_st.st_dev)
+            return NULL;
+    }
+
+    cp = g_new0 (copy_pipe_t, 1);
+
+    if (src_fd != -1)
+    {
+        cp->side = COPY_PIPE_READER;
+        cp->fd = src_fd;
+        func = copy_pipe_reader;
+    }
+    else
+    {
+        cp->side = COPY_PIPE_WRITER;
+        cp->fd = dest_fd;
+        func = copy_pipe_writer;
+    }
+
+    cp->bufsize = bufsize;
+    cp->nbufs = CLAMP (COPY_PIPE_RING_SIZE / bufsize, COPY_PIPE_MIN_BUFS, COPY_PIPE_MAX_BUFS);
+    cp->bufs = g_new0 (copy_pipe_buf_t, cp->nbufs);
+    for (i = 0; i < cp->nbufs; i++)
+        cp->bufs[i].data = g_malloc (bufsize);
+
+    g_mutex_init (&cp->lock);
+    g_cond_init (&cp->cond);
+
+    cp->thread = g_thread_try_new ("copy", func, cp, NULL);
+    if (cp->thread == NULL)
+    {
+        copy_pipe_free (cp);
+        return NULL;
+    }
+
+    return cp;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop the thread and free pipe. Data that was not written yet is dropped.
+ *
+ * @param cp pipe
+ */
+
+void
+copy_pipe_free (copy_pipe_t *cp)
+{
+    guint i;
+
+    if (cp == NULL)
+        return;
+
+    if (cp->thread != NULL)
+    {
+        g_mutex_lock (&cp->lock);
+        cp->stop = TRUE;
+        g_cond_broadcast (&cp->cond);
+        g_mutex_unlock (&cp->lock);
+
+        g_thread_join (cp->thread);
+    }
+
+    for (i = 0; i < cp->nbufs; i++)
+        g_free (cp->bufs[i].data);
+    g_free (cp->bufs);
+
+    g_cond_clear (&cp->cond);
+    g_mutex_clear (&cp->lock);
+    g_free (cp);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+copy_pipe_side_t
+copy_pipe_get_side (const copy_pipe_t *cp)
+{
+    return cp->side;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get next block of source file. Reader side only.
+ * Block should be returned to the pipe with copy_pipe_release() after use.
+ *
+ * @param cp pipe
+ * @param data pointer to store block data
+ *
+ * @return size of block, 0 at the end of file, -1 on error (errno is set)
+ */
+
+ssize_t
+copy_pipe_read (copy_pipe_t *cp, char **data)
+{
+    ssize_t ret;
+
+    g_mutex_lock (&cp->lock);
+
+    while (cp->count == 0 && !cp->failed)
+        g_cond_wait (&cp->cond, &cp->lock);
+
+    if (cp->count != 0)
+    {
+        *data = cp->bufs[cp->head].data;
+        ret = (ssize_t) cp->bufs[cp->head].len;
+    }
+    else
+    {
+        errno = cp->error;
+        ret = -1;
+    }
+
+    g_mutex_unlock (&cp->lock);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Return block got by copy_pipe_read() to the pipe. Reader side only.
+ *
+ * @param cp pipe
+ */
+
+void
+copy_pipe_release (copy_pipe_t *cp)
+{
+    g_mutex_lock (&cp->lock);
+    cp->head = (cp->head + 1) % cp->nbufs;
+    cp->count--;
+    g_cond_broadcast (&cp->cond);
+    g_mutex_unlock (&cp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get free buffer to put data to be written. Writer side only.
+ * Buffer is of size passed to copy_pipe_new() and should be queued with copy_pipe_write().
+ *
+ * @param cp pipe
+ *
+ * @return buffer or NULL if write of previous data failed (errno is set)
+ */
+
+char *
+copy_pipe_get_buffer (copy_pipe_t *cp)
+{
+    char *ret = NULL;
+
+    g_mutex_lock (&cp->lock);
+
+    while (cp->count == cp->nbufs && !cp->failed)
+        g_cond_wait (&cp->cond, &cp->lock);
+
+    if (cp->failed)
+        errno = cp->error;
+    else
+        ret = cp->bufs[(cp->head + cp->count) % cp->nbufs].data;
+
+    g_mutex_unlock (&cp->lock);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Queue buffer got by copy_pipe_get_buffer() to be written. Writer side only.
+ *
+ * @param cp pipe
+ * @param len size of data in buffer
+ */
+
+void
+copy_pipe_write (copy_pipe_t *cp, size_t len)
+{
+    copy_pipe_buf_t *buf;
+
+    g_mutex_lock (&cp->lock);
+    buf = &cp->bufs[(cp->head + cp->count) % cp->nbufs];
+    buf->len = len;
+    buf->done = 0;
+    cp->count++;
+    g_cond_broadcast (&cp->cond);
+    g_mutex_unlock (&cp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait until all queued data is written. Writer side only.
+ *
+ * @param cp pipe
+ *
+ * @return 0 on success, -1 on error (errno is set)
+ */
+
+int
+copy_pipe_flush (copy_pipe_t *cp)
+{
+    int ret = 0;
+
+    g_mutex_lock (&cp->lock);
+
+    while (cp->count != 0 && !cp->failed)
+        g_cond_wait (&cp->cond, &cp->lock);
+
+    if (cp->failed)
+    {
+        errno = cp->error;
+        ret = -1;
+    }
+
+    g_mutex_unlock (&cp->lock);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop data which failed to be written and continue with the next block. Writer side only.
+ *
+ * @param cp pipe
+ */
+
+void
+copy_pipe_skip (copy_pipe_t *cp)
+{
+    g_mutex_lock (&cp->lock);
+    if (cp->failed && cp->count != 0)
+    {
+        cp->head = (cp->head + 1) % cp->nbufs;
+        cp->count--;
+    }
+    cp->failed = FALSE;
+    g_cond_broadcast (&cp->cond);
+    g_mutex_unlock (&cp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Repeat failed operation.
+ *
+ * @param cp pipe
+ */
+
+void
+copy_pipe_retry (copy_pipe_t *cp)
+{
+    g_mutex_lock (&cp->lock);
+    cp->failed = FALSE;
+    g_cond_broadcast (&cp->cond);
+    g_mutex_unlock (&cp->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,45 @@
+/** \file copypipe.h
+ *  \brief Header: pipelined copy of file data
+ */
+
+#ifndef MC__COPYPIPE_H
+#define MC__COPYPIPE_H
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct copy_pipe_t copy_pipe_t;
+
+/*** enums ***************************************************************************************/
+
+/* which side of copy is done in the pipe thread */
+typedef enum
+{
+    COPY_PIPE_READER = 0,  // thread reads source file, caller writes data
+    COPY_PIPE_WRITER       // caller reads data, thread writes target file
+} copy_pipe_side_t;
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+copy_pipe_t *copy_pipe_new (int src_vfs_fd, int dest_vfs_fd, size_t bufsize);
+void copy_pipe_free (copy_pipe_t *cp);
+copy_pipe_side_t copy_pipe_get_side (const copy_pipe_t *cp);
+
+ssize_t copy_pipe_read (copy_pipe_t *cp, char **data);
+void copy_pipe_release (copy_pipe_t *cp);
+
+char *copy_pipe_get_buffer (copy_pipe_t *cp);
+void copy_pipe_write (copy_pipe_t *cp, size_t len);
+int copy_pipe_flush (copy_pipe_t *cp);
+void copy_pipe_skip (copy_pipe_t *cp);
+
+void copy_pipe_retry (copy_pipe_t *cp);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -0,0 +1,423 @@
+/*
+   Concurrent copy of small files.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file copysched.c
+ *  \brief Source: concurrent copy of small files
+ *
+ *  Copy of a tree of many small files is bound by latency of per-file operations rather
+ *  than by bandwidth. The scheduler copies such files in worker threads, several files
+ *  at a time.
+ *
+ *  Only new local files are copied here: all checks that may require user's interaction
+ *  (overwrite, hardlinks) are done by the caller before. Workers don't use VFS and don't
+ *  report errors: finished files are returned to the caller which handles errors in the
+ *  usual way, e.g. by copying the file again.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+#include "lib/vfs/utilvfs.h"  // vfs_utime()
+#include "lib/workpool.h"
+
+#include "copysched.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+#define COPY_SCHED_BUFSIZE    (64 * 1024)
+
+/* max number of files which are being copied or waiting for the caller */
+#define COPY_SCHED_MAX_QUEUED 256
+
+/*** file scope type declarations ****************************************************************/
+
+struct copy_sched_t
+{
+    mc_workpool_t *pool;
+    GAsyncQueue *done;  // finished files
+    guint queued;       // number of pushed but not popped files
+    gint cancel;        // don't copy files which are not started yet, accessed atomically
+
+    gboolean preserve;
+    gboolean preserve_uidgid;
+    mode_t umask_kill;
+    mode_t new_mode;  // mode of new file if attributes are not preserved
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+copy_sched_get_local_path (const char *path)
+{
+    vfs_path_t *vpath;
+    char *ret = NULL;
+
+    vpath = vfs_path_from_str (path);
+
+    if (vfs_path_elements_count (vpath) == 1 && vfs_file_is_local (vpath))
+    {
+        const vfs_path_element_t *element;
+
+        element = vfs_path_get_by_index (vpath, 0);
+#ifdef HAVE_CHARSET
+        if (element->encoding == NULL)
+#endif
+            ret = g_strdup (element->path);
+    }
+
+    vfs_path_free (vpath, TRUE);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+copy_sched_copy_data (int src_fd, int dst_fd)
+{
+    char *buf;
+    int error = 0;
+
+    buf = g_malloc (COPY_SCHED_BUFSIZE);
+
+    while (error == 0)
+    {
+        ssize_t n_read;
+        char *t = buf;
+
+        while ((n_read = read (src_fd, buf, COPY_SCHED_BUFSIZE)) == -1 && errno == EINTR)
+            ;
+        if (n_read <= 0)
+        {
+            if (n_read < 0)
+                error = errno;
+            break;
+        }
+
+        while (n_read > 0)
+        {
+            ssize_t n_written;
+
+            n_written = write (dst_fd, t, (size_t) n_read);
+            if (n_written > 0)
+            {
+                n_read -= n_written;
+                t += n_written;
+            }
+            else if (n_written == 0 || errno != EINTR)
+            {
+                error = n_written < 0 ? errno : ENOSPC;
+                break;
+            }
+        }
+    }
+
+    g_free (buf);
+
+    return error;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Copy file and its attributes like copy_file_file() does.
+ *
+ * @return 0 on success, errno otherwise
+ */
+
+static int
+copy_sched_copy_file (const copy_sched_t *cs, copy_sched_file_t *f)
+{
+    int src_fd, dst_fd;
+    struct stat st;
+    mc_timesbuf_t times;
+    int error = 0;
+
+    src_fd = open (f->src_local, O_RDONLY | O_CLOEXEC);
+    if (src_fd == -1)
+        return errno;
+
+    if (fstat (src_fd, &st) != 0)
+        error = errno;
+    else if (!S_ISREG (st.st_mode))
+        error = EINVAL;
+    else
+    {
+        dst_fd = open (f->dst_local, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode);
+        if (dst_fd == -1)
+            error = errno;
+        else
+        {
+            f->created = TRUE;
+
+            error = copy_sched_copy_data (src_fd, dst_fd);
+
+            if (error == 0 && cs->preserve_uidgid && fchown (dst_fd, st.st_uid, st.st_gid) != 0)
+                error = errno;
+
+            if (error == 0 && cs->preserve && fchmod (dst_fd, st.st_mode & cs->umask_kill) != 0)
+                error = errno;
+
+            if (error == 0 && !cs->preserve)
+                (void) fchmod (dst_fd, cs->new_mode);
+
+            if (close (dst_fd) != 0 && error == 0)
+                error = errno;
+        }
+    }
+
+    close (src_fd);
+
+    if (error == 0)
+    {
+        // always sync timestamps
+        vfs_get_timesbuf_from_stat (&st, &times);
+        (void) vfs_utime (f->dst_local, &times);
+    }
+
+    return error;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+copy_sched_run (gpointer task, gpointer user_data)
+{
+    copy_sched_file_t *f = (copy_sched_file_t *) task;
+    copy_sched_t *cs = (copy_sched_t *) user_data;
+
+    if (g_atomic_int_get (&cs->cancel) != 0)
+        f->error = ECANCELED;
+    else
+        f->error = copy_sched_copy_file (cs, f);
+
+    g_async_queue_push (cs->done, f);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create scheduler.
+ *
+ * @param preserve preserve mode and timestamps of files
+ * @param preserve_uidgid preserve owner of files
+ * @param umask_kill the bits to preserve in mode of new files
+ *
+ * @return newly allocated scheduler
+ */
+
+copy_sched_t *
+copy_sched_new (gboolean preserve, gboolean preserve_uidgid, mode_t umask_kill)
+{
+    copy_sched_t *cs;
+    mode_t mask;
+    int workers;
+
+    cs = g_new0 (copy_sched_t, 1);
+    cs->preserve = preserve;
+    cs->preserve_uidgid = preserve_uidgid;
+    cs->umask_kill = umask_kill;
+
+    // umask cannot be got in threads safely
+    mask = umask (-1);
+    umask (mask);
+    cs->new_mode = (0100666 & ~mask) & umask_kill;
+
+    // operations are I/O bound, so use more threads than CPUs
+    workers = MIN (2 * mc_workpool_get_num_workers (), MC_WORKPOOL_MAX_WORKERS);
+
+    cs->done = g_async_queue_new ();
+    cs->pool = mc_workpool_new (copy_sched_run, cs, workers);
+
+    return cs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for all pushed files and free scheduler. Results of not popped files are lost.
+ *
+ * @param cs scheduler
+ */
+
+void
+copy_sched_free (copy_sched_t *cs)
+{
+    copy_sched_file_t *f;
+
+    if (cs == NULL)
+        return;
+
+    mc_workpool_free (cs->pool);
+
+    while ((f = (copy_sched_file_t *) g_async_queue_try_pop (cs->done)) != NULL)
+        copy_sched_file_free (f);
+    g_async_queue_unref (cs->done);
+
+    g_free (cs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Schedule copy of file. Target file must not exist.
+ *
+ * @param cs scheduler
+ * @param src_path source file
+ * @param dst_path target file
+ * @param src_stat stat of source file
+ *
+ * @return TRUE if file is scheduled, FALSE if file should be copied in the usual way
+ */
+
+gboolean
+copy_sched_push (copy_sched_t *cs, const char *src_path, const char *dst_path,
+                 const struct stat *src_stat)
+{
+    copy_sched_file_t *f;
+    char *src_local, *dst_local;
+
+    if (!S_ISREG (src_stat->st_mode) || src_stat->st_size > COPY_SCHED_MAX_FILE_SIZE)
+        return FALSE;
+
+    src_local = copy_sched_get_local_path (src_path);
+    if (src_local == NULL)
+        return FALSE;
+
+    dst_local = copy_sched_get_local_path (dst_path);
+    if (dst_local == NULL)
+    {
+        g_free (src_local);
+        return FALSE;
+    }
+
+    f = g_new0 (copy_sched_file_t, 1);
+    f->src_path = g_strdup (src_path);
+    f->dst_path = g_strdup (dst_path);
+    f->src_local = src_local;
+    f->dst_local = dst_local;
+    f->size = src_stat->st_size;
+
+    cs->queued++;
+    mc_workpool_push (cs->pool, f);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether too many files are queued. If so, finished files should be popped before
+ * pushing new ones.
+ */
+
+gboolean
+copy_sched_is_full (const copy_sched_t *cs)
+{
+    return (cs->queued >= COPY_SCHED_MAX_QUEUED);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get finished file.
+ *
+ * @param cs scheduler
+ * @param wait if TRUE, wait for a file if none is finished yet
+ *
+ * @return file that should be freed with copy_sched_file_free(), or NULL if all pushed files
+ *         are popped already or, if @wait is FALSE, none is finished
+ */
+
+copy_sched_file_t *
+copy_sched_pop (copy_sched_t *cs, gboolean wait)
+{
+    copy_sched_file_t *f;
+
+    if (cs->queued == 0)
+        return NULL;
+
+    if (wait)
+        f = (copy_sched_file_t *) g_async_queue_pop (cs->done);
+    else
+        f = (copy_sched_file_t *) g_async_queue_try_pop (cs->done);
+
+    if (f != NULL)
+        cs->queued--;
+
+    return f;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+copy_sched_file_free (copy_sched_file_t *f)
+{
+    g_free (f->src_path);
+    g_free (f->dst_path);
+    g_free (f->src_local);
+    g_free (f->dst_local);
+    g_free (f);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Don't copy files which are not started yet. They are finished with ECANCELED error.
+ *
+ * @param cs scheduler
+ */
+
+void
+copy_sched_cancel (copy_sched_t *cs)
+{
+    g_atomic_int_set (&cs->cancel, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether copy is canceled.
+ *
+ * @param cs scheduler
+ */
+
+gboolean
+copy_sched_is_canceled (copy_sched_t *cs)
+{
+    return (g_atomic_int_get (&cs->cancel) != 0);
+}
+
+/* --------------------------------------------------------------------------------------------- */
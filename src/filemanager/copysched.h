@@ -0,0 +1,52 @@
+/** \file copysched.h
+ *  \brief Header: concurrent copy of small files
+ */
+
+#ifndef MC__COPYSCHED_H
+#define MC__COPYSCHED_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "lib/global.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/* larger files are copied in the usual way */
+#define COPY_SCHED_MAX_FILE_SIZE (1024 * 1024)
+
+typedef struct copy_sched_t copy_sched_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct
+{
+    char *src_path;    // source file, VFS path
+    char *dst_path;    // target file, VFS path
+    char *src_local;   // source file, path in local filesystem
+    char *dst_local;   // target file, path in local filesystem
+    off_t size;        // size of source file
+    int error;         // errno of failed operation, 0 on success
+    gboolean created;  // target file was created
+} copy_sched_file_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+copy_sched_t *copy_sched_new (gboolean preserve, gboolean preserve_uidgid, mode_t umask_kill);
+void copy_sched_free (copy_sched_t *cs);
+
+gboolean copy_sched_push (copy_sched_t *cs, const char *src_path, const char *dst_path,
+                          const struct stat *src_stat);
+gboolean copy_sched_is_full (const copy_sched_t *cs);
+copy_sched_file_t *copy_sched_pop (copy_sched_t *cs, gboolean wait);
+void copy_sched_file_free (copy_sched_file_t *f);
+void copy_sched_cancel (copy_sched_t *cs);
+gboolean copy_sched_is_canceled (copy_sched_t *cs);
+
+/*** inline functions ****************************************************************************/
+
+#endif
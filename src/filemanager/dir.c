@@ -30,10 +30,14 @@
 
 #include <config.h>
 
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 
 #include "lib/global.h"
 #include "lib/tty/tty.h"
@@ -42,6 +46,7 @@
 #include "lib/fs.h"
 #include "lib/strutil.h"
 #include "lib/util.h"
+#include "lib/workpool.h"
 
 #include "src/setup.h"  // panels_options
 
@@ -58,8 +63,83 @@
          ? 1                                                                                       \
          : ((S_ISDIR (x->st.st_mode) || link_isdir (x)) ? 2 : 0))
 
+#if defined(HAVE_FSTATAT) && defined(HAVE_FDOPENDIR)
+/* local directories are read directly and files are stat'ed relative to the directory fd */
+#define DIR_LIST_LOCAL_STAT 1
+#endif
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* number of entries stat'ed by one task of local directory loader */
+#define DIR_LIST_STAT_CHUNK        256
+/* minimal number of entries to stat them in worker threads */
+#define DIR_LIST_STAT_PARALLEL_MIN 2048
+
+/* sizes of blocks of names storage */
+#define DIR_LIST_ARENA_BLOCK_MIN   (16 * 1024)
+#define DIR_LIST_ARENA_BLOCK_MAX   (1024 * 1024)
+
+#define DIR_LIST_ARENA_ALIGN(size) (((size) + sizeof (gpointer) - 1) & ~(sizeof (gpointer) - 1))
+
+/* minimal number of entries to sort them and create their keys in worker threads */
+#define DIR_LIST_SORT_PARALLEL_MIN 8192
+/* number of entries in a range sorted by insertion before merging */
+#define DIR_LIST_SORT_RUN          16
+
 /*** file scope type declarations ****************************************************************/
 
+#ifdef DIR_LIST_LOCAL_STAT
+/* range of directory list entries to stat in one task */
+typedef struct
+{
+    file_entry_t *list;
+    int start;
+    int end;
+    guint8 *moved;  // if not NULL, set for entries whose position in sorted list may change
+} dir_stat_chunk_t;
+#endif
+
+/* range of entries to create sort keys for in one task */
+typedef struct
+{
+    file_entry_t *entries;
+    char **keys;  // name key and extension key for every entry
+    int start;
+    int end;
+} dir_key_chunk_t;
+
+/* sort order by name for entries which names differ in first bytes */
+typedef struct
+{
+    int head;        // group of entry: directories, executables, files; dot files go first
+    guint64 prefix;  // first bytes of name sort key in big-endian order
+} dir_sort_prefix_t;
+
+/* sort of array of entry indexes */
+typedef struct
+{
+    const file_entry_t *entries;
+    GCompareFunc sort;
+    const dir_sort_prefix_t *prefix;  // NULL if entries are compared by sort function only
+} dir_sort_t;
+
+/* sort a range of indexes or merge two sorted ranges in one task */
+typedef struct
+{
+    const dir_sort_t *ds;
+    int *src;
+    int *dst;  // if sorting, temporary buffer
+    int start;
+    int mid;  // -1 if range is sorted, otherwise the start of the second range to merge
+    int end;
+} dir_sort_task_t;
+
 /*** forward declarations (file scope functions) *************************************************/
 
 /*** file scope variables ************************************************************************/
@@ -111,37 +191,672 @@ key_collate (const char *t1, const char *t2)
 static inline int
 compare_by_names (file_entry_t *a, file_entry_t *b)
 {
-    // create key if does not exist, key will be freed after sorting
-    if (a->name_sort_key == NULL)
-        a->name_sort_key = str_create_key_for_filename (a->fname->str, case_sensitive);
-    if (b->name_sort_key == NULL)
-        b->name_sort_key = str_create_key_for_filename (b->fname->str, case_sensitive);
-
+    // keys are created by dir_list_make_sort_keys() before sorting
     return key_collate (a->name_sort_key, b->name_sort_key);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+
+static gpointer
+dir_list_arena_alloc (dir_list_arena_t *arena, gsize size)
+{
+    gpointer p;
+
+    size = DIR_LIST_ARENA_ALIGN (size);
+
+    if (arena->blocks == NULL || arena->block_used + size > arena->block_size)
+    {
+        gsize block_size;
+
+        block_size = arena->blocks == NULL ? DIR_LIST_ARENA_BLOCK_MIN
+                                           : MIN (arena->block_size * 2, DIR_LIST_ARENA_BLOCK_MAX);
+        block_size = MAX (block_size, size);
+        arena->blocks = g_slist_prepend (arena->blocks, g_malloc (block_size));
+        arena->block_size = block_size;
+        arena->block_used = 0;
+    }
+
+    p = (char *) arena->blocks->data + arena->block_used;
+    arena->block_used += size;
+    arena->used += size;
+
+    return p;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_list_arena_free (dir_list_arena_t *arena)
+{
+    g_slist_free_full (arena->blocks, g_free);
+    arena->blocks = NULL;
+    arena->block_size = 0;
+    arena->block_used = 0;
+    arena->used = 0;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
- * clear keys, should be call after sorting is finished.
+ * Keep the sort key created by str_create_key() or str_create_key_for_filename() in the list
+ * storage.
+ *
+ * @param list directory list
+ * @param text the text the key was created for
+ * @param key the key
+ *
+ * @return key that lives as long as the list
  */
 
+static char *
+dir_list_keep_sort_key (dir_list *list, const char *text, char *key)
+{
+    char *ret;
+    size_t len;
+
+    // some string backends use the text itself as a key
+    if (key == text)
+        return key;
+
+    len = strlen (key);
+    ret = (char *) dir_list_arena_alloc (&list->arena, len + 1);
+    memcpy (ret, key, len + 1);
+    str_release_key (key, case_sensitive);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 static void
-clean_sort_keys (dir_list *list, int start, int count)
+dir_entries_drop_sort_keys (file_entry_t *entries, int count)
 {
     int i;
 
     for (i = 0; i < count; i++)
     {
-        file_entry_t *fentry;
+        entries[i].name_sort_key = NULL;
+        entries[i].extension_sort_key = NULL;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create missing sort keys for range of entries.
+ * Called in a worker thread: keys are stored in the array of chunk, not in the entries.
+ */
+
+static void
+dir_entries_create_keys (gpointer task, gpointer user_data)
+{
+    const dir_key_chunk_t *chunk = (const dir_key_chunk_t *) task;
+    const gboolean need_ext = *(const gboolean *) user_data;
+    int i;
 
-        fentry = &list->list[i + start];
-        str_release_key (fentry->name_sort_key, case_sensitive);
-        fentry->name_sort_key = NULL;
-        str_release_key (fentry->extension_sort_key, case_sensitive);
-        fentry->extension_sort_key = NULL;
+    for (i = chunk->start; i < chunk->end; i++)
+    {
+        const file_entry_t *fentry = &chunk->entries[i];
+
+        if (fentry->name_sort_key == NULL)
+            chunk->keys[2 * i] = str_create_key_for_filename (fentry->fname->str, case_sensitive);
+        if (need_ext && fentry->extension_sort_key == NULL)
+            chunk->keys[2 * i + 1] = str_create_key (extension (fentry->fname->str), case_sensitive);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static guint64
+dir_sort_key_prefix (const char *key)
+{
+    guint64 prefix = 0;
+    size_t i;
+
+    for (i = 0; i < sizeof (prefix); i++)
+    {
+        prefix <<= 8;
+        if (*key != '\0')
+            prefix |= (guchar) *key++;
+    }
+
+    return prefix;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static inline int
+dir_sort_compare (const dir_sort_t *ds, int a, int b)
+{
+    if (ds->prefix != NULL)
+    {
+        const dir_sort_prefix_t *pa = &ds->prefix[a];
+        const dir_sort_prefix_t *pb = &ds->prefix[b];
+
+        if (pa->head != pb->head)
+            return pa->head < pb->head ? -1 : 1;
+        if (pa->prefix != pb->prefix)
+            return (pa->prefix < pb->prefix ? -1 : 1) * reverse;
+    }
+
+    return ds->sort (&ds->entries[a], &ds->entries[b]);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_sort_insertion (const dir_sort_t *ds, int *perm, int start, int end)
+{
+    int i;
+
+    for (i = start + 1; i < end; i++)
+    {
+        const int x = perm[i];
+        int j;
+
+        for (j = i; j > start && dir_sort_compare (ds, perm[j - 1], x) > 0; j--)
+            perm[j] = perm[j - 1];
+        perm[j] = x;
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Merge sorted ranges src[start, mid) and src[mid, end) into dst[start, end).
+ * Entries of the first range go first if equal.
+ */
+
+static void
+dir_sort_merge (const dir_sort_t *ds, const int *src, int *dst, int start, int mid, int end)
+{
+    int i = start, j = mid, k = start;
+
+    while (i < mid && j < end)
+        dst[k++] = dir_sort_compare (ds, src[j], src[i]) < 0 ? src[j++] : src[i++];
+
+    if (i < mid)
+        memcpy (dst + k, src + i, (mid - i) * sizeof (int));
+    else if (j < end)
+        memcpy (dst + k, src + j, (end - j) * sizeof (int));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stable sort of perm[start, end) using tmp[start, end) as buffer.
+ */
+
+static void
+dir_sort_range (const dir_sort_t *ds, int *perm, int *tmp, int start, int end)
+{
+    int *src = perm, *dst = tmp;
+    int width, i;
+
+    for (i = start; i < end; i += DIR_LIST_SORT_RUN)
+        dir_sort_insertion (ds, perm, i, MIN (i + DIR_LIST_SORT_RUN, end));
+
+    for (width = DIR_LIST_SORT_RUN; width < end - start; width *= 2)
+    {
+        int *t;
+
+        for (i = start; i < end; i += 2 * width)
+            dir_sort_merge (ds, src, dst, i, MIN (i + width, end), MIN (i + 2 * width, end));
+
+        t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != perm)
+        memcpy (perm + start, src + start, (end - start) * sizeof (int));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_sort_run_task (gpointer task, gpointer user_data)
+{
+    const dir_sort_task_t *t = (const dir_sort_task_t *) task;
+
+    (void) user_data;
+
+    if (t->mid < 0)
+        dir_sort_range (t->ds, t->src, t->dst, t->start, t->end);
+    else
+        dir_sort_merge (t->ds, t->src, t->dst, t->start, t->mid, t->end);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort array of indexes. Large arrays are split into parts which are sorted and then merged
+ * pairwise by the pool of worker threads.
+ */
+
+static void
+dir_sort_perm (const dir_sort_t *ds, int *perm, int *tmp, int count)
+{
+    int n_parts;
+    int *bounds, *src, *dst;
+    dir_sort_task_t *tasks;
+    mc_workpool_t *pool;
+    int i;
+
+    n_parts = count < DIR_LIST_SORT_PARALLEL_MIN ? 1 : mc_workpool_get_num_workers ();
+    if (n_parts == 1)
+    {
+        dir_sort_range (ds, perm, tmp, 0, count);
+        return;
+    }
+
+    bounds = g_new (int, n_parts + 1);
+    tasks = g_new (dir_sort_task_t, n_parts);
+    pool = mc_workpool_new (dir_sort_run_task, NULL, n_parts);
+
+    for (i = 0; i <= n_parts; i++)
+        bounds[i] = (int) ((gint64) count * i / n_parts);
+
+    for (i = 0; i < n_parts; i++)
+    {
+        tasks[i].ds = ds;
+        tasks[i].src = perm;
+        tasks[i].dst = tmp;
+        tasks[i].start = bounds[i];
+        tasks[i].mid = -1;
+        tasks[i].end = bounds[i + 1];
+        mc_workpool_push (pool, &tasks[i]);
+    }
+
+    mc_workpool_wait (pool);
+
+    src = perm;
+    dst = tmp;
+
+    while (n_parts > 1)
+    {
+        int n = 0;
+        int *t;
+
+        for (i = 0; i < n_parts; i += 2)
+        {
+            dir_sort_task_t *task = &tasks[n];
+
+            task->ds = ds;
+            task->src = src;
+            task->dst = dst;
+            task->start = bounds[i];
+            task->mid = bounds[MIN (i + 1, n_parts)];
+            task->end = bounds[MIN (i + 2, n_parts)];
+            mc_workpool_push (pool, task);
+
+            bounds[n++] = bounds[i];
+        }
+
+        bounds[n] = count;
+        n_parts = n;
+        mc_workpool_wait (pool);
+
+        t = src;
+        src = dst;
+        dst = t;
+    }
+
+    if (src != perm)
+        memcpy (perm, src, count * sizeof (int));
+
+    mc_workpool_free (pool);
+    g_free (tasks);
+    g_free (bounds);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort entries.
+ *
+ * Array of indexes is sorted instead of entries themselves, then entries are moved to their
+ * places once. If names are sorted by keys that are compared byte by byte, first bytes of keys
+ * are compared before calling the sort function.
+ * Sort options must be set by dir_list_set_sort_options() and keys must be created by
+ * dir_list_make_sort_keys() before.
+ *
+ * @param entries entries
+ * @param count number of entries
+ * @param sort sort function
+ */
+
+static void
+dir_sort_entries (file_entry_t *entries, int count, GCompareFunc sort)
+{
+    dir_sort_t ds;
+    dir_sort_prefix_t *prefix = NULL;
+    int *perm;
+    int i;
+
+    if (count < 2)
+        return;
+
+    perm = g_try_new (int, 2 * (gsize) count);
+    if (perm == NULL)
+    {
+        qsort (entries, count, sizeof (file_entry_t), sort);
+        return;
+    }
+
+    if (sort == (GCompareFunc) sort_name && str_key_is_bytewise (case_sensitive))
+        prefix = g_try_new (dir_sort_prefix_t, count);
+
+    if (prefix != NULL)
+        for (i = 0; i < count; i++)
+        {
+            const file_entry_t *fentry = &entries[i];
+            const int group = panels_options.mix_all_files ? 0 : 2 - MY_ISDIR (fentry);
+
+            prefix[i].head = group * 2 + (fentry->name_sort_key[0] == '.' ? 0 : 1);
+            prefix[i].prefix = dir_sort_key_prefix (fentry->name_sort_key);
+        }
+
+    ds.entries = entries;
+    ds.sort = sort;
+    ds.prefix = prefix;
+
+    for (i = 0; i < count; i++)
+        perm[i] = i;
+
+    dir_sort_perm (&ds, perm, perm + count, count);
+
+    // move entries along the cycles of permutation: entries[i] = old entries[perm[i]]
+    for (i = 0; i < count; i++)
+        if (perm[i] != i)
+        {
+            const file_entry_t saved = entries[i];
+            int j = i;
+
+            while (TRUE)
+            {
+                const int k = perm[j];
+
+                perm[j] = j;
+                if (k == i)
+                {
+                    entries[j] = saved;
+                    break;
+                }
+                entries[j] = entries[k];
+                j = k;
+            }
+        }
+
+    g_free (prefix);
+    g_free (perm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create missing sort keys of entries. Keys are kept in the list storage and reused by
+ * subsequent sorts until the case sensitivity is changed.
+ * Sort options must be set by dir_list_set_sort_options() before.
+ *
+ * @param list directory list that owns the names of entries
+ * @param entries entries
+ * @param count number of entries
+ * @param sort sort function
+ */
+
+static void
+dir_list_make_sort_keys (dir_list *list, file_entry_t *entries, int count, GCompareFunc sort)
+{
+    gboolean need_ext = sort == (GCompareFunc) sort_ext;
+    char **keys = NULL;
+    int i;
+
+    if (sort == (GCompareFunc) unsorted || sort == (GCompareFunc) sort_inode)
+        return;
+
+    if (count >= DIR_LIST_SORT_PARALLEL_MIN)
+    {
+        // create keys in worker threads, then move them to the list storage
+        const int n_chunks = mc_workpool_get_num_workers ();
+        mc_workpool_t *pool;
+        dir_key_chunk_t *chunks;
+
+        keys = g_new0 (char *, 2 * count);
+        chunks = g_new (dir_key_chunk_t, n_chunks);
+        pool = mc_workpool_new (dir_entries_create_keys, &need_ext, n_chunks);
+
+        for (i = 0; i < n_chunks; i++)
+        {
+            chunks[i].entries = entries;
+            chunks[i].keys = keys;
+            chunks[i].start = (int) ((gint64) count * i / n_chunks);
+            chunks[i].end = (int) ((gint64) count * (i + 1) / n_chunks);
+            mc_workpool_push (pool, &chunks[i]);
+        }
+
+        mc_workpool_free (pool);
+        g_free (chunks);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        file_entry_t *fentry = &entries[i];
+
+        if (fentry->name_sort_key == NULL)
+            fentry->name_sort_key = dir_list_keep_sort_key (
+                list, fentry->fname->str,
+                keys != NULL ? keys[2 * i]
+                             : str_create_key_for_filename (fentry->fname->str, case_sensitive));
+
+        if (need_ext && fentry->extension_sort_key == NULL)
+        {
+            const char *ext;
+
+            ext = extension (fentry->fname->str);
+            fentry->extension_sort_key = dir_list_keep_sort_key (
+                list, ext, keys != NULL ? keys[2 * i + 1] : str_create_key (ext, case_sensitive));
+        }
+    }
+
+    g_free (keys);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop sort keys of the list if they were created with another case sensitivity.
+ * Sort options must be set by dir_list_set_sort_options() before.
+ */
+
+static void
+dir_list_check_sort_keys (dir_list *list)
+{
+    if (list->arena.keys_case_sensitive != case_sensitive)
+    {
+        dir_entries_drop_sort_keys (list->list, list->len);
+        list->arena.keys_case_sensitive = case_sensitive;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gsize
+dir_entry_storage_size (const file_entry_t *fentry)
+{
+    gsize size;
+
+    size = DIR_LIST_ARENA_ALIGN (sizeof (GString) + fentry->fname->len + 1);
+    if (fentry->name_sort_key != NULL && fentry->name_sort_key != fentry->fname->str)
+        size += DIR_LIST_ARENA_ALIGN (strlen (fentry->name_sort_key) + 1);
+    if (fentry->extension_sort_key != NULL
+        && fentry->extension_sort_key != extension (fentry->fname->str))
+        size += DIR_LIST_ARENA_ALIGN (strlen (fentry->extension_sort_key) + 1);
+
+    return size;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move names to the new storage if most of the storage is occupied by names of removed
+ * entries. Sort keys are dropped.
+ */
+
+static void
+dir_list_pack_names (dir_list *list)
+{
+    dir_list_arena_t arena;
+    gsize live = 0;
+    int i;
+
+    if (list->arena.used < DIR_LIST_ARENA_BLOCK_MAX)
+        return;
+
+    for (i = 0; i < list->len; i++)
+        live += dir_entry_storage_size (&list->list[i]);
+
+    if (live * 2 > list->arena.used)
+        return;
+
+    arena = list->arena;
+    memset (&list->arena, 0, sizeof (list->arena));
+    list->arena.keys_case_sensitive = arena.keys_case_sensitive;
+
+    for (i = 0; i < list->len; i++)
+    {
+        file_entry_t *fentry = &list->list[i];
+
+        fentry->fname = dir_list_new_name (list, fentry->fname->str, fentry->fname->len);
+    }
+
+    dir_entries_drop_sort_keys (list->list, list->len);
+    dir_list_arena_free (&arena);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_list_set_sort_options (const dir_sort_options_t *sort_op)
+{
+    reverse = sort_op->reverse ? -1 : 1;
+    case_sensitive = sort_op->case_sensitive ? 1 : 0;
+    exec_first = sort_op->exec_first;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether new attributes of file can change its position in the sorted list.
+ */
+
+static inline gboolean
+dir_entry_sort_changed (const file_entry_t *fentry, const struct stat *st, gboolean link_to_dir)
+{
+    return (fentry->st.st_mode != st->st_mode || fentry->st.st_size != st->st_size
+            || fentry->st.st_mtime != st->st_mtime || fentry->st.st_ctime != st->st_ctime
+            || fentry->st.st_atime != st->st_atime || fentry->st.st_ino != st->st_ino
+            || link_isdir (fentry) != link_to_dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether new attributes of file can change anything shown in the panel. Computed size
+ * of directory is replaced by the real one, so such entry is always changed.
+ */
+
+static inline gboolean
+dir_entry_stat_changed (const file_entry_t *fentry, const struct stat *st, gboolean link_to_dir,
+                        gboolean stale_link)
+{
+    return (dir_entry_sort_changed (fentry, st, link_to_dir) || fentry->f.dir_size_computed != 0
+            || fentry->st.st_uid != st->st_uid || fentry->st.st_gid != st->st_gid
+            || fentry->st.st_nlink != st->st_nlink || fentry->st.st_dev != st->st_dev
+            || fentry->st.st_rdev != st->st_rdev || fentry->f.stale_link != (stale_link ? 1 : 0));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Calculate digest of options that affect the set of directory entries.
+ */
+
+static guint
+dir_list_options_digest (const file_filter_t *filter)
+{
+    guint digest;
+
+    digest = (panels_options.show_dot_files ? 1 : 0) | (panels_options.show_backups ? 2 : 0);
+
+    if (filter != NULL && filter->handler != NULL && filter->value != NULL)
+        digest ^= (g_str_hash (filter->value) ^ (guint) filter->flags) << 2;
+
+    return digest;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_list_stamp_set (dir_list *list, const struct stat *dir_st, time_t load_time,
+                    const file_filter_t *filter)
+{
+    list->stamp.valid = TRUE;
+    list->stamp.dev = dir_st->st_dev;
+    list->stamp.ino = dir_st->st_ino;
+    list->stamp.mtime = dir_st->st_mtime;
+    list->stamp.ctime = dir_st->st_ctime;
+    list->stamp.load_time = load_time;
+    list->stamp.options = dir_list_options_digest (filter);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether the set of directory entries is not changed since last load.
+ *
+ * Directory timestamps have one second resolution, so they are trusted only if the directory
+ * was modified before the second in which it was loaded.
+ */
+
+static gboolean
+dir_list_stamp_names_unchanged (const dir_list *list, const struct stat *dir_st,
+                                const file_filter_t *filter)
+{
+    const dir_list_stamp_t *stamp = &list->stamp;
+
+    return (stamp->mtime == dir_st->st_mtime && stamp->ctime == dir_st->st_ctime
+            && stamp->mtime < stamp->load_time && stamp->ctime < stamp->load_time
+            && stamp->options == dir_list_options_digest (filter));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether directory entry should be skipped regardless of its type.
+ * @return TRUE if entry is not shown in the panel
+ */
+
+static gboolean
+dirent_is_skipped (const char *d_name, size_t d_len)
+{
+    if (DIR_IS_DOT (d_name) || DIR_IS_DOTDOT (d_name))
+        return TRUE;
+    if (!panels_options.show_dot_files && (d_name[0] == '.'))
+        return TRUE;
+    if (!panels_options.show_backups && d_name[d_len - 1] == '~')
+        return TRUE;
+
+    return FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Apply file filter to the directory entry.
+ * @return FALSE = don't add, TRUE = add to the list
+ */
+
+static gboolean
+dirent_filter_match (const file_filter_t *filter, const char *d_name, size_t d_len,
+                     const struct stat *st, gboolean link_to_dir)
+{
+    gboolean files_only;
+
+    if (filter == NULL || filter->handler == NULL)
+        return TRUE;
+
+    files_only = (filter->flags & SELECT_FILES_ONLY) != 0;
+
+    return ((S_ISDIR (st->st_mode) || link_to_dir) && files_only)
+        || mc_search_run (filter->handler, d_name, 0, d_len, NULL);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * If you change handle_dirent then check also handle_path.
@@ -153,13 +868,8 @@ handle_dirent (struct vfs_dirent *dp, const file_filter_t *filter, struct stat *
                gboolean *link_to_dir, gboolean *stale_link)
 {
     vfs_path_t *vpath;
-    gboolean ok = TRUE;
 
-    if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
-        return FALSE;
-    if (!panels_options.show_dot_files && (dp->d_name[0] == '.'))
-        return FALSE;
-    if (!panels_options.show_backups && dp->d_name[dp->d_len - 1] == '~')
+    if (dirent_is_skipped (dp->d_name, dp->d_len))
         return FALSE;
 
     vpath = vfs_path_from_str (dp->d_name);
@@ -179,18 +889,278 @@ handle_dirent (struct vfs_dirent *dp, const file_filter_t *filter, struct stat *
     // A link to a file or a directory?
     *link_to_dir = file_is_symlink_to_dir (vpath, buf1, stale_link);
 
-    vfs_path_free (vpath, TRUE);
+    vfs_path_free (vpath, TRUE);
+
+    return dirent_filter_match (filter, dp->d_name, dp->d_len, buf1, *link_to_dir);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read directory entries using VFS and append them to the list.
+ *
+ * @param list directory list
+ * @param dirp directory opened with mc_opendir()
+ * @param filter file filter
+ * @param marked_files names of files marked before reload or NULL
+ * @param marked_cnt number of files in @marked_files
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+static gboolean
+dir_list_read_vfs (dir_list *list, DIR *dirp, const file_filter_t *filter,
+                   GHashTable *marked_files, int marked_cnt)
+{
+    struct vfs_dirent *dp;
+    struct stat st;
+
+    while ((dp = mc_readdir (dirp)) != NULL)
+    {
+        gboolean link_to_dir, stale_link;
+        file_entry_t *fentry;
+
+        if (list->callback != NULL)
+            list->callback (DIR_READ, dp);
+
+        if (!handle_dirent (dp, filter, &st, &link_to_dir, &stale_link))
+            continue;
+
+        if (!dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link))
+            return FALSE;
+
+        fentry = &list->list[list->len - 1];
+
+        /*
+         * If we have marked files in the copy, scan through the copy
+         * to find matching file.  Decrease number of remaining marks if
+         * we copied one.
+         */
+        fentry->f.marked =
+            (marked_cnt > 0 && g_hash_table_lookup (marked_files, dp->d_name) != NULL) ? 1 : 0;
+        if (fentry->f.marked != 0)
+            marked_cnt--;
+    }
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_LIST_LOCAL_STAT
+/**
+ * Open local directory bypassing VFS.
+ *
+ * @param vpath directory path
+ *
+ * @return directory stream or NULL if @vpath is not a plain local directory
+ */
+
+static DIR *
+dir_list_local_opendir (const vfs_path_t *vpath)
+{
+    const vfs_path_element_t *element;
+    int fd;
+    DIR *dirp;
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return NULL;
+
+    element = vfs_path_get_by_index (vpath, 0);
+    if (element->path == NULL || !IS_PATH_SEP (element->path[0]))
+        return NULL;
+#ifdef HAVE_CHARSET
+    // file names must be recoded
+    if (element->encoding != NULL)
+        return NULL;
+#endif
+
+    fd = open (element->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1)
+        return NULL;
+
+    dirp = fdopendir (fd);
+    if (dirp == NULL)
+        close (fd);
+
+    return dirp;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stat range of directory list entries relative to the directory fd.
+ * Called in a worker thread: touch nothing but the given entries.
+ */
+
+static void
+dir_list_stat_chunk (gpointer task, gpointer user_data)
+{
+    const dir_stat_chunk_t *chunk = (const dir_stat_chunk_t *) task;
+    const int dfd = *(const int *) user_data;
+    int i;
+
+    for (i = chunk->start; i < chunk->end; i++)
+    {
+        file_entry_t *fentry = &chunk->list[i];
+        struct stat st;
+        gboolean link_to_dir = FALSE;
+        gboolean stale_link = FALSE;
+
+        // lstat() fails: see comment in handle_dirent()
+        if (fstatat (dfd, fentry->fname->str, &st, AT_SYMLINK_NOFOLLOW) == -1)
+            memset (&st, 0, sizeof (st));
+
+        if (S_ISLNK (st.st_mode))
+        {
+            struct stat st2;
+
+            if (fstatat (dfd, fentry->fname->str, &st2, 0) == 0)
+                link_to_dir = S_ISDIR (st2.st_mode);
+            else
+                stale_link = TRUE;
+        }
+
+        if (chunk->moved != NULL)
+        {
+            // keep cached color and formatted line of unchanged entry
+            if (!dir_entry_stat_changed (fentry, &st, link_to_dir, stale_link))
+            {
+                chunk->moved[i] = 0;
+                continue;
+            }
+
+            chunk->moved[i] = dir_entry_sort_changed (fentry, &st, link_to_dir) ? 1 : 0;
+        }
+
+        fentry->st = st;
+        fentry->f.link_to_dir = link_to_dir ? 1 : 0;
+        fentry->f.stale_link = stale_link ? 1 : 0;
+        fentry->f.dir_size_computed = 0;
+        file_entry_reset_cache (fentry);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stat directory list entries starting from @first. Large lists are stat'ed in parallel.
+ *
+ * @param list directory list
+ * @param first index of first entry to stat
+ * @param dfd directory fd
+ * @param moved array of list->len elements to mark entries changed in sort-relevant
+ *              attributes or NULL
+ */
+
+static void
+dir_list_stat_entries (dir_list *list, int first, int dfd, guint8 *moved)
+{
+    const int count = list->len - first;
+    mc_workpool_t *pool;
+    dir_stat_chunk_t *chunks;
+    int n_chunks, i;
+
+    if (count <= 0)
+        return;
+
+    n_chunks = (count + DIR_LIST_STAT_CHUNK - 1) / DIR_LIST_STAT_CHUNK;
+    chunks = g_new (dir_stat_chunk_t, n_chunks);
+
+    pool =
+        mc_workpool_new (dir_list_stat_chunk, &dfd, count < DIR_LIST_STAT_PARALLEL_MIN ? 1 : 0);
+
+    for (i = 0; i < n_chunks; i++)
+    {
+        chunks[i].list = list->list;
+        chunks[i].start = first + i * DIR_LIST_STAT_CHUNK;
+        chunks[i].end = MIN (chunks[i].start + DIR_LIST_STAT_CHUNK, list->len);
+        chunks[i].moved = moved;
+        mc_workpool_push (pool, &chunks[i]);
+    }
+
+    mc_workpool_free (pool);
+    g_free (chunks);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read local directory and append its entries to the list.
+ *
+ * Names are read first, then entries are stat'ed in place using fstatat() relative to
+ * the directory fd. Large directories are stat'ed by the pool of worker threads.
+ * Finally, filter is applied and marks are restored.
+ *
+ * @param list directory list
+ * @param dirp directory opened with dir_list_local_opendir()
+ * @param filter file filter
+ * @param marked_files names of files marked before reload or NULL
+ * @param marked_cnt number of files in @marked_files
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+static gboolean
+dir_list_read_local (dir_list *list, DIR *dirp, const file_filter_t *filter,
+                     GHashTable *marked_files, int marked_cnt)
+{
+    struct vfs_dirent *vdp = NULL;
+    struct dirent *dp;
+    struct stat st;
+    const int first = list->len;
+    int i, j;
+    gboolean ret = TRUE;
+
+    if (list->callback != NULL)
+        vdp = vfs_dirent_init (NULL, "", 0, DT_UNKNOWN);
+
+    memset (&st, 0, sizeof (st));
+
+    while (ret && (dp = readdir (dirp)) != NULL)
+    {
+        const size_t d_len = strlen (dp->d_name);
+
+        if (vdp != NULL)
+        {
+            vfs_dirent_assign (vdp, dp->d_name, dp->d_ino, DT_UNKNOWN);
+            list->callback (DIR_READ, vdp);
+        }
+
+        if (!dirent_is_skipped (dp->d_name, d_len))
+            ret = dir_list_append (list, dp->d_name, &st, FALSE, FALSE);
+    }
+
+    if (vdp != NULL)
+        vfs_dirent_free (vdp);
+
+    dir_list_stat_entries (list, first, dirfd (dirp), NULL);
+
+    // apply filter, restore marks and remove rejected entries
+    for (i = j = first; i < list->len; i++)
+    {
+        file_entry_t *fentry = &list->list[i];
+
+        // name of rejected entry is released with the list
+        if (!dirent_filter_match (filter, fentry->fname->str, fentry->fname->len, &fentry->st,
+                                  link_isdir (fentry)))
+            continue;
+
+        if (S_ISDIR (fentry->st.st_mode))
+            tree_store_mark_checked (fentry->fname->str);
 
-    if (filter != NULL && filter->handler != NULL)
-    {
-        gboolean files_only = (filter->flags & SELECT_FILES_ONLY) != 0;
+        if (marked_cnt > 0 && g_hash_table_lookup (marked_files, fentry->fname->str) != NULL)
+        {
+            fentry->f.marked = 1;
+            marked_cnt--;
+        }
 
-        ok = ((S_ISDIR (buf1->st_mode) || *link_to_dir) && files_only)
-            || mc_search_run (filter->handler, dp->d_name, 0, dp->d_len, NULL);
+        if (i != j)
+            list->list[j] = *fentry;
+        j++;
     }
 
-    return ok;
+    list->len = j;
+
+    return ret;
 }
+#endif /* DIR_LIST_LOCAL_STAT */
 
 /* --------------------------------------------------------------------------------------------- */
 /** get info about ".." */
@@ -234,6 +1204,225 @@ alloc_dir_copy (int size)
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Sort new and changed entries and merge them into the sorted list.
+ *
+ * @param list directory list, entries starting from @first are sorted
+ * @param first index of first entry to merge with
+ * @param changed array of new and changed entries, it is sorted in place
+ * @param sort sort function
+ * @param sort_op sort options
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+static gboolean
+dir_list_merge (dir_list *list, int first, GArray *changed, GCompareFunc sort,
+                const dir_sort_options_t *sort_op)
+{
+    const int nb = (int) changed->len;
+    file_entry_t *b;
+    int i, j, k;
+
+    if (nb == 0)
+        return TRUE;
+
+    if (list->len + nb > list->size && !dir_list_grow (list, list->len + nb - list->size))
+        return FALSE;
+
+    b = &g_array_index (changed, file_entry_t, 0);
+
+    if (sort != (GCompareFunc) unsorted)
+    {
+        dir_list_set_sort_options (sort_op);
+        if (list->arena.keys_case_sensitive != case_sensitive)
+            dir_entries_drop_sort_keys (b, nb);
+        dir_list_check_sort_keys (list);
+        dir_list_make_sort_keys (list, &list->list[first], list->len - first, sort);
+        dir_list_make_sort_keys (list, b, nb, sort);
+        dir_sort_entries (b, nb, sort);
+    }
+
+    // merge from the tail, entries of list go first if equal
+    i = list->len - 1;
+    j = nb - 1;
+    k = list->len + nb - 1;
+
+    while (j >= 0)
+        if (i >= first && sort != (GCompareFunc) unsorted && sort (&list->list[i], &b[j]) > 0)
+            list->list[k--] = list->list[i--];
+        else
+            list->list[k--] = b[j--];
+
+    list->len += nb;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Drop removed entries from the list and move changed ones to their new places.
+ *
+ * @param list directory list
+ * @param first index of first sorted entry
+ * @param moved state of entries: 0 - removed, 1 - not changed, 2 - should be moved.
+ *              It is freed here.
+ * @param changed array of new entries with names in the list storage. Moved entries are added
+ *                to it. It is freed here.
+ * @param sort sort function
+ * @param sort_op sort options
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+static gboolean
+dir_list_apply_moved (dir_list *list, int first, guint8 *moved, GArray *changed,
+                      GCompareFunc sort, const dir_sort_options_t *sort_op)
+{
+    int i, j;
+    gboolean ret;
+
+    // drop removed entries and take out moved ones keeping the order of the rest
+    for (i = j = first; i < list->len; i++)
+    {
+        file_entry_t *fentry = &list->list[i];
+
+        switch (moved[i])
+        {
+        case 0:
+            // name is released with the list
+            break;
+        case 2:
+            g_array_append_val (changed, *fentry);
+            break;
+        default:
+            if (i != j)
+                list->list[j] = *fentry;
+            j++;
+            break;
+        }
+    }
+
+    list->len = j;
+    g_free (moved);
+
+    ret = dir_list_merge (list, first, changed, sort, sort_op);
+    g_array_free (changed, TRUE);
+
+    if (ret)
+        dir_list_pack_names (list);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update directory list incrementally.
+ *
+ * If the set of directory entries is not changed, existing entries are re-stat'ed in place.
+ * Otherwise directory is read again and compared with the list by name: removed entries are
+ * dropped, existing ones are updated, new ones are added. Entries whose sort-relevant
+ * attributes were changed and new entries are sorted separately and merged into the list.
+ * Marks of existing entries are kept.
+ *
+ * @param list directory list
+ * @param local_dirp directory opened with dir_list_local_opendir() or NULL
+ * @param dirp directory opened with mc_opendir() if @local_dirp is NULL
+ * @param names_unchanged the set of directory entries is not changed since last load
+ * @param sort sort function
+ * @param sort_op sort options
+ * @param filter file filter
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+static gboolean
+dir_list_update (dir_list *list, DIR *local_dirp, DIR *dirp, gboolean names_unchanged,
+                 GCompareFunc sort, const dir_sort_options_t *sort_op, const file_filter_t *filter)
+{
+    const int first = (list->len > 0 && DIR_IS_DOTDOT (list->list[0].fname->str)) ? 1 : 0;
+    guint8 *moved;
+    GArray *changed;
+    int i, j;
+    gboolean ret = TRUE;
+
+    // 0: entry is removed, 1: entry is not changed, 2: entry should be moved
+    moved = g_new0 (guint8, list->len);
+    changed = g_array_sized_new (FALSE, FALSE, sizeof (file_entry_t), 16);
+
+#ifdef DIR_LIST_LOCAL_STAT
+    if (names_unchanged && local_dirp != NULL)
+    {
+        dir_list_stat_entries (list, first, dirfd (local_dirp), moved);
+
+        for (i = first; i < list->len; i++)
+        {
+            moved[i]++;
+            if (S_ISDIR (list->list[i].st.st_mode))
+                tree_store_mark_checked (list->list[i].fname->str);
+        }
+    }
+    else
+#else
+    (void) local_dirp;
+    (void) names_unchanged;
+#endif
+    {
+        dir_list fresh;
+        GHashTable *names;
+
+        memset (&fresh, 0, sizeof (fresh));
+        fresh.callback = list->callback;
+
+#ifdef DIR_LIST_LOCAL_STAT
+        if (local_dirp != NULL)
+            ret = dir_list_read_local (&fresh, local_dirp, filter, NULL, 0);
+        else
+#endif
+            ret = dir_list_read_vfs (&fresh, dirp, filter, NULL, 0);
+
+        if (!ret)
+        {
+            dir_list_free_list (&fresh);
+            g_array_free (changed, TRUE);
+            g_free (moved);
+            return FALSE;
+        }
+
+        names = g_hash_table_new (g_str_hash, g_str_equal);
+        for (i = first; i < list->len; i++)
+            g_hash_table_insert (names, list->list[i].fname->str, GINT_TO_POINTER (i));
+
+        for (j = 0; j < fresh.len; j++)
+        {
+            file_entry_t *fe = &fresh.list[j];
+            gpointer value;
+
+            if (!g_hash_table_lookup_extended (names, fe->fname->str, NULL, &value))
+            {
+                // new entry: move name to the list storage
+                fe->fname = dir_list_new_name (list, fe->fname->str, fe->fname->len);
+                g_array_append_val (changed, *fe);
+                continue;
+            }
+
+            i = GPOINTER_TO_INT (value);
+            moved[i] = dir_entry_sort_changed (&list->list[i], &fe->st, link_isdir (fe)) ? 2 : 1;
+            list->list[i].st = fe->st;
+            list->list[i].f.link_to_dir = fe->f.link_to_dir;
+            list->list[i].f.stale_link = fe->f.stale_link;
+            list->list[i].f.dir_size_computed = 0;
+            file_entry_reset_cache (&list->list[i]);
+        }
+
+        g_hash_table_destroy (names);
+        dir_list_free_list (&fresh);
+    }
+
+    return dir_list_apply_moved (list, first, moved, changed, sort, sort_op);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -282,6 +1471,35 @@ dir_list_grow (dir_list *list, int delta)
     return TRUE;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create name of directory entry in the list storage.
+ *
+ * The GString header and the characters are placed together. The string must not be changed
+ * or freed: it is released with the list storage by dir_list_clean() or dir_list_free_list().
+ *
+ * @param list directory list
+ * @param fname file name
+ * @param len length of file name
+ *
+ * @return name that lives as long as the list storage
+ */
+
+GString *
+dir_list_new_name (dir_list *list, const char *fname, size_t len)
+{
+    GString *s;
+
+    s = (GString *) dir_list_arena_alloc (&list->arena, sizeof (GString) + len + 1);
+    s->str = (char *) (s + 1);
+    memcpy (s->str, fname, len);
+    s->str[len] = '\0';
+    s->len = len;
+    s->allocated_len = len + 1;
+
+    return s;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Append file info to the directory list.
@@ -306,7 +1524,7 @@ dir_list_append (dir_list *list, const char *fname, const struct stat *st, gbool
         return FALSE;
 
     fentry = &list->list[list->len];
-    fentry->fname = g_string_new (fname);
+    fentry->fname = dir_list_new_name (list, fname, strlen (fname));
     fentry->f.marked = 0;
     fentry->f.link_to_dir = link_to_dir ? 1 : 0;
     fentry->f.stale_link = stale_link ? 1 : 0;
@@ -314,6 +1532,7 @@ dir_list_append (dir_list *list, const char *fname, const struct stat *st, gbool
     fentry->st = *st;
     fentry->name_sort_key = NULL;
     fentry->extension_sort_key = NULL;
+    file_entry_reset_cache (fentry);
 
     list->len++;
 
@@ -379,11 +1598,7 @@ sort_ext (file_entry_t *a, file_entry_t *b)
     {
         int r;
 
-        if (a->extension_sort_key == NULL)
-            a->extension_sort_key = str_create_key (extension (a->fname->str), case_sensitive);
-        if (b->extension_sort_key == NULL)
-            b->extension_sort_key = str_create_key (extension (b->fname->str), case_sensitive);
-
+        // keys are created by dir_list_make_sort_keys() before sorting
         r = str_key_collate (a->extension_sort_key, b->extension_sort_key, case_sensitive);
         if (r != 0)
             return r * reverse;
@@ -505,13 +1720,10 @@ dir_list_sort (dir_list *list, GCompareFunc sort, const dir_sort_options_t *sort
         /* If there is an ".." entry the caller must take care to
            ensure that it occupies the first list element. */
         dot_dot_found = DIR_IS_DOTDOT (fentry->fname->str) ? 1 : 0;
-        reverse = sort_op->reverse ? -1 : 1;
-        case_sensitive = sort_op->case_sensitive ? 1 : 0;
-        exec_first = sort_op->exec_first;
-        qsort (&(list->list)[dot_dot_found], list->len - dot_dot_found, sizeof (file_entry_t),
-               sort);
-
-        clean_sort_keys (list, dot_dot_found, list->len - dot_dot_found);
+        dir_list_set_sort_options (sort_op);
+        dir_list_check_sort_keys (list);
+        dir_list_make_sort_keys (list, &list->list[dot_dot_found], list->len - dot_dot_found, sort);
+        dir_sort_entries (&list->list[dot_dot_found], list->len - dot_dot_found, sort);
     }
 }
 
@@ -520,18 +1732,9 @@ dir_list_sort (dir_list *list, GCompareFunc sort, const dir_sort_options_t *sort
 void
 dir_list_clean (dir_list *list)
 {
-    int i;
-
-    for (i = 0; i < list->len; i++)
-    {
-        file_entry_t *fentry;
-
-        fentry = &list->list[i];
-        g_string_free (fentry->fname, TRUE);
-        fentry->fname = NULL;
-    }
-
     list->len = 0;
+    dir_list_arena_free (&list->arena);
+    list->stamp.valid = FALSE;
     // reduce memory usage
     dir_list_grow (list, DIR_LIST_MIN_SIZE - list->size);
 }
@@ -541,19 +1744,11 @@ dir_list_clean (dir_list *list)
 void
 dir_list_free_list (dir_list *list)
 {
-    int i;
-
-    for (i = 0; i < list->len; i++)
-    {
-        file_entry_t *fentry;
-
-        fentry = &list->list[i];
-        g_string_free (fentry->fname, TRUE);
-    }
-
+    dir_list_arena_free (&list->arena);
     MC_PTR_FREE (list->list);
     list->len = 0;
     list->size = 0;
+    list->stamp.valid = FALSE;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -564,6 +1759,8 @@ dir_list_init (dir_list *list)
 {
     file_entry_t *fentry;
 
+    list->stamp.valid = FALSE;
+
     // Need to grow the *list?
     if (list->size == 0 && !dir_list_grow (list, DIR_LIST_RESIZE_STEP))
     {
@@ -573,7 +1770,7 @@ dir_list_init (dir_list *list)
 
     fentry = &list->list[0];
     memset (fentry, 0, sizeof (*fentry));
-    fentry->fname = g_string_new ("..");
+    fentry->fname = dir_list_new_name (list, "..", 2);
     fentry->f.link_to_dir = 0;
     fentry->f.stale_link = 0;
     fentry->f.dir_size_computed = 0;
@@ -634,12 +1831,13 @@ gboolean
 dir_list_load (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
                const dir_sort_options_t *sort_op, const file_filter_t *filter)
 {
-    DIR *dirp;
-    struct vfs_dirent *dp;
+    DIR *dirp = NULL;
+    DIR *local_dirp = NULL;
     struct stat st;
     file_entry_t *fentry;
     const char *vpath_str;
-    gboolean ret = TRUE;
+    const time_t load_time = time (NULL);
+    gboolean ret;
 
     // ".." (if any) must be the first entry in the list
     if (!dir_list_init (list))
@@ -647,13 +1845,22 @@ dir_list_load (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
 
     fentry = &list->list[0];
     if (dir_get_dotdot_stat (vpath, &st))
+    {
         fentry->st = st;
+        file_entry_reset_cache (fentry);
+    }
 
     if (list->callback != NULL)
         list->callback (DIR_OPEN, (void *) vpath);
-    dirp = mc_opendir (vpath);
-    if (dirp == NULL)
-        return FALSE;
+#ifdef DIR_LIST_LOCAL_STAT
+    local_dirp = dir_list_local_opendir (vpath);
+    if (local_dirp == NULL)
+#endif
+    {
+        dirp = mc_opendir (vpath);
+        if (dirp == NULL)
+            return FALSE;
+    }
 
     tree_store_start_check (vpath);
 
@@ -662,26 +1869,27 @@ dir_list_load (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
     if (IS_PATH_SEP (vpath_str[0]) && vpath_str[1] == '\0')
         dir_list_clean (list);
 
-    while (ret && (dp = mc_readdir (dirp)) != NULL)
-    {
-        gboolean link_to_dir, stale_link;
-
-        if (list->callback != NULL)
-            list->callback (DIR_READ, dp);
-
-        if (!handle_dirent (dp, filter, &st, &link_to_dir, &stale_link))
-            continue;
-
-        if (!dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link))
-            ret = FALSE;
-    }
+#ifdef DIR_LIST_LOCAL_STAT
+    if (local_dirp != NULL)
+        ret = dir_list_read_local (list, local_dirp, filter, NULL, 0);
+    else
+#endif
+        ret = dir_list_read_vfs (list, dirp, filter, NULL, 0);
 
     if (ret)
+    {
         dir_list_sort (list, sort, sort_op);
 
+        if (mc_stat (vpath, &st) == 0)
+            dir_list_stamp_set (list, &st, load_time, filter);
+    }
+
     if (list->callback != NULL)
         list->callback (DIR_CLOSE, NULL);
-    mc_closedir (dirp);
+    if (local_dirp != NULL)
+        closedir (local_dirp);
+    else
+        mc_closedir (dirp);
     tree_store_end_check ();
 
     return ret;
@@ -701,35 +1909,30 @@ if_link_is_exe (const vfs_path_t *full_name_vpath, const file_entry_t *file)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** If filter is null, then it is a match */
+/**
+ * Reload directory list from scratch preserving marks.
+ *
+ * @return FALSE on failure, TRUE on success
+ */
 
-gboolean
-dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
-                 const dir_sort_options_t *sort_op, const file_filter_t *filter)
+static gboolean
+dir_list_reload_full (dir_list *list, const vfs_path_t *vpath, DIR *local_dirp, DIR *dirp,
+                      const file_filter_t *filter)
 {
-    DIR *dirp;
-    struct vfs_dirent *dp;
     int i;
     struct stat st;
     int marked_cnt;
     GHashTable *marked_files;
     const char *tmp_path;
-    gboolean ret = TRUE;
-
-    if (list->callback != NULL)
-        list->callback (DIR_OPEN, (void *) vpath);
-    dirp = mc_opendir (vpath);
-    if (dirp == NULL)
-    {
-        dir_list_clean (list);
-        dir_list_init (list);
-        return FALSE;
-    }
-
-    tree_store_start_check (vpath);
+    gboolean ret;
 
     marked_files = g_hash_table_new (g_str_hash, g_str_equal);
     alloc_dir_copy (list->len);
+
+    // keep names in the copy until the list is reread
+    dir_copy.arena = list->arena;
+    memset (&list->arena, 0, sizeof (list->arena));
+
     for (marked_cnt = i = 0; i < list->len; i++)
     {
         file_entry_t *fentry, *dfentry;
@@ -737,7 +1940,7 @@ dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
         fentry = &list->list[i];
         dfentry = &dir_copy.list[i];
 
-        dfentry->fname = mc_g_string_dup (fentry->fname);
+        dfentry->fname = fentry->fname;
         dfentry->f.marked = fentry->f.marked;
         dfentry->f.dir_size_computed = fentry->f.dir_size_computed;
         dfentry->f.link_to_dir = fentry->f.link_to_dir;
@@ -767,8 +1970,8 @@ dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
         dir_list_clean (list);
         if (!dir_list_init (list))
         {
+            g_hash_table_destroy (marked_files);
             dir_list_free_list (&dir_copy);
-            mc_closedir (dirp);
             return FALSE;
         }
 
@@ -778,53 +1981,211 @@ dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
 
             fentry = &list->list[0];
             fentry->st = st;
+            file_entry_reset_cache (fentry);
         }
     }
 
-    while (ret && (dp = mc_readdir (dirp)) != NULL)
+#ifdef DIR_LIST_LOCAL_STAT
+    if (local_dirp != NULL)
+        ret = dir_list_read_local (list, local_dirp, filter, marked_files, marked_cnt);
+    else
+#else
+    (void) local_dirp;
+#endif
+        ret = dir_list_read_vfs (list, dirp, filter, marked_files, marked_cnt);
+
+    g_hash_table_destroy (marked_files);
+    dir_list_free_list (&dir_copy);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Reload directory list.
+ *
+ * If the list contains entries of the same directory, it is updated incrementally.
+ * Otherwise it is rebuilt from scratch. Marks of files are preserved in both cases.
+ * If filter is null, then it is a match.
+ */
+
+gboolean
+dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
+                 const dir_sort_options_t *sort_op, const file_filter_t *filter)
+{
+    DIR *dirp = NULL;
+    DIR *local_dirp = NULL;
+    struct stat dir_st;
+    gboolean dir_st_ok;
+    const time_t load_time = time (NULL);
+    gboolean ret;
+
+    if (list->callback != NULL)
+        list->callback (DIR_OPEN, (void *) vpath);
+#ifdef DIR_LIST_LOCAL_STAT
+    local_dirp = dir_list_local_opendir (vpath);
+    if (local_dirp == NULL)
+#endif
     {
-        gboolean link_to_dir, stale_link;
+        dirp = mc_opendir (vpath);
+        if (dirp == NULL)
+        {
+            dir_list_clean (list);
+            dir_list_init (list);
+            return FALSE;
+        }
+    }
 
-        if (list->callback != NULL)
-            list->callback (DIR_READ, dp);
+    tree_store_start_check (vpath);
 
-        if (!handle_dirent (dp, filter, &st, &link_to_dir, &stale_link))
-            continue;
+    dir_st_ok = mc_stat (vpath, &dir_st) == 0;
 
-        if (!dir_list_append (list, dp->d_name, &st, link_to_dir, stale_link))
-            ret = FALSE;
-        else
+    if (dir_st_ok && list->stamp.valid && list->stamp.dev == dir_st.st_dev
+        && list->stamp.ino == dir_st.st_ino)
+    {
+        const gboolean names_unchanged = dir_list_stamp_names_unchanged (list, &dir_st, filter);
+
+        ret = dir_list_update (list, local_dirp, dirp, names_unchanged, sort, sort_op, filter);
+
+        if (ret && list->len > 0 && DIR_IS_DOTDOT (list->list[0].fname->str))
         {
-            file_entry_t *fentry;
+            struct stat st;
 
-            fentry = &list->list[list->len - 1];
-
-            /*
-             * If we have marked files in the copy, scan through the copy
-             * to find matching file.  Decrease number of remaining marks if
-             * we copied one.
-             */
-            fentry->f.marked =
-                (marked_cnt > 0 && g_hash_table_lookup (marked_files, dp->d_name) != NULL) ? 1 : 0;
-            if (fentry->f.marked != 0)
-                marked_cnt--;
+            if (dir_get_dotdot_stat (vpath, &st))
+            {
+                list->list[0].st = st;
+                file_entry_reset_cache (&list->list[0]);
+            }
         }
     }
+    else
+    {
+        ret = dir_list_reload_full (list, vpath, local_dirp, dirp, filter);
 
-    if (ret)
-        dir_list_sort (list, sort, sort_op);
+        if (ret)
+            dir_list_sort (list, sort, sort_op);
+    }
+
+    if (ret && dir_st_ok)
+        dir_list_stamp_set (list, &dir_st, load_time, filter);
+    else
+        list->stamp.valid = FALSE;
 
     if (list->callback != NULL)
         list->callback (DIR_CLOSE, NULL);
-    mc_closedir (dirp);
+    if (local_dirp != NULL)
+        closedir (local_dirp);
+    else
+        mc_closedir (dirp);
     tree_store_end_check ();
 
-    g_hash_table_destroy (marked_files);
-    dir_list_free_list (&dir_copy);
-
     return ret;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Update entries of sorted directory list by names.
+ *
+ * Every named entry is stat'ed again: it is added to the list if it appeared, removed if it
+ * disappeared or doesn't match the filter anymore and updated otherwise. Marks of existing
+ * entries are kept.
+ *
+ * @param list directory list
+ * @param vpath directory path
+ * @param names array of unique names (char *) of changed entries
+ * @param sort sort function
+ * @param sort_op sort options
+ * @param filter file filter
+ *
+ * @return FALSE on failure, TRUE on success
+ */
+
+gboolean
+dir_list_update_names (dir_list *list, const vfs_path_t *vpath, const GPtrArray *names,
+                       GCompareFunc sort, const dir_sort_options_t *sort_op,
+                       const file_filter_t *filter)
+{
+    const int first = (list->len > 0 && DIR_IS_DOTDOT (list->list[0].fname->str)) ? 1 : 0;
+    GHashTable *index;
+    guint8 *moved;
+    GArray *changed;
+    guint n;
+    int i;
+
+    if (names->len == 0)
+        return TRUE;
+
+    // 0: entry is removed, 1: entry is not changed, 2: entry should be moved
+    moved = g_new (guint8, list->len);
+    memset (moved, 1, list->len);
+    changed = g_array_sized_new (FALSE, FALSE, sizeof (file_entry_t), names->len);
+
+    index = g_hash_table_new (g_str_hash, g_str_equal);
+    for (i = first; i < list->len; i++)
+        g_hash_table_insert (index, list->list[i].fname->str, GINT_TO_POINTER (i));
+
+    for (n = 0; n < names->len; n++)
+    {
+        const char *name = (const char *) g_ptr_array_index (names, n);
+        const size_t len = strlen (name);
+        struct stat st;
+        gboolean link_to_dir = FALSE;
+        gboolean stale_link = FALSE;
+        gboolean exists = FALSE;
+        gpointer value;
+
+        if (len != 0 && !dirent_is_skipped (name, len))
+        {
+            vfs_path_t *path_vpath;
+
+            path_vpath = vfs_path_append_new (vpath, name, (char *) NULL);
+            exists = mc_lstat (path_vpath, &st) == 0;
+            if (exists)
+            {
+                link_to_dir = file_is_symlink_to_dir (path_vpath, &st, &stale_link);
+                exists = dirent_filter_match (filter, name, len, &st, link_to_dir);
+            }
+            vfs_path_free (path_vpath, TRUE);
+        }
+
+        if (g_hash_table_lookup_extended (index, name, NULL, &value))
+        {
+            file_entry_t *fentry;
+
+            i = GPOINTER_TO_INT (value);
+            fentry = &list->list[i];
+
+            if (!exists)
+                moved[i] = 0;
+            else
+            {
+                if (dir_entry_sort_changed (fentry, &st, link_to_dir))
+                    moved[i] = 2;
+                fentry->st = st;
+                fentry->f.link_to_dir = link_to_dir ? 1 : 0;
+                fentry->f.stale_link = stale_link ? 1 : 0;
+                fentry->f.dir_size_computed = 0;
+                file_entry_reset_cache (fentry);
+            }
+        }
+        else if (exists)
+        {
+            file_entry_t fentry;
+
+            memset (&fentry, 0, sizeof (fentry));
+            fentry.fname = dir_list_new_name (list, name, len);
+            fentry.st = st;
+            fentry.f.link_to_dir = link_to_dir ? 1 : 0;
+            fentry.f.stale_link = stale_link ? 1 : 0;
+            g_array_append_val (changed, fentry);
+        }
+    }
+
+    g_hash_table_destroy (index);
+
+    return dir_list_apply_moved (list, first, moved, changed, sort, sort_op);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 void
@@ -41,6 +41,34 @@ typedef void (*dir_list_cb_fn) (dir_list_cb_state_t state, void *data);
 
 /*** structures declarations (and typedefs of structures)*****************************************/
 
+/**
+ * State of directory at the moment of last load.
+ * It is used by dir_list_reload() to update the list incrementally.
+ */
+typedef struct
+{
+    gboolean valid;    // list contains entries of this directory sorted in the current order
+    dev_t dev;
+    ino_t ino;
+    time_t mtime;
+    time_t ctime;
+    time_t load_time;  // time when loading was started
+    guint options;     // digest of options that affect the set of entries
+} dir_list_stamp_t;
+
+/**
+ * Storage of names and sort keys of directory entries.
+ * Names are not freed one by one: all memory is released at once when the list is cleaned.
+ */
+typedef struct
+{
+    GSList *blocks;                // allocated blocks, the current one is the first
+    gsize block_size;              // size of the current block
+    gsize block_used;              // number of used bytes in the current block
+    gsize used;                    // number of used bytes in all blocks
+    gboolean keys_case_sensitive;  // case sensitivity of sort keys
+} dir_list_arena_t;
+
 /**
  * A structure to represent directory content
  */
@@ -50,6 +78,8 @@ typedef struct
     int size;                 // number of allocated elements in list (capacity)
     int len;                  // number of used elements in list
     dir_list_cb_fn callback;  // callback to visualize of directory read
+    dir_list_stamp_t stamp;   // state of directory at the moment of last load
+    dir_list_arena_t arena;   // storage of names of entries
 } dir_list;
 
 /**
@@ -75,6 +105,7 @@ typedef struct
 /*** declarations of public functions ************************************************************/
 
 gboolean dir_list_grow (dir_list *list, int delta);
+GString *dir_list_new_name (dir_list *list, const char *fname, size_t len);
 gboolean dir_list_append (dir_list *list, const char *fname, const struct stat *st,
                           gboolean link_to_dir, gboolean stale_link);
 
@@ -82,6 +113,9 @@ gboolean dir_list_load (dir_list *list, const vfs_path_t *vpath, GCompareFunc so
                         const dir_sort_options_t *sort_op, const file_filter_t *filter);
 gboolean dir_list_reload (dir_list *list, const vfs_path_t *vpath, GCompareFunc sort,
                           const dir_sort_options_t *sort_op, const file_filter_t *filter);
+gboolean dir_list_update_names (dir_list *list, const vfs_path_t *vpath, const GPtrArray *names,
+                                GCompareFunc sort, const dir_sort_options_t *sort_op,
+                                const file_filter_t *filter);
 void dir_list_sort (dir_list *list, GCompareFunc sort, const dir_sort_options_t *sort_op);
 gboolean dir_list_init (dir_list *list);
 void dir_list_clean (dir_list *list);
@@ -0,0 +1,524 @@
+/*
+   Fast computing of size of local directories.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file dirsize.c
+ *  \brief Source: fast computing of size of local directories
+ *
+ *  Local directory trees are walked in worker threads bypassing VFS. Every directory is
+ *  a separate task, so subtrees are walked in parallel. Entries are stat'ed relative to
+ *  the directory fd.
+ *
+ *  If dir_size_cache option is set, the number and the total size of files of every walked
+ *  directory are kept together with names of its subdirectories. The record is identified by
+ *  device, inode and times of directory, so unchanged directories are not read again on the
+ *  next walk: only subdirectories are opened. Note that changes of contents of files don't
+ *  change times of directory and aren't noticed, so the option is off by default.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/widget.h"
+#include "lib/workpool.h"
+
+#include "src/setup.h"  // dir_size_cache
+
+#include "dirsize.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined(HAVE_FSTATAT) && defined(HAVE_FDOPENDIR)
+#define DIR_SIZE_LOCAL 1
+#endif
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* how often progress is updated, in microseconds: 25 FPS */
+#define DIR_SIZE_UPDATE_DELAY (G_USEC_PER_SEC / 25)
+
+/* max number of directories in the cache */
+#define DIR_SIZE_CACHE_MAX    (256 * 1024)
+
+/* directories changed just before walk aren't cached: next change in the same second
+   cannot be noticed */
+#define DIR_SIZE_RACY_SEC     2
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    dev_t dev;
+    ino_t ino;
+    gboolean follow;  // entries were stat'ed with following of symlinks
+} dir_size_key_t;
+
+/* files of one directory */
+typedef struct
+{
+    dir_size_key_t key;  // must be first
+    time_t mtime;
+    time_t ctime;
+    size_t count;     // number of entries except subdirectories
+    uintmax_t total;  // total size of them
+    char **subdirs;   // NULL-terminated list of names of subdirectories
+} dir_size_node_t;
+
+typedef struct
+{
+    mc_workpool_t *pool;
+    gboolean follow;
+    gboolean use_cache;  // value of dir_size_cache at start of walk
+    time_t start;        // time of start of walk
+
+    GMutex lock;          // protects members below
+    GHashTable *visited;  // keys of walked directories
+    size_t dir_count;
+    size_t count;
+    uintmax_t total;
+    char *current;  // last walked directory
+
+    gint abort;  // walk was interrupted, accessed atomically
+} dir_size_ctx_t;
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+#ifdef DIR_SIZE_LOCAL
+/* walked directories, accessed from worker threads */
+static GHashTable *size_cache = NULL;
+static GMutex size_cache_lock;
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef DIR_SIZE_LOCAL
+static guint
+dir_size_key_hash (gconstpointer v)
+{
+    const dir_size_key_t *k = (const dir_size_key_t *) v;
+    guint64 h;
+
+    h = (guint64) k->ino * 31 + (guint64) k->dev;
+    h = h * 2 + (k->follow ? 1 : 0);
+
+    return (guint) (h ^ (h >> 32));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_size_key_equal (gconstpointer v1, gconstpointer v2)
+{
+    const dir_size_key_t *k1 = (const dir_size_key_t *) v1;
+    const dir_size_key_t *k2 = (const dir_size_key_t *) v2;
+
+    return k1->dev == k2->dev && k1->ino == k2->ino && k1->follow == k2->follow;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_size_node_free (gpointer data)
+{
+    dir_size_node_t *node = (dir_size_node_t *) data;
+
+    if (node != NULL)
+    {
+        g_strfreev (node->subdirs);
+        g_free (node);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get files of unchanged directory from the cache.
+ *
+ * @param node directory with key and times filled
+ *
+ * @return TRUE if directory is found, FALSE otherwise
+ */
+
+static gboolean
+dir_size_cache_lookup (dir_size_node_t *node)
+{
+    const dir_size_node_t *n = NULL;
+
+    g_mutex_lock (&size_cache_lock);
+    if (size_cache != NULL)
+        n = (const dir_size_node_t *) g_hash_table_lookup (size_cache, &node->key);
+    if (n != NULL && (n->mtime != node->mtime || n->ctime != node->ctime))
+        n = NULL;
+    if (n != NULL)
+    {
+        node->count = n->count;
+        node->total = n->total;
+        node->subdirs = g_strdupv (n->subdirs);
+    }
+    g_mutex_unlock (&size_cache_lock);
+
+    return (n != NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_size_cache_add (const dir_size_node_t *node)
+{
+    dir_size_node_t *n;
+
+    n = g_new (dir_size_node_t, 1);
+    *n = *node;
+    n->subdirs = g_strdupv (node->subdirs);
+
+    g_mutex_lock (&size_cache_lock);
+    if (size_cache == NULL)
+        size_cache =
+            g_hash_table_new_full (dir_size_key_hash, dir_size_key_equal, NULL, dir_size_node_free);
+    else if (g_hash_table_size (size_cache) >= DIR_SIZE_CACHE_MAX)
+        g_hash_table_remove_all (size_cache);
+    g_hash_table_replace (size_cache, &n->key, n);
+    g_mutex_unlock (&size_cache_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read entries of directory.
+ *
+ * @param ctx walk context
+ * @param fd directory fd. It is closed here
+ * @param node directory whose files are counted
+ *
+ * @return TRUE if all entries are read, FALSE otherwise
+ */
+
+static gboolean
+dir_size_read (dir_size_ctx_t *ctx, int fd, dir_size_node_t *node)
+{
+    DIR *dirp;
+    struct dirent *dp;
+    GPtrArray *subdirs;
+    const int flags = ctx->follow ? 0 : AT_SYMLINK_NOFOLLOW;
+    gboolean aborted;
+
+    dirp = fdopendir (fd);
+    if (dirp == NULL)
+    {
+        close (fd);
+        return FALSE;
+    }
+
+    subdirs = g_ptr_array_new ();
+
+    while ((dp = readdir (dirp)) != NULL && g_atomic_int_get (&ctx->abort) == 0)
+    {
+        struct stat st;
+        gboolean is_dir;
+
+        if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
+            continue;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+        // subdirectory is stat'ed by its own task
+        is_dir = (dp->d_type == DT_DIR);
+#else
+        is_dir = FALSE;
+#endif
+
+        if (!is_dir)
+        {
+            // entry is skipped if it cannot be stat'ed, like in do_compute_dir_size()
+            if (fstatat (dirfd (dirp), dp->d_name, &st, flags) != 0)
+                continue;
+
+            is_dir = S_ISDIR (st.st_mode);
+        }
+
+        if (is_dir)
+            g_ptr_array_add (subdirs, g_strdup (dp->d_name));
+        else
+        {
+            node->count++;
+            node->total += (uintmax_t) st.st_size;
+        }
+    }
+
+    aborted = (g_atomic_int_get (&ctx->abort) != 0);
+
+    closedir (dirp);
+
+    g_ptr_array_add (subdirs, NULL);
+    node->subdirs = (char **) g_ptr_array_free (subdirs, FALSE);
+
+    return !aborted;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Count files of one directory and push tasks for its subdirectories. Runs in a worker thread.
+ */
+
+static void
+dir_size_task (gpointer task, gpointer user_data)
+{
+    char *path = (char *) task;
+    dir_size_ctx_t *ctx = (dir_size_ctx_t *) user_data;
+    dir_size_node_t *node = NULL;
+    struct stat st;
+    gboolean walked;
+    int fd;
+    char **subdir;
+    char *prev;
+
+    if (g_atomic_int_get (&ctx->abort) != 0)
+        goto ret;
+
+    fd = open (path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd != -1 && fstat (fd, &st) != 0)
+    {
+        close (fd);
+        fd = -1;
+    }
+
+    if (fd == -1)
+    {
+        // directory is counted even if it can't be read, like do_compute_dir_size() does
+        g_mutex_lock (&ctx->lock);
+        ctx->dir_count++;
+        g_mutex_unlock (&ctx->lock);
+        goto ret;
+    }
+
+    node = g_new0 (dir_size_node_t, 1);
+    node->key.dev = st.st_dev;
+    node->key.ino = st.st_ino;
+    node->key.follow = ctx->follow;
+    node->mtime = st.st_mtime;
+    node->ctime = st.st_ctime;
+
+    g_mutex_lock (&ctx->lock);
+    ctx->dir_count++;
+    walked = g_hash_table_contains (ctx->visited, &node->key);
+    if (!walked)
+    {
+        dir_size_key_t *key;
+
+        key = g_new (dir_size_key_t, 1);
+        *key = node->key;
+        g_hash_table_add (ctx->visited, key);
+    }
+    g_mutex_unlock (&ctx->lock);
+
+    // don't walk in circles via symlinks
+    if (walked)
+    {
+        close (fd);
+        goto ret;
+    }
+
+    if (ctx->use_cache && dir_size_cache_lookup (node))
+        close (fd);
+    else if (!dir_size_read (ctx, fd, node))
+        goto ret;
+    else if (ctx->use_cache && node->ctime < ctx->start - DIR_SIZE_RACY_SEC
+             && node->mtime < ctx->start - DIR_SIZE_RACY_SEC)
+        dir_size_cache_add (node);
+
+    for (subdir = node->subdirs; *subdir != NULL && g_atomic_int_get (&ctx->abort) == 0; subdir++)
+        mc_workpool_push (ctx->pool, g_build_filename (path, *subdir, (char *) NULL));
+
+    g_mutex_lock (&ctx->lock);
+    ctx->count += node->count;
+    ctx->total += node->total;
+    // swap strings to avoid duplication
+    prev = ctx->current;
+    ctx->current = path;
+    path = prev;
+    g_mutex_unlock (&ctx->lock);
+
+ret:
+    dir_size_node_free (node);
+    g_free (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+dir_size_get_local_path (const vfs_path_t *vpath)
+{
+    const vfs_path_element_t *element;
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return NULL;
+
+    element = vfs_path_get_by_index (vpath, 0);
+    if (element->path == NULL || !IS_PATH_SEP (element->path[0]))
+        return NULL;
+#ifdef HAVE_CHARSET
+    // file names must be recoded
+    if (element->encoding != NULL)
+        return NULL;
+#endif
+
+    return element->path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_size_update_status (dir_size_ctx_t *ctx, const vfs_path_t *vpath, dirsize_status_msg_t *dsm,
+                        size_t dir_count, uintmax_t total, FileProgressStatus *status)
+{
+    status_msg_t *sm = STATUS_MSG (dsm);
+    vfs_path_t *current = NULL;
+
+    g_mutex_lock (&ctx->lock);
+    dsm->dir_count = dir_count + ctx->dir_count;
+    dsm->total_size = total + ctx->total;
+    if (ctx->current != NULL)
+        current = vfs_path_from_str (ctx->current);
+    g_mutex_unlock (&ctx->lock);
+
+    dsm->dirname_vpath = current != NULL ? current : vpath;
+    *status = sm->update (sm);
+    dsm->dirname_vpath = NULL;
+    vfs_path_free (current, TRUE);
+
+    if (*status != FILE_CONT)
+        g_atomic_int_set (&ctx->abort, 1);
+}
+#endif /* DIR_SIZE_LOCAL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compute the number of files and the number of bytes used by them in a local directory.
+ * Results are added to the values of counters.
+ *
+ * @param vpath directory
+ * @param follow_symlinks whether to follow symlinks
+ * @param dsm status dialog
+ * @param ret_dir_count number of directories
+ * @param ret_count number of files
+ * @param ret_total total size of files
+ * @param status result: FILE_CONT, or FILE_SKIP or FILE_ABORT if interrupted by user
+ *
+ * @return FALSE if @vpath is not a local directory and should be walked via VFS, TRUE otherwise
+ */
+
+gboolean
+dir_size_compute (const vfs_path_t *vpath, gboolean follow_symlinks, dirsize_status_msg_t *dsm,
+                  size_t *ret_dir_count, size_t *ret_count, uintmax_t *ret_total,
+                  FileProgressStatus *status)
+{
+#ifdef DIR_SIZE_LOCAL
+    const char *path;
+    dir_size_ctx_t ctx;
+    int workers;
+
+    path = dir_size_get_local_path (vpath);
+    if (path == NULL)
+        return FALSE;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.follow = follow_symlinks;
+    ctx.use_cache = dir_size_cache;
+    ctx.start = time (NULL);
+    g_mutex_init (&ctx.lock);
+    ctx.visited = g_hash_table_new_full (dir_size_key_hash, dir_size_key_equal, g_free, NULL);
+
+    *status = FILE_CONT;
+
+    // operations are I/O bound, so use more threads than CPUs
+    workers = MIN (2 * mc_workpool_get_num_workers (), MC_WORKPOOL_MAX_WORKERS);
+    ctx.pool = mc_workpool_new (dir_size_task, &ctx, workers);
+
+    mc_workpool_push (ctx.pool, g_strdup (path));
+
+    while (!mc_workpool_wait_timeout (ctx.pool, DIR_SIZE_UPDATE_DELAY))
+        if (*status == FILE_CONT && STATUS_MSG (dsm)->update != NULL)
+            dir_size_update_status (&ctx, vpath, dsm, *ret_dir_count, *ret_total, status);
+
+    mc_workpool_free (ctx.pool);
+
+    *ret_dir_count += ctx.dir_count;
+    *ret_count += ctx.count;
+    *ret_total += ctx.total;
+
+    g_hash_table_destroy (ctx.visited);
+    g_free (ctx.current);
+    g_mutex_clear (&ctx.lock);
+
+    return TRUE;
+#else
+    (void) vpath;
+    (void) follow_symlinks;
+    (void) dsm;
+    (void) ret_dir_count;
+    (void) ret_count;
+    (void) ret_total;
+    (void) status;
+
+    return FALSE;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free cache of directories.
+ */
+
+void
+dir_size_done (void)
+{
+#ifdef DIR_SIZE_LOCAL
+    g_mutex_lock (&size_cache_lock);
+    if (size_cache != NULL)
+    {
+        g_hash_table_destroy (size_cache);
+        size_cache = NULL;
+    }
+    g_mutex_unlock (&size_cache_lock);
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
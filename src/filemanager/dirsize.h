@@ -0,0 +1,32 @@
+/** \file dirsize.h
+ *  \brief Header: fast computing of size of local directories
+ */
+
+#ifndef MC__DIRSIZE_H
+#define MC__DIRSIZE_H
+
+#include <inttypes.h>  // uintmax_t
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+
+#include "file.h"  // dirsize_status_msg_t
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+gboolean dir_size_compute (const vfs_path_t *vpath, gboolean follow_symlinks,
+                           dirsize_status_msg_t *dsm, size_t *ret_dir_count, size_t *ret_count,
+                           uintmax_t *ret_total, FileProgressStatus *status);
+void dir_size_done (void);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -0,0 +1,582 @@
+/*
+   Live update of panels when directories are changed.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file dirwatch.c
+ *  \brief Source: live update of panels when directories are changed
+ *
+ *  Directories of panels on the local filesystem are watched with inotify. The inotify
+ *  descriptor is a select channel of the main loop: events are read as soon as they arrive,
+ *  names of changed entries are coalesced per panel and only those entries are stat'ed again.
+ *  If too many entries are changed or the event queue is overflowed, the panel is reloaded.
+ *
+ *  Events of one burst are debounced with a timerfd that is another select channel, so the
+ *  main loop is never blocked while waiting for further events.
+ *
+ *  Changes are applied only if the file manager is the top dialog. Otherwise they are
+ *  collected and applied when the file manager gets control back.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/tty/key.h"  // add_select_channel()
+#include "lib/util.h"
+#include "lib/vfs/vfs.h"
+#include "lib/widget.h"
+
+#include "dirwatch.h"
+
+#ifdef ENABLE_DIR_WATCH
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#define DIR_WATCH_MASK                                                                             \
+    (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_CLOSE_WRITE             \
+     | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+/* if more entries are changed, the panel is reloaded */
+#define DIR_WATCH_MAX_NAMES 512
+
+/* events that arrive within this time (in microseconds) are handled in one batch */
+#define DIR_WATCH_DELAY     20000
+
+/* max number of delays to collect one batch */
+#define DIR_WATCH_MAX_DELAY 5
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    WPanel *panel;
+    int wd;             // watch descriptor, -1 if directory is not watched
+    char *path;         // watched directory
+    GHashTable *names;  // names of changed entries
+    gboolean reload;    // panel should be reloaded
+} dir_watch_t;
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+static int watch_fd = -1;
+static int timer_fd = -1;
+/* time of the first event of the current batch, 0 if there are no pending events */
+static gint64 batch_start = 0;
+static GSList *watch_list = NULL;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static dir_watch_t *
+dir_watch_find (const WPanel *panel)
+{
+    GSList *l;
+
+    for (l = watch_list; l != NULL; l = g_slist_next (l))
+    {
+        dir_watch_t *w = (dir_watch_t *) l->data;
+
+        if (w->panel == panel)
+            return w;
+    }
+
+    return NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_clear (dir_watch_t *w)
+{
+    g_hash_table_remove_all (w->names);
+    w->reload = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get directory of panel that can be watched.
+ *
+ * @return path of directory or NULL if directory is not local or panel is panelized
+ */
+
+static const char *
+dir_watch_get_path (const WPanel *panel)
+{
+    const vfs_path_element_t *path_element;
+
+    if (panel->is_panelized || panel->cwd_vpath == NULL
+        || vfs_path_elements_count (panel->cwd_vpath) != 1 || !vfs_file_is_local (panel->cwd_vpath))
+        return NULL;
+
+    path_element = vfs_path_get_by_index (panel->cwd_vpath, 0);
+#ifdef HAVE_CHARSET
+    // names in events are not recoded
+    if (path_element->encoding != NULL)
+        return NULL;
+#endif
+    if (!IS_PATH_SEP (path_element->path[0]))
+        return NULL;
+
+    return path_element->path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop watching directory of panel. The same directory can be shown in both panels,
+ * in this case watch descriptor is shared.
+ */
+
+static void
+dir_watch_unsubscribe (dir_watch_t *w)
+{
+    GSList *l;
+
+    if (w->wd != -1)
+    {
+        for (l = watch_list; l != NULL; l = g_slist_next (l))
+        {
+            const dir_watch_t *w2 = (const dir_watch_t *) l->data;
+
+            if (w2 != w && w2->wd == w->wd)
+                break;
+        }
+
+        if (l == NULL)
+            (void) inotify_rm_watch (watch_fd, w->wd);
+
+        w->wd = -1;
+    }
+
+    MC_PTR_FREE (w->path);
+    dir_watch_clear (w);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_add_event (const struct inotify_event *ev)
+{
+    GSList *l;
+
+    for (l = watch_list; l != NULL; l = g_slist_next (l))
+    {
+        dir_watch_t *w = (dir_watch_t *) l->data;
+
+        if ((ev->mask & IN_Q_OVERFLOW) != 0)
+            w->reload = TRUE;
+        else if (w->wd != ev->wd)
+            continue;
+        else if ((ev->mask & IN_IGNORED) != 0)
+        {
+            // watch is removed by kernel: directory is deleted or unmounted
+            w->wd = -1;
+            w->reload = TRUE;
+        }
+        else if ((ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) != 0)
+            w->reload = TRUE;
+        else if (!w->reload && ev->len != 0 && ev->name[0] != '\0')
+        {
+            if (g_hash_table_size (w->names) >= DIR_WATCH_MAX_NAMES)
+            {
+                g_hash_table_remove_all (w->names);
+                w->reload = TRUE;
+            }
+            else if (!g_hash_table_contains (w->names, ev->name))
+                g_hash_table_add (w->names, g_strdup (ev->name));
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read all available events.
+ *
+ * @return TRUE if any event was read
+ */
+
+static gboolean
+dir_watch_read_events (void)
+{
+    // events are aligned as struct inotify_event
+    guint64 buf[4096 / sizeof (guint64)];
+    gboolean got = FALSE;
+
+    while (TRUE)
+    {
+        const char *p, *end;
+        ssize_t len;
+
+        len = read (watch_fd, buf, sizeof (buf));
+        if (len < 0 && errno == EINTR)
+            continue;
+        if (len <= 0)
+            break;
+
+        got = TRUE;
+
+        for (p = (const char *) buf, end = p + len; p < end;)
+        {
+            const struct inotify_event *ev = (const struct inotify_event *) p;
+
+            dir_watch_add_event (ev);
+            p += sizeof (struct inotify_event) + ev->len;
+        }
+    }
+
+    return got;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/**
+ * Arm or disarm one-shot timer of the batch.
+ *
+ * @param delay time in microseconds, 0 to disarm the timer
+ */
+
+static void
+dir_watch_set_timer (gint64 delay)
+{
+    struct itimerspec its;
+
+    memset (&its, 0, sizeof (its));
+    its.it_value.tv_sec = (time_t) (delay / G_USEC_PER_SEC);
+    its.it_value.tv_nsec = (long) (delay % G_USEC_PER_SEC) * 1000;
+
+    (void) timerfd_settime (timer_fd, 0, &its, NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_collect_name (gpointer key, gpointer value, gpointer user_data)
+{
+    (void) value;
+
+    g_ptr_array_add ((GPtrArray *) user_data, key);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Apply collected changes to the panel.
+ *
+ * @return TRUE if panel was changed
+ */
+
+static gboolean
+dir_watch_apply (dir_watch_t *w)
+{
+    WPanel *panel = w->panel;
+    const file_entry_t *fe;
+    char *current_file = NULL;
+    const char *path;
+
+    if (!w->reload && g_hash_table_size (w->names) == 0)
+        return FALSE;
+
+    path = dir_watch_get_path (panel);
+    if (path == NULL || w->path == NULL || strcmp (path, w->path) != 0)
+    {
+        // panel was changed and watch will be updated
+        dir_watch_clear (w);
+        return FALSE;
+    }
+
+    fe = panel_current_entry (panel);
+    if (fe != NULL)
+        current_file = g_strndup (fe->fname->str, fe->fname->len);
+
+    if (w->reload)
+    {
+        // watch is recreated in panel_reload()
+        memset (&panel->dir_stat, 0, sizeof (panel->dir_stat));
+        panel_reload (panel);
+    }
+    else
+    {
+        GPtrArray *names;
+
+        names = g_ptr_array_sized_new (g_hash_table_size (w->names));
+        g_hash_table_foreach (w->names, dir_watch_collect_name, names);
+        if (!dir_list_update_names (&panel->dir, panel->cwd_vpath, names,
+                                    panel->sort_field->sort_routine, &panel->sort_info,
+                                    &panel->filter))
+            message (D_ERROR, MSG_ERROR, _ ("Cannot read directory contents"));
+        g_ptr_array_free (names, TRUE);
+    }
+
+    dir_watch_clear (w);
+
+    panel_set_current_by_name (panel, current_file);
+    g_free (current_file);
+    recalculate_panel_summary (panel);
+    panel->dirty = TRUE;
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_watch_filemanager_is_top (void)
+{
+    return filemanager != NULL && top_dlg != NULL && DIALOG (top_dlg->data) == filemanager;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_batch_done (void)
+{
+    batch_start = 0;
+    dir_watch_set_timer (0);
+
+    if (dir_watch_filemanager_is_top ())
+        dir_watch_flush ();
+    else if (filemanager != NULL)
+        // apply changes when file manager gets control back
+        widget_idle (WIDGET (filemanager), TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+dir_watch_callback (int fd, void *info)
+{
+    gint64 now, delay;
+
+    (void) fd;
+    (void) info;
+
+    if (!dir_watch_read_events ())
+        return 0;
+
+    // postpone the batch while events are coming, but not longer than DIR_WATCH_MAX_DELAY times
+    now = g_get_monotonic_time ();
+    if (batch_start == 0)
+        batch_start = now;
+
+    delay = MIN (DIR_WATCH_DELAY, batch_start + DIR_WATCH_MAX_DELAY * DIR_WATCH_DELAY - now);
+    if (delay > 0)
+        dir_watch_set_timer (delay);
+    else
+        dir_watch_batch_done ();
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+dir_watch_timer_callback (int fd, void *info)
+{
+    guint64 expirations;
+
+    (void) info;
+
+    if (read (fd, &expirations, sizeof (expirations)) > 0 && batch_start != 0)
+        dir_watch_batch_done ();
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+dir_watch_init (void)
+{
+    if (watch_fd != -1)
+        return TRUE;
+
+    watch_fd = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+    if (watch_fd == -1)
+        return FALSE;
+
+    timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer_fd == -1)
+    {
+        close (watch_fd);
+        watch_fd = -1;
+        return FALSE;
+    }
+
+    add_select_channel (watch_fd, dir_watch_callback, NULL);
+    add_select_channel (timer_fd, dir_watch_timer_callback, NULL);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+dir_watch_done (void)
+{
+    if (watch_fd == -1)
+        return;
+
+    delete_select_channel (timer_fd);
+    close (timer_fd);
+    timer_fd = -1;
+    batch_start = 0;
+
+    delete_select_channel (watch_fd);
+    close (watch_fd);
+    watch_fd = -1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start watching directory of panel or follow the change of directory.
+ * Should be called before directory is (re)loaded: all previously collected changes are dropped.
+ *
+ * @param panel file panel
+ */
+
+void
+dir_watch_panel (WPanel *panel)
+{
+    dir_watch_t *w;
+    const char *path;
+
+    w = dir_watch_find (panel);
+    path = dir_watch_get_path (panel);
+
+    if (w != NULL && w->wd != -1 && path != NULL && strcmp (w->path, path) == 0)
+    {
+        dir_watch_clear (w);
+        return;
+    }
+
+    if (w != NULL)
+        dir_watch_unsubscribe (w);
+
+    if (path == NULL || !dir_watch_init ())
+        return;
+
+    if (w == NULL)
+    {
+        w = g_new0 (dir_watch_t, 1);
+        w->panel = panel;
+        w->wd = -1;
+        w->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+        watch_list = g_slist_prepend (watch_list, w);
+    }
+
+    w->wd = inotify_add_watch (watch_fd, path, DIR_WATCH_MASK);
+    if (w->wd != -1)
+        w->path = g_strdup (path);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop watching directory of panel.
+ *
+ * @param panel file panel
+ */
+
+void
+dir_watch_panel_remove (WPanel *panel)
+{
+    dir_watch_t *w;
+
+    w = dir_watch_find (panel);
+    if (w == NULL)
+        return;
+
+    dir_watch_unsubscribe (w);
+    g_hash_table_destroy (w->names);
+    watch_list = g_slist_remove (watch_list, w);
+    g_free (w);
+
+    if (watch_list == NULL)
+        dir_watch_done ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Exchange watches of panels whose contents were swapped.
+ */
+
+void
+dir_watch_swap_panels (WPanel *panel1, WPanel *panel2)
+{
+    dir_watch_t *w1, *w2;
+
+    w1 = dir_watch_find (panel1);
+    w2 = dir_watch_find (panel2);
+
+    if (w1 != NULL)
+        w1->panel = panel2;
+    if (w2 != NULL)
+        w2->panel = panel1;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Apply collected changes to panels and redraw them. Does nothing if the file manager
+ * is not the top dialog.
+ */
+
+void
+dir_watch_flush (void)
+{
+    GSList *l;
+    gboolean changed = FALSE;
+
+    if (!dir_watch_filemanager_is_top ())
+        return;
+
+    for (l = watch_list; l != NULL; l = g_slist_next (l))
+    {
+        dir_watch_t *w = (dir_watch_t *) l->data;
+
+        if (dir_watch_apply (w))
+        {
+            if (widget_get_state (WIDGET (w->panel), WST_VISIBLE))
+                widget_draw (WIDGET (w->panel));
+            changed = TRUE;
+        }
+    }
+
+    if (changed)
+    {
+        widget_update_cursor (WIDGET (filemanager));
+        mc_refresh ();
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+#endif /* ENABLE_DIR_WATCH */
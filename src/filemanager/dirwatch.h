@@ -0,0 +1,62 @@
+/** \file dirwatch.h
+ *  \brief Header: live update of panels when directories are changed
+ */
+
+#ifndef MC__DIRWATCH_H
+#define MC__DIRWATCH_H
+
+#include "lib/global.h"
+
+#include "panel.h"  // WPanel
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+#if defined(HAVE_SYS_INOTIFY_H) && defined(HAVE_INOTIFY_INIT1) && defined(HAVE_SYS_TIMERFD_H)      \
+    && defined(HAVE_TIMERFD_CREATE)
+#define ENABLE_DIR_WATCH 1
+#endif
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+#ifdef ENABLE_DIR_WATCH
+void dir_watch_panel (WPanel *panel);
+void dir_watch_panel_remove (WPanel *panel);
+void dir_watch_swap_panels (WPanel *panel1, WPanel *panel2);
+void dir_watch_flush (void);
+#endif
+
+/*** inline functions ****************************************************************************/
+
+#ifndef ENABLE_DIR_WATCH
+static inline void
+dir_watch_panel (WPanel *panel)
+{
+    (void) panel;
+}
+
+static inline void
+dir_watch_panel_remove (WPanel *panel)
+{
+    (void) panel;
+}
+
+static inline void
+dir_watch_swap_panels (WPanel *panel1, WPanel *panel2)
+{
+    (void) panel1;
+    (void) panel2;
+}
+
+static inline void
+dir_watch_flush (void)
+{
+}
+#endif
+
+#endif
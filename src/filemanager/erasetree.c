@@ -0,0 +1,414 @@
+/*
+   Fast removal of local directory trees.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file erasetree.c
+ *  \brief Source: fast removal of local directory trees
+ *
+ *  Local directory trees are removed in worker threads bypassing VFS. Every directory is
+ *  a separate task, so sibling subtrees are removed concurrently. Files are removed with
+ *  unlinkat() relative to the directory fd, type of entry is taken from d_type if possible.
+ *  A directory is removed when the last of its subdirectories is removed.
+ *
+ *  Workers don't report errors: entries which cannot be removed are skipped and returned
+ *  to the caller which handles them in the usual way, e.g. by asking user to retry.
+ */
+
+#include <config.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/workpool.h"
+
+#include "erasetree.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#if defined(HAVE_FSTATAT) && defined(HAVE_FDOPENDIR) && defined(HAVE_UNLINKAT)
+#define ERASE_TREE_LOCAL 1
+#endif
+
+#ifndef O_DIRECTORY
+#define O_DIRECTORY 0
+#endif
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* removal is bound by locks of filesystem, so more threads don't help */
+#define ERASE_TREE_MAX_WORKERS 4
+
+/* progress of large directory is published after this number of removed files */
+#define ERASE_TREE_REPORT_FILES 1024
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct erase_tree_dir_t erase_tree_dir_t;
+
+struct erase_tree_dir_t
+{
+    erase_tree_dir_t *parent;
+    char *path;
+    gint refs;  // reading of directory and unfinished subdirectories, accessed atomically
+};
+
+struct erase_tree_t
+{
+    mc_workpool_t *pool;
+    GAsyncQueue *errors;  // entries which cannot be removed
+    gint abort;           // don't remove anything more, accessed atomically
+
+    GMutex lock;    // protects members below
+    size_t count;   // number of removed files
+    char *current;  // directory being processed
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef ERASE_TREE_LOCAL
+static void
+erase_tree_add_error (erase_tree_t *et, char *path, gboolean is_dir)
+{
+    erase_tree_error_t *e;
+
+    e = g_new (erase_tree_error_t, 1);
+    e->path = path;
+    e->is_dir = is_dir;
+    g_async_queue_push (et->errors, e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static erase_tree_dir_t *
+erase_tree_dir_new (erase_tree_dir_t *parent, char *path)
+{
+    erase_tree_dir_t *dir;
+
+    dir = g_new (erase_tree_dir_t, 1);
+    dir->parent = parent;
+    dir->path = path;
+    dir->refs = 1;
+
+    if (parent != NULL)
+        g_atomic_int_inc (&parent->refs);
+
+    return dir;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Finish task of directory. If the directory and all its subdirectories are read, remove it and
+ * finish its parent.
+ */
+
+static void
+erase_tree_dir_release (erase_tree_t *et, erase_tree_dir_t *dir)
+{
+    while (dir != NULL && g_atomic_int_dec_and_test (&dir->refs))
+    {
+        erase_tree_dir_t *parent = dir->parent;
+
+        if (g_atomic_int_get (&et->abort) == 0 && rmdir (dir->path) != 0)
+            erase_tree_add_error (et, dir->path, TRUE);
+        else
+            g_free (dir->path);
+
+        g_free (dir);
+        dir = parent;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Publish number of files removed by worker and the directory being processed.
+ *
+ * @param et remover
+ * @param path directory being processed
+ * @param count number of removed files, it is reset
+ */
+
+static void
+erase_tree_report (erase_tree_t *et, const char *path, size_t *count)
+{
+    g_mutex_lock (&et->lock);
+    et->count += *count;
+    g_free (et->current);
+    et->current = g_strdup (path);
+    g_mutex_unlock (&et->lock);
+
+    *count = 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+erase_tree_is_dir (DIR *dirp, const struct dirent *dp)
+{
+    struct stat st;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+    if (dp->d_type != DT_UNKNOWN)
+        return (dp->d_type == DT_DIR);
+#endif
+
+    return (fstatat (dirfd (dirp), dp->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0
+            && S_ISDIR (st.st_mode));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Remove files of one directory and push tasks for its subdirectories. Runs in a worker thread.
+ */
+
+static void
+erase_tree_task (gpointer task, gpointer user_data)
+{
+    erase_tree_dir_t *dir = (erase_tree_dir_t *) task;
+    erase_tree_t *et = (erase_tree_t *) user_data;
+    DIR *dirp = NULL;
+    size_t count = 0;
+
+    if (g_atomic_int_get (&et->abort) == 0)
+    {
+        int fd;
+
+        // don't follow symlink which replaced directory meanwhile
+        fd = open (dir->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd != -1)
+        {
+            dirp = fdopendir (fd);
+            if (dirp == NULL)
+                close (fd);
+        }
+    }
+
+    // if directory cannot be read, its removal fails and the error is reported
+    if (dirp != NULL)
+    {
+        struct dirent *dp;
+
+        while ((dp = readdir (dirp)) != NULL && g_atomic_int_get (&et->abort) == 0)
+        {
+            char *path;
+
+            if (DIR_IS_DOT (dp->d_name) || DIR_IS_DOTDOT (dp->d_name))
+                continue;
+
+            if (erase_tree_is_dir (dirp, dp))
+            {
+                path = g_build_filename (dir->path, dp->d_name, (char *) NULL);
+                mc_workpool_push (et->pool, erase_tree_dir_new (dir, path));
+            }
+            else if (unlinkat (dirfd (dirp), dp->d_name, 0) == 0)
+            {
+                if (++count == ERASE_TREE_REPORT_FILES)
+                    erase_tree_report (et, dir->path, &count);
+            }
+            else
+            {
+                path = g_build_filename (dir->path, dp->d_name, (char *) NULL);
+                erase_tree_add_error (et, path, FALSE);
+            }
+        }
+
+        closedir (dirp);
+    }
+
+    erase_tree_report (et, dir->path, &count);
+    erase_tree_dir_release (et, dir);
+}
+#endif /* ERASE_TREE_LOCAL */
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start removal of directory tree.
+ *
+ * @param vpath directory
+ *
+ * @return newly allocated remover, or NULL if @vpath is not a local directory and should be
+ *         removed via VFS
+ */
+
+erase_tree_t *
+erase_tree_new (const vfs_path_t *vpath)
+{
+#ifdef ERASE_TREE_LOCAL
+    const vfs_path_element_t *element;
+    erase_tree_t *et;
+    int workers;
+
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return NULL;
+
+    element = vfs_path_get_by_index (vpath, 0);
+    if (element->path == NULL || !IS_PATH_SEP (element->path[0]))
+        return NULL;
+#ifdef HAVE_CHARSET
+    // file names must be recoded
+    if (element->encoding != NULL)
+        return NULL;
+#endif
+
+    et = g_new0 (erase_tree_t, 1);
+    et->errors = g_async_queue_new ();
+    g_mutex_init (&et->lock);
+
+    workers = MIN (mc_workpool_get_num_workers (), ERASE_TREE_MAX_WORKERS);
+    et->pool = mc_workpool_new (erase_tree_task, et, workers);
+
+    mc_workpool_push (et->pool, erase_tree_dir_new (NULL, g_strdup (element->path)));
+
+    return et;
+#else
+    (void) vpath;
+
+    return NULL;
+#endif
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for the end of removal and free remover. Not popped errors are lost.
+ *
+ * @param et remover
+ */
+
+void
+erase_tree_free (erase_tree_t *et)
+{
+    erase_tree_error_t *e;
+
+    if (et == NULL)
+        return;
+
+    mc_workpool_free (et->pool);
+
+    while ((e = (erase_tree_error_t *) g_async_queue_try_pop (et->errors)) != NULL)
+        erase_tree_error_free (e);
+    g_async_queue_unref (et->errors);
+
+    g_free (et->current);
+    g_mutex_clear (&et->lock);
+    g_free (et);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for the end of removal, but not longer than @timeout.
+ *
+ * @param et remover
+ * @param timeout max time to wait in microseconds
+ *
+ * @return TRUE if the whole tree is processed, FALSE if timeout is expired
+ */
+
+gboolean
+erase_tree_wait (erase_tree_t *et, gint64 timeout)
+{
+    return mc_workpool_wait_timeout (et->pool, timeout);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get progress of removal.
+ *
+ * @param et remover
+ * @param current directory being processed. Newly allocated string or NULL if nothing
+ *                was reported since the previous call
+ *
+ * @return number of files removed since the previous call
+ */
+
+size_t
+erase_tree_get_progress (erase_tree_t *et, char **current)
+{
+    size_t count;
+
+    g_mutex_lock (&et->lock);
+    count = et->count;
+    et->count = 0;
+    *current = et->current;
+    et->current = NULL;
+    g_mutex_unlock (&et->lock);
+
+    return count;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get entry which cannot be removed.
+ *
+ * @param et remover
+ *
+ * @return entry that should be freed with erase_tree_error_free(), or NULL if there are no
+ *         errors yet
+ */
+
+erase_tree_error_t *
+erase_tree_pop_error (erase_tree_t *et)
+{
+    return (erase_tree_error_t *) g_async_queue_try_pop (et->errors);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+erase_tree_error_free (erase_tree_error_t *e)
+{
+    g_free (e->path);
+    g_free (e);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop removal. Entries which are not processed yet are kept.
+ *
+ * @param et remover
+ */
+
+void
+erase_tree_abort (erase_tree_t *et)
+{
+    g_atomic_int_set (&et->abort, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,41 @@
+/** \file erasetree.h
+ *  \brief Header: fast removal of local directory trees
+ */
+
+#ifndef MC__ERASETREE_H
+#define MC__ERASETREE_H
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct erase_tree_t erase_tree_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/* file or directory which cannot be removed */
+typedef struct
+{
+    char *path;
+    gboolean is_dir;
+} erase_tree_error_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+erase_tree_t *erase_tree_new (const vfs_path_t *vpath);
+void erase_tree_free (erase_tree_t *et);
+
+gboolean erase_tree_wait (erase_tree_t *et, gint64 timeout);
+size_t erase_tree_get_progress (erase_tree_t *et, char **current);
+erase_tree_error_t *erase_tree_pop_error (erase_tree_t *et);
+void erase_tree_error_free (erase_tree_error_t *e);
+void erase_tree_abort (erase_tree_t *et);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -53,6 +53,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -81,6 +82,10 @@
 #include "tree.h"
 #include "filemanager.h"  // other_panel
 #include "layout.h"       // rotate_dash()
+#include "copypipe.h"
+#include "copysched.h"
+#include "dirsize.h"
+#include "erasetree.h"
 #include "ioblksize.h"    // io_blksize()
 
 #include "file.h"
@@ -103,6 +108,15 @@ const char *op_names[3] = {
 #define FILEOP_UPDATE_INTERVAL_US   (FILEOP_UPDATE_INTERVAL * G_USEC_PER_SEC)
 #define FILEOP_STALLING_INTERVAL_US (FILEOP_STALLING_INTERVAL * G_USEC_PER_SEC)
 
+/* limits of chunk size for copy of local files in kernel */
+#define FILEOP_KERNEL_CHUNK_MIN (1024 * 1024)
+#define FILEOP_KERNEL_CHUNK_MAX (64 * 1024 * 1024)
+/* chunk size is adjusted to copy one chunk in this time */
+#define FILEOP_KERNEL_CHUNK_US  (G_USEC_PER_SEC / 4)
+
+/* how often progress of removal of local directory tree is updated: 25 FPS */
+#define FILEOP_ERASE_UPDATE_US (G_USEC_PER_SEC / 25)
+
 /*** file scope type declarations ****************************************************************/
 
 /* This is a hard link cache */
@@ -137,6 +151,15 @@ typedef enum
     HARDLINK_ABORT         // Stop file operation after hardlink creation error
 } hardlink_status_t;
 
+/* Attributes of target directory which are set when all files below it are copied */
+typedef struct
+{
+    vfs_path_t *dst_vpath;
+    struct stat src_stat;
+    unsigned long attrs;
+    gboolean attrs_ok;
+} dir_attrs_t;
+
 /*
  * This array introduced to avoid translation problems. The former (op_names)
  * is assumed to be nouns, suitable in dialog box titles; this one should
@@ -188,6 +211,12 @@ static GQueue *erase_list = NULL;
  */
 static GSList *dest_dirs = NULL;
 
+/* the scheduler of concurrent copy of small files */
+static copy_sched_t *copy_sched = NULL;
+
+/* target directories whose attributes are set after copy_sched is finished */
+static GSList *copy_sched_dirs = NULL;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -635,6 +664,11 @@ do_compute_dir_size (const vfs_path_t *dirname_vpath, dirsize_status_msg_t *dsm,
     struct vfs_dirent *dirent;
     FileProgressStatus ret = FILE_CONT;
 
+    // local directories are walked in worker threads
+    if (dir_size_compute (dirname_vpath, stat_func == mc_stat, dsm, dir_count, ret_marked,
+                          ret_total, &ret))
+        return ret;
+
     (*dir_count)++;
 
     dir = mc_opendir (dirname_vpath);
@@ -1177,6 +1211,30 @@ calc_copy_file_progress (file_op_context_t *ctx, gint64 tv_current, off_t file_p
     }
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Ask user what to do if target file cannot be written.
+ *
+ * @return FILE_RETRY to write data again, FILE_IGNORE to skip data and continue copying,
+ *         other values to stop copying
+ */
+
+static FileProgressStatus
+copy_file_write_error (file_op_context_t *ctx, const char *dst_path)
+{
+    FileProgressStatus status;
+
+    if (ctx->ignore_all)
+        status = FILE_IGNORE_ALL;
+    else
+        status = file_error (ctx, TRUE, _ ("Cannot write target file\n%s"), dst_path);
+
+    if (status == FILE_IGNORE_ALL)
+        ctx->ignore_all = TRUE;
+
+    return status;
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static gboolean
@@ -1431,6 +1489,83 @@ try_erase_dir (file_op_context_t *ctx, const vfs_path_t *vpath)
 
 /* --------------------------------------------------------------------------------------------- */
 
+/**
+ * Remove local directory tree in worker threads. Entries which cannot be removed are
+ * reported like in recursive_erase().
+ *
+ * @return TRUE if @vpath is a local directory and was processed, FALSE otherwise
+ */
+
+static gboolean
+erase_tree_local (file_op_context_t *ctx, const vfs_path_t *vpath, FileProgressStatus *status)
+{
+    erase_tree_t *et;
+    gboolean finished = FALSE;
+
+    et = erase_tree_new (vpath);
+    if (et == NULL)
+        return FALSE;
+
+    *status = FILE_CONT;
+
+    while (!finished)
+    {
+        erase_tree_error_t *e;
+        char *current;
+
+        finished = erase_tree_wait (et, FILEOP_ERASE_UPDATE_US);
+
+        ctx->total_progress_count += erase_tree_get_progress (et, &current);
+
+        // try again and ask user if it fails
+        while (*status != FILE_ABORT && (e = erase_tree_pop_error (et)) != NULL)
+        {
+            vfs_path_t *tmp_vpath;
+
+            tmp_vpath = vfs_path_from_str (e->path);
+            if (e->is_dir)
+                *status = try_erase_dir (ctx, tmp_vpath);
+            else
+            {
+                *status = FILE_CONT;
+                try_remove_file (ctx, tmp_vpath, status);
+            }
+            vfs_path_free (tmp_vpath, TRUE);
+            erase_tree_error_free (e);
+        }
+
+        // check buttons on every tick: one huge directory is processed for a long time
+        if (*status != FILE_ABORT)
+        {
+            if (current != NULL)
+            {
+                vfs_path_t *tmp_vpath;
+
+                tmp_vpath = vfs_path_from_str (current);
+                file_progress_show_deleting (ctx, tmp_vpath, NULL);
+                vfs_path_free (tmp_vpath, TRUE);
+            }
+
+            file_progress_show_count (ctx);
+            if (file_progress_check_buttons (ctx) == FILE_ABORT)
+                *status = FILE_ABORT;
+
+            mc_refresh ();
+        }
+
+        g_free (current);
+
+        if (*status == FILE_ABORT)
+            erase_tree_abort (et);
+    }
+
+    erase_tree_free (et);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
 /**
   Recursive removal of files
   abort -> cancel stack
@@ -1444,6 +1579,9 @@ recursive_erase (file_op_context_t *ctx, const vfs_path_t *vpath)
     DIR *reading;
     FileProgressStatus return_status = FILE_CONT;
 
+    if (erase_tree_local (ctx, vpath, &return_status))
+        return return_status;
+
     reading = mc_opendir (vpath);
     if (reading == NULL)
         return FILE_RETRY;
@@ -2198,6 +2336,117 @@ operate_one_file (const WPanel *panel, file_op_context_t *ctx, const char *src,
     return value;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Move marked entries within one local filesystem by renaming them, without scanning of
+ * directories. Entries which cannot be moved so (target exists, cross-device move, errors)
+ * are kept marked to be moved in the usual way. Entries which don't match the source mask are
+ * unmarked and their indexes are appended to @skipped to be marked again after the operation.
+ *
+ * Progress dialog is created only if renaming takes a noticeable time. It is created without
+ * ETA because totals aren't known yet; panel_operate_init_totals() replaces it by the full one
+ * if some entries are left to be moved in the usual way.
+ *
+ * @return FILE_ABORT if operation was aborted, FILE_CONT otherwise
+ */
+
+static FileProgressStatus
+panel_move_rename (WPanel *panel, file_op_context_t *ctx, const char *dest,
+                   const vfs_path_t *dest_vpath, filegui_dialog_type_t dialog_type,
+                   GArray *skipped)
+{
+#if defined(HAVE_RENAMEAT2) && defined(RENAME_NOREPLACE)
+    // update with 25 FPS rate
+    const gint64 delay = G_USEC_PER_SEC / 25;
+    gint64 timestamp;
+    struct stat src_stat, dst_stat;
+    FileProgressStatus value = FILE_CONT;
+    int i;
+
+    if (vfs_path_elements_count (panel->cwd_vpath) != 1 || !vfs_file_is_local (panel->cwd_vpath)
+        || vfs_path_elements_count (dest_vpath) != 1 || !vfs_file_is_local (dest_vpath))
+        return FILE_CONT;
+
+    // all entries are renamed within one filesystem
+    if (mc_stat (panel->cwd_vpath, &src_stat) != 0 || mc_stat (dest_vpath, &dst_stat) != 0
+        || !S_ISDIR (dst_stat.st_mode) || src_stat.st_dev != dst_stat.st_dev)
+        return FILE_CONT;
+
+    ctx->total_count = panel->marked;
+    ctx->total_progress_count = 0;
+    timestamp = g_get_monotonic_time ();
+
+    for (i = 0; i < panel->dir.len && value != FILE_ABORT; i++)
+    {
+        const char *src;
+        vfs_path_t *src_vpath;
+        char *dst;
+
+        if (panel->dir.list[i].f.marked == 0)
+            continue;
+
+        src = panel->dir.list[i].fname->str;
+        if (g_path_is_absolute (src))
+            src_vpath = vfs_path_from_str (src);
+        else
+            src_vpath = vfs_path_append_new (panel->cwd_vpath, src, (char *) NULL);
+
+        dst = build_dest (ctx, vfs_path_as_str (src_vpath), dest, &value);
+        if (dst != NULL)
+        {
+            vfs_path_t *dst_vpath;
+
+            dst_vpath = vfs_path_from_str (dst);
+
+            /* existing target, cross-device move (e.g. of panelized file) and errors
+               are handled in the usual way */
+            if (vfs_path_elements_count (src_vpath) == 1 && vfs_file_is_local (src_vpath)
+                && vfs_path_elements_count (dst_vpath) == 1 && vfs_file_is_local (dst_vpath)
+                && renameat2 (AT_FDCWD, vfs_path_get_last_path_str (src_vpath), AT_FDCWD,
+                              vfs_path_get_last_path_str (dst_vpath), RENAME_NOREPLACE)
+                    == 0)
+            {
+                do_file_mark (panel, i, 0);
+                ctx->total_progress_count++;
+            }
+
+            vfs_path_free (dst_vpath, TRUE);
+            g_free (dst);
+        }
+        else if (value == FILE_SKIP)
+        {
+            // don't build destination name of this entry once more below
+            do_file_mark (panel, i, 0);
+            g_array_append_val (skipped, i);
+        }
+
+        if (value != FILE_ABORT && mc_time_elapsed (&timestamp, delay))
+        {
+            file_progress_ui_create (ctx, FALSE, dialog_type);
+            file_progress_show_source (ctx, src_vpath);
+            file_progress_show_count (ctx);
+            value = file_progress_check_buttons (ctx);
+            mc_refresh ();
+        }
+
+        vfs_path_free (src_vpath, TRUE);
+    }
+
+    ctx->total_progress_count = 0;
+
+    return (value == FILE_ABORT ? FILE_ABORT : FILE_CONT);
+#else
+    (void) panel;
+    (void) ctx;
+    (void) dest;
+    (void) dest_vpath;
+    (void) dialog_type;
+    (void) skipped;
+
+    return FILE_CONT;
+#endif
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 #ifdef ENABLE_BACKGROUND
@@ -2229,6 +2478,198 @@ attrs_ignore_error (const int e)
             || e == ELOOP || e == ENXIO);
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/* {{{ Concurrent copy routines */
+
+static void
+copy_dir_set_attrs (const file_op_context_t *ctx, const vfs_path_t *dst_vpath,
+                    const struct stat *src_stat, unsigned long attrs, gboolean attrs_ok)
+{
+    if (ctx->preserve)
+    {
+        mc_timesbuf_t times;
+
+        mc_chmod (dst_vpath, src_stat->st_mode & ctx->umask_kill);
+
+        if (attrs_ok)
+            mc_fsetflags (dst_vpath, attrs);
+
+        vfs_get_timesbuf_from_stat (src_stat, &times);
+        mc_utime (dst_vpath, &times);
+    }
+    else
+    {
+        mode_t mode;
+
+        mode = umask (-1);
+        umask (mode);
+        mode = 0100777 & ~mode;
+        mc_chmod (dst_vpath, mode & ctx->umask_kill);
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+free_dir_attrs (void *data)
+{
+    dir_attrs_t *da = (dir_attrs_t *) data;
+
+    vfs_path_free (da->dst_vpath, TRUE);
+    g_free (da);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Handle file copied by scheduler: update progress or, if copy failed, copy file again in the
+ * usual way to report the error to user.
+ */
+
+static FileProgressStatus
+copy_file_sched_done (file_op_context_t *ctx, copy_sched_file_t *f)
+{
+    vfs_path_t *src_vpath, *dst_vpath;
+    FileProgressStatus return_status = FILE_CONT;
+
+    src_vpath = vfs_path_from_str (f->src_path);
+    dst_vpath = vfs_path_from_str (f->dst_path);
+
+    if (f->error == 0 && copymove_persistent_ext2_attr)
+    {
+        unsigned long attrs;
+
+        if ((mc_fgetflags (src_vpath, &attrs) != 0 || mc_fsetflags (dst_vpath, attrs) != 0)
+            && !attrs_ignore_error (errno))
+            f->error = errno;
+    }
+
+    if (f->error == 0)
+    {
+        file_progress_show_source (ctx, src_vpath);
+        file_progress_show_target (ctx, dst_vpath);
+        progress_update_one (TRUE, ctx, f->size);
+        return_status = file_progress_check_buttons (ctx);
+    }
+    else
+    {
+        // remove incomplete file
+        if (f->created)
+            mc_unlink (dst_vpath);
+
+        if (!copy_sched_is_canceled (copy_sched))
+            return_status = copy_file_file (ctx, f->src_path, f->dst_path);
+    }
+
+    vfs_path_free (src_vpath, TRUE);
+    vfs_path_free (dst_vpath, TRUE);
+
+    return return_status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Handle files copied by scheduler.
+ *
+ * @param ctx file operation context
+ * @param wait_all if TRUE, wait for all scheduled files. Otherwise handle finished files only
+ *                 and wait only if too many files are scheduled
+ *
+ * @return FILE_ABORT if operation was aborted, FILE_CONT otherwise
+ */
+
+static FileProgressStatus
+copy_file_sched_collect (file_op_context_t *ctx, gboolean wait_all)
+{
+    FileProgressStatus return_status = FILE_CONT;
+    copy_sched_file_t *f;
+
+    while ((f = copy_sched_pop (copy_sched, wait_all || copy_sched_is_full (copy_sched))) != NULL)
+    {
+        if (copy_file_sched_done (ctx, f) == FILE_ABORT)
+            copy_sched_cancel (copy_sched);
+        copy_sched_file_free (f);
+    }
+
+    if (copy_sched_is_canceled (copy_sched))
+        return_status = FILE_ABORT;
+
+    return return_status;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Try to copy file concurrently with other ones. Files which may require user's interaction
+ * (overwrite, append, hardlinks) are not scheduled.
+ *
+ * @param ctx file operation context
+ * @param src_path source file
+ * @param dst_path target file
+ * @param src_stat stat of source file
+ * @param status status of operation if file is scheduled
+ *
+ * @return TRUE if file is scheduled, FALSE if it should be copied with copy_file_file()
+ */
+
+static gboolean
+copy_file_sched (file_op_context_t *ctx, const char *src_path, const char *dst_path,
+                 const struct stat *src_stat, FileProgressStatus *status)
+{
+    vfs_path_t *dst_vpath;
+    struct stat dst_stat;
+    gboolean dst_exists;
+
+    if (copy_sched == NULL || ctx->do_append || ctx->do_reget > 0
+        || (!ctx->follow_links && src_stat->st_nlink > 1))
+        return FALSE;
+
+    dst_vpath = vfs_path_from_str (dst_path);
+    dst_exists = mc_lstat (dst_vpath, &dst_stat) == 0 || errno != ENOENT;
+    vfs_path_free (dst_vpath, TRUE);
+
+    if (dst_exists || !copy_sched_push (copy_sched, src_path, dst_path, src_stat))
+        return FALSE;
+
+    *status = copy_file_sched_collect (ctx, FALSE);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Wait for all scheduled files, free scheduler and set attributes of target directories.
+ */
+
+static FileProgressStatus
+copy_file_sched_finish (file_op_context_t *ctx, FileProgressStatus return_status)
+{
+    GSList *dirs;
+
+    if (return_status == FILE_ABORT)
+        copy_sched_cancel (copy_sched);
+
+    if (copy_file_sched_collect (ctx, TRUE) == FILE_ABORT)
+        return_status = FILE_ABORT;
+
+    copy_sched_free (copy_sched);
+    copy_sched = NULL;
+
+    // directories were prepended in post-order, restore it to handle children before parents
+    copy_sched_dirs = g_slist_reverse (copy_sched_dirs);
+    for (dirs = copy_sched_dirs; dirs != NULL; dirs = g_slist_next (dirs))
+    {
+        const dir_attrs_t *da = (const dir_attrs_t *) dirs->data;
+
+        copy_dir_set_attrs (ctx, da->dst_vpath, &da->src_stat, da->attrs, da->attrs_ok);
+    }
+
+    g_slist_free_full (copy_sched_dirs, free_dir_attrs);
+    copy_sched_dirs = NULL;
+
+    return return_status;
+}
+
+/* }}} */
+
 /* --------------------------------------------------------------------------------------------- */
 /*** public functions ****************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -2294,6 +2735,7 @@ copy_file_file (file_op_context_t *ctx, const char *src_path, const char *dst_pa
     int open_flags;
     vfs_path_t *src_vpath = NULL, *dst_vpath = NULL;
     char *buf = NULL;
+    copy_pipe_t *cpipe = NULL;
 
     /* Keep the non-default value applied in chain of calls:
        move_file_file() -> file_progress_real_query_replace()
@@ -2706,73 +3148,160 @@ copy_file_file (file_op_context_t *ctx, const char *src_path, const char *dst_pa
         gboolean is_first_time = TRUE;
 
         const size_t bufsize = io_blksize (dst_stat);
-        buf = g_malloc (bufsize);
+        // try to copy local files in kernel first
+        gboolean kernel_copy = TRUE;
+        size_t kernel_chunk = FILEOP_KERNEL_CHUNK_MIN;
 
         while (TRUE)
         {
             ssize_t n_read = -1;
+            char *t = NULL;
 
-            // src_read
-            if (mc_ctl (src_desc, VFS_CTL_IS_NOTREADY, 0) == 0)
-                while ((n_read = mc_read (src_desc, buf, bufsize)) < 0 && !ctx->ignore_all)
+            if (kernel_copy)
+            {
+                const gint64 tv_start = g_get_monotonic_time ();
+
+                n_read = vfs_copy_file_chunk (dest_desc, src_desc, kernel_chunk);
+
+                /* On any error, copy the rest of file via buffer: real errors will be reported
+                   there. 0 at start may mean that file size is unknown (procfs, sysfs) */
+                if (n_read < 0 || (n_read == 0 && file_part == 0))
+                {
+                    kernel_copy = FALSE;
+                    n_read = -1;
+                }
+                else
+                {
+                    // keep UI responsive on slow devices
+                    const gint64 usecs = g_get_monotonic_time () - tv_start;
+
+                    if (usecs < FILEOP_KERNEL_CHUNK_US / 2
+                        && kernel_chunk < FILEOP_KERNEL_CHUNK_MAX)
+                        kernel_chunk *= 2;
+                    else if (usecs > FILEOP_KERNEL_CHUNK_US
+                             && kernel_chunk > FILEOP_KERNEL_CHUNK_MIN)
+                        kernel_chunk /= 2;
+                }
+            }
+
+            if (!kernel_copy && buf == NULL && cpipe == NULL)
+            {
+                // overlap reading and writing if files are on different devices
+                cpipe = copy_pipe_new (src_desc, dest_desc, bufsize);
+                if (cpipe == NULL)
+                    buf = g_malloc (bufsize);
+            }
+
+            if (cpipe != NULL && copy_pipe_get_side (cpipe) == COPY_PIPE_READER)
+            {
+                // src_read in the pipe thread
+                while ((n_read = copy_pipe_read (cpipe, &t)) < 0 && !ctx->ignore_all)
                 {
                     return_status =
                         file_error (ctx, TRUE, _ ("Cannot read source file\n%s"), src_path);
                     if (return_status == FILE_RETRY)
+                    {
+                        copy_pipe_retry (cpipe);
                         continue;
+                    }
                     if (return_status == FILE_IGNORE_ALL)
                         ctx->ignore_all = TRUE;
                     goto ret;
                 }
 
+                if (n_read < 0)
+                    copy_pipe_retry (cpipe);
+            }
+            else if (!kernel_copy)
+            {
+                t = buf;
+
+                // write of previous data in the pipe thread may fail
+                while (cpipe != NULL && (t = copy_pipe_get_buffer (cpipe)) == NULL)
+                {
+                    const gboolean write_errno_nospace = (errno == ENOSPC);
+
+                    return_status = copy_file_write_error (ctx, dst_path);
+                    if (return_status == FILE_RETRY)
+                        copy_pipe_retry (cpipe);
+                    else if (return_status == FILE_IGNORE && !write_errno_nospace)
+                        copy_pipe_skip (cpipe);
+                    else
+                        goto ret;
+                }
+
+                // src_read
+                if (mc_ctl (src_desc, VFS_CTL_IS_NOTREADY, 0) == 0)
+                    while ((n_read = mc_read (src_desc, t, bufsize)) < 0 && !ctx->ignore_all)
+                    {
+                        return_status =
+                            file_error (ctx, TRUE, _ ("Cannot read source file\n%s"), src_path);
+                        if (return_status == FILE_RETRY)
+                            continue;
+                        if (return_status == FILE_IGNORE_ALL)
+                            ctx->ignore_all = TRUE;
+                        goto ret;
+                    }
+            }
+
             if (n_read == 0)
+            {
+                // wait until the pipe thread writes all data
+                while (cpipe != NULL && copy_pipe_get_side (cpipe) == COPY_PIPE_WRITER
+                       && copy_pipe_flush (cpipe) != 0)
+                {
+                    const gboolean write_errno_nospace = (errno == ENOSPC);
+
+                    return_status = copy_file_write_error (ctx, dst_path);
+                    if (return_status == FILE_RETRY)
+                        copy_pipe_retry (cpipe);
+                    else if (return_status == FILE_IGNORE && !write_errno_nospace)
+                        copy_pipe_skip (cpipe);
+                    else
+                        goto ret;
+                }
+
                 break;
+            }
 
             const gint64 tv_current = g_get_monotonic_time ();
 
             if (n_read > 0)
             {
-                ssize_t n_written;
-                char *t = buf;
-
                 file_part += n_read;
 
                 tv_last_input = tv_current;
 
-                // dst_write
-                while ((n_written = mc_write (dest_desc, t, (size_t) n_read)) < n_read)
+                if (cpipe != NULL && copy_pipe_get_side (cpipe) == COPY_PIPE_WRITER)
+                    // dst_write in the pipe thread
+                    copy_pipe_write (cpipe, (size_t) n_read);
+                else if (!kernel_copy)
                 {
-                    gboolean write_errno_nospace;
+                    ssize_t n_written;
 
-                    if (n_written > 0)
+                    // dst_write
+                    while ((n_written = mc_write (dest_desc, t, (size_t) n_read)) < n_read)
                     {
-                        n_read -= n_written;
-                        t += n_written;
-                        continue;
-                    }
+                        gboolean write_errno_nospace;
 
-                    write_errno_nospace = (n_written < 0 && errno == ENOSPC);
+                        if (n_written > 0)
+                        {
+                            n_read -= n_written;
+                            t += n_written;
+                            continue;
+                        }
 
-                    if (ctx->ignore_all)
-                        return_status = FILE_IGNORE_ALL;
-                    else
-                        return_status =
-                            file_error (ctx, TRUE, _ ("Cannot write target file\n%s"), dst_path);
+                        write_errno_nospace = (n_written < 0 && errno == ENOSPC);
 
-                    if (return_status == FILE_IGNORE)
-                    {
-                        if (write_errno_nospace)
+                        return_status = copy_file_write_error (ctx, dst_path);
+                        if (return_status == FILE_IGNORE && !write_errno_nospace)
+                            break;
+                        if (return_status != FILE_RETRY)
                             goto ret;
-                        break;
                     }
-                    if (return_status == FILE_IGNORE_ALL)
-                    {
-                        ctx->ignore_all = TRUE;
-                        if (write_errno_nospace)
-                            goto ret;
-                    }
-                    if (return_status != FILE_RETRY)
-                        goto ret;
+
+                    if (cpipe != NULL)
+                        copy_pipe_release (cpipe);
                 }
             }
 
@@ -2847,6 +3376,7 @@ copy_file_file (file_op_context_t *ctx, const char *src_path, const char *dst_pa
     }
 
 ret:
+    copy_pipe_free (cpipe);
     g_free (buf);
 
     rotate_dash (FALSE);
@@ -3009,10 +3539,18 @@ copy_dir_dir (file_op_context_t *ctx, const char *s, const char *d, gboolean top
     link_t *lp;
     vfs_path_t *src_vpath, *dst_vpath;
     gboolean do_mkdir = TRUE;
+    gboolean sched_owner = FALSE;
 
     src_vpath = vfs_path_from_str (s);
     dst_vpath = vfs_path_from_str (d);
 
+    // copy small files of the tree concurrently; files of moved tree are erased one by one
+    if (copy_sched == NULL && !do_delete)
+    {
+        copy_sched = copy_sched_new (ctx->preserve, ctx->preserve_uidgid, ctx->umask_kill);
+        sched_owner = TRUE;
+    }
+
     // First get the mode of the source dir
 
 retry_src_stat:
@@ -3247,7 +3785,8 @@ retry_dst_stat:
             char *dest_file;
 
             dest_file = mc_build_filename (d, x_basename (path), (char *) NULL);
-            return_status = copy_file_file (ctx, path, dest_file);
+            if (!copy_file_sched (ctx, path, dest_file, &dst_stat, &return_status))
+                return_status = copy_file_file (ctx, path, dest_file);
             g_free (dest_file);
         }
 
@@ -3275,30 +3814,27 @@ retry_dst_stat:
     }
     mc_closedir (reading);
 
-    if (ctx->preserve)
-    {
-        mc_timesbuf_t times;
-
-        mc_chmod (dst_vpath, src_stat.st_mode & ctx->umask_kill);
-
-        if (attrs_ok)
-            mc_fsetflags (dst_vpath, attrs);
-
-        vfs_get_timesbuf_from_stat (&src_stat, &times);
-        mc_utime (dst_vpath, &times);
-    }
+    if (copy_sched == NULL)
+        copy_dir_set_attrs (ctx, dst_vpath, &src_stat, attrs, attrs_ok);
     else
     {
-        src_stat.st_mode = umask (-1);
-        umask (src_stat.st_mode);
-        src_stat.st_mode = 0100777 & ~src_stat.st_mode;
-        mc_chmod (dst_vpath, src_stat.st_mode & ctx->umask_kill);
+        dir_attrs_t *da;
+
+        // files of directory can be not copied yet
+        da = g_new (dir_attrs_t, 1);
+        da->dst_vpath = vfs_path_clone (dst_vpath);
+        da->src_stat = src_stat;
+        da->attrs = attrs;
+        da->attrs_ok = attrs_ok;
+        copy_sched_dirs = g_slist_prepend (copy_sched_dirs, da);
     }
 
 ret:
     free_link (parent_dirs->data);
     g_slist_free_1 (parent_dirs);
 ret_fast:
+    if (sched_owner)
+        return_status = copy_file_sched_finish (ctx, return_status);
     vfs_path_free (src_vpath, TRUE);
     vfs_path_free (dst_vpath, TRUE);
     return return_status;
@@ -3489,6 +4025,7 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
     FileProgressStatus value;
     file_op_context_t *ctx;
     filegui_dialog_type_t dialog_type = FILEGUI_DIALOG_ONE_ITEM;
+    GArray *skipped = NULL;
 
     gboolean do_bg = FALSE;  // do background operation?
 
@@ -3627,13 +4164,20 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
                 goto clean_up;
         }
 
-        /* TODO: the good way is required to skip directories scanning in case of rename/move
-         * of several directories. Since reqular expression can be used for destination,
-         * some directory movements can be a cross-filesystem and directory scanning is useful
-         * for those directories only. */
+        /* Entries moved within one filesystem don't need directory scanning. Since regular
+         * expression can be used for destination, some movements can be a cross-filesystem
+         * ones: these entries are left marked and scanned below. */
+        if (operation == OP_MOVE)
+        {
+            skipped = g_array_new (FALSE, FALSE, sizeof (int));
+            value = panel_move_rename (panel, ctx, dest, dest_vpath, dialog_type, skipped);
+        }
+        else
+            value = FILE_CONT;
 
-        value =
-            panel_operate_init_totals (panel, NULL, NULL, ctx, file_op_compute_totals, dialog_type);
+        if (value == FILE_CONT && panel->marked != 0)
+            value = panel_operate_init_totals (panel, NULL, NULL, ctx, file_op_compute_totals,
+                                               dialog_type);
         if (value == FILE_CONT)
             // Loop for every file, perform the actual copy operation
             for (i = 0; i < panel->dir.len; i++)
@@ -3659,6 +4203,14 @@ panel_operate (void *source_panel, FileOperation operation, gboolean force_singl
 
 clean_up:
     // Clean up
+    if (skipped != NULL)
+    {
+        // entries skipped by source mask are kept marked
+        for (i = 0; i < (int) skipped->len; i++)
+            do_file_mark (panel, g_array_index (skipped, int, i), 1);
+        g_array_free (skipped, TRUE);
+    }
+
     if (save_cwd != NULL)
     {
         mc_setctl (save_cwd, VFS_SETCTL_STALE_DATA, NULL);
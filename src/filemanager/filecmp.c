@@ -0,0 +1,593 @@
+/*
+   Compare contents of files.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file filecmp.c
+ *  \brief Source: compare contents of files
+ *
+ *  Pairs of local files are compared in worker threads, several pairs at a time, using
+ *  large blocks. Other files are compared via VFS in the main thread meanwhile. The main
+ *  thread shows progress and allows to interrupt the compare.
+ *
+ *  If compare_digest_cache option is set, the digest of file is kept after the full compare.
+ *  The digest is identified by device, inode, size and times of file, so unchanged files are
+ *  not read again on the next compare.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/util.h"
+#include "lib/widget.h"
+#include "lib/workpool.h"
+
+#include "src/setup.h"  // compare_digest_cache
+
+#include "filecmp.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* size of block to read files */
+#define FILE_CMP_BLOCK        (1024 * 1024)
+
+/* how often progress is updated, in microseconds */
+#define FILE_CMP_UPDATE_DELAY 100000
+
+#define FILE_CMP_DIGEST_TYPE  G_CHECKSUM_SHA256
+#define FILE_CMP_DIGEST_LEN   32
+
+/* max number of digests in the cache */
+#define FILE_CMP_CACHE_MAX    65536
+
+/*** file scope type declarations ****************************************************************/
+
+typedef ssize_t (*file_cmp_read_fn) (int fd, void *buf, size_t count);
+
+typedef struct
+{
+    simple_status_msg_t status_msg;  // base class
+
+    gboolean first;
+    gboolean use_cache;  // value of compare_digest_cache at start of compare
+    guint64 total;       // total size of files
+    guint64 done;        // size of compared data
+    GMutex lock;         // protects 'done'
+    gint abort;          // compare was interrupted, accessed atomically
+} file_cmp_ctx_t;
+
+typedef struct
+{
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    time_t ctime;
+} file_cmp_key_t;
+
+typedef struct
+{
+    file_cmp_key_t key;  // must be first
+    guint8 digest[FILE_CMP_DIGEST_LEN];
+} file_cmp_digest_t;
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* digests of files, accessed from worker threads */
+static GHashTable *digest_cache = NULL;
+static GMutex digest_cache_lock;
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static guint
+file_cmp_key_hash (gconstpointer v)
+{
+    const file_cmp_key_t *k = (const file_cmp_key_t *) v;
+    guint64 h;
+
+    h = (guint64) k->ino * 31 + (guint64) k->dev;
+    h = h * 31 + (guint64) k->size;
+    h = h * 31 + (guint64) k->mtime;
+
+    return (guint) (h ^ (h >> 32));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+file_cmp_key_equal (gconstpointer v1, gconstpointer v2)
+{
+    const file_cmp_key_t *k1 = (const file_cmp_key_t *) v1;
+    const file_cmp_key_t *k2 = (const file_cmp_key_t *) v2;
+
+    return k1->dev == k2->dev && k1->ino == k2->ino && k1->size == k2->size
+        && k1->mtime == k2->mtime && k1->ctime == k2->ctime;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+file_cmp_make_key (file_cmp_key_t *key, const struct stat *st)
+{
+    memset (key, 0, sizeof (*key));
+    key->dev = st->st_dev;
+    key->ino = st->st_ino;
+    key->size = st->st_size;
+    key->mtime = st->st_mtime;
+    key->ctime = st->st_ctime;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+file_cmp_cache_lookup (const file_cmp_key_t *key, guint8 *digest)
+{
+    const file_cmp_digest_t *d = NULL;
+
+    g_mutex_lock (&digest_cache_lock);
+    if (digest_cache != NULL)
+        d = (const file_cmp_digest_t *) g_hash_table_lookup (digest_cache, key);
+    if (d != NULL)
+        memcpy (digest, d->digest, FILE_CMP_DIGEST_LEN);
+    g_mutex_unlock (&digest_cache_lock);
+
+    return (d != NULL);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+file_cmp_cache_add (const file_cmp_key_t *key, const guint8 *digest)
+{
+    file_cmp_digest_t *d;
+
+    d = g_new (file_cmp_digest_t, 1);
+    d->key = *key;
+    memcpy (d->digest, digest, FILE_CMP_DIGEST_LEN);
+
+    g_mutex_lock (&digest_cache_lock);
+    if (digest_cache == NULL)
+        digest_cache = g_hash_table_new_full (file_cmp_key_hash, file_cmp_key_equal, g_free, NULL);
+    else if (g_hash_table_size (digest_cache) >= FILE_CMP_CACHE_MAX)
+        g_hash_table_remove_all (digest_cache);
+    g_hash_table_replace (digest_cache, d, d);
+    g_mutex_unlock (&digest_cache_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+file_cmp_add_progress (file_cmp_ctx_t *ctx, guint64 n)
+{
+    g_mutex_lock (&ctx->lock);
+    ctx->done += n;
+    g_mutex_unlock (&ctx->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+file_cmp_status_update_cb (status_msg_t *sm)
+{
+    simple_status_msg_t *ssm = SIMPLE_STATUS_MSG (sm);
+    file_cmp_ctx_t *ctx = (file_cmp_ctx_t *) sm;
+    Widget *wd = WIDGET (sm->dlg);
+    guint64 done;
+    int percent = 0;
+
+    g_mutex_lock (&ctx->lock);
+    done = ctx->done;
+    g_mutex_unlock (&ctx->lock);
+
+    if (ctx->total != 0)
+        percent = (int) MIN (done * 100 / ctx->total, 100);
+
+    label_set_textv (ssm->label, _ ("Comparing: %3d%%"), percent);
+
+    if (ctx->first)
+    {
+        Widget *lw = WIDGET (ssm->label);
+        WRect r;
+
+        r = wd->rect;
+        r.cols = MAX (r.cols, lw->rect.cols + 6);
+        widget_set_size_rect (wd, &r);
+        r = lw->rect;
+        r.x = wd->rect.x + (wd->rect.cols - r.cols) / 2;
+        widget_set_size_rect (lw, &r);
+        ctx->first = FALSE;
+    }
+
+    return status_msg_common_update (sm);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+file_cmp_update_status (file_cmp_ctx_t *ctx)
+{
+    status_msg_t *sm = STATUS_MSG (ctx);
+
+    if (sm->update (sm) == B_CANCEL)
+        g_atomic_int_set (&ctx->abort, 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read up to @count bytes. Less bytes are read only at the end of file.
+ *
+ * @return number of read bytes or -1 on error
+ */
+
+static ssize_t
+file_cmp_read (int fd, char *buf, size_t count, file_cmp_read_fn read_fn)
+{
+    size_t total = 0;
+
+    while (total < count)
+    {
+        ssize_t n;
+
+        n = read_fn (fd, buf + total, count - total);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+
+        total += (size_t) n;
+    }
+
+    return (ssize_t) total;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare contents of opened files.
+ *
+ * @param ctx compare context
+ * @param fd1 first file
+ * @param fd2 second file
+ * @param read_fn function to read files
+ * @param checksum if not NULL, checksum is updated by file contents
+ * @param ui TRUE if called from the main thread: update progress and check for interrupt
+ *
+ * @return TRUE if files are equal
+ */
+
+static gboolean
+file_cmp_fds (file_cmp_ctx_t *ctx, int fd1, int fd2, file_cmp_read_fn read_fn,
+              GChecksum *checksum, gboolean ui)
+{
+    char *buf1, *buf2;
+    gboolean equal = FALSE;
+
+    buf1 = g_try_malloc (2 * FILE_CMP_BLOCK);
+    if (buf1 == NULL)
+        return FALSE;
+
+    buf2 = buf1 + FILE_CMP_BLOCK;
+
+    while (g_atomic_int_get (&ctx->abort) == 0)
+    {
+        ssize_t n1, n2;
+
+        n1 = file_cmp_read (fd1, buf1, FILE_CMP_BLOCK, read_fn);
+        n2 = file_cmp_read (fd2, buf2, FILE_CMP_BLOCK, read_fn);
+
+        if (n1 < 0 || n1 != n2 || memcmp (buf1, buf2, (size_t) n1) != 0)
+            break;
+
+        if (checksum != NULL)
+            g_checksum_update (checksum, (const guchar *) buf1, n1);
+
+        file_cmp_add_progress (ctx, (guint64) n1);
+
+        if (n1 < FILE_CMP_BLOCK)
+        {
+            // end of both files
+            equal = TRUE;
+            break;
+        }
+
+        if (ui)
+            file_cmp_update_status (ctx);
+    }
+
+    g_free (buf1);
+
+    return equal;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static gboolean
+file_cmp_local_fds (file_cmp_ctx_t *ctx, int fd1, int fd2)
+{
+    struct stat st1, st2;
+    file_cmp_key_t key1, key2;
+    GChecksum *checksum = NULL;
+    gboolean equal;
+
+    if (fstat (fd1, &st1) != 0 || fstat (fd2, &st2) != 0 || st1.st_size != st2.st_size)
+        return FALSE;
+
+    if (st1.st_dev == st2.st_dev && st1.st_ino == st2.st_ino)
+    {
+        // the same file
+        file_cmp_add_progress (ctx, (guint64) st1.st_size);
+        return TRUE;
+    }
+
+    if (ctx->use_cache)
+    {
+        guint8 digest1[FILE_CMP_DIGEST_LEN], digest2[FILE_CMP_DIGEST_LEN];
+
+        file_cmp_make_key (&key1, &st1);
+        file_cmp_make_key (&key2, &st2);
+
+        if (file_cmp_cache_lookup (&key1, digest1) && file_cmp_cache_lookup (&key2, digest2))
+        {
+            file_cmp_add_progress (ctx, (guint64) st1.st_size);
+            return (memcmp (digest1, digest2, FILE_CMP_DIGEST_LEN) == 0);
+        }
+
+        checksum = g_checksum_new (FILE_CMP_DIGEST_TYPE);
+    }
+
+#ifdef HAVE_POSIX_FADVISE
+    (void) posix_fadvise (fd1, 0, 0, POSIX_FADV_SEQUENTIAL);
+    (void) posix_fadvise (fd2, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    equal = file_cmp_fds (ctx, fd1, fd2, read, checksum, FALSE);
+
+    if (checksum != NULL)
+    {
+        if (equal)
+        {
+            guint8 digest[FILE_CMP_DIGEST_LEN];
+            gsize len = sizeof (digest);
+
+            // contents are equal, so are digests
+            g_checksum_get_digest (checksum, digest, &len);
+            file_cmp_cache_add (&key1, digest);
+            file_cmp_cache_add (&key2, digest);
+        }
+
+        g_checksum_free (checksum);
+    }
+
+    return equal;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare pair of local files. Runs in a worker thread.
+ */
+
+static void
+file_cmp_local_task (gpointer task, gpointer user_data)
+{
+    file_cmp_pair_t *pair = (file_cmp_pair_t *) task;
+    file_cmp_ctx_t *ctx = (file_cmp_ctx_t *) user_data;
+    gboolean equal = FALSE;
+    int fd1;
+
+    if (g_atomic_int_get (&ctx->abort) != 0)
+        return;
+
+    fd1 = open (pair->path1, O_RDONLY | O_CLOEXEC);
+    if (fd1 != -1)
+    {
+        int fd2;
+
+        fd2 = open (pair->path2, O_RDONLY | O_CLOEXEC);
+        if (fd2 != -1)
+        {
+            equal = file_cmp_local_fds (ctx, fd1, fd2);
+            close (fd2);
+        }
+        close (fd1);
+    }
+
+    // results of interrupted compare are dropped
+    pair->differ = !equal && g_atomic_int_get (&ctx->abort) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare pair of files via VFS in the main thread.
+ */
+
+static void
+file_cmp_vfs (file_cmp_ctx_t *ctx, file_cmp_pair_t *pair)
+{
+    gboolean equal = FALSE;
+    int fd1;
+
+    fd1 = mc_open (pair->vpath1, O_RDONLY);
+    if (fd1 != -1)
+    {
+        int fd2;
+
+        fd2 = mc_open (pair->vpath2, O_RDONLY);
+        if (fd2 != -1)
+        {
+            equal = file_cmp_fds (ctx, fd1, fd2, mc_read, NULL, TRUE);
+            mc_close (fd2);
+        }
+        mc_close (fd1);
+    }
+
+    pair->differ = !equal && g_atomic_int_get (&ctx->abort) == 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static const char *
+file_cmp_get_local_path (const vfs_path_t *vpath)
+{
+    if (vfs_path_elements_count (vpath) != 1 || !vfs_file_is_local (vpath))
+        return NULL;
+
+    return vfs_path_get_by_index (vpath, 0)->path;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create pair of files to compare.
+ *
+ * @param vpath1 first file. The pair takes ownership of it
+ * @param vpath2 second file. The pair takes ownership of it
+ * @param size size of files
+ * @param index caller's data
+ *
+ * @return newly allocated pair
+ */
+
+file_cmp_pair_t *
+file_cmp_pair_new (vfs_path_t *vpath1, vfs_path_t *vpath2, off_t size, int index)
+{
+    file_cmp_pair_t *pair;
+
+    pair = g_new0 (file_cmp_pair_t, 1);
+    pair->vpath1 = vpath1;
+    pair->vpath2 = vpath2;
+    pair->path1 = file_cmp_get_local_path (pair->vpath1);
+    pair->path2 = file_cmp_get_local_path (pair->vpath2);
+    pair->size = size;
+    pair->index = index;
+
+    return pair;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+file_cmp_pair_free (gpointer pair)
+{
+    file_cmp_pair_t *p = (file_cmp_pair_t *) pair;
+
+    vfs_path_free (p->vpath1, TRUE);
+    vfs_path_free (p->vpath2, TRUE);
+    g_free (p);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Compare contents of files. The 'differ' member of each pair is set to the result.
+ * Files that cannot be read are different.
+ *
+ * @param pairs array of file_cmp_pair_t
+ *
+ * @return FALSE if compare was interrupted by user, TRUE otherwise
+ */
+
+gboolean
+file_cmp_run (GPtrArray *pairs)
+{
+    file_cmp_ctx_t ctx;
+    mc_workpool_t *pool;
+    gboolean aborted;
+    guint i;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.first = TRUE;
+    ctx.use_cache = compare_digest_cache;
+    g_mutex_init (&ctx.lock);
+
+    for (i = 0; i < pairs->len; i++)
+        ctx.total += (guint64) ((file_cmp_pair_t *) g_ptr_array_index (pairs, i))->size;
+
+    status_msg_init (STATUS_MSG (&ctx), _ ("Compare files"), 1.0, simple_status_msg_init_cb,
+                     file_cmp_status_update_cb, NULL);
+
+    // local files are compared in worker threads...
+    pool = mc_workpool_new (file_cmp_local_task, &ctx, 0);
+
+    for (i = 0; i < pairs->len; i++)
+    {
+        file_cmp_pair_t *pair = (file_cmp_pair_t *) g_ptr_array_index (pairs, i);
+
+        if (pair->path1 != NULL && pair->path2 != NULL)
+            mc_workpool_push (pool, pair);
+    }
+
+    // ...and other ones via VFS in this thread meanwhile
+    for (i = 0; i < pairs->len && g_atomic_int_get (&ctx.abort) == 0; i++)
+    {
+        file_cmp_pair_t *pair = (file_cmp_pair_t *) g_ptr_array_index (pairs, i);
+
+        if (pair->path1 == NULL || pair->path2 == NULL)
+            file_cmp_vfs (&ctx, pair);
+    }
+
+    while (!mc_workpool_wait_timeout (pool, FILE_CMP_UPDATE_DELAY))
+        file_cmp_update_status (&ctx);
+
+    mc_workpool_free (pool);
+
+    aborted = (g_atomic_int_get (&ctx.abort) != 0);
+
+    status_msg_deinit (STATUS_MSG (&ctx));
+    g_mutex_clear (&ctx.lock);
+
+    return !aborted;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Free cache of digests.
+ */
+
+void
+file_cmp_done (void)
+{
+    g_mutex_lock (&digest_cache_lock);
+    if (digest_cache != NULL)
+    {
+        g_hash_table_destroy (digest_cache);
+        digest_cache = NULL;
+    }
+    g_mutex_unlock (&digest_cache_lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
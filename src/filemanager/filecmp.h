@@ -0,0 +1,41 @@
+/** \file filecmp.h
+ *  \brief Header: compare contents of files
+ */
+
+#ifndef MC__FILECMP_H
+#define MC__FILECMP_H
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"  // vfs_path_t
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+typedef struct
+{
+    vfs_path_t *vpath1;
+    vfs_path_t *vpath2;
+    const char *path1;  // path of local file or NULL
+    const char *path2;  // path of local file or NULL
+    off_t size;
+    int index;        // caller's data
+    gboolean differ;  // result: files are different
+} file_cmp_pair_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+file_cmp_pair_t *file_cmp_pair_new (vfs_path_t *vpath1, vfs_path_t *vpath2, off_t size,
+                                    int index);
+void file_cmp_pair_free (gpointer pair);
+
+gboolean file_cmp_run (GPtrArray *pairs);
+void file_cmp_done (void);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -45,6 +45,7 @@
 
 #include "lib/global.h"
 #include "lib/fileloc.h"  // MC_HINT, MC_FILEPOS_FILE
+#include "lib/idcache.h"
 #include "lib/tty/tty.h"
 #include "lib/tty/key.h"  // KEY_M_* masks
 #include "lib/skin.h"
@@ -72,6 +73,9 @@
 #include "panelize.h"
 #include "command.h"  // cmdline
 #include "dir.h"      // dir_list_clean()
+#include "dirwatch.h"
+#include "dirsize.h"  // dir_size_done()
+#include "filecmp.h"  // file_cmp_done()
 
 #ifdef USE_INTERNAL_EDIT
 #include "src/editor/edit.h"
@@ -131,6 +135,9 @@ static const label_colors_t prompt_colors = {
 
 static menu_t *left_menu, *right_menu;
 
+/* one-time actions on the first idle event are done */
+static gboolean boot_done = FALSE;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -863,6 +870,9 @@ done_mc (void)
 
     save_setup (auto_save_setup, panels_options.auto_save_setup);
 
+    file_cmp_done ();
+    dir_size_done ();
+
     vfs_stamp_path (vfs_get_raw_current_dir ());
 }
 
@@ -1085,6 +1095,28 @@ update_dirty_panels (void)
         widget_draw (WIDGET (other_panel));
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Redraw panels when names of owners requested by them are resolved in background.
+ */
+
+static void
+update_panels_owners (void)
+{
+    // if another dialog is on top, panels are redrawn when it is closed
+    if (top_dlg == NULL || DIALOG (top_dlg->data) != filemanager)
+        return;
+
+    if (get_current_type () == view_listing)
+        current_panel->dirty = TRUE;
+    if (get_other_type () == view_listing)
+        other_panel->dirty = TRUE;
+
+    update_dirty_panels ();
+    widget_update_cursor (WIDGET (filemanager));
+    mc_refresh ();
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 static void
@@ -1477,16 +1509,24 @@ midnight_callback (Widget *w, Widget *sender, widget_msg_t msg, int parm, void *
         return MSG_HANDLED;
 
     case MSG_IDLE:
-        // We only need the first idle event to show user menu after start
         widget_idle (w, FALSE);
 
-        if (boot_current_is_left)
-            widget_select (get_panel_widget (0));
-        else
-            widget_select (get_panel_widget (1));
+        // apply changes of directories caught while another dialog was on top
+        dir_watch_flush ();
 
-        if (auto_menu)
-            midnight_execute_cmd (NULL, CK_UserMenu);
+        // We only need the first idle event to show user menu after start
+        if (!boot_done)
+        {
+            boot_done = TRUE;
+
+            if (boot_current_is_left)
+                widget_select (get_panel_widget (0));
+            else
+                widget_select (get_panel_widget (1));
+
+            if (auto_menu)
+                midnight_execute_cmd (NULL, CK_UserMenu);
+        }
         return MSG_HANDLED;
 
     case MSG_KEY:
@@ -1787,10 +1827,12 @@ do_nc (void)
 
         setup_mc ();
         mc_filehighlight = mc_fhl_new (TRUE);
+        mc_idcache_set_notify (update_panels_owners);
 
         create_file_manager ();
         (void) dlg_run (filemanager);
 
+        mc_idcache_done ();
         mc_fhl_free (&mc_filehighlight);
 
         ret = TRUE;
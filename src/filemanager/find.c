@@ -56,6 +56,7 @@
 #include "cmd.h"  // find_cmd(), view_file_at_line()
 #include "boxes.h"
 #include "panelize.h"
+#include "findcontent.h"
 
 /*** global variables ****************************************************************************/
 
@@ -206,6 +207,8 @@ static char *in_start_dir = INPUT_LAST_TEXT;
 
 static mc_search_t *search_file_handle = NULL;
 static mc_search_t *search_content_handle = NULL;
+/* concurrent search in local files */
+static find_content_t *search_content_engine = NULL;
 
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
@@ -1128,6 +1131,53 @@ search_content (WDialog *h, const char *directory, const char *filename)
     return ret_val;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Add files scanned by search engine to the find listbox.
+ *
+ * @param h find dialog
+ * @param timeout max time to wait for the next scanned file, in microseconds
+ */
+
+static void
+search_content_drain (WDialog *h, gint64 timeout)
+{
+    find_content_file_t *f;
+
+    while ((f = find_content_pop (search_content_engine, timeout)) != NULL)
+    {
+        gint64 tv;
+        guint i;
+
+        // get time elapsed from last refresh
+        tv = g_get_monotonic_time ();
+
+        /* if we add results for a file, we have to ensure that
+           name of this file is shown in status bar */
+        if (f->matches->len != 0 || (tv - last_refresh) > MAX_REFRESH_INTERVAL)
+        {
+            char buffer[BUF_MEDIUM];
+
+            g_snprintf (buffer, sizeof (buffer), _ ("Grepping in %s"), f->filename);
+            status_update (str_trunc (buffer, WIDGET (h)->rect.cols - 8));
+            mc_refresh ();
+            last_refresh = tv;
+        }
+
+        for (i = 0; i < f->matches->len; i++)
+        {
+            const find_content_match_t *m = &g_array_index (f->matches, find_content_match_t, i);
+            char result[BUF_MEDIUM];
+
+            g_snprintf (result, sizeof (result), "%d:%s", m->line, f->filename);
+            find_add_match (f->directory, result, m->start, m->end);
+        }
+
+        find_content_file_free (f);
+        timeout = 0;
+    }
+}
+
 /* --------------------------------------------------------------------------------------------- */
 
 /**
@@ -1234,6 +1284,18 @@ do_search (WDialog *h)
 
     for (count = 0; count < 32; count++)
     {
+        if (search_content_engine != NULL)
+        {
+            search_content_drain (h, 0);
+
+            // don't walk too far ahead of scanning of files
+            if (find_content_is_full (search_content_engine))
+            {
+                search_content_drain (h, MAX_REFRESH_INTERVAL);
+                return 1;
+            }
+        }
+
         while (dp == NULL)
         {
             if (dirp != NULL)
@@ -1253,6 +1315,14 @@ do_search (WDialog *h)
                     tmp_vpath = pop_directory ();
                     if (tmp_vpath == NULL)
                     {
+                        // wait for files which are being scanned yet
+                        if (search_content_engine != NULL
+                            && !find_content_is_empty (search_content_engine))
+                        {
+                            search_content_drain (h, MAX_REFRESH_INTERVAL);
+                            return 1;
+                        }
+
                         running = FALSE;
                         if (ignore_count == 0)
                             status_update (_ ("Finished"));
@@ -1367,8 +1437,17 @@ do_search (WDialog *h)
             {
                 if (content_pattern == NULL)
                     find_add_match (directory, dp->d_name, 0, 0);
-                else if (search_content (h, directory, dp->d_name))
-                    return 1;
+                else if (search_content_engine == NULL
+                         || !find_content_push (search_content_engine, directory, dp->d_name))
+                {
+                    // keep order of found files
+                    while (search_content_engine != NULL
+                           && !find_content_is_empty (search_content_engine))
+                        search_content_drain (h, MAX_REFRESH_INTERVAL);
+
+                    if (search_content (h, directory, dp->d_name))
+                        return 1;
+                }
             }
         }
 
@@ -1708,11 +1787,16 @@ run_process (void)
     search_file_handle->is_all_charsets = options.file_all_charsets;
     search_file_handle->is_entire_line = options.file_pattern;
 
+    search_content_engine = find_content_new (search_content_handle, options.content_first_hit);
+
     resuming = FALSE;
 
     widget_idle (WIDGET (find_dlg), TRUE);
     ret = dlg_run (find_dlg);
 
+    find_content_free (search_content_engine);
+    search_content_engine = NULL;
+
     mc_search_free (search_file_handle);
     search_file_handle = NULL;
     mc_search_free (search_content_handle);
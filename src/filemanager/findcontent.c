@@ -0,0 +1,550 @@
+/*
+   Concurrent search of text in local files.
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/** \file findcontent.c
+ *  \brief Source: concurrent search of text in local files
+ *
+ *  Files found by name are scanned in worker threads bypassing VFS, every worker uses its
+ *  own copy of the search handle. Files are read by large blocks and every block is searched
+ *  at once with mc_search_run_block(), so patterns may match several lines. Like in
+ *  search_content() of Find File dialog, only the first match in a line is reported.
+ *
+ *  Scanned files are returned to the caller in the order of pushing, so the list of found
+ *  files doesn't depend on the timing of workers.
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "lib/global.h"
+#include "lib/vfs/vfs.h"
+#include "lib/workpool.h"
+
+#include "findcontent.h"
+
+/*** global variables ****************************************************************************/
+
+/*** file scope macro definitions ****************************************************************/
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* max size of read block */
+#define FIND_CONTENT_BUFSIZE     (1024 * 1024)
+
+/* max size of text kept for match which continues in the next block */
+#define FIND_CONTENT_MAX_BUFSIZE (64 * 1024 * 1024)
+
+/* max number of files which are being scanned or waiting for the caller */
+#define FIND_CONTENT_MAX_JOBS    256
+
+/*** file scope type declarations ****************************************************************/
+
+typedef struct
+{
+    find_content_file_t file;  // must be first
+    char *path;                // local path of file
+    gint done;                 // file is scanned, accessed atomically
+} find_content_job_t;
+
+typedef struct
+{
+    char *data;  // always terminated with zero
+    gsize size;
+    gsize len;
+    gsize pos;      // start of search
+    off_t base;     // file offset of data
+    gsize counted;  // lines are counted up to this position
+    int line;       // number of line at counted position
+    gboolean eof;
+} find_content_buf_t;
+
+struct find_content_t
+{
+    mc_workpool_t *pool;
+    GAsyncQueue *searches;  // idle search handles, one per worker
+    gboolean first_hit;
+    gint cancel;  // don't scan files anymore, accessed atomically
+
+    GMutex lock;  // signals end of scan of file
+    GCond cond;
+
+    // used in the main thread only
+    GQueue jobs;      // pushed and not popped files in order of pushing
+    char *dir;        // the last directory of pushed file
+    char *dir_local;  // local path of it
+};
+
+/*** forward declarations (file scope functions) *************************************************/
+
+/*** file scope variables ************************************************************************/
+
+/* --------------------------------------------------------------------------------------------- */
+/*** file scope functions ************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+
+static char *
+find_content_get_local_path (const char *path)
+{
+    vfs_path_t *vpath;
+    char *ret = NULL;
+
+    vpath = vfs_path_from_str (path);
+
+    if (vfs_path_elements_count (vpath) == 1 && vfs_file_is_local (vpath))
+    {
+        const vfs_path_element_t *element;
+
+        element = vfs_path_get_by_index (vpath, 0);
+        if (element->path != NULL && IS_PATH_SEP (element->path[0])
+#ifdef HAVE_CHARSET
+            && element->encoding == NULL
+#endif
+        )
+            ret = g_strdup (element->path);
+    }
+
+    vfs_path_free (vpath, TRUE);
+
+    return ret;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create prepared copy of search handle. Handles are prepared in the main thread, so workers
+ * only run them.
+ */
+
+static mc_search_t *
+find_content_search_dup (const mc_search_t *search)
+{
+    mc_search_t *s;
+
+    s = mc_search_new_len (search->original.str->str, search->original.str->len,
+                           search->original.charset);
+    if (s == NULL)
+        return NULL;
+
+    s->search_type = search->search_type;
+    s->is_all_charsets = search->is_all_charsets;
+    s->is_case_sensitive = search->is_case_sensitive;
+    s->whole_words = search->whole_words;
+    s->is_entire_line = search->is_entire_line;
+
+    if (!mc_search_prepare (s))
+    {
+        mc_search_free (s);
+        s = NULL;
+    }
+
+    return s;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static int
+find_content_count_lines (const char *p, gsize len)
+{
+    const char *end = p + len;
+    int n = 0;
+
+    while ((p = memchr (p, '\n', (gsize) (end - p))) != NULL)
+    {
+        n++;
+        p++;
+    }
+
+    return n;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Read next block of file. Not searched data are moved to the beginning of buffer.
+ *
+ * @return FALSE if scan is canceled, TRUE otherwise
+ */
+
+static gboolean
+find_content_fill (find_content_t *fc, int fd, find_content_buf_t *b)
+{
+    ssize_t n_read;
+
+    if (g_atomic_int_get (&fc->cancel) != 0)
+        return FALSE;
+
+    if (b->pos != 0)
+    {
+        b->line += find_content_count_lines (b->data + b->counted, b->pos - b->counted);
+        b->counted = 0;
+        memmove (b->data, b->data + b->pos, b->len - b->pos);
+        b->base += b->pos;
+        b->len -= b->pos;
+        b->pos = 0;
+    }
+    else if (b->len == b->size)
+    {
+        // match may continue after the end of buffer
+        b->size *= 2;
+        b->data = g_realloc (b->data, b->size + 1);
+    }
+
+    while ((n_read = read (fd, b->data + b->len, b->size - b->len)) == -1 && errno == EINTR)
+        ;
+
+    if (n_read <= 0)
+        b->eof = TRUE;
+    else
+        b->len += (gsize) n_read;
+
+    b->data[b->len] = '\0';
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Search text in file. Runs in a worker thread.
+ */
+
+static void
+find_content_scan (find_content_t *fc, mc_search_t *search, find_content_job_t *job)
+{
+    struct stat st;
+    int fd;
+    find_content_buf_t b;
+    gboolean skip_line = FALSE;  // the rest of line is skipped because match is found in it
+    gboolean done = FALSE;
+
+    // don't open special files
+    if (stat (job->path, &st) != 0 || !S_ISREG (st.st_mode))
+        return;
+
+    fd = open (job->path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return;
+
+#ifdef HAVE_POSIX_FADVISE
+    (void) posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    memset (&b, 0, sizeof (b));
+    b.size = (gsize) CLAMP (st.st_size, BUF_4K, FIND_CONTENT_BUFSIZE);
+    b.data = g_malloc (b.size + 1);
+    b.data[0] = '\0';
+    b.line = 1;
+
+    while (!done && !b.eof && find_content_fill (fc, fd, &b))
+    {
+        mc_search_block_t block;
+        gsize found_len;
+
+        // text kept for too long match is not searched again
+        mc_search_block_init (&block, b.data, b.len, b.base,
+                              b.eof || b.len >= FIND_CONTENT_MAX_BUFSIZE);
+
+        while (TRUE)
+        {
+            gsize pos;
+            const char *eol;
+            find_content_match_t m;
+
+            if (skip_line)
+            {
+                eol = memchr (b.data + b.pos, '\n', b.len - b.pos);
+                skip_line = (eol == NULL);
+                b.pos = eol == NULL ? b.len : (gsize) (eol - b.data) + 1;
+                if (skip_line)
+                    break;
+            }
+
+            if (!mc_search_run_block (search, &block, b.pos, &found_len))
+            {
+                // pattern error
+                if (search->error != MC_SEARCH_E_NOTFOUND)
+                    done = TRUE;
+                else
+                    b.pos = block.keep;
+                break;
+            }
+
+            pos = (gsize) (search->normal_offset - b.base);
+            b.line += find_content_count_lines (b.data + b.counted, pos - b.counted);
+            b.counted = pos;
+
+            m.line = b.line;
+            // off by one: ticket 3280
+            m.start = (gsize) search->normal_offset + 1;
+            m.end = m.start + found_len;
+            g_array_append_val (job->file.matches, m);
+
+            if (fc->first_hit)
+            {
+                done = TRUE;
+                break;
+            }
+
+            /* search in line once. Match may span several lines: skip from its end, but don't
+               skip the next line if match ends with the line break */
+            b.pos = pos + found_len;
+            skip_line = found_len == 0 || b.data[b.pos - 1] != '\n';
+        }
+
+        mc_search_block_deinit (&block);
+    }
+
+    g_free (b.data);
+    close (fd);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+find_content_task (gpointer task, gpointer user_data)
+{
+    find_content_job_t *job = (find_content_job_t *) task;
+    find_content_t *fc = (find_content_t *) user_data;
+
+    if (g_atomic_int_get (&fc->cancel) == 0)
+    {
+        mc_search_t *search;
+
+        search = (mc_search_t *) g_async_queue_pop (fc->searches);
+        find_content_scan (fc, search, job);
+        g_async_queue_push (fc->searches, search);
+    }
+
+    g_mutex_lock (&fc->lock);
+    g_atomic_int_set (&job->done, 1);
+    g_cond_signal (&fc->cond);
+    g_mutex_unlock (&fc->lock);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/*** public functions ****************************************************************************/
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Create search engine.
+ *
+ * @param search search handle. It is copied
+ * @param first_hit find only the first matched line in file
+ *
+ * @return newly allocated engine, or NULL if @search cannot be prepared
+ */
+
+find_content_t *
+find_content_new (const mc_search_t *search, gboolean first_hit)
+{
+    find_content_t *fc;
+    int workers, i;
+
+    if (search == NULL)
+        return NULL;
+
+    fc = g_new0 (find_content_t, 1);
+    fc->first_hit = first_hit;
+    fc->searches = g_async_queue_new ();
+    g_mutex_init (&fc->lock);
+    g_cond_init (&fc->cond);
+    g_queue_init (&fc->jobs);
+
+    workers = mc_workpool_get_num_workers ();
+
+    for (i = 0; i < workers; i++)
+    {
+        mc_search_t *s;
+
+        s = find_content_search_dup (search);
+        if (s == NULL)
+            break;
+
+        g_async_queue_push (fc->searches, s);
+    }
+
+    if (i < workers)
+    {
+        find_content_free (fc);
+        return NULL;
+    }
+
+    fc->pool = mc_workpool_new (find_content_task, fc, workers);
+
+    return fc;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Stop scanning and free engine. Not popped files are lost.
+ *
+ * @param fc engine
+ */
+
+void
+find_content_free (find_content_t *fc)
+{
+    find_content_job_t *job;
+    mc_search_t *search;
+
+    if (fc == NULL)
+        return;
+
+    g_atomic_int_set (&fc->cancel, 1);
+
+    if (fc->pool != NULL)
+        mc_workpool_free (fc->pool);
+
+    while ((job = (find_content_job_t *) g_queue_pop_head (&fc->jobs)) != NULL)
+        find_content_file_free (&job->file);
+
+    while ((search = (mc_search_t *) g_async_queue_try_pop (fc->searches)) != NULL)
+        mc_search_free (search);
+    g_async_queue_unref (fc->searches);
+
+    g_free (fc->dir);
+    g_free (fc->dir_local);
+    g_cond_clear (&fc->cond);
+    g_mutex_clear (&fc->lock);
+    g_free (fc);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Schedule scan of file.
+ *
+ * @param fc engine
+ * @param directory directory of file
+ * @param filename name of file
+ *
+ * @return TRUE if file is scheduled, FALSE if file is not local and should be scanned via VFS
+ */
+
+gboolean
+find_content_push (find_content_t *fc, const char *directory, const char *filename)
+{
+    find_content_job_t *job;
+
+    if (fc->dir == NULL || strcmp (fc->dir, directory) != 0)
+    {
+        g_free (fc->dir);
+        g_free (fc->dir_local);
+        fc->dir = g_strdup (directory);
+        fc->dir_local = find_content_get_local_path (directory);
+    }
+
+    if (fc->dir_local == NULL)
+        return FALSE;
+
+    job = g_new0 (find_content_job_t, 1);
+    job->file.directory = g_strdup (directory);
+    job->file.filename = g_strdup (filename);
+    job->file.matches = g_array_new (FALSE, FALSE, sizeof (find_content_match_t));
+    job->path = g_build_filename (fc->dir_local, filename, (char *) NULL);
+
+    g_queue_push_tail (&fc->jobs, job);
+    mc_workpool_push (fc->pool, job);
+
+    return TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether too many files are scheduled. If so, scanned files should be popped before
+ * pushing new ones.
+ */
+
+gboolean
+find_content_is_full (const find_content_t *fc)
+{
+    return (g_queue_get_length ((GQueue *) &fc->jobs) >= FIND_CONTENT_MAX_JOBS);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Check whether all pushed files are popped.
+ */
+
+gboolean
+find_content_is_empty (const find_content_t *fc)
+{
+    return g_queue_is_empty ((GQueue *) &fc->jobs);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get the first of not popped files if it is scanned already.
+ *
+ * @param fc engine
+ * @param timeout max time to wait for the end of scan, in microseconds
+ *
+ * @return file that should be freed with find_content_file_free(), or NULL if there are no
+ *         pushed files or the first of them is not scanned yet
+ */
+
+find_content_file_t *
+find_content_pop (find_content_t *fc, gint64 timeout)
+{
+    find_content_job_t *job;
+
+    job = (find_content_job_t *) g_queue_peek_head (&fc->jobs);
+    if (job == NULL)
+        return NULL;
+
+    if (g_atomic_int_get (&job->done) == 0 && timeout > 0)
+    {
+        const gint64 end_time = g_get_monotonic_time () + timeout;
+
+        g_mutex_lock (&fc->lock);
+        while (g_atomic_int_get (&job->done) == 0
+               && g_cond_wait_until (&fc->cond, &fc->lock, end_time))
+            ;
+        g_mutex_unlock (&fc->lock);
+    }
+
+    if (g_atomic_int_get (&job->done) == 0)
+        return NULL;
+
+    g_queue_pop_head (&fc->jobs);
+
+    return &job->file;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+void
+find_content_file_free (find_content_file_t *f)
+{
+    find_content_job_t *job = (find_content_job_t *) f;
+
+    g_free (f->directory);
+    g_free (f->filename);
+    g_array_free (f->matches, TRUE);
+    g_free (job->path);
+    g_free (job);
+}
+
+/* --------------------------------------------------------------------------------------------- */
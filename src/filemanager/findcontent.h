@@ -0,0 +1,50 @@
+/** \file findcontent.h
+ *  \brief Header: concurrent search of text in local files
+ */
+
+#ifndef MC__FINDCONTENT_H
+#define MC__FINDCONTENT_H
+
+#include "lib/global.h"
+#include "lib/search.h"
+
+/*** typedefs(not structures) and defined constants **********************************************/
+
+typedef struct find_content_t find_content_t;
+
+/*** enums ***************************************************************************************/
+
+/*** structures declarations (and typedefs of structures)*****************************************/
+
+/* found line */
+typedef struct
+{
+    int line;
+    gsize start;  // offsets of found text in file
+    gsize end;
+} find_content_match_t;
+
+/* scanned file */
+typedef struct
+{
+    char *directory;
+    char *filename;
+    GArray *matches;  // array of find_content_match_t
+} find_content_file_t;
+
+/*** global variables defined in .c file *********************************************************/
+
+/*** declarations of public functions ************************************************************/
+
+find_content_t *find_content_new (const mc_search_t *search, gboolean first_hit);
+void find_content_free (find_content_t *fc);
+
+gboolean find_content_push (find_content_t *fc, const char *directory, const char *filename);
+gboolean find_content_is_full (const find_content_t *fc);
+gboolean find_content_is_empty (const find_content_t *fc);
+find_content_file_t *find_content_pop (find_content_t *fc, gint64 timeout);
+void find_content_file_free (find_content_file_t *f);
+
+/*** inline functions ****************************************************************************/
+
+#endif
@@ -64,6 +64,7 @@
 #include "tree.h"
 /* Needed for the extern declarations of integer parameters */
 #include "dir.h"
+#include "dirwatch.h"
 #include "layout.h"
 #include "info.h"  // The Info widget
 
@@ -1280,6 +1281,8 @@ swap_panels (void)
         panelswap (dir_stat);
 #undef panelswap
 
+        dir_watch_swap_panels (panel1, panel2);
+
         panel1->quick_search.active = FALSE;
         panel2->quick_search.active = FALSE;
 
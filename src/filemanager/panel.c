@@ -39,6 +39,7 @@
 
 #include "lib/global.h"
 
+#include "lib/idcache.h"
 #include "lib/tty/tty.h"
 #include "lib/tty/key.h"  // XCTRL and ALT macros
 #include "lib/skin.h"
@@ -65,6 +66,7 @@
 #include "src/usermenu.h"
 
 #include "dir.h"
+#include "dirwatch.h"
 #include "boxes.h"
 #include "tree.h"
 #include "ext.h"     // regexp_command
@@ -139,6 +141,53 @@ typedef enum
     FILENAME_SCROLL_RIGHT = 4
 } filename_scroll_flag_t;
 
+/* part of formatted line of file list */
+typedef enum
+{
+    PANEL_CELL_TEXT,   // text of one color
+    PANEL_CELL_VLINE,  // vertical line between fields
+    PANEL_CELL_FILL    // spaces up to the end of line
+} panel_cell_type_t;
+
+typedef struct
+{
+    panel_cell_type_t type;
+    int color;  // -1 to keep the current color
+    int value;  // offset of text in panel_line_t::text, or number of spaces
+} panel_cell_t;
+
+/* formatted line of file list */
+typedef struct
+{
+    // key
+    gboolean valid;
+    int file_index;
+    file_attr_t attr;
+    int width;
+    unsigned int entry_stamp;  // stamp of entry, 0 if there is no entry
+
+    // value
+    GArray *cells;                  // array of panel_cell_t
+    GString *text;                  // NUL-terminated texts of cells
+    filename_scroll_flag_t scroll;  // file name doesn't fit
+    int field_length;               // length of name field
+    unsigned int name_shift;        // max shift of file name
+} panel_line_t;
+
+struct panel_line_cache_struct
+{
+    panel_line_t *lines;  // indexed by number of file modulo size
+    int size;
+
+    // state of panel and options which affects all lines
+    unsigned int content_shift;
+    guint fhl_stamp;
+    guint idcache_stamp;
+    gboolean filetype_mode;
+    gboolean permission_mode;
+    gboolean kilobyte_si;
+};
+
 /*** forward declarations (file scope functions) *************************************************/
 
 static const char *string_file_name (const file_entry_t *fe, int len);
@@ -241,6 +290,9 @@ static int state_mark = 0;
 
 static GString *string_file_name_buffer;
 
+/* the last stamp of file entry in caches of formatted lines */
+static unsigned int panel_line_last_stamp = 0;
+
 /* --------------------------------------------------------------------------------------------- */
 /*** file scope functions ************************************************************************/
 /* --------------------------------------------------------------------------------------------- */
@@ -304,8 +356,191 @@ panel_lines (const WPanel *p)
 /** This code relies on the default justification!!! */
 
 static void
-add_permission_string (const char *dest, int width, file_entry_t *fe, file_attr_t attr, int color,
-                       gboolean is_octal)
+panel_line_add_text (panel_line_t *line, int color, const char *text, gsize len)
+{
+    panel_cell_t cell;
+
+    if (line->cells->len != 0)
+    {
+        panel_cell_t *last;
+
+        last = &g_array_index (line->cells, panel_cell_t, line->cells->len - 1);
+        if (last->type == PANEL_CELL_TEXT && last->color == color)
+        {
+            // join with the previous text: replace its terminating NUL
+            g_string_truncate (line->text, line->text->len - 1);
+            g_string_append_len (line->text, text, len);
+            g_string_append_c (line->text, '\0');
+            return;
+        }
+    }
+
+    cell.type = PANEL_CELL_TEXT;
+    cell.color = color;
+    cell.value = (int) line->text->len;
+    g_string_append_len (line->text, text, len);
+    g_string_append_c (line->text, '\0');
+    g_array_append_val (line->cells, cell);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_line_add_cell (panel_line_t *line, panel_cell_type_t type, int color, int value)
+{
+    panel_cell_t cell;
+
+    cell.type = type;
+    cell.color = color;
+    cell.value = value;
+    g_array_append_val (line->cells, cell);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_line_init (panel_line_t *line)
+{
+    line->valid = FALSE;
+    line->cells = g_array_new (FALSE, FALSE, sizeof (panel_cell_t));
+    line->text = g_string_sized_new (128);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_line_deinit (panel_line_t *line)
+{
+    g_array_free (line->cells, TRUE);
+    g_string_free (line->text, TRUE);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_line_paint (const panel_line_t *line)
+{
+    guint i;
+
+    for (i = 0; i < line->cells->len; i++)
+    {
+        const panel_cell_t *cell = &g_array_index (line->cells, panel_cell_t, i);
+
+        if (cell->color >= 0)
+            tty_setcolor (cell->color);
+
+        switch (cell->type)
+        {
+        case PANEL_CELL_TEXT:
+            tty_print_string (line->text->str + cell->value);
+            break;
+        case PANEL_CELL_VLINE:
+            tty_print_one_vline (TRUE);
+            break;
+        case PANEL_CELL_FILL:
+        {
+            int y, x;
+
+            tty_getyx (&y, &x);
+            tty_draw_hline (y, x, ' ', cell->value);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+panel_line_cache_free (WPanel *panel)
+{
+    panel_line_cache_t *cache = panel->line_cache;
+    int i;
+
+    if (cache == NULL)
+        return;
+
+    for (i = 0; i < cache->size; i++)
+        panel_line_deinit (&cache->lines[i]);
+    g_free (cache->lines);
+    g_free (cache);
+
+    panel->line_cache = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Forget all formatted lines of panel. Lines of changed entries are forgotten automatically:
+ * see file_entry_reset_cache().
+ */
+
+static void
+panel_line_cache_clear (WPanel *panel)
+{
+    panel_line_cache_t *cache = panel->line_cache;
+    int i;
+
+    if (cache == NULL)
+        return;
+
+    for (i = 0; i < cache->size; i++)
+        cache->lines[i].valid = FALSE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Prepare cache of formatted lines for @size visible files. The cache is cleared if panel or
+ * options are changed since the previous call.
+ */
+
+static panel_line_cache_t *
+panel_line_cache_check (WPanel *panel, int size)
+{
+    panel_line_cache_t *cache = panel->line_cache;
+    const guint fhl_stamp = mc_filehighlight != NULL ? mc_filehighlight->stamp : 0;
+    const guint idcache_stamp = mc_idcache_get_stamp ();
+
+    if (cache != NULL && cache->size != size)
+    {
+        panel_line_cache_free (panel);
+        cache = NULL;
+    }
+
+    if (cache == NULL)
+    {
+        int i;
+
+        cache = g_new0 (panel_line_cache_t, 1);
+        cache->size = size;
+        cache->lines = g_new (panel_line_t, size);
+        for (i = 0; i < size; i++)
+            panel_line_init (&cache->lines[i]);
+        panel->line_cache = cache;
+    }
+    else if (cache->content_shift != panel->content_shift || cache->fhl_stamp != fhl_stamp
+             || cache->idcache_stamp != idcache_stamp
+             || cache->filetype_mode != panels_options.filetype_mode
+             || cache->permission_mode != panels_options.permission_mode
+             || cache->kilobyte_si != panels_options.kilobyte_si)
+        panel_line_cache_clear (panel);
+
+    cache->content_shift = panel->content_shift;
+    cache->fhl_stamp = fhl_stamp;
+    cache->idcache_stamp = idcache_stamp;
+    cache->filetype_mode = panels_options.filetype_mode;
+    cache->permission_mode = panels_options.permission_mode;
+    cache->kilobyte_si = panels_options.kilobyte_si;
+
+    return cache;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+add_permission_string (panel_line_t *line, const char *dest, int width, file_entry_t *fe,
+                       file_attr_t attr, int color, gboolean is_octal)
 {
     int i, r, l;
 
@@ -324,19 +559,19 @@ add_permission_string (const char *dest, int width, file_entry_t *fe, file_attr_
         r = l + 3;
     }
 
-    for (i = 0; i < width; i++)
+    for (i = 0; i < width && dest[i] != '\0'; i++)
     {
+        int c = color;
+
         if (i >= l && i < r)
         {
             if (attr == FATTR_CURRENT || attr == FATTR_MARKED_CURRENT)
-                tty_setcolor (CORE_MARKED_SELECTED_COLOR);
+                c = CORE_MARKED_SELECTED_COLOR;
             else
-                tty_setcolor (CORE_MARKED_COLOR);
+                c = CORE_MARKED_COLOR;
         }
-        else
-            tty_setcolor (color);
 
-        tty_print_char (dest[i]);
+        panel_line_add_text (line, c, dest + i, 1);
     }
 }
 
@@ -595,7 +830,8 @@ string_file_owner (const file_entry_t *fe, int len)
 {
     (void) len;
 
-    return get_owner (fe->st.st_uid);
+    // don't block on NSS: the panel is redrawn when the name is resolved
+    return mc_idcache_get_owner (fe->st.st_uid, !panels_options.prefetch_owners);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -606,7 +842,7 @@ string_file_group (const file_entry_t *fe, int len)
 {
     (void) len;
 
-    return get_group (fe->st.st_gid);
+    return mc_idcache_get_group (fe->st.st_gid, !panels_options.prefetch_owners);
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -678,19 +914,22 @@ panel_items (const WPanel *p)
 }
 
 /* --------------------------------------------------------------------------------------------- */
-/** Formats the file number file_index of panel in the buffer dest */
+/** Formats the file number file_index of panel in the line */
 
-static filename_scroll_flag_t
+static void
 format_file (WPanel *panel, int file_index, int width, file_attr_t attr, gboolean isstatus,
-             int *field_length)
+             panel_line_t *line)
 {
     int color = CORE_NORMAL_COLOR;
     int length = 0;
     GSList *format, *home;
     file_entry_t *fe = NULL;
-    filename_scroll_flag_t res = FILENAME_NOSCROLL;
 
-    *field_length = 0;
+    g_array_set_size (line->cells, 0);
+    g_string_set_size (line->text, 0);
+    line->scroll = FILENAME_NOSCROLL;
+    line->field_length = 0;
+    line->name_shift = 0;
 
     if (panel->dir.len != 0 && file_index < panel->dir.len)
     {
@@ -725,20 +964,20 @@ format_file (WPanel *panel, int file_index, int width, file_attr_t attr, gboolea
                 const int str_len = str_length (txt);
                 const unsigned int len_diff = (unsigned int) DOZ (str_len, len);
 
-                *field_length = len + 1;
+                line->field_length = len + 1;
 
-                panel->max_shift = MAX (panel->max_shift, len_diff);
+                line->name_shift = MAX (line->name_shift, len_diff);
 
                 if (len_diff != 0)
                 {
                     const unsigned int shift = MIN (panel->content_shift, len_diff);
 
                     if (shift != 0)
-                        res |= FILENAME_SCROLL_LEFT;
+                        line->scroll |= FILENAME_SCROLL_LEFT;
 
                     name_offset = str_offset_to_pos (txt, shift);
                     if (str_length (txt + name_offset) > len)
-                        res |= FILENAME_SCROLL_RIGHT;
+                        line->scroll |= FILENAME_SCROLL_RIGHT;
                 }
             }
 
@@ -750,40 +989,74 @@ format_file (WPanel *panel, int file_index, int width, file_attr_t attr, gboolea
                     perm = 2;
             }
 
-            tty_setcolor (color);
-
             if (!isstatus)
                 prepared_text = str_fit_to_term (txt + name_offset, len, HIDE_FIT (fi->just_mode));
             else
                 prepared_text = str_fit_to_term (txt, len, fi->just_mode);
 
             if (perm != 0 && fe != NULL)
-                add_permission_string (prepared_text, fi->field_len, fe, attr, color, perm != 1);
+                add_permission_string (line, prepared_text, fi->field_len, fe, attr, color,
+                                       perm != 1);
             else
-                tty_print_string (prepared_text);
+                panel_line_add_text (line, color, prepared_text, strlen (prepared_text));
 
             length += len;
         }
         else
         {
             if (attr == FATTR_CURRENT || attr == FATTR_MARKED_CURRENT)
-                tty_setcolor (CORE_SELECTED_COLOR);
+                panel_line_add_cell (line, PANEL_CELL_VLINE, CORE_SELECTED_COLOR, 0);
             else
-                tty_setcolor (CORE_FRAME_COLOR);
-            tty_print_one_vline (TRUE);
+                panel_line_add_cell (line, PANEL_CELL_VLINE, CORE_FRAME_COLOR, 0);
             length++;
         }
     }
 
     if (length < width)
+        panel_line_add_cell (line, PANEL_CELL_FILL, -1, width - length);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get formatted line of file. Only changed lines are formatted, the rest are taken from cache.
+ */
+
+static const panel_line_t *
+panel_get_line (WPanel *panel, int file_index, int width, file_attr_t attr)
+{
+    panel_line_cache_t *cache;
+    panel_line_t *line;
+    unsigned int stamp = 0;
+
+    cache = panel_line_cache_check (panel, MAX (panel_items (panel), 1));
+    line = &cache->lines[file_index % cache->size];
+
+    if (file_index < panel->dir.len)
     {
-        int y, x;
+        file_entry_t *fe = &panel->dir.list[file_index];
 
-        tty_getyx (&y, &x);
-        tty_draw_hline (y, x, ' ', width - length);
+        if (fe->line_stamp == 0)
+        {
+            // zero stamp means that entry isn't formatted yet
+            if (++panel_line_last_stamp == 0)
+                panel_line_last_stamp++;
+            fe->line_stamp = panel_line_last_stamp;
+        }
+        stamp = fe->line_stamp;
     }
 
-    return res;
+    if (!line->valid || line->file_index != file_index || line->attr != attr
+        || line->width != width || line->entry_stamp != stamp)
+    {
+        format_file (panel, file_index, width, attr, FALSE, line);
+        line->valid = TRUE;
+        line->file_index = file_index;
+        line->attr = attr;
+        line->width = width;
+        line->entry_stamp = stamp;
+    }
+
+    return line;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -796,9 +1069,10 @@ repaint_file (WPanel *panel, int file_index, file_attr_t attr)
     int nth_column = 0;
     int width;
     int offset = 0;
+    const panel_line_t *line;
     filename_scroll_flag_t ret_frm;
     int ypos = 0;
-    int fln = 0;
+    int fln;
 
     // Divide into panel->list_cols equally wide columns, plus maybe some leftover space: #4906
     width = w->rect.cols - 1;
@@ -823,7 +1097,11 @@ repaint_file (WPanel *panel, int file_index, file_attr_t attr)
     ypos += 2;  // top frame and header
     widget_gotoyx (w, ypos, offset + 1);
 
-    ret_frm = format_file (panel, file_index, width, attr, FALSE, &fln);
+    line = panel_get_line (panel, file_index, width, attr);
+    panel_line_paint (line);
+    panel->max_shift = MAX (panel->max_shift, line->name_shift);
+    ret_frm = line->scroll;
+    fln = line->field_length;
 
     if (nth_column + 1 < panel->list_cols)
     {
@@ -884,9 +1162,12 @@ repaint_status (WPanel *panel)
     width = WIDGET (panel)->rect.cols - 2;
     if (width > 0)
     {
-        int fln = 0;
+        panel_line_t line;
 
-        (void) format_file (panel, panel->current, width, FATTR_STATUS, TRUE, &fln);
+        panel_line_init (&line);
+        format_file (panel, panel->current, width, FATTR_STATUS, TRUE, &line);
+        panel_line_paint (&line);
+        panel_line_deinit (&line);
     }
 }
 
@@ -1440,6 +1721,7 @@ panel_destroy (WPanel *p)
         g_free (name);
     }
 
+    dir_watch_panel_remove (p);
     panel_clean_dir (p);
 
     // clean history
@@ -1464,6 +1746,8 @@ panel_destroy (WPanel *p)
 
     panelized_descr_free (p->panelized_descr);
 
+    panel_line_cache_free (p);
+
     g_string_free (p->quick_search.buffer, TRUE);
     g_string_free (p->quick_search.prev_buffer, TRUE);
 
@@ -1807,6 +2091,7 @@ use_display_format (WPanel *panel, const char *format, char **error, gboolean is
         return NULL;
 
     panel->dirty = TRUE;
+    panel_line_cache_clear (panel);
 
     // Divide into panel->list_cols equally wide columns, plus maybe some leftover space: #4906
     usable_columns = WIDGET (panel)->rect.cols - 1;
@@ -3352,6 +3637,44 @@ get_parent_dir_name (const vfs_path_t *cwd_vpath, const vfs_path_t *lwd_vpath)
     return (p != lwd || IS_PATH_SEP (*p)) ? p + 1 : p;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Start resolving names of owners and groups of loaded files in background.
+ */
+
+static void
+panel_prefetch_owners (const WPanel *panel)
+{
+    uid_t *uids;
+    gid_t *gids;
+    size_t len = 0;
+    int i;
+
+    if (!panels_options.prefetch_owners || panel->dir.len == 0)
+        return;
+
+    uids = g_new (uid_t, panel->dir.len);
+    gids = g_new (gid_t, panel->dir.len);
+
+    for (i = 0; i < panel->dir.len; i++)
+    {
+        const struct stat *st = &panel->dir.list[i].st;
+
+        // files of one owner are usually listed together
+        if (len == 0 || uids[len - 1] != st->st_uid || gids[len - 1] != st->st_gid)
+        {
+            uids[len] = st->st_uid;
+            gids[len] = st->st_gid;
+            len++;
+        }
+    }
+
+    mc_idcache_prefetch (uids, gids, len);
+
+    g_free (uids);
+    g_free (gids);
+}
+
 /* --------------------------------------------------------------------------------------------- */
 /**
  * Changes the current directory of the panel.
@@ -3393,10 +3716,12 @@ panel_do_cd_int (WPanel *panel, const vfs_path_t *new_dir_vpath, enum cd_enum cd
 
     // Reload current panel
     panel_clean_dir (panel);
+    dir_watch_panel (panel);
 
     if (!dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                         &panel->sort_info, &panel->filter))
         message (D_ERROR, MSG_ERROR, _ ("Cannot read directory contents"));
+    panel_prefetch_owners (panel);
 
     if (panel->dir.len == 0)
         panel_set_current (panel, -1);
@@ -4140,9 +4465,8 @@ reload_panelized (WPanel *panel)
         vfs_path_t *vpath;
 
         vpath = vfs_path_from_str (list->list[i].fname->str);
-        if (mc_lstat (vpath, &list->list[i].st) != 0)
-            g_string_free (list->list[i].fname, TRUE);
-        else
+        // name of removed entry is released with the list
+        if (mc_lstat (vpath, &list->list[i].st) == 0)
         {
             if (j != i)
                 list->list[j] = list->list[i];
@@ -4602,9 +4926,11 @@ panel_sized_with_dir_new (const char *panel_name, const WRect *r, const vfs_path
     }
 
     // Load the default format
+    dir_watch_panel (panel);
     if (!dir_list_load (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                         &panel->sort_info, &panel->filter))
         message (D_ERROR, MSG_ERROR, _ ("Cannot read directory contents"));
+    panel_prefetch_owners (panel);
 
     if (panel->dir.len == 0)
         panel_set_current (panel, -1);
@@ -4652,10 +4978,12 @@ panel_reload (WPanel *panel)
     panel->cwd_vpath = cwd_vpath;
     memset (&(panel->dir_stat), 0, sizeof (panel->dir_stat));
     show_dir (panel);
+    dir_watch_panel (panel);
 
     if (!dir_list_reload (&panel->dir, panel->cwd_vpath, panel->sort_field->sort_routine,
                           &panel->sort_info, &panel->filter))
         message (D_ERROR, MSG_ERROR, _ ("Cannot read directory contents"));
+    panel_prefetch_owners (panel);
 
     panel->dirty = TRUE;
 
@@ -5287,22 +5615,27 @@ panel_panelize_restore (void)
     for (i = 0; i < plist->len; i++)
     {
         if (panelized_same || DIR_IS_DOTDOT (plist->list[i].fname->str))
-            list->list[i].fname = mc_g_string_dup (plist->list[i].fname);
+            list->list[i].fname =
+                dir_list_new_name (list, plist->list[i].fname->str, plist->list[i].fname->len);
         else
         {
             vfs_path_t *tmp_vpath;
+            const char *path;
 
             tmp_vpath =
                 vfs_path_append_new (pdescr->root_vpath, plist->list[i].fname->str, (char *) NULL);
-            list->list[i].fname = g_string_new_take (vfs_path_free (tmp_vpath, FALSE));
+            path = vfs_path_as_str (tmp_vpath);
+            list->list[i].fname = dir_list_new_name (list, path, strlen (path));
+            vfs_path_free (tmp_vpath, TRUE);
         }
         list->list[i].f.link_to_dir = plist->list[i].f.link_to_dir;
         list->list[i].f.stale_link = plist->list[i].f.stale_link;
         list->list[i].f.dir_size_computed = plist->list[i].f.dir_size_computed;
         list->list[i].f.marked = plist->list[i].f.marked;
         list->list[i].st = plist->list[i].st;
-        list->list[i].name_sort_key = plist->list[i].name_sort_key;
-        list->list[i].extension_sort_key = plist->list[i].extension_sort_key;
+        list->list[i].name_sort_key = NULL;
+        list->list[i].extension_sort_key = NULL;
+        file_entry_reset_cache (&list->list[i]);
     }
 
     panel->is_panelized = TRUE;
@@ -5395,14 +5728,16 @@ panel_panelize_save (WPanel *panel)
 
     for (i = 0; i < panel->dir.len; i++)
     {
-        plist->list[i].fname = mc_g_string_dup (list->list[i].fname);
+        plist->list[i].fname =
+            dir_list_new_name (plist, list->list[i].fname->str, list->list[i].fname->len);
         plist->list[i].f.link_to_dir = list->list[i].f.link_to_dir;
         plist->list[i].f.stale_link = list->list[i].f.stale_link;
         plist->list[i].f.dir_size_computed = list->list[i].f.dir_size_computed;
         plist->list[i].f.marked = list->list[i].f.marked;
         plist->list[i].st = list->list[i].st;
-        plist->list[i].name_sort_key = list->list[i].name_sort_key;
-        plist->list[i].extension_sort_key = list->list[i].extension_sort_key;
+        plist->list[i].name_sort_key = NULL;
+        plist->list[i].extension_sort_key = NULL;
+        file_entry_reset_cache (&plist->list[i]);
     }
 }
 
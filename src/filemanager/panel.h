@@ -25,6 +25,8 @@
 
 #define UP_KEEPSEL   ((char *) -1)
 
+typedef struct panel_line_cache_struct panel_line_cache_t;
+
 /*** enums ***************************************************************************************/
 
 typedef enum
@@ -138,6 +140,8 @@ typedef struct
 
     unsigned int content_shift;  // Number of characters of filename need to skip from left side
     unsigned int max_shift;      // Max shift for visible part of current panel
+
+    panel_line_cache_t *line_cache;  // formatted lines of visible files
 } WPanel;
 
 /*** global variables defined in .c file *********************************************************/
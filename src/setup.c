@@ -141,6 +141,7 @@ panels_options_t panels_options = {
     .mouse_move_pages = TRUE,
     .filetype_mode = TRUE,
     .permission_mode = FALSE,
+    .prefetch_owners = TRUE,
     .qsearch_mode = QSEARCH_PANEL_CASE,
     .select_flags = SELECT_MATCH_CASE | SELECT_SHELL_PATTERNS,
 };
@@ -175,6 +176,13 @@ gboolean verbose = TRUE;
  */
 gboolean file_op_compute_totals = TRUE;
 
+/* If true, digests of files are kept to skip reading of unchanged files on next compare */
+gboolean compare_digest_cache = FALSE;
+
+/* If true, sizes of files in local directories are kept to skip reading of unchanged directories.
+   Off by default: files rewritten in place don't change times of directory and aren't noticed */
+gboolean dir_size_cache = FALSE;
+
 /* If true use the internal viewer */
 gboolean use_internal_view = TRUE;
 /* If set, use the builtin editor */
@@ -322,6 +330,8 @@ static const struct
     { "xtree_mode", &xtree_mode },
     { "file_op_compute_totals", &file_op_compute_totals },
     { "classic_progressbar", &classic_progressbar },
+    { "compare_digest_cache", &compare_digest_cache },
+    { "dir_size_cache", &dir_size_cache },
 #ifdef ENABLE_VFS
 #ifdef ENABLE_VFS_FTP
     { "use_netrc", &ftpfs_use_netrc },
@@ -442,6 +452,7 @@ static const struct
     { "mouse_move_pages", &panels_options.mouse_move_pages },
     { "filetype_mode", &panels_options.filetype_mode },
     { "permission_mode", &panels_options.permission_mode },
+    { "prefetch_owners", &panels_options.prefetch_owners },
     {
         NULL,
         NULL,
@@ -54,6 +54,7 @@ typedef struct
     gboolean mouse_move_pages;  // Scroll page/item using mouse wheel
     gboolean filetype_mode;     // If TRUE then add per file type highlighting
     gboolean permission_mode;   // If TRUE, we use permission highlighting
+    gboolean prefetch_owners;   // If TRUE, names of owners are resolved in background
     qsearch_mode_t qsearch_mode;  // Quick search mode
     select_flags_t select_flags;  // Select/unselect file flags
 } panels_options_t;
@@ -101,6 +102,8 @@ extern gboolean output_starts_shell;
 extern gboolean use_file_to_check_type;
 #endif
 extern gboolean file_op_compute_totals;
+extern gboolean compare_digest_cache;
+extern gboolean dir_size_cache;
 extern gboolean editor_ask_filename_before_edit;
 
 extern panels_options_t panels_options;
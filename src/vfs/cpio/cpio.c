@@ -45,6 +45,7 @@
 #include "lib/vfs/utilvfs.h"
 #include "lib/vfs/xdirentry.h"
 #include "lib/vfs/gc.h"  // vfs_rmstamp
+#include "lib/vfs/zstream.h"
 
 #include "cpio.h"
 
@@ -59,9 +60,9 @@
 /* #define CPIO_POS(super) (super)->u.arch.fd */
 
 #define CPIO_SEEK_SET(super, where)                                                                \
-    mc_lseek (CPIO_SUPER (super)->fd, CPIO_POS (super) = (where), SEEK_SET)
+    vfs_zstream_seek (CPIO_SUPER (super)->stream, CPIO_POS (super) = (where), SEEK_SET)
 #define CPIO_SEEK_CUR(super, where)                                                                \
-    mc_lseek (CPIO_SUPER (super)->fd, CPIO_POS (super) += (where), SEEK_SET)
+    vfs_zstream_seek (CPIO_SUPER (super)->stream, CPIO_POS (super) += (where), SEEK_SET)
 
 #define MAGIC_LENGTH (6)  // How many bytes we have to read ahead
 #define SEEKBACK     CPIO_SEEK_CUR (super, ptr - top)
@@ -135,7 +136,7 @@ typedef struct
 {
     struct vfs_s_super base;  // base class
 
-    int fd;
+    vfs_zstream_t *stream;
     struct stat st;
     int type;          // Type of the archive
     GSList *deferred;  // List of inodes for which another entries may appear
@@ -198,7 +199,6 @@ cpio_new_archive (struct vfs_class *me)
 
     arch = g_new0 (cpio_super_t, 1);
     arch->base.me = me;
-    arch->fd = -1;  // for now
     arch->type = CPIO_UNKNOWN;
 
     return VFS_SUPER (arch);
@@ -213,11 +213,8 @@ cpio_free_archive (struct vfs_class *me, struct vfs_s_super *super)
 
     (void) me;
 
-    if (arch->fd != -1)
-    {
-        mc_close (arch->fd);
-        arch->fd = -1;
-    }
+    vfs_zstream_close (arch->stream);
+    arch->stream = NULL;
 
     g_clear_slist (&arch->deferred, g_free);
 }
@@ -227,46 +224,21 @@ cpio_free_archive (struct vfs_class *me, struct vfs_s_super *super)
 static int
 cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_path_t *vpath)
 {
-    int fd, type;
-    cpio_super_t *arch;
+    cpio_super_t *arch = CPIO_SUPER (super);
     mode_t mode;
     struct vfs_s_inode *root;
 
-    fd = mc_open (vpath, O_RDONLY);
-    if (fd == -1)
+    // compressed archive is decompressed while it is read
+    arch->stream = vfs_zstream_open (vpath);
+    if (arch->stream == NULL)
     {
         message (D_ERROR, MSG_ERROR, _ ("Cannot open cpio archive\n%s"), vfs_path_as_str (vpath));
         return -1;
     }
 
     super->name = g_strdup (vfs_path_as_str (vpath));
-    arch = CPIO_SUPER (super);
     mc_stat (vpath, &arch->st);
 
-    type = get_compression_type (fd, super->name);
-    if (type == COMPRESSION_NONE)
-        mc_lseek (fd, 0, SEEK_SET);
-    else
-    {
-        char *s;
-        vfs_path_t *tmp_vpath;
-
-        mc_close (fd);
-        s = g_strconcat (super->name, decompress_extension (type), (char *) NULL);
-        tmp_vpath = vfs_path_from_str_flags (s, VPF_NO_CANON);
-        fd = mc_open (tmp_vpath, O_RDONLY);
-        vfs_path_free (tmp_vpath, TRUE);
-        if (fd == -1)
-        {
-            message (D_ERROR, MSG_ERROR, _ ("Cannot open cpio archive\n%s"), s);
-            g_free (s);
-            MC_PTR_FREE (super->name);
-            return -1;
-        }
-        g_free (s);
-    }
-
-    arch->fd = fd;
     mode = arch->st.st_mode & 07777;
     mode |= (mode & 0444) >> 2;  // set eXec where Read is
     mode |= S_IFDIR;
@@ -281,7 +253,7 @@ cpio_open_cpio_file (struct vfs_class *me, struct vfs_s_super *super, const vfs_
 
     CPIO_SEEK_SET (super, 0);
 
-    return fd;
+    return 0;
 }
 
 /* --------------------------------------------------------------------------------------------- */
@@ -318,7 +290,7 @@ cpio_find_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t top;
     ssize_t tmp;
 
-    top = mc_read (arch->fd, buf, sizeof (buf));
+    top = vfs_zstream_read (arch->stream, buf, sizeof (buf));
     if (top > 0)
         CPIO_POS (super) += top;
 
@@ -332,7 +304,7 @@ cpio_find_head (struct vfs_class *me, struct vfs_s_super *super)
                 ptr -= top - sizeof (buf) / 2;
                 top = sizeof (buf) / 2;
             }
-            tmp = mc_read (arch->fd, buf, top);
+            tmp = vfs_zstream_read (arch->stream, buf, top);
             if (tmp == 0 || tmp == -1)
             {
                 message (D_ERROR, MSG_ERROR, _ ("Premature end of cpio archive\n%s"), super->name);
@@ -515,12 +487,12 @@ cpio_create_entry (struct vfs_class *me, struct vfs_s_super *super, struct stat
         {
             if (inode != NULL)
             {
-                // FIXME: do we must read from arch->fd in case of inode != NULL only or in any
+                // FIXME: do we must read from arch->stream in case of inode != NULL only or in any
                 // case?
 
                 inode->linkname = g_malloc (st->st_size + 1);
 
-                if (mc_read (arch->fd, inode->linkname, st->st_size) < st->st_size)
+                if (vfs_zstream_read (arch->stream, inode->linkname, st->st_size) < st->st_size)
                 {
                     inode->linkname[0] = '\0';
                     return STATUS_EOF;
@@ -553,7 +525,7 @@ cpio_read_bin_head (struct vfs_class *me, struct vfs_s_super *super)
     char *name;
     struct stat st;
 
-    len = mc_read (arch->fd, (char *) &u.buf, HEAD_LENGTH);
+    len = vfs_zstream_read (arch->stream, (char *) &u.buf, HEAD_LENGTH);
     if (len < HEAD_LENGTH)
         return STATUS_EOF;
     CPIO_POS (super) += len;
@@ -571,7 +543,7 @@ cpio_read_bin_head (struct vfs_class *me, struct vfs_s_super *super)
         return STATUS_FAIL;
     }
     name = g_malloc (u.buf.c_namesize);
-    len = mc_read (arch->fd, name, u.buf.c_namesize);
+    len = vfs_zstream_read (arch->stream, name, u.buf.c_namesize);
     if (len < u.buf.c_namesize)
     {
         g_free (name);
@@ -624,7 +596,7 @@ cpio_read_oldc_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t len;
     char *name;
 
-    if (mc_read (arch->fd, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
+    if (vfs_zstream_read (arch->stream, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
         return STATUS_EOF;
     CPIO_POS (super) += HEAD_LENGTH;
     u.buf[HEAD_LENGTH] = 0;
@@ -645,7 +617,7 @@ cpio_read_oldc_head (struct vfs_class *me, struct vfs_s_super *super)
         return STATUS_FAIL;
     }
     name = g_malloc (hd.c_namesize);
-    len = mc_read (arch->fd, name, hd.c_namesize);
+    len = vfs_zstream_read (arch->stream, name, hd.c_namesize);
     if ((len == -1) || ((unsigned long) len < hd.c_namesize))
     {
         g_free (name);
@@ -696,7 +668,7 @@ cpio_read_crc_head (struct vfs_class *me, struct vfs_s_super *super)
     ssize_t len;
     char *name;
 
-    if (mc_read (arch->fd, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
+    if (vfs_zstream_read (arch->stream, u.buf, HEAD_LENGTH) != HEAD_LENGTH)
         return STATUS_EOF;
 
     CPIO_POS (super) += HEAD_LENGTH;
@@ -724,7 +696,7 @@ cpio_read_crc_head (struct vfs_class *me, struct vfs_s_super *super)
     }
 
     name = g_malloc (hd.c_namesize);
-    len = mc_read (arch->fd, name, hd.c_namesize);
+    len = vfs_zstream_read (arch->stream, name, hd.c_namesize);
 
     if ((len == -1) || ((unsigned long) len < hd.c_namesize))
     {
@@ -845,16 +817,16 @@ cpio_read (void *fh, char *buffer, size_t count)
 {
     vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
     struct vfs_class *me = VFS_FILE_HANDLER_SUPER (fh)->me;
-    int fd = CPIO_SUPER (VFS_FILE_HANDLER_SUPER (fh))->fd;
+    vfs_zstream_t *stream = CPIO_SUPER (VFS_FILE_HANDLER_SUPER (fh))->stream;
     off_t begin = file->ino->data_offset;
     ssize_t res;
 
-    if (mc_lseek (fd, begin + file->pos, SEEK_SET) != begin + file->pos)
+    if (vfs_zstream_seek (stream, begin + file->pos, SEEK_SET) != begin + file->pos)
         ERRNOR (EIO, -1);
 
     count = MIN (count, (size_t) (file->ino->st.st_size - file->pos));
 
-    res = mc_read (fd, buffer, count);
+    res = vfs_zstream_read (stream, buffer, count);
     if (res == -1)
         ERRNOR (errno, -1);
 
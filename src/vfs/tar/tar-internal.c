@@ -36,8 +36,7 @@
 #include <inttypes.h>  // uintmax_t
 
 #include "lib/global.h"
-#include "lib/widget.h"   // message()
-#include "lib/vfs/vfs.h"  // mc_read()
+#include "lib/widget.h"  // message()
 
 #include "tar-internal.h"
 
@@ -94,7 +93,7 @@ tar_short_read (size_t status, tar_super_t *archive)
         {
             ssize_t r;
 
-            r = mc_read (archive->fd, more, left);
+            r = vfs_zstream_read (archive->stream, more, left);
             if (r == -1)
                 return FALSE;
 
@@ -120,7 +119,7 @@ tar_flush_read (tar_super_t *archive)
 {
     size_t status;
 
-    status = mc_read (archive->fd, archive->record_start->buffer, record_size);
+    status = vfs_zstream_read (archive->stream, archive->record_start->buffer, record_size);
     if ((idx_t) status == record_size)
         return TRUE;
 
@@ -165,7 +164,7 @@ tar_seek_archive (tar_super_t *archive, off_t size)
 
     start = tar_current_block_ordinal (archive);
 
-    offset = mc_lseek (archive->fd, nrec * record_size, SEEK_CUR);
+    offset = vfs_zstream_seek (archive->stream, nrec * record_size, SEEK_CUR);
     if (offset < 0)
         return offset;
 
@@ -15,6 +15,7 @@
 #include "lib/intprops.h"
 #include "lib/idx.h"
 #include "lib/vfs/xdirentry.h"  // vfs_s_super
+#include "lib/vfs/zstream.h"
 
 /*** typedefs(not structures) and defined constants **********************************************/
 
@@ -222,7 +223,7 @@ typedef struct
 {
     struct vfs_s_super base;  // base class
 
-    int fd;
+    vfs_zstream_t *stream;
     struct stat st;
     enum archive_format type;   // type of the archive
     union block *record_start;  // start of record of archive
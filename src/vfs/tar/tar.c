@@ -841,7 +841,6 @@ tar_new_archive (struct vfs_class *me)
 
     arch = g_new0 (tar_super_t, 1);
     arch->base.me = me;
-    arch->fd = -1;
     arch->type = TAR_UNKNOWN;
 
     // Prepare global data needed for tar_find_next_block:
@@ -869,11 +868,8 @@ tar_free_archive (struct vfs_class *me, struct vfs_s_super *archive)
 
     (void) me;
 
-    if (arch->fd != -1)
-    {
-        mc_close (arch->fd);
-        arch->fd = -1;
-    }
+    vfs_zstream_close (arch->stream);
+    arch->stream = NULL;
 
     g_free (arch->record_start);
     tar_stat_destroy (&current_stat_info);
@@ -886,12 +882,12 @@ static gboolean
 tar_open_archive_int (struct vfs_class *me, const vfs_path_t *vpath, struct vfs_s_super *archive)
 {
     tar_super_t *arch = TAR_SUPER (archive);
-    int result, type;
     mode_t mode;
     struct vfs_s_inode *root;
 
-    result = mc_open (vpath, O_RDONLY);
-    if (result == -1)
+    // compressed archive is decompressed while it is read
+    arch->stream = vfs_zstream_open (vpath);
+    if (arch->stream == NULL)
     {
         message (D_ERROR, MSG_ERROR, _ ("Cannot open tar archive\n%s"), vfs_path_as_str (vpath));
         ERRNOR (ENOENT, FALSE);
@@ -900,31 +896,6 @@ tar_open_archive_int (struct vfs_class *me, const vfs_path_t *vpath, struct vfs_
     archive->name = g_strdup (vfs_path_as_str (vpath));
     mc_stat (vpath, &arch->st);
 
-    // Find out the method to handle this tar file
-    type = get_compression_type (result, archive->name);
-    if (type == COMPRESSION_NONE)
-        mc_lseek (result, 0, SEEK_SET);
-    else
-    {
-        char *s;
-        vfs_path_t *tmp_vpath;
-
-        mc_close (result);
-        s = g_strconcat (archive->name, decompress_extension (type), (char *) NULL);
-        tmp_vpath = vfs_path_from_str_flags (s, VPF_NO_CANON);
-        result = mc_open (tmp_vpath, O_RDONLY);
-        vfs_path_free (tmp_vpath, TRUE);
-        if (result == -1)
-            message (D_ERROR, MSG_ERROR, _ ("Cannot open tar archive\n%s"), s);
-        g_free (s);
-        if (result == -1)
-        {
-            MC_PTR_FREE (archive->name);
-            ERRNOR (ENOENT, FALSE);
-        }
-    }
-
-    arch->fd = result;
     mode = arch->st.st_mode & 07777;
     if (mode & 0400)
         mode |= 0100;
@@ -1114,7 +1085,7 @@ tar_get_sparse_chunk_idx (const GArray *sparse_map, off_t offset)
 static ssize_t
 tar_read_sparse (vfs_file_handler_t *fh, char *buffer, size_t count)
 {
-    int fd = TAR_SUPER (fh->ino->super)->fd;
+    vfs_zstream_t *stream = TAR_SUPER (fh->ino->super)->stream;
     const GArray *sm = (const GArray *) fh->ino->user_data;
     ssize_t chunk_idx;
     const struct sp_array *chunk;
@@ -1127,7 +1098,7 @@ tar_read_sparse (vfs_file_handler_t *fh, char *buffer, size_t count)
         // we are in the chunk -- read data until chunk end
         chunk = &g_array_index (sm, struct sp_array, chunk_idx - 1);
         remain = MIN ((off_t) count, chunk->offset + chunk->numbytes - fh->pos);
-        res = mc_read (fd, buffer, (size_t) remain);
+        res = vfs_zstream_read (stream, buffer, (size_t) remain);
     }
     else
     {
@@ -1158,7 +1129,7 @@ static off_t
 tar_lseek_sparse (vfs_file_handler_t *fh, off_t offset)
 {
     off_t saved_offset = offset;
-    int fd = TAR_SUPER (fh->ino->super)->fd;
+    vfs_zstream_t *stream = TAR_SUPER (fh->ino->super)->stream;
     const GArray *sm = (const GArray *) fh->ino->user_data;
     ssize_t chunk_idx;
     const struct sp_array *chunk;
@@ -1199,7 +1170,7 @@ tar_lseek_sparse (vfs_file_handler_t *fh, off_t offset)
         }
     }
 
-    res = mc_lseek (fd, offset, SEEK_SET);
+    res = vfs_zstream_seek (stream, offset, SEEK_SET);
     // return requested offset in success
     if (res == offset)
         res = saved_offset;
@@ -1214,7 +1185,7 @@ tar_read (void *fh, char *buffer, size_t count)
 {
     struct vfs_class *me = VFS_FILE_HANDLER_SUPER (fh)->me;
     vfs_file_handler_t *file = VFS_FILE_HANDLER (fh);
-    int fd = TAR_SUPER (VFS_FILE_HANDLER_SUPER (fh))->fd;
+    vfs_zstream_t *stream = TAR_SUPER (VFS_FILE_HANDLER_SUPER (fh))->stream;
     off_t begin = file->pos;
     ssize_t res;
 
@@ -1229,11 +1200,11 @@ tar_read (void *fh, char *buffer, size_t count)
     {
         begin += file->ino->data_offset;
 
-        if (mc_lseek (fd, begin, SEEK_SET) != begin)
+        if (vfs_zstream_seek (stream, begin, SEEK_SET) != begin)
             ERRNOR (EIO, -1);
 
         count = (size_t) MIN ((off_t) count, file->ino->st.st_size - file->pos);
-        res = mc_read (fd, buffer, count);
+        res = vfs_zstream_read (stream, buffer, count);
     }
 
     if (res == -1)
@@ -0,0 +1,293 @@
+/*
+   lib/filehighlight - tests for compiled rules of file highlighting
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/filehighlight"
+
+#include "tests/mctest.h"
+
+#include <stdlib.h>
+
+#include "lib/charsets.h"
+#include "lib/strutil.h"
+#include "lib/skin.h"
+#include "lib/filehighlight.h"
+#include "lib/filehighlight/internal.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* Rules in order of declaration. Every group has one parameter, so the filter of rule has the same
+   index. Color of rule is its group name. */
+static const struct test_rule
+{
+    const char *group;
+    const char *param;
+    const char *value;
+    gboolean extensions_case;
+    gboolean expected_combined;  // for regexp filters
+} test_rules[] = {
+    { "101", "type", "DIR", FALSE, FALSE },
+    { "102", "extensions", "tar.gz;tgz", FALSE, FALSE },
+    { "103", "regexp", "^core$", FALSE, TRUE },
+    { "104", "extensions", "gz;bz2", FALSE, FALSE },
+    { "105", "extensions", "C;H", TRUE, FALSE },
+    { "106", "regexp", "\\.(bak|orig)$", FALSE, TRUE },
+    { "107", "extensions", "c;h", FALSE, FALSE },
+    // back reference can't be combined
+    { "108", "regexp", "^(a)\\1", FALSE, FALSE },
+    // caseless non-ASCII extensions aren't hashed
+    { "109", "extensions", "txt;\xc3\x84", FALSE, FALSE },
+    { "110", "regexp", "~$", FALSE, TRUE },
+    // duplicated extension: the first rule wins
+    { "111", "extensions", "gz", FALSE, FALSE },
+    // invalid regexp can't be combined
+    { "112", "regexp", "[", FALSE, FALSE },
+    { "113", "regexp", "^x", FALSE, TRUE },
+};
+
+static mc_fhl_t *fhl;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Mock */
+int
+mc_skin_color_get (const gchar *group, const gchar *name)
+{
+    (void) group;
+
+    return atoi (name);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    size_t i;
+
+    str_init_strings ("UTF-8");
+    mc_global.utf8_display = TRUE;
+    cp_display = "UTF-8";
+
+    fhl = mc_fhl_new (FALSE);
+    fhl->config = mc_config_init (NULL, FALSE);
+
+    for (i = 0; i < G_N_ELEMENTS (test_rules); i++)
+    {
+        mc_config_set_string (fhl->config, test_rules[i].group, test_rules[i].param,
+                              test_rules[i].value);
+        if (test_rules[i].extensions_case)
+            mc_config_set_bool (fhl->config, test_rules[i].group, "extensions_case", TRUE);
+    }
+
+    mctest_assert_true (mc_fhl_parse_ini_file (fhl));
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    mc_fhl_free (&fhl);
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static file_entry_t *
+create_file_entry (const char *name, mode_t mode)
+{
+    file_entry_t *fe;
+
+    fe = g_new0 (file_entry_t, 1);
+    fe->fname = g_string_new (name);
+    fe->st.st_mode = mode;
+    fe->st.st_nlink = 1;
+
+    return fe;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+free_file_entry (file_entry_t *fe)
+{
+    g_string_free (fe->fname, TRUE);
+    g_free (fe);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/**
+ * Get color like before rules were compiled: every rule is checked in order, extensions are
+ * searched with regexp.
+ */
+
+static int
+get_color_by_rules (const file_entry_t *fe)
+{
+    size_t i;
+
+    for (i = 0; i < G_N_ELEMENTS (test_rules); i++)
+    {
+        const struct test_rule *rule = &test_rules[i];
+        GString *pattern;
+        mc_search_t *s;
+        gboolean found;
+
+        if (strcmp (rule->param, "type") == 0)
+        {
+            if (S_ISDIR (fe->st.st_mode))
+                return atoi (rule->group);
+            continue;
+        }
+
+        if (strcmp (rule->param, "regexp") == 0)
+            pattern = g_string_new (rule->value);
+        else
+        {
+            gchar **exts, **e;
+
+            exts = g_strsplit (rule->value, ";", -1);
+            pattern = g_string_new (".*\\.(");
+            for (e = exts; *e != NULL; e++)
+            {
+                char *esc_ext;
+
+                esc_ext = str_regex_escape (*e);
+                if (e != exts)
+                    g_string_append_c (pattern, '|');
+                g_string_append (pattern, esc_ext);
+                g_free (esc_ext);
+            }
+            g_string_append (pattern, ")$");
+            g_strfreev (exts);
+        }
+
+        s = mc_search_new_len (pattern->str, pattern->len, NULL);
+        s->is_case_sensitive = strcmp (rule->param, "regexp") == 0 || rule->extensions_case;
+        s->search_type = MC_SEARCH_T_REGEX;
+        found = mc_search_run (s, fe->fname->str, 0, fe->fname->len, NULL);
+        mc_search_free (s);
+        g_string_free (pattern, TRUE);
+
+        if (found)
+            return atoi (rule->group);
+    }
+
+    return FILEHIGHLIGHT_DEFAULT_COLOR;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_mc_fhl_get_color_ds") */
+static const struct test_mc_fhl_get_color_ds
+{
+    const char *name;
+    mode_t mode;
+    int expected_color;
+} test_mc_fhl_get_color_ds[] = {
+    { "dir.tar.gz", S_IFDIR | 0755, 101 },
+    { "dir.tar.gz", S_IFREG | 0644, 102 },
+    { "x.TGZ", S_IFREG | 0644, 102 },
+    { "core", S_IFREG | 0644, 103 },
+    { "core.c", S_IFREG | 0644, 107 },
+    { "a.GZ", S_IFREG | 0644, 104 },
+    { "b.bz2", S_IFREG | 0644, 104 },
+    { "m.C", S_IFREG | 0644, 105 },
+    { "m.h", S_IFREG | 0644, 107 },
+    { "readme.txt", S_IFREG | 0644, 109 },
+    { "README.TXT", S_IFREG | 0644, 109 },
+    { "u.\xc3\xa4", S_IFREG | 0644, 109 },
+    { "aa", S_IFREG | 0644, 108 },
+    { "aab.bak", S_IFREG | 0644, 106 },
+    { "f.orig~", S_IFREG | 0644, 110 },
+    { "x.orig", S_IFREG | 0644, 106 },
+    { "xyz", S_IFREG | 0644, 113 },
+    { "x.c\nfoo", S_IFREG | 0644, 107 },
+    { "two\nlines.c", S_IFREG | 0644, FILEHIGHLIGHT_DEFAULT_COLOR },
+    { "plain", S_IFREG | 0644, FILEHIGHLIGHT_DEFAULT_COLOR },
+    { "no.ext.", S_IFREG | 0644, FILEHIGHLIGHT_DEFAULT_COLOR },
+};
+
+/* @Test(dataSource = "test_mc_fhl_get_color_ds") */
+START_PARAMETRIZED_TEST (test_mc_fhl_get_color, test_mc_fhl_get_color_ds)
+{
+    // given
+    file_entry_t *fe;
+    int actual_color, cached_color;
+
+    fe = create_file_entry (data->name, data->mode);
+
+    // when
+    actual_color = mc_fhl_get_color (fhl, fe);
+    cached_color = mc_fhl_get_color (fhl, fe);
+
+    // then
+    ck_assert_int_eq (actual_color, data->expected_color);
+    ck_assert_int_eq (actual_color, get_color_by_rules (fe));
+    ck_assert_int_eq (cached_color, actual_color);
+
+    free_file_entry (fe);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+START_TEST (test_mc_fhl_regexp_combined)
+{
+    size_t i;
+
+    ck_assert_int_eq (fhl->filters->len, G_N_ELEMENTS (test_rules));
+    mctest_assert_not_null (fhl->regexps);
+
+    for (i = 0; i < G_N_ELEMENTS (test_rules); i++)
+    {
+        const mc_fhl_filter_t *mc_filter;
+
+        mc_filter = (const mc_fhl_filter_t *) g_ptr_array_index (fhl->filters, i);
+        ck_assert_int_eq (mc_filter->color_pair_index, atoi (test_rules[i].group));
+        ck_assert_int_eq (mc_filter->is_combined, test_rules[i].expected_combined);
+    }
+}
+END_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_mc_fhl_get_color, test_mc_fhl_get_color_ds);
+    tcase_add_test (tc_core, test_mc_fhl_regexp_combined);
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,421 @@
+/*
+   libmc - checks for search of plain strings without regex
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/search/normal"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+#include "lib/search.h"
+#include "lib/search/internal.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+#define BLOCK_OFFSET 100
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings ("UTF-8");
+    mc_global.utf8_display = TRUE;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static mc_search_t *
+create_search (const char *pattern, gboolean is_case_sensitive, gboolean whole_words,
+               gboolean expected_literal)
+{
+    mc_search_t *s;
+    const mc_search_cond_t *cond;
+
+    s = mc_search_new (pattern, "UTF-8");
+    s->search_type = MC_SEARCH_T_NORMAL;
+    s->is_case_sensitive = is_case_sensitive;
+    s->whole_words = whole_words;
+
+    mctest_assert_true (mc_search_prepare (s));
+    cond = (const mc_search_cond_t *) g_ptr_array_index (s->prepared.conditions, 0);
+    ck_assert_int_eq (cond->literal != NULL, expected_literal);
+
+    return s;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_normal_run_literal_ds") */
+static const struct test_normal_run_literal_ds
+{
+    const char *text;
+    const char *pattern;
+    gboolean is_case_sensitive;
+    gboolean whole_words;
+    gboolean expected_literal;
+    gboolean expected_found;
+    off_t expected_offset;
+    gsize expected_len;
+} test_normal_run_literal_ds[] = {
+    {
+        // 0. Case sensitive string is found with memmem() in the second line
+        "abc\nxyzdef\n",
+        "def",
+        TRUE,
+        FALSE,
+        TRUE,
+        TRUE,
+        7,
+        3,
+    },
+    {
+        // 1. Case sensitive string doesn't match other case
+        "abc\nDEF\n",
+        "def",
+        TRUE,
+        FALSE,
+        TRUE,
+        FALSE,
+        0,
+        0,
+    },
+    {
+        // 2. Caseless: candidates of the first byte which don't match are passed
+        "xx f fo FoO\n",
+        "foo",
+        FALSE,
+        FALSE,
+        TRUE,
+        TRUE,
+        8,
+        3,
+    },
+    {
+        // 3. Caseless: upper case candidate is before lower case one
+        "Fx fOO foo",
+        "foo",
+        FALSE,
+        FALSE,
+        TRUE,
+        TRUE,
+        3,
+        3,
+    },
+    {
+        // 4. Caseless: pattern in mixed case
+        "abc BAR",
+        "bAr",
+        FALSE,
+        FALSE,
+        TRUE,
+        TRUE,
+        4,
+        3,
+    },
+    {
+        // 5. Caseless: the first byte has no case
+        "a1.c 1.B",
+        "1.b",
+        FALSE,
+        FALSE,
+        TRUE,
+        TRUE,
+        5,
+        3,
+    },
+    {
+        // 6. Case sensitive non-ASCII string is plain
+        "x\xc3\xa4y",
+        "\xc3\xa4",
+        TRUE,
+        FALSE,
+        TRUE,
+        TRUE,
+        1,
+        2,
+    },
+    {
+        // 7. Fallback to regex: whole words
+        "foobar foo",
+        "foo",
+        TRUE,
+        TRUE,
+        FALSE,
+        TRUE,
+        7,
+        3,
+    },
+    {
+        // 8. Fallback to regex: caseless 'k' matches KELVIN SIGN in UTF-8
+        "OK",
+        "ok",
+        FALSE,
+        FALSE,
+        FALSE,
+        TRUE,
+        0,
+        2,
+    },
+    {
+        // 9. Fallback to regex: caseless non-ASCII letter
+        "x\xc3\x84y",
+        "\xc3\xa4",
+        FALSE,
+        FALSE,
+        FALSE,
+        TRUE,
+        1,
+        2,
+    },
+    {
+        // 10. Fallback to regex: newline in pattern isn't found in lines
+        "abc\ndef",
+        "c\nd",
+        TRUE,
+        FALSE,
+        FALSE,
+        FALSE,
+        0,
+        0,
+    },
+    {
+        // 11. Special characters of regex are plain
+        "a.c abc a+c",
+        "a+c",
+        TRUE,
+        FALSE,
+        TRUE,
+        TRUE,
+        8,
+        3,
+    },
+};
+
+/* @Test(dataSource = "test_normal_run_literal_ds") */
+START_PARAMETRIZED_TEST (test_normal_run_literal, test_normal_run_literal_ds)
+{
+    // given
+    mc_search_t *s;
+    gsize found_len = 0;
+    gboolean found;
+
+    s = create_search (data->pattern, data->is_case_sensitive, data->whole_words,
+                       data->expected_literal);
+
+    // when
+    found = mc_search_run (s, data->text, 0, strlen (data->text), &found_len);
+
+    // then
+    ck_assert_int_eq (found, data->expected_found);
+    if (found)
+    {
+        ck_assert_int_eq (s->normal_offset, data->expected_offset);
+        ck_assert_int_eq (found_len, data->expected_len);
+    }
+    else
+        ck_assert_int_eq (s->error, MC_SEARCH_E_NOTFOUND);
+
+    mc_search_free (s);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_normal_run_literal_block_ds") */
+static const struct test_normal_run_literal_block_ds
+{
+    const char *text;
+    const char *pattern;
+    gboolean is_case_sensitive;
+    gboolean whole_words;
+    gboolean is_last;
+    gsize start;
+    gboolean expected_literal;
+    gboolean expected_found;
+    off_t expected_offset;  // offset of match in block
+    gsize expected_len;
+    gsize expected_keep;
+} test_normal_run_literal_block_ds[] = {
+    {
+        // 0. Match is split by the end of block: keep its line
+        "abc\nxde",
+        "def",
+        TRUE,
+        FALSE,
+        FALSE,
+        0,
+        TRUE,
+        FALSE,
+        0,
+        0,
+        4,
+    },
+    {
+        // 1. The rest of split match in the next block
+        "xdef\n",
+        "def",
+        TRUE,
+        FALSE,
+        TRUE,
+        0,
+        TRUE,
+        TRUE,
+        1,
+        3,
+        0,
+    },
+    {
+        // 2. Caseless match is split by the end of block
+        "abc\nxyz\nxDe",
+        "def",
+        FALSE,
+        FALSE,
+        FALSE,
+        0,
+        TRUE,
+        FALSE,
+        0,
+        0,
+        8,
+    },
+    {
+        // 3. Caseless match ends at the end of block
+        "abc\nDeF",
+        "def",
+        FALSE,
+        FALSE,
+        FALSE,
+        0,
+        TRUE,
+        TRUE,
+        4,
+        3,
+        4,
+    },
+    {
+        // 4. Match starts at the start of search
+        "abcd\nabc",
+        "abc",
+        TRUE,
+        FALSE,
+        TRUE,
+        5,
+        TRUE,
+        TRUE,
+        5,
+        3,
+        5,
+    },
+    {
+        // 5. Fallback to regex: pattern with newline matches several lines in block
+        "abc\ndef\n",
+        "c\nd",
+        TRUE,
+        FALSE,
+        TRUE,
+        0,
+        FALSE,
+        TRUE,
+        2,
+        3,
+        0,
+    },
+    {
+        // 6. Fallback to regex: whole words
+        "foobar foo\n",
+        "foo",
+        TRUE,
+        TRUE,
+        TRUE,
+        0,
+        FALSE,
+        TRUE,
+        7,
+        3,
+        0,
+    },
+};
+
+/* @Test(dataSource = "test_normal_run_literal_block_ds") */
+START_PARAMETRIZED_TEST (test_normal_run_literal_block, test_normal_run_literal_block_ds)
+{
+    // given
+    mc_search_t *s;
+    mc_search_block_t block;
+    gsize found_len = 0;
+    gboolean found;
+
+    s = create_search (data->pattern, data->is_case_sensitive, data->whole_words,
+                       data->expected_literal);
+
+    mc_search_block_init (&block, data->text, strlen (data->text), BLOCK_OFFSET, data->is_last);
+
+    // when
+    found = mc_search_run_block (s, &block, data->start, &found_len);
+
+    // then
+    ck_assert_int_eq (found, data->expected_found);
+    if (found)
+    {
+        ck_assert_int_eq (s->normal_offset, BLOCK_OFFSET + data->expected_offset);
+        ck_assert_int_eq (found_len, data->expected_len);
+    }
+    else
+        ck_assert_int_eq (s->error, MC_SEARCH_E_NOTFOUND);
+    ck_assert_int_eq (block.keep, data->expected_keep);
+
+    mc_search_block_deinit (&block);
+    mc_search_free (s);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_normal_run_literal, test_normal_run_literal_ds);
+    mctest_add_parameterized_test (tc_core, test_normal_run_literal_block,
+                                   test_normal_run_literal_block_ds);
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
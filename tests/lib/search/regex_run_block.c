@@ -0,0 +1,242 @@
+/*
+   libmc - checks for search in block of text
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "lib/search/regex"
+
+#include "tests/mctest.h"
+
+#include "lib/search.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+#define BLOCK_OFFSET 100
+
+/* @DataSource("test_regex_run_block_ds") */
+static const struct test_regex_run_block_ds
+{
+    const char *text;
+    const char *pattern;
+    mc_search_type_t type;
+    gboolean is_last;
+    gsize start;
+    gboolean expected_found;
+    off_t expected_offset;  // offset of match in block
+    gsize expected_len;
+    gsize expected_keep;
+} test_regex_run_block_ds[] = {
+    {
+        // 0. Simplest case
+        "abc\ndef\n",
+        "def",
+        MC_SEARCH_T_NORMAL,
+        TRUE,
+        0,
+        TRUE,
+        4,
+        3,
+        4,
+    },
+    {
+        // 1. '^' and '$' match at every line
+        "abc\ndef\nghi\n",
+        "^def$",
+        MC_SEARCH_T_REGEX,
+        TRUE,
+        0,
+        TRUE,
+        4,
+        3,
+        4,
+    },
+    {
+        // 2. Pattern may match several lines
+        "foo\nbar\n",
+        "o\\nb",
+        MC_SEARCH_T_REGEX,
+        TRUE,
+        0,
+        TRUE,
+        2,
+        3,
+        0,
+    },
+    {
+        // 3. '.' doesn't match newline
+        "ab\ncd\n",
+        "b.*",
+        MC_SEARCH_T_REGEX,
+        TRUE,
+        0,
+        TRUE,
+        1,
+        1,
+        0,
+    },
+    {
+        // 4. Start from the middle of block
+        "abc\nabc\n",
+        "abc",
+        MC_SEARCH_T_NORMAL,
+        TRUE,
+        4,
+        TRUE,
+        4,
+        3,
+        4,
+    },
+    {
+        // 5. Not found: keep the last incomplete line
+        "abc\nxyz\nqq",
+        "def",
+        MC_SEARCH_T_NORMAL,
+        FALSE,
+        0,
+        FALSE,
+        0,
+        0,
+        8,
+    },
+    {
+        // 6. Not found in the last block: nothing to keep
+        "abc\nxyz\nqq",
+        "def",
+        MC_SEARCH_T_NORMAL,
+        TRUE,
+        0,
+        FALSE,
+        0,
+        0,
+        10,
+    },
+    {
+        // 7. Partial match of plain string at the end of block: keep its line
+        "abc\nxyz\nde",
+        "def",
+        MC_SEARCH_T_NORMAL,
+        FALSE,
+        0,
+        FALSE,
+        0,
+        0,
+        8,
+    },
+    {
+        // 8. Match reaches the end of block and may be longer
+        "abc\n12",
+        "[0-9]+",
+        MC_SEARCH_T_REGEX,
+        FALSE,
+        0,
+        FALSE,
+        0,
+        0,
+        4,
+    },
+    {
+        // 9. Match ends before the end of block
+        "abc\n12\n",
+        "[0-9]+",
+        MC_SEARCH_T_REGEX,
+        FALSE,
+        0,
+        TRUE,
+        4,
+        2,
+        4,
+    },
+    {
+        // 10. Partial match of regex at the end of block: position is unknown, keep all
+        "abc\nxyz\nde",
+        "de[f]",
+        MC_SEARCH_T_REGEX,
+        FALSE,
+        0,
+        FALSE,
+        0,
+        0,
+        0,
+    },
+    {
+        // 11. Plain string at the end of block is complete
+        "abc\ndef",
+        "def",
+        MC_SEARCH_T_NORMAL,
+        FALSE,
+        0,
+        TRUE,
+        4,
+        3,
+        4,
+    },
+};
+
+/* @Test(dataSource = "test_regex_run_block_ds") */
+START_PARAMETRIZED_TEST (test_regex_run_block, test_regex_run_block_ds)
+{
+    // given
+    mc_search_t *s;
+    mc_search_block_t block;
+    gsize found_len = 0;
+    gboolean found;
+
+    s = mc_search_new (data->pattern, NULL);
+    s->is_case_sensitive = TRUE;
+    s->search_type = data->type;
+
+    mc_search_block_init (&block, data->text, strlen (data->text), BLOCK_OFFSET, data->is_last);
+
+    // when
+    found = mc_search_run_block (s, &block, data->start, &found_len);
+
+    // then
+    ck_assert_int_eq (found, data->expected_found);
+    if (found)
+    {
+        ck_assert_int_eq (s->normal_offset, BLOCK_OFFSET + data->expected_offset);
+        ck_assert_int_eq (found_len, data->expected_len);
+    }
+    else
+        ck_assert_int_eq (s->error, MC_SEARCH_E_NOTFOUND);
+    ck_assert_int_eq (block.keep, data->expected_keep);
+
+    mc_search_block_deinit (&block);
+    mc_search_free (s);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_regex_run_block, test_regex_run_block_ds);
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
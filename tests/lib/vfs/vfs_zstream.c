@@ -0,0 +1,407 @@
+/*
+   lib/vfs - test reading of compressed archives
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib/vfs"
+
+#include "tests/mctest.h"
+
+#include <errno.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "lib/strutil.h"
+#include "lib/vfs/zstream.h"
+
+#include "src/vfs/local/local.c"
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* size of uncompressed data, several times larger than data kept for backward seeks */
+#define DATA_SIZE (300 * 1000)
+
+static guint8 *text;
+static char *archive_name;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    guint32 r = 1;
+    size_t i;
+
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    // compressible, but not too much
+    text = g_malloc (DATA_SIZE);
+    for (i = 0; i < DATA_SIZE; i++)
+    {
+        r = r * 1103515245 + 12345;
+        text[i] = (guint8) ('a' + ((r >> 16) & 0x0F));
+    }
+
+    archive_name = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    if (archive_name != NULL)
+    {
+        unlink (archive_name);
+        g_free (archive_name);
+    }
+
+    g_free (text);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static vfs_zstream_t *
+open_archive (const guint8 *archive, size_t len)
+{
+    vfs_path_t *vpath;
+    vfs_zstream_t *zs;
+    int fd;
+
+    fd = g_file_open_tmp ("mc-zstream-XXXXXX", &archive_name, NULL);
+    ck_assert_int_ne (fd, -1);
+    ck_assert_int_eq (write (fd, archive, len), (ssize_t) len);
+    close (fd);
+
+    vpath = vfs_path_from_str (archive_name);
+    zs = vfs_zstream_open (vpath);
+    vfs_path_free (vpath, TRUE);
+    mctest_assert_not_null (zs);
+
+    return zs;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+START_TEST (test_vfs_zstream_plain)
+{
+    // given
+    vfs_zstream_t *zs;
+    guint8 buf[BUF_8K];
+
+    // when
+    zs = open_archive (text, DATA_SIZE);
+
+    // then
+    ck_assert_int_eq (vfs_zstream_seek (zs, 4, SEEK_SET), 4);
+    ck_assert_int_eq (vfs_zstream_read (zs, buf, sizeof (buf)), sizeof (buf));
+    ck_assert_int_eq (memcmp (buf, text + 4, sizeof (buf)), 0);
+
+    vfs_zstream_close (zs);
+}
+END_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef HAVE_ZLIB
+
+/* append gzip member with @len bytes of text from @offset */
+static void
+append_gzip_member (GByteArray *archive, size_t offset, size_t len)
+{
+    z_stream z;
+    guint8 buf[BUF_8K];
+    int ret;
+
+    memset (&z, 0, sizeof (z));
+    ck_assert_int_eq (deflateInit2 (&z, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY), Z_OK);
+
+    z.next_in = text + offset;
+    z.avail_in = (uInt) len;
+
+    do
+    {
+        z.next_out = buf;
+        z.avail_out = sizeof (buf);
+        ret = deflate (&z, Z_FINISH);
+        ck_assert_int_ne (ret, Z_STREAM_ERROR);
+        g_byte_array_append (archive, buf, sizeof (buf) - z.avail_out);
+    }
+    while (ret != Z_STREAM_END);
+
+    deflateEnd (&z);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* read the rest of stream and check it */
+static void
+check_read_to_end (vfs_zstream_t *zs, size_t offset)
+{
+    guint8 *buf;
+    ssize_t len;
+
+    buf = g_malloc (DATA_SIZE);
+    len = vfs_zstream_read (zs, buf, DATA_SIZE);
+    ck_assert_int_eq (len, DATA_SIZE - offset);
+    ck_assert_int_eq (memcmp (buf, text + offset, (size_t) len), 0);
+
+    // clean end of stream
+    ck_assert_int_eq (vfs_zstream_read (zs, buf, DATA_SIZE), 0);
+
+    g_free (buf);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_vfs_zstream_members_ds") */
+static const struct test_vfs_zstream_members_ds
+{
+    size_t members[4];  // sizes of members, the last one takes the rest of text
+    const char *trailer;
+    size_t trailer_len;
+} test_vfs_zstream_members_ds[] = {
+    {
+        // 0. Single member
+        { 0 },
+        NULL,
+        0,
+    },
+    {
+        // 1. Several members
+        { 1000, 100 * 1000, 7, 0 },
+        NULL,
+        0,
+    },
+    {
+        // 2. Trailing garbage after the last member
+        { 0 },
+        "garbage",
+        7,
+    },
+    {
+        // 3. Trailing zeros after several members
+        { 50 * 1000, 0 },
+        "\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0",
+        16,
+    },
+    {
+        // 4. Member is decompressed in the same block as trailing garbage
+        { DATA_SIZE - 100, 0 },
+        "garbage",
+        7,
+    },
+};
+
+/* @Test(dataSource = "test_vfs_zstream_members_ds") */
+START_PARAMETRIZED_TEST (test_vfs_zstream_members, test_vfs_zstream_members_ds)
+{
+    // given
+    GByteArray *archive;
+    vfs_zstream_t *zs;
+    size_t offset = 0;
+    size_t i;
+
+    archive = g_byte_array_new ();
+    for (i = 0; data->members[i] != 0; i++)
+    {
+        append_gzip_member (archive, offset, data->members[i]);
+        offset += data->members[i];
+    }
+    append_gzip_member (archive, offset, DATA_SIZE - offset);
+    if (data->trailer != NULL)
+        g_byte_array_append (archive, (const guint8 *) data->trailer, data->trailer_len);
+
+    // when
+    zs = open_archive (archive->data, archive->len);
+
+    // then
+    check_read_to_end (zs, 0);
+
+    vfs_zstream_close (zs);
+    g_byte_array_free (archive, TRUE);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+START_TEST (test_vfs_zstream_corrupted)
+{
+    // given
+    GByteArray *archive;
+    vfs_zstream_t *zs;
+    guint8 *buf;
+    ssize_t len;
+
+    archive = g_byte_array_new ();
+    append_gzip_member (archive, 0, DATA_SIZE);
+    archive->data[archive->len / 2] ^= 0xFF;
+
+    // when
+    zs = open_archive (archive->data, archive->len);
+    buf = g_malloc (DATA_SIZE);
+    do
+        len = vfs_zstream_read (zs, buf, BUF_8K);
+    while (len > 0);
+
+    // then
+    ck_assert_int_eq (len, -1);
+    ck_assert_int_eq (errno, EIO);
+
+    g_free (buf);
+    vfs_zstream_close (zs);
+    g_byte_array_free (archive, TRUE);
+}
+END_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+START_TEST (test_vfs_zstream_seek)
+{
+    // sequence of seeks and reads in one stream
+    static const struct
+    {
+        off_t offset;
+        int whence;
+        size_t len;
+    } steps[] = {
+        // forward
+        { 1000, SEEK_SET, 100 },
+        { 200 * 1000, SEEK_SET, 1000 },
+        { 5000, SEEK_CUR, 1000 },
+        // backward within kept data
+        { -1500, SEEK_CUR, 1000 },
+        // backward beyond kept data
+        { 10, SEEK_SET, 20 * 1000 },
+        { 150 * 1000, SEEK_SET, 1 },
+        // forward after backward
+        { DATA_SIZE - 10, SEEK_SET, 10 },
+        // backward again: data are read from temporary file
+        { 0, SEEK_SET, 10 },
+        { 100 * 1000 - 10, SEEK_SET, 20 * 1000 },
+    };
+
+    GByteArray *archive;
+    vfs_zstream_t *zs;
+    guint8 buf[20 * 1000];
+    off_t pos = 0;
+    size_t i;
+
+    // given
+    archive = g_byte_array_new ();
+    append_gzip_member (archive, 0, 100 * 1000);
+    append_gzip_member (archive, 100 * 1000, DATA_SIZE - 100 * 1000);
+    zs = open_archive (archive->data, archive->len);
+
+    for (i = 0; i < G_N_ELEMENTS (steps); i++)
+    {
+        // when
+        pos = (steps[i].whence == SEEK_SET ? 0 : pos) + steps[i].offset;
+        ck_assert_int_eq (vfs_zstream_seek (zs, steps[i].offset, steps[i].whence), pos);
+        ck_assert_int_eq (vfs_zstream_read (zs, buf, steps[i].len), steps[i].len);
+
+        // then
+        ck_assert_msg (memcmp (buf, text + pos, steps[i].len) == 0, "step %zu", i);
+        pos += (off_t) steps[i].len;
+    }
+
+    // seek from the end isn't supported
+    ck_assert_int_eq (vfs_zstream_seek (zs, 0, SEEK_END), -1);
+    ck_assert_int_eq (vfs_zstream_seek (zs, -1, SEEK_SET), -1);
+
+    // and the rest of stream is read after all
+    ck_assert_int_eq (vfs_zstream_seek (zs, pos, SEEK_SET), pos);
+    check_read_to_end (zs, (size_t) pos);
+
+    vfs_zstream_close (zs);
+    g_byte_array_free (archive, TRUE);
+}
+END_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Test */
+START_TEST (test_vfs_zstream_read_backward)
+{
+    // given
+    GByteArray *archive;
+    vfs_zstream_t *zs;
+    guint8 buf[BUF_8K];
+    off_t pos;
+
+    archive = g_byte_array_new ();
+    append_gzip_member (archive, 0, DATA_SIZE);
+    zs = open_archive (archive->data, archive->len);
+
+    // when
+    for (pos = (off_t) (DATA_SIZE - sizeof (buf)); pos >= 0; pos -= (off_t) (3 * sizeof (buf)))
+    {
+        // then
+        ck_assert_int_eq (vfs_zstream_seek (zs, pos, SEEK_SET), pos);
+        ck_assert_int_eq (vfs_zstream_read (zs, buf, sizeof (buf)), sizeof (buf));
+        ck_assert_msg (memcmp (buf, text + pos, sizeof (buf)) == 0, "offset %jd", (intmax_t) pos);
+    }
+
+    vfs_zstream_close (zs);
+    g_byte_array_free (archive, TRUE);
+}
+END_TEST
+
+#endif /* HAVE_ZLIB */
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    // Add new tests here: ***************
+    tcase_add_test (tc_core, test_vfs_zstream_plain);
+#ifdef HAVE_ZLIB
+    mctest_add_parameterized_test (tc_core, test_vfs_zstream_members, test_vfs_zstream_members_ds);
+    tcase_add_test (tc_core, test_vfs_zstream_corrupted);
+    tcase_add_test (tc_core, test_vfs_zstream_seek);
+    tcase_add_test (tc_core, test_vfs_zstream_read_backward);
+#endif
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
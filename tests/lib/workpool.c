@@ -0,0 +1,99 @@
+/*
+   lib - mc_workpool_*() functions testing
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/lib"
+
+#include "tests/mctest.h"
+
+#include "lib/workpool.h"
+
+/* --------------------------------------------------------------------------------------------- */
+
+#define TASK_COUNT 1000
+
+static int results[TASK_COUNT];
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+square_task (gpointer task, gpointer user_data)
+{
+    int *item = (int *) task;
+    const int *offset = (const int *) user_data;
+
+    *item = (*item) * (*item) + *offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_workpool_ds") */
+static const struct test_workpool_ds
+{
+    int max_workers;
+} test_workpool_ds[] = {
+    { 0 },
+    { 1 },
+    { 4 },
+};
+
+/* @Test(dataSource = "test_workpool_ds") */
+START_PARAMETRIZED_TEST (test_workpool, test_workpool_ds)
+{
+    // given
+    mc_workpool_t *pool;
+    int offset = 3;
+    int i;
+
+    for (i = 0; i < TASK_COUNT; i++)
+        results[i] = i;
+
+    // when
+    pool = mc_workpool_new (square_task, &offset, data->max_workers);
+    for (i = 0; i < TASK_COUNT; i++)
+        mc_workpool_push (pool, &results[i]);
+    mc_workpool_wait (pool);
+
+    // then
+    for (i = 0; i < TASK_COUNT; i++)
+        ck_assert_int_eq (results[i], i * i + 3);
+
+    mc_workpool_free (pool);
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_workpool, test_workpool_ds);
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,383 @@
+/*
+   src/editor - tests for line index of editor buffer
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "lib/strutil.h"
+
+#include "src/vfs/local/local.c"
+
+// small pages to cross page boundaries often
+#define S_EDIT_BUF_SIZE 8
+
+#include "src/editor/editbuffer.c"
+
+#define TEST_FILE_NAME "edit_buffer_get_line_offset.txt"
+
+static edit_buffer_t test_buf;
+// the same text kept in plain string
+static GString *test_text;
+static GRand *test_rand;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    str_init_strings (NULL);
+
+    vfs_init ();
+    vfs_init_localfs ();
+    vfs_setup_work_dir ();
+
+    edit_buffer_init (&test_buf, 0);
+    test_text = g_string_new ("");
+    test_rand = NULL;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    edit_buffer_clean (&test_buf);
+    g_string_free (test_text, TRUE);
+    if (test_rand != NULL)
+        g_rand_free (test_rand);
+    unlink (TEST_FILE_NAME);
+
+    vfs_shut ();
+    str_uninit_strings ();
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static char
+test_random_char (void)
+{
+    if (g_rand_int_range (test_rand, 0, 8) == 0)
+        return '\n';
+
+    return (char) g_rand_int_range (test_rand, 'a', 'z' + 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static GString *
+test_random_string (off_t len)
+{
+    GString *s;
+
+    s = g_string_sized_new ((gsize) len);
+    for (; len > 0; len--)
+        g_string_append_c (s, test_random_char ());
+
+    return s;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static off_t
+test_random_offset (void)
+{
+    return (off_t) g_rand_int_range (test_rand, 0, (gint32) test_text->len + 1);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** count newlines between first and last bytes */
+
+static long
+test_naive_count_lines (off_t first, off_t last)
+{
+    long lines = 0;
+
+    for (; first < last; first++)
+        if (test_text->str[first] == '\n')
+            lines++;
+
+    return lines;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** offset of line beginning, offset of the last line if there are less lines */
+
+static off_t
+test_naive_line_offset (long line)
+{
+    off_t offset = 0;
+    gsize i;
+
+    for (i = 0; i < test_text->len && line > 0; i++)
+        if (test_text->str[i] == '\n')
+        {
+            offset = (off_t) i + 1;
+            line--;
+        }
+
+    return offset;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+static void
+test_check_buffer (void)
+{
+    const off_t size = (off_t) test_text->len;
+    long lines, line;
+    off_t i;
+    int k;
+
+    ck_assert_int_eq (test_buf.size, size);
+    ck_assert_int_eq (test_buf.curs1 + test_buf.curs2, size);
+
+    for (i = 0; i < size;)
+    {
+        const char *s;
+        off_t len;
+
+        s = edit_buffer_get_chunk (&test_buf, i, &len);
+        mctest_assert_not_null (s);
+        ck_assert_int_gt (len, 0);
+        len = MIN (len, size - i);
+        ck_assert_int_eq (memcmp (s, test_text->str + i, (size_t) len), 0);
+        i += len;
+    }
+
+    lines = test_naive_count_lines (0, size);
+    ck_assert_int_eq (test_buf.lines, lines);
+    ck_assert_int_eq (edit_buffer_count_lines (&test_buf, 0, size), lines);
+
+    for (line = 0; line <= lines + 1; line += 1 + lines / 64)
+        ck_assert_int_eq (edit_buffer_get_line_offset (&test_buf, line),
+                          test_naive_line_offset (line));
+    ck_assert_int_eq (edit_buffer_get_line_offset (&test_buf, lines),
+                      test_naive_line_offset (lines));
+
+    for (k = 0; k < 32; k++)
+    {
+        off_t first, last;
+
+        first = test_random_offset ();
+        last = test_random_offset ();
+        ck_assert_int_eq (edit_buffer_count_lines (&test_buf, MIN (first, last), MAX (first, last)),
+                          test_naive_count_lines (MIN (first, last), MAX (first, last)));
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** apply random change to both buffer and string and keep number of lines as editor does */
+
+static void
+test_random_edit (void)
+{
+    const off_t curs = test_buf.curs1;
+    off_t len;
+    GString *s;
+    char c;
+
+    switch (g_rand_int_range (test_rand, 0, 9))
+    {
+    case 0:
+        // short move
+        len = curs + g_rand_int_range (test_rand, -3 * EDIT_BUF_SIZE, 3 * EDIT_BUF_SIZE);
+        len = CLAMP (len, 0, (off_t) test_text->len);
+        (void) edit_buffer_move_cursor (&test_buf, len - curs);
+        break;
+    case 1:
+        (void) edit_buffer_move_cursor (&test_buf, test_random_offset () - curs);
+        break;
+    case 2:
+        c = test_random_char ();
+        edit_buffer_insert (&test_buf, c);
+        g_string_insert_c (test_text, curs, c);
+        if (c == '\n')
+            test_buf.lines++;
+        break;
+    case 3:
+        c = test_random_char ();
+        edit_buffer_insert_ahead (&test_buf, c);
+        g_string_insert_c (test_text, curs, c);
+        if (c == '\n')
+            test_buf.lines++;
+        break;
+    case 4:
+        if (test_buf.curs2 != 0)
+        {
+            ck_assert_int_eq (edit_buffer_delete (&test_buf), (unsigned char) test_text->str[curs]);
+            if (test_text->str[curs] == '\n')
+                test_buf.lines--;
+            g_string_erase (test_text, curs, 1);
+        }
+        break;
+    case 5:
+        if (curs != 0)
+        {
+            ck_assert_int_eq (edit_buffer_backspace (&test_buf),
+                              (unsigned char) test_text->str[curs - 1]);
+            if (test_text->str[curs - 1] == '\n')
+                test_buf.lines--;
+            g_string_erase (test_text, curs - 1, 1);
+        }
+        break;
+    case 6:
+        len = g_rand_int_range (test_rand, 0, 5 * EDIT_BUF_SIZE);
+        s = test_random_string (len);
+        test_buf.lines += edit_buffer_insert_block_ahead (&test_buf, s->str, len);
+        g_string_insert_len (test_text, curs, s->str, (gssize) len);
+        g_string_free (s, TRUE);
+        break;
+    default:
+        len = g_rand_int_range (test_rand, 0, 5 * EDIT_BUF_SIZE);
+        len = MIN (len, test_buf.curs2);
+        ck_assert_int_eq (edit_buffer_delete_block (&test_buf, len),
+                          test_naive_count_lines (curs, curs + len));
+        test_buf.lines -= test_naive_count_lines (curs, curs + len);
+        g_string_erase (test_text, curs, (gssize) len);
+        break;
+    }
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_line_index_ds") */
+static const struct test_line_index_ds
+{
+    guint32 seed;
+    off_t size;
+} test_line_index_ds[] = {
+    {
+        // 0. empty buffer
+        1,
+        0,
+    },
+    {
+        // 1. less than one page
+        2,
+        EDIT_BUF_SIZE / 2,
+    },
+    {
+        // 2. many pages
+        3,
+        40 * EDIT_BUF_SIZE + 7,
+    },
+};
+
+/* @Test(dataSource = "test_line_index_ds") */
+START_PARAMETRIZED_TEST (test_line_index, test_line_index_ds)
+{
+    GString *s;
+    int i;
+
+    // given
+    test_rand = g_rand_new_with_seed (data->seed);
+    s = test_random_string (data->size);
+    test_buf.lines = edit_buffer_insert_block_ahead (&test_buf, s->str, data->size);
+    g_string_assign (test_text, s->str);
+    g_string_free (s, TRUE);
+    test_check_buffer ();
+
+    // when
+    for (i = 1; i <= 3000; i++)
+    {
+        test_random_edit ();
+
+        // then
+        if (i % 50 == 0)
+            test_check_buffer ();
+    }
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+#ifdef EDIT_BUFFER_MMAP
+/* @Test */
+START_TEST (test_line_index_map)
+{
+    const off_t size = 8 * EDIT_MAP_MIN_SIZE + 123;
+    vfs_path_t *vpath;
+    GString *s;
+    int fd, i;
+
+    // given
+    test_rand = g_rand_new_with_seed (4);
+    s = test_random_string (size);
+    mctest_assert_true (g_file_set_contents (TEST_FILE_NAME, s->str, (gssize) size, NULL));
+    g_string_assign (test_text, s->str);
+    g_string_free (s, TRUE);
+
+    vpath = vfs_path_from_str (TEST_FILE_NAME);
+    fd = mc_open (vpath, O_RDONLY);
+    vfs_path_free (vpath, TRUE);
+    ck_assert_int_ne (fd, -1);
+
+    edit_buffer_clean (&test_buf);
+    edit_buffer_init (&test_buf, size);
+    mctest_assert_true (edit_buffer_map_file (&test_buf, fd, NULL, NULL));
+    mc_close (fd);
+
+    // when: file is changed while lines are counted
+    for (i = 0; i < 20; i++)
+        test_random_edit ();
+
+    (void) edit_buffer_finish_lines (&test_buf);
+
+    // then
+    test_check_buffer ();
+
+    for (i = 1; i <= 3000; i++)
+    {
+        test_random_edit ();
+
+        if (i % 50 == 0)
+            test_check_buffer ();
+    }
+}
+END_TEST
+#endif
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_line_index, test_line_index_ds);
+#ifdef EDIT_BUFFER_MMAP
+    tcase_add_test (tc_core, test_line_index_map);
+#endif
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
@@ -0,0 +1,234 @@
+/*
+   src/editor - tests for match_keyword_to_right() function
+
+   Copyright (C) 2026
+   Free Software Foundation, Inc.
+
+   This file is part of the Midnight Commander.
+
+   The Midnight Commander is free software: you can redistribute it
+   and/or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   The Midnight Commander is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define TEST_SUITE_NAME "/src/editor"
+
+#include "tests/mctest.h"
+
+#include "src/editor/syntax.c"
+
+#define TEST_WHOLE_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"
+
+#define TEST_KEYWORDS_MAX 16
+
+static WEdit *test_edit;
+static context_rule_t *test_rule;
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @Before */
+static void
+setup (void)
+{
+    test_edit = g_new0 (WEdit, 1);
+    edit_buffer_init (&test_edit->buffer, 0);
+
+    test_rule = g_new0 (context_rule_t, 1);
+    test_rule->left = g_string_new ("");
+    test_rule->right = g_string_new ("");
+    test_rule->keyword = g_ptr_array_new_with_free_func (syntax_keyword_free);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @After */
+static void
+teardown (void)
+{
+    context_rule_free (test_rule);
+    edit_buffer_clean (&test_edit->buffer);
+    g_free (test_edit);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** add keyword in the syntax file notation, "!" prefix makes it whole, "^" prefix linestart */
+
+static void
+test_add_keyword (const char *text)
+{
+    syntax_keyword_t *k;
+    char *s;
+
+    k = g_new0 (syntax_keyword_t, 1);
+
+    if (*text == '!')
+    {
+        text++;
+        k->whole_word_chars_left = g_strdup (TEST_WHOLE_CHARS);
+        k->whole_word_chars_right = g_strdup (TEST_WHOLE_CHARS);
+    }
+
+    if (*text == '^')
+    {
+        text++;
+        k->line_start = TRUE;
+    }
+
+    // syntax file is lowerized by edit_read_syntax_rules() for case insensitive languages
+    s = g_strdup (text);
+    xx_lowerize_line (test_edit, s, strlen (s));
+    k->keyword = g_string_new (convert (s));
+    g_free (s);
+
+    g_ptr_array_add (test_rule->keyword, k);
+}
+
+/* --------------------------------------------------------------------------------------------- */
+/** search used before keywords were compiled into trie: compare every keyword by its first char */
+
+static guint
+test_match_keyword_first_char (off_t i, int c, off_t *end)
+{
+    guint k;
+
+    for (k = 1; k < test_rule->keyword->len; k++)
+    {
+        const syntax_keyword_t *kw = SYNTAX_KEYWORD (g_ptr_array_index (test_rule->keyword, k));
+        const unsigned char first = (unsigned char) kw->keyword->str[0];
+        off_t e;
+
+        if (first == '\0')
+            break;
+
+        if (first >= '\005' && xx_tolower (test_edit, first) != c)
+            continue;
+
+        e = compare_word_to_right (test_edit, i, kw->keyword, kw->whole_word_chars_left,
+                                   kw->whole_word_chars_right, kw->line_start);
+        if (e > 0)
+        {
+            *end = e;
+            return k;
+        }
+    }
+
+    return 0;
+}
+
+/* --------------------------------------------------------------------------------------------- */
+
+/* @DataSource("test_match_keyword_ds") */
+static const struct test_match_keyword_ds
+{
+    gboolean case_insensitive;
+    const char *keywords[TEST_KEYWORDS_MAX];
+    const char *text;      // text to search, followed by random text
+    const char *alphabet;  // characters of random text
+} test_match_keyword_ds[] = {
+    {
+        // 0. keywords with common prefixes
+        FALSE,
+        { "!if", "!int", "in", "!include", "i", "!for", "foreach", "fo", "else", "elif", "!elif",
+          "==", "=", "!=", NULL },
+        "if (int i) include for foreach fo elif else == != =\n",
+        "ifntcludeorachs  =!_\n",
+    },
+    {
+        // 1. wildcards at the beginning and in the middle of keywords
+        FALSE,
+        { "\\{abc\\}def", "*/", "0x\\[0123456789abcdef\\]", "a*b", "a+c", "!ab+", "^#*\\n",
+          "/\\*", "*x", "abc", "b", "\\[0123456789\\]", "+", NULL },
+        "abcdef bdef 0x1f a--b ac abbb #define x\n/* c */ xx 123 +\n",
+        "abcdefx0129#/*+ \n",
+    },
+    {
+        // 2. empty keyword stops the search
+        FALSE,
+        { "ab", "a*", "", "a", "b", NULL },
+        "ab a abc b\n",
+        "abc \n",
+    },
+    {
+        // 3. case insensitive language
+        TRUE,
+        { "!Begin", "!END", "beg", "E*d", "*Y", "!bEgIn\\{ABC\\}", "^Rem*\\n", "\\[XYZ\\]", NULL },
+        "BEGIN Begin begin bEgInAbC end End eNd\nREM x\nRem\nxyz XYZ y\n",
+        "BbEeGgIiNnDdAaCcXyRrMm \n",
+    },
+};
+
+/* @Test(dataSource = "test_match_keyword_ds") */
+START_PARAMETRIZED_TEST (test_match_keyword, test_match_keyword_ds)
+{
+    const size_t alphabet_len = strlen (data->alphabet);
+    GRand *rand;
+    off_t i;
+    int k;
+
+    // given
+    test_edit->is_case_insensitive = data->case_insensitive;
+
+    test_add_keyword (" ");
+    for (k = 0; data->keywords[k] != NULL; k++)
+        test_add_keyword (data->keywords[k]);
+
+    context_rule_compile_keywords (test_rule);
+
+    for (const char *t = data->text; *t != '\0'; t++)
+        edit_buffer_insert (&test_edit->buffer, *t);
+
+    rand = g_rand_new_with_seed (_i + 1);
+    for (i = 0; i < 4000; i++)
+        edit_buffer_insert (&test_edit->buffer,
+                            data->alphabet[g_rand_int_range (rand, 0, (gint32) alphabet_len)]);
+    g_rand_free (rand);
+
+    // when
+    for (i = 0; i < test_edit->buffer.size; i++)
+    {
+        int c;
+        guint actual, expected;
+        off_t actual_end = 0, expected_end = 0;
+
+        c = edit_buffer_get_byte (&test_edit->buffer, i);
+        c = xx_tolower (test_edit, c);
+
+        actual = match_keyword_to_right (test_edit, test_rule, i, c, &actual_end);
+        expected = test_match_keyword_first_char (i, c, &expected_end);
+
+        // then
+        ck_assert_int_eq (actual, expected);
+        if (expected != 0)
+            ck_assert_int_eq (actual_end, expected_end);
+    }
+}
+END_PARAMETRIZED_TEST
+
+/* --------------------------------------------------------------------------------------------- */
+
+int
+main (void)
+{
+    TCase *tc_core;
+
+    tc_core = tcase_create ("Core");
+
+    tcase_add_checked_fixture (tc_core, setup, teardown);
+
+    // Add new tests here: ***************
+    mctest_add_parameterized_test (tc_core, test_match_keyword, test_match_keyword_ds);
+    // ***********************************
+
+    return mctest_run_all (tc_core);
+}
+
+/* --------------------------------------------------------------------------------------------- */
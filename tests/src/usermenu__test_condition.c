@@ -33,19 +33,20 @@
 static void
 setup (void)
 {
+    dir_list *list;
+    struct stat st;
+
     easy_patterns = FALSE;
 
     current_panel = g_new0 (WPanel, 1);
-    current_panel->dir.size = 4;
-    current_panel->dir.len = current_panel->dir.size;
-    current_panel->dir.list = g_new0 (file_entry_t, current_panel->dir.size);
 
-    file_entry_t *list = current_panel->dir.list;
+    list = &current_panel->dir;
+    memset (&st, 0, sizeof (st));
 
-    list[0].fname = g_string_new ("file_without_spaces");
-    list[1].fname = g_string_new ("file with spaces");
-    list[2].fname = g_string_new ("file_without_spaces_utf8_local_chars_ä_ü_ö_ß_");
-    list[3].fname = g_string_new ("file_without_spaces_utf8_nonlocal_chars_à_á_");
+    dir_list_append (list, "file_without_spaces", &st, FALSE, FALSE);
+    dir_list_append (list, "file with spaces", &st, FALSE, FALSE);
+    dir_list_append (list, "file_without_spaces_utf8_local_chars_ä_ü_ö_ß_", &st, FALSE, FALSE);
+    dir_list_append (list, "file_without_spaces_utf8_nonlocal_chars_à_á_", &st, FALSE, FALSE);
 }
 
 /* --------------------------------------------------------------------------------------------- */
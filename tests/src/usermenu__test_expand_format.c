@@ -53,24 +53,25 @@ static WPanel *other_panel;
 static void
 setup_mock_panels (void)
 {
+    struct stat st;
     file_entry_t *list;
 
     setup ();
 
+    memset (&st, 0, sizeof (st));
+
     current_panel = g_new0 (WPanel, 1);
 
-    current_panel->dir.size = 4;
-    current_panel->dir.len = current_panel->dir.size;
-    current_panel->dir.list = g_new0 (file_entry_t, current_panel->dir.size);
     current_panel->cwd_vpath = vfs_path_from_str (CURRENT_DIR);
 
+    dir_list_append (&current_panel->dir, CURRENT_PFX FNAME1, &st, FALSE, FALSE);
+    dir_list_append (&current_panel->dir, CURRENT_PFX TAGGED_PFX FNAME2, &st, FALSE, FALSE);
+    dir_list_append (&current_panel->dir, CURRENT_PFX FNAME3, &st, FALSE, FALSE);
+    dir_list_append (&current_panel->dir, CURRENT_PFX TAGGED_PFX FNAME4, &st, FALSE, FALSE);
+
     list = current_panel->dir.list;
 
-    list[0].fname = g_string_new (CURRENT_PFX FNAME1);
-    list[1].fname = g_string_new (CURRENT_PFX TAGGED_PFX FNAME2);
     list[1].f.marked = TRUE;
-    list[2].fname = g_string_new (CURRENT_PFX FNAME3);
-    list[3].fname = g_string_new (CURRENT_PFX TAGGED_PFX FNAME4);
     list[3].f.marked = TRUE;
 
     current_panel->current = 0;
@@ -78,19 +79,17 @@ setup_mock_panels (void)
 
     other_panel = g_new0 (WPanel, 1);
 
-    other_panel->dir.size = 4;
-    other_panel->dir.len = other_panel->dir.size;
     other_panel->cwd_vpath = vfs_path_from_str (OTHER_DIR);
-    other_panel->dir.list = g_new0 (file_entry_t, other_panel->dir.size);
+
+    dir_list_append (&other_panel->dir, OTHER_PFX TAGGED_PFX FNAME1, &st, FALSE, FALSE);
+    dir_list_append (&other_panel->dir, OTHER_PFX FNAME2, &st, FALSE, FALSE);
+    dir_list_append (&other_panel->dir, OTHER_PFX TAGGED_PFX FNAME3, &st, FALSE, FALSE);
+    dir_list_append (&other_panel->dir, OTHER_PFX FNAME4, &st, FALSE, FALSE);
 
     list = other_panel->dir.list;
 
-    list[0].fname = g_string_new (OTHER_PFX TAGGED_PFX FNAME1);
     list[0].f.marked = TRUE;
-    list[1].fname = g_string_new (OTHER_PFX FNAME2);
-    list[2].fname = g_string_new (OTHER_PFX TAGGED_PFX FNAME3);
     list[2].f.marked = TRUE;
-    list[3].fname = g_string_new (OTHER_PFX FNAME4);
 
     other_panel->current = 1;
     other_panel->marked = 2;